@@ -96,7 +96,8 @@ namespace VulkanSDK
         Init()
         {
             base.Init();
-            if (this.BuildEnvironment.Platform.Includes(Bam.Core.EPlatform.OSX))
+            // only the Windows SDK is certain to have a glslangValidator of the version supported
+            if (!this.BuildEnvironment.Platform.Includes(Bam.Core.EPlatform.Windows))
             {
                 this.Tool = Bam.Core.Graph.Instance.FindReferencedModule<glslang.GLSLangValidator>();
             }
@@ -65,9 +65,16 @@ namespace VulkanSDK
             }
             else if (platform.Includes(Bam.Core.EPlatform.Linux))
             {
-                // TODO: is this compatible with the Linux installer?
-                latest_version_path = System.Environment.ExpandEnvironmentVariables("VK_SDK_PATH");
-                System.Diagnostics.Debug.Assert(latest_version_path.StartsWith("1.0", System.StringComparison.Ordinal));
+                // the Linux SDK's setup-env.sh exports VULKAN_SDK as its <version>/x86_64 directory
+                latest_version_path = System.Environment.GetEnvironmentVariable("VULKAN_SDK");
+                if (System.String.IsNullOrEmpty(latest_version_path))
+                {
+                    latest_version_path = System.Environment.GetEnvironmentVariable("VK_SDK_PATH");
+                }
+                if (System.String.IsNullOrEmpty(latest_version_path))
+                {
+                    throw new Bam.Core.Exception("Unable to locate any Vulkan SDK installations; source the SDK's setup-env.sh to set VULKAN_SDK");
+                }
             }
             Bam.Core.Log.Info($"Using VulkanSDK installed at {latest_version_path}");
             return latest_version_path;
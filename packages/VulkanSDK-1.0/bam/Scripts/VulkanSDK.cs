@@ -42,16 +42,26 @@ namespace VulkanSDK
             var latest_version_path = GetInstallDir.Find(this.BuildEnvironment.Platform);
             this.Macros[Bam.Core.ModuleMacroNames.PackageDirectory].Set(latest_version_path, null);
 
-            if (Bam.Core.OSUtilities.Is64Bit(this.BuildEnvironment.Platform))
+            if (this.BuildEnvironment.Platform.Includes(Bam.Core.EPlatform.Linux))
             {
-                this.Macros["VulkanLibDir"] = this.CreateTokenizedString("$(packagedir)/Source/Lib");
+                // the Linux SDK is laid out as a prefix, for a single architecture
+                this.Macros["VulkanLibDir"] = this.CreateTokenizedString("$(packagedir)/lib");
+                this.Macros["VulkanIncludeDir"] = this.CreateTokenizedString("$(packagedir)/include");
+                this.Macros[Bam.Core.ModuleMacroNames.OutputName] = this.CreateTokenizedString("vulkan");
             }
             else
             {
-                this.Macros["VulkanLibDir"] = this.CreateTokenizedString("$(packagedir)/Source/Lib32");
+                if (Bam.Core.OSUtilities.Is64Bit(this.BuildEnvironment.Platform))
+                {
+                    this.Macros["VulkanLibDir"] = this.CreateTokenizedString("$(packagedir)/Source/Lib");
+                }
+                else
+                {
+                    this.Macros["VulkanLibDir"] = this.CreateTokenizedString("$(packagedir)/Source/Lib32");
+                }
+                this.Macros["VulkanIncludeDir"] = this.CreateTokenizedString("$(packagedir)/Include");
+                this.Macros[Bam.Core.ModuleMacroNames.OutputName] = this.CreateTokenizedString("vulkan-1");
             }
-
-            this.Macros[Bam.Core.ModuleMacroNames.OutputName] = this.CreateTokenizedString("vulkan-1");
             this.RegisterGeneratedFile(
                 ExecutableKey,
                 this.CreateTokenizedString("$(VulkanLibDir)/$(dynamicprefix)$(OutputName)$(dynamicext)") // note: 64-bit
@@ -66,14 +76,15 @@ namespace VulkanSDK
 
             var headers = this.CreateHeaderCollection();
             headers.Macros[Bam.Core.ModuleMacroNames.PackageDirectory].Set(latest_version_path, null); // must set this as well as on this, since it doesn't inherit
-            headers.AddFiles("$(packagedir)/Include/vulkan/*.h");
-            headers.AddFiles("$(packagedir)/Include/vulkan/*.hpp");
+            headers.Macros["VulkanIncludeDir"] = this.Macros["VulkanIncludeDir"];
+            headers.AddFiles("$(VulkanIncludeDir)/vulkan/*.h");
+            headers.AddFiles("$(VulkanIncludeDir)/vulkan/*.hpp");
 
             this.PublicPatch((settings, appliedTo) =>
                 {
                     if (settings is C.ICommonPreprocessorSettings preprocessor)
                     {
-                        preprocessor.IncludePaths.AddUnique(this.CreateTokenizedString("$(packagedir)/Include"));
+                        preprocessor.IncludePaths.AddUnique(this.Macros["VulkanIncludeDir"]);
 
                         if (this.BuildEnvironment.Platform.Includes(Bam.Core.EPlatform.Windows))
                         {
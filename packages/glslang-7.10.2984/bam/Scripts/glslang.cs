@@ -104,6 +104,15 @@ namespace glslang
                 cxxCompiler.LanguageStandard = C.Cxx.ELanguageStandard.Cxx11;
                 cxxCompiler.StandardLibrary = C.Cxx.EStandardLibrary.libcxx;
             });
+
+            // for glslang/Public/ShaderLang.h
+            this.PublicPatch((settings, appliedTo) =>
+            {
+                if (settings is C.ICommonPreprocessorSettings preprocessor)
+                {
+                    preprocessor.IncludePaths.AddUnique(this.CreateTokenizedString("$(packagedir)"));
+                }
+            });
         }
     }
 
@@ -147,6 +156,46 @@ namespace glslang
                 cxxCompiler.LanguageStandard = C.Cxx.ELanguageStandard.Cxx11;
                 cxxCompiler.StandardLibrary = C.Cxx.EStandardLibrary.libcxx;
             });
+
+            // for SPIRV/GlslangToSpv.h
+            this.PublicPatch((settings, appliedTo) =>
+            {
+                if (settings is C.ICommonPreprocessorSettings preprocessor)
+                {
+                    preprocessor.IncludePaths.AddUnique(this.CreateTokenizedString("$(packagedir)"));
+                }
+            });
+        }
+    }
+
+    // the default TBuiltInResource limits used by glslangvalidator, for applications compiling in-process
+    class DefaultResourceLimits :
+        C.StaticLibrary
+    {
+        protected override void
+        Init()
+        {
+            base.Init();
+
+            var source = this.CreateCxxSourceCollection("$(packagedir)/StandAlone/ResourceLimits.cpp");
+            source.PrivatePatch(settings =>
+            {
+                var preprocessor = settings as C.ICommonPreprocessorSettings;
+                preprocessor.IncludePaths.AddUnique(this.CreateTokenizedString("$(packagedir)"));
+
+                var cxxCompiler = settings as C.ICxxOnlyCompilerSettings;
+                cxxCompiler.LanguageStandard = C.Cxx.ELanguageStandard.Cxx11;
+                cxxCompiler.StandardLibrary = C.Cxx.EStandardLibrary.libcxx;
+            });
+
+            // for StandAlone/ResourceLimits.h
+            this.PublicPatch((settings, appliedTo) =>
+            {
+                if (settings is C.ICommonPreprocessorSettings preprocessor)
+                {
+                    preprocessor.IncludePaths.AddUnique(this.CreateTokenizedString("$(packagedir)"));
+                }
+            });
         }
     }
 }
@@ -76,11 +76,21 @@ namespace VulkanTriangle
             }
             else
             {
+                // Linux shares the Windows entry point, using its Xlib event loop
                 this.CompileAndLinkAgainst<WindowLibrary.GraphicsWindow>(source);
                 source.AddFiles("$(packagedir)/source/entry/windows/*.cpp");
                 this.CompileAndLinkAgainst<VulkanSDK.Vulkan>(source);
             }
 
+            // in-process GLSL to SPIR-V compilation
+            this.CompileAndLinkAgainst<glslang.SPIRV>(source);
+            this.CompileAndLinkAgainst<glslang.GLSLang>(source);
+            this.CompileAndLinkAgainst<glslang.OGLCompilersDLL>(source);
+            this.CompileAndLinkAgainst<glslang.DefaultResourceLimits>(source);
+
+            // SPIR-V reflection for pipeline layouts
+            this.CompileAndLinkAgainst<SPIRVCross.SPIRVCross>(source);
+
             source.PrivatePatch(settings =>
                 {
                     var cxxcompiler = settings as C.ICxxOnlyCompilerSettings;
@@ -89,6 +99,8 @@ namespace VulkanTriangle
 
                     var preprocessor = settings as C.ICommonPreprocessorSettings;
                     preprocessor.IncludePaths.AddUnique(this.CreateTokenizedString("$(packagedir)/source"));
+                    // TextureHeader, of the payloads shared with textureprocessor
+                    preprocessor.IncludePaths.AddUnique(this.CreateTokenizedString("$(packagedir)/../RenderTextureAndProcessor/source/common"));
 
                     switch (settings)
                     {
@@ -129,6 +141,13 @@ namespace VulkanTriangle
                     var linker = settings as C.ICommonLinkerSettings;
                     linker.Libraries.Add("user32.lib");
                 }
+
+                if (settings is GccCommon.ICommonLinkerSettings)
+                {
+                    var linker = settings as C.ICommonLinkerSettings;
+                    linker.Libraries.AddUnique("-lX11"); // window and Xlib surface
+                    linker.Libraries.AddUnique("-lpthread"); // command buffer recording threads
+                }
             });
 
             var vertexShaderGLSL = Bam.Core.Module.Create<VulkanSDK.GLSLSource>(preInitCallback: module =>
@@ -152,6 +171,117 @@ namespace VulkanTriangle
                 module.DependsOn(fragmentShaderGLSL);
             });
             this.Requires(fragmentShaderSPIRV);
+
+            var texturedFragmentShaderGLSL = Bam.Core.Module.Create<VulkanSDK.GLSLSource>(preInitCallback: module =>
+            {
+                module.InputPath = this.CreateTokenizedString("$(packagedir)/shaders/textured.frag");
+            });
+            var texturedFragmentShaderSPIRV = Bam.Core.Module.Create<VulkanSDK.SPIRVModule>(preInitCallback: module =>
+            {
+                module.Source = texturedFragmentShaderGLSL;
+                module.DependsOn(texturedFragmentShaderGLSL);
+            });
+            this.Requires(texturedFragmentShaderSPIRV);
+
+            var instancedVertexShaderGLSL = Bam.Core.Module.Create<VulkanSDK.GLSLSource>(preInitCallback: module =>
+            {
+                module.InputPath = this.CreateTokenizedString("$(packagedir)/shaders/instanced.vert");
+            });
+            var instancedVertexShaderSPIRV = Bam.Core.Module.Create<VulkanSDK.SPIRVModule>(preInitCallback: module =>
+            {
+                module.Source = instancedVertexShaderGLSL;
+                module.DependsOn(instancedVertexShaderGLSL);
+            });
+            this.Requires(instancedVertexShaderSPIRV);
+
+            // image processing compute shaders
+            foreach (var computeShader in new[] { "filter.comp", "convert.comp", "downsample.comp" })
+            {
+                var computeShaderGLSL = Bam.Core.Module.Create<VulkanSDK.GLSLSource>(preInitCallback: module =>
+                {
+                    module.InputPath = this.CreateTokenizedString("$(packagedir)/shaders/" + computeShader);
+                });
+                var computeShaderSPIRV = Bam.Core.Module.Create<VulkanSDK.SPIRVModule>(preInitCallback: module =>
+                {
+                    module.Source = computeShaderGLSL;
+                    module.DependsOn(computeShaderGLSL);
+                });
+                this.Requires(computeShaderSPIRV);
+            }
+        }
+    }
+
+    // re-executes captures made by VulkanTriangle, headlessly
+    class VulkanReplay :
+        C.Cxx.ConsoleApplication
+    {
+        protected override void
+        Init()
+        {
+            base.Init();
+
+            this.CreateHeaderCollection("$(packagedir)/source/replay/*.h");
+            var source = this.CreateCxxSourceCollection("$(packagedir)/source/replay/*.cpp");
+            source.AddFiles("$(packagedir)/source/log.cpp");
+            foreach (var renderer in new[] { "captureformat", "devicedispatch", "exception", "layoutcache", "pipelinecompiler", "shaderreflection", "threadpool" })
+            {
+                source.AddFiles("$(packagedir)/source/renderer/" + renderer + ".cpp");
+            }
+
+            if (this.BuildEnvironment.Platform.Includes(Bam.Core.EPlatform.OSX))
+            {
+                this.CompileAndLinkAgainst<MoltenVK.MoltenVK>(source);
+                this.CompileAgainst<VulkanHeaders.VkHeaders>(source);
+            }
+            else
+            {
+                this.CompileAndLinkAgainst<VulkanSDK.Vulkan>(source);
+            }
+
+            // SPIR-V reflection, used by the layout cache
+            this.CompileAndLinkAgainst<SPIRVCross.SPIRVCross>(source);
+
+            source.PrivatePatch(settings =>
+                {
+                    var cxxcompiler = settings as C.ICxxOnlyCompilerSettings;
+                    cxxcompiler.ExceptionHandler = C.Cxx.EExceptionHandler.Asynchronous;
+                    cxxcompiler.LanguageStandard = C.Cxx.ELanguageStandard.Cxx11;
+
+                    var preprocessor = settings as C.ICommonPreprocessorSettings;
+                    preprocessor.IncludePaths.AddUnique(this.CreateTokenizedString("$(packagedir)/source"));
+
+                    switch (settings)
+                    {
+                        case ClangCommon.ICommonCompilerSettings clang_compiler:
+                            clang_compiler.AllWarnings = true;
+                            clang_compiler.ExtraWarnings = true;
+                            clang_compiler.Pedantic = true;
+                            break;
+                        case GccCommon.ICommonCompilerSettings gcc_compiler:
+                            gcc_compiler.AllWarnings = true;
+                            gcc_compiler.ExtraWarnings = true;
+                            gcc_compiler.Pedantic = true;
+                            break;
+                        case VisualCCommon.ICommonCompilerSettings vc_compiler:
+                            vc_compiler.WarningLevel = VisualCCommon.EWarningLevel.Level4;
+                            preprocessor.PreprocessorDefines.Add("NOMINMAX"); // so std::numeric_limits<type>::max() will work
+                            break;
+                    }
+                });
+
+            this.PrivatePatch(settings =>
+            {
+                if (settings is ClangCommon.ICommonLinkerSettings clang_linker)
+                {
+                    clang_linker.RPath.AddUnique(@"@executable_path/../Frameworks");
+                }
+
+                if (settings is GccCommon.ICommonLinkerSettings)
+                {
+                    var linker = settings as C.ICommonLinkerSettings;
+                    linker.Libraries.AddUnique("-lpthread"); // pipeline compiler's thread pool
+                }
+            });
         }
     }
 
@@ -176,6 +306,8 @@ namespace VulkanTriangle
 
             var appAnchor = this.Include<VulkanTriangle>(C.Cxx.GUIApplication.ExecutableKey);
 
+            this.Include<VulkanReplay>(C.Cxx.ConsoleApplication.ExecutableKey);
+
             var app = appAnchor.SourceModule as VulkanTriangle;
             if (this.BuildEnvironment.Configuration != Bam.Core.EConfiguration.Debug &&
                 app.Linker is VisualCCommon.LinkerBase)
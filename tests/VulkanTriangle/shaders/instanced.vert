@@ -0,0 +1,20 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// per vertex
+layout(location = 0) in vec2 inPosition;
+
+// per instance, from location 1 onwards
+layout(location = 1) in vec4 inPlacement; // xy offset, z scale, w rotation in radians
+layout(location = 2) in vec4 inColour;
+
+layout(location = 0) out vec3 fragColour;
+
+void main()
+{
+    float c = cos(inPlacement.w);
+    float s = sin(inPlacement.w);
+    vec2 rotated = vec2(c * inPosition.x - s * inPosition.y, s * inPosition.x + c * inPosition.y);
+    gl_Position = vec4(rotated * inPlacement.z + inPlacement.xy, 0.0, 1.0);
+    fragColour = inColour.rgb;
+}
@@ -1,7 +1,27 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
+// both blocks are bound as dynamic uniform buffers into the renderer's uniform ring
+layout(set = 0, binding = 0) uniform FrameUniforms
+{
+    vec4 time; // x seconds since startup, 0 in pre-recorded command buffers
+} frame;
+
+// must match OBJECTS_PER_BLOCK in the renderer
+layout(set = 0, binding = 1) uniform ObjectUniforms
+{
+    vec4 colour[256];
+} objects;
+
+// per draw
+layout(push_constant) uniform DrawConstants
+{
+    vec4 placement; // xy offset, z scale, w rotation
+    uint object;    // index into objects
+} draw;
+
 layout(location = 0) out vec3 fragColour;
+layout(location = 1) out vec2 fragUV; // read by textured.frag only
 
 vec2 positions[3] = vec2[]
 (
@@ -10,6 +30,13 @@ vec2 positions[3] = vec2[]
     vec2(-0.5, 0.5)
 );
 
+vec2 uvs[3] = vec2[]
+(
+    vec2(0.5, 0.0),
+    vec2(1.0, 1.0),
+    vec2(0.0, 1.0)
+);
+
 vec3 colours[3] = vec3[]
 (
     vec3(1.0, 0.0, 0.0),
@@ -19,6 +46,10 @@ vec3 colours[3] = vec3[]
 
 void main()
 {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColour = colours[gl_VertexIndex];
+    float angle = draw.placement.w + frame.time.x;
+    mat2 rotation = mat2(cos(angle), sin(angle), -sin(angle), cos(angle));
+    vec2 position = draw.placement.xy + draw.placement.z * (rotation * positions[gl_VertexIndex]);
+    gl_Position = vec4(position, 0.0, 1.0);
+    fragColour = colours[gl_VertexIndex] * objects.colour[draw.object].rgb;
+    fragUV = uvs[gl_VertexIndex];
 }
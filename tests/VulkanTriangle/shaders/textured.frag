@@ -0,0 +1,34 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// as shader.frag, so that the same pipeline variants apply
+layout(constant_id = 0) const uint COLOUR_MODE = 0; // 0 vertex colour, 1 luminance, 2 inverted
+layout(constant_id = 1) const bool SATURATE = false;
+layout(constant_id = 2) const float BRIGHTNESS = 1.0;
+
+// sampled through the renderer's immutable sampler
+layout(set = 1, binding = 0) uniform sampler2D tex;
+
+layout(location = 0) in vec3 fragColour;
+layout(location = 1) in vec2 fragUV;
+layout(location = 0) out vec4 outColour;
+
+void main()
+{
+    vec4 texel = texture(tex, fragUV);
+    vec3 colour = fragColour * texel.rgb;
+    if (COLOUR_MODE == 1)
+    {
+        colour = vec3(dot(colour, vec3(0.2126, 0.7152, 0.0722)));
+    }
+    else if (COLOUR_MODE == 2)
+    {
+        colour = vec3(1.0) - colour;
+    }
+    colour *= BRIGHTNESS;
+    if (SATURATE)
+    {
+        colour = clamp(colour, 0.0, 1.0);
+    }
+    outColour = vec4(colour, 1.0);
+}
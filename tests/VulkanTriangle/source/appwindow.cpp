@@ -30,10 +30,16 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "appwindow.h"
 #include "renderer/renderer.h"
 
+AppWindow::AppWindow(
+    const RendererSettings &inSettings)
+    :
+    _settings(inSettings)
+{}
+
 void
 AppWindow::onCreate()
 {
-    this->_renderer.reset(new Renderer(this));
+    this->_renderer.reset(new Renderer(this, this->_settings));
     this->_renderer->init();
 }
 
@@ -56,3 +62,33 @@ AppWindow::renderer() const
 {
     return this->_renderer.get();
 }
+
+ViewportWindow::ViewportWindow(
+    AppWindow *inOwner)
+    :
+    _owner(inOwner)
+{}
+
+ViewportWindow::~ViewportWindow()
+{
+    this->onClose();
+}
+
+void
+ViewportWindow::onCreate()
+{
+    this->_owner->renderer()->add_window(this);
+    this->_drawn = true;
+}
+
+void
+ViewportWindow::onClose()
+{
+    // the owner's renderer is gone if it was closed first
+    auto renderer = this->_owner->renderer();
+    if (this->_drawn && (nullptr != renderer))
+    {
+        renderer->remove_window(this);
+    }
+    this->_drawn = false;
+}
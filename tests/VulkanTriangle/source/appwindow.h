@@ -31,6 +31,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define APPWINDOW_H
 
 #include "windowlibrary/graphicswindow.h"
+#include "renderer/settings.h"
 
 class Renderer;
 
@@ -38,6 +39,9 @@ class AppWindow :
     public WindowLibrary::GraphicsWindow
 {
 public:
+    explicit AppWindow(
+        const RendererSettings &inSettings);
+
     void
     onCreate() override;
 
@@ -51,7 +55,29 @@ public:
     renderer() const;
 
 private:
+    RendererSettings          _settings;
     std::unique_ptr<Renderer> _renderer;
 };
 
+// a further window onto the scene of an AppWindow, drawn by its renderer
+// created after the AppWindow, and destroyed before it
+class ViewportWindow :
+    public WindowLibrary::GraphicsWindow
+{
+public:
+    explicit ViewportWindow(
+        AppWindow *inOwner);
+    ~ViewportWindow();
+
+    void
+    onCreate() override;
+
+    void
+    onClose() override;
+
+private:
+    AppWindow *_owner;
+    bool       _drawn = false;
+};
+
 #endif // APPWINDOW_H
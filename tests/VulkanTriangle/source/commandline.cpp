@@ -0,0 +1,275 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "commandline.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+
+uint32_t
+to_uint32(
+    const std::string &inName,
+    const std::string &inValue)
+{
+    // strtoull accepts leading whitespace and a sign, negating the result, so the value must start with a digit
+    if (inValue.empty() || inValue[0] < '0' || inValue[0] > '9')
+    {
+        throw std::runtime_error("Option --" + inName + " requires an unsigned integer value, not '" + inValue + "'");
+    }
+    char *end = nullptr;
+    errno = 0;
+    const auto value = std::strtoull(inValue.c_str(), &end, 10);
+    if ('\0' != *end)
+    {
+        throw std::runtime_error("Option --" + inName + " requires an unsigned integer value, not '" + inValue + "'");
+    }
+    if (ERANGE == errno || value > std::numeric_limits<uint32_t>::max())
+    {
+        throw std::runtime_error("Option --" + inName + " value '" + inValue + "' exceeds " + std::to_string(std::numeric_limits<uint32_t>::max()));
+    }
+    return static_cast<uint32_t>(value);
+}
+
+PresentMode
+to_present_mode(
+    const std::string &inName,
+    const std::string &inValue)
+{
+    if ("fifo" == inValue)
+    {
+        return PresentMode::Fifo;
+    }
+    if ("fifo-relaxed" == inValue)
+    {
+        return PresentMode::FifoRelaxed;
+    }
+    if ("mailbox" == inValue)
+    {
+        return PresentMode::Mailbox;
+    }
+    if ("immediate" == inValue)
+    {
+        return PresentMode::Immediate;
+    }
+    throw std::runtime_error("Option --" + inName + " requires one of fifo, fifo-relaxed, mailbox or immediate, not '" + inValue + "'");
+}
+
+} // anonymous namespace
+
+RendererSettings
+parse_command_line(
+    int argc,
+    char *argv[])
+{
+    RendererSettings settings;
+    // argv[0] is the executable
+    for (auto i = 1; i < argc; ++i)
+    {
+        const std::string arg(argv[i]);
+        if (0 == arg.compare(0, 5, "-psn_"))
+        {
+            continue; // process serial number, passed by macOS when launched from the Finder
+        }
+        if (0 != arg.compare(0, 2, "--"))
+        {
+            throw std::runtime_error("Unexpected argument '" + arg + "'");
+        }
+        const auto equals = arg.find('=');
+        const auto name = arg.substr(2, equals - 2);
+        const auto value = (std::string::npos == equals) ? std::string() : arg.substr(equals + 1);
+
+        if ("present-mode" == name)
+        {
+            settings.present_mode = to_present_mode(name, value);
+        }
+        else if ("swapchain-images" == name)
+        {
+            settings.swapchain_images = to_uint32(name, value);
+        }
+        else if ("frames-in-flight" == name)
+        {
+            settings.frames_in_flight = to_uint32(name, value);
+            if (0 == settings.frames_in_flight || settings.frames_in_flight > MAX_FRAMES_IN_FLIGHT)
+            {
+                throw std::runtime_error("Option --" + name + " requires from 1 to " + std::to_string(MAX_FRAMES_IN_FLIGHT) + " frames, not " + value);
+            }
+        }
+        else if ("frame-stats" == name)
+        {
+            settings.frame_stats_interval = to_uint32(name, value);
+        }
+        else if ("dynamic-frames" == name)
+        {
+            settings.dynamic_frames = true;
+        }
+        else if ("record-threads" == name)
+        {
+            settings.recording_threads = to_uint32(name, value);
+        }
+        else if ("draws" == name)
+        {
+            settings.draw_count = to_uint32(name, value);
+        }
+        else if ("scene-chunks" == name)
+        {
+            settings.scene_chunks = to_uint32(name, value);
+        }
+        else if ("dirty-chunks" == name)
+        {
+            settings.dirty_chunks = to_uint32(name, value);
+        }
+        else if ("benchmark-recording" == name)
+        {
+            settings.benchmark_recording = true;
+        }
+        else if ("benchmark-dynamic" == name)
+        {
+            settings.benchmark_dynamic = true;
+        }
+        else if ("instances" == name)
+        {
+            settings.instances = to_uint32(name, value);
+        }
+        else if ("frames" == name)
+        {
+            settings.benchmark_frames = to_uint32(name, value);
+        }
+        else if ("image-processing" == name)
+        {
+            settings.image_processing_size = to_uint32(name, value);
+        }
+        else if ("render-graph" == name)
+        {
+            settings.render_graph = true;
+        }
+        else if ("shader-dir" == name)
+        {
+            if (value.empty())
+            {
+                throw std::runtime_error("Option --" + name + " requires a path");
+            }
+            settings.shader_dir = value;
+        }
+        else if ("shader-cache" == name)
+        {
+            if (value.empty())
+            {
+                throw std::runtime_error("Option --" + name + " requires a path");
+            }
+            settings.shader_cache_dir = value;
+        }
+        else if ("pipeline-threads" == name)
+        {
+            settings.pipeline_threads = to_uint32(name, value);
+        }
+        else if ("pipeline-cache" == name)
+        {
+            if (value.empty())
+            {
+                throw std::runtime_error("Option --" + name + " requires a path");
+            }
+            settings.pipeline_cache_path = value;
+        }
+        else if ("pipeline-variant" == name)
+        {
+            settings.pipeline_variant = value;
+        }
+        else if ("pipeline-variants" == name)
+        {
+            if (value.empty())
+            {
+                throw std::runtime_error("Option --" + name + " requires a path");
+            }
+            settings.pipeline_variant_manifest = value;
+        }
+        else if ("gpu-profile" == name)
+        {
+            if (value.empty())
+            {
+                throw std::runtime_error("Option --" + name + " requires a path");
+            }
+            settings.gpu_profile_path = value;
+        }
+        else if ("host-allocator" == name)
+        {
+            settings.host_allocator = true;
+        }
+        else if ("capability-report" == name)
+        {
+            if (value.empty())
+            {
+                throw std::runtime_error("Option --" + name + " requires a path");
+            }
+            settings.capability_report_path = value;
+        }
+        else if ("capture" == name)
+        {
+            if (value.empty())
+            {
+                throw std::runtime_error("Option --" + name + " requires a path");
+            }
+            settings.capture_path = value;
+        }
+        else if ("capture-frames" == name)
+        {
+            settings.capture_frames = to_uint32(name, value);
+        }
+        else if ("windows" == name)
+        {
+            settings.windows = to_uint32(name, value);
+            if (0 == settings.windows)
+            {
+                throw std::runtime_error("Option --" + name + " requires at least one window");
+            }
+        }
+        else if ("texture" == name)
+        {
+            if (value.empty())
+            {
+                throw std::runtime_error("Option --" + name + " requires a path");
+            }
+            settings.texture_path = value;
+        }
+        else if ("debug-report-rate" == name)
+        {
+            settings.debug_report_rate = to_uint32(name, value);
+        }
+        else
+        {
+            throw std::runtime_error("Unknown option '" + arg + "'");
+        }
+    }
+    return settings;
+}
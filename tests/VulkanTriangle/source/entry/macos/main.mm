@@ -29,10 +29,13 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "renderer/renderer.h"
 #include "appwindow.h"
+#include "commandline.h"
 
 #include "windowlibrary/graphicswindow.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #import <Cocoa/Cocoa.h>
 #import <Metal/Metal.h>
@@ -42,6 +45,24 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /* ---------------------------------------------------------------------- */
 
 std::unique_ptr<AppWindow> metalWindow;
+std::vector<std::unique_ptr<ViewportWindow>> viewportWindows; // further windows onto the same scene
+
+/* ---------------------------------------------------------------------- */
+
+// Vulkan draws to a Metal layer backed view, which fills the window
+static void
+add_metal_view(
+    WindowLibrary::GraphicsWindow *inWindow)
+{
+    auto metal_view = [[NSView alloc] initWithFrame:NSMakeRect(0, 0, inWindow->width(), inWindow->height())];
+    if (![metal_view.layer isKindOfClass:[CAMetalLayer class]])
+    {
+        [metal_view setLayer:[CAMetalLayer layer]];
+        [metal_view setWantsLayer:YES];
+    }
+    [[inWindow->getNativeWindowHandle() contentView] addSubview:metal_view];
+    inWindow->macosSetViewHandle(metal_view);
+}
 
 /* ---------------------------------------------------------------------- */
 
@@ -123,7 +144,15 @@ DisplayLinkCallback(
     (void)flagsIn;
     (void)flagsOut;
     (void)target;
-    metalWindow->renderer()->draw_frame();
+    auto renderer = metalWindow->renderer();
+    renderer->draw_frame();
+    if (renderer->finished())
+    {
+        CVDisplayLinkStop(displayLink);
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [NSApp terminate:nil];
+        });
+    }
     return kCVReturnSuccess;
 }
 
@@ -132,7 +161,9 @@ DisplayLinkCallback(
 /* ---------------------------------------------------------------------- */
 
 int
-main()
+main(
+    int argc,
+    char *argv[])
 {
     NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
 
@@ -153,25 +184,28 @@ main()
     [appMenuItem setSubmenu:appMenu];
 
     /* -- add a Metal view -- */
-    metalWindow.reset(new AppWindow);
+    const auto settings = parse_command_line(argc, argv);
+    metalWindow.reset(new AppWindow(settings));
     metalWindow->init(512, 512, "Vulkan Cube Example");
+    add_metal_view(metalWindow.get());
 
-    auto metal_view = [[NSView alloc] initWithFrame:NSMakeRect(0, 0, metalWindow->width(), metalWindow->height())];
-    if (![metal_view.layer isKindOfClass:[CAMetalLayer class]])
-    {
-        [metal_view setLayer:[CAMetalLayer layer]];
-        [metal_view setWantsLayer:YES];
-    }
-
+    // drives the display link, which draws every window
     auto view_controller = [[MetalViewController alloc] init];
-    view_controller.view = metal_view;
-
-    [[metalWindow->getNativeWindowHandle() contentView] addSubview:metal_view];
-    metalWindow->macosSetViewHandle(metal_view);
+    view_controller.view = metalWindow->macosGetViewHandle();
 
     metalWindow->finalise();
     metalWindow->show();
 
+    for (auto i = 1u; i < settings.windows; ++i)
+    {
+        std::unique_ptr<ViewportWindow> viewport(new ViewportWindow(metalWindow.get()));
+        viewport->init(512, 512, "Vulkan Cube Example " + std::to_string(i + 1));
+        add_metal_view(viewport.get());
+        viewport->finalise();
+        viewport->show();
+        viewportWindows.push_back(std::move(viewport));
+    }
+
     /* -- go... -- */
     [NSApp run];
 
@@ -30,27 +30,33 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "renderer/renderer.h"
 #include "log.h"
 #include "appwindow.h"
+#include "commandline.h"
 
 #ifdef D_BAM_PLATFORM_WINDOWS
 #include <Windows.h>
 #else
+#include <X11/Xlib.h>
 #endif
 
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace
 {
 
 int
 event_loop(
-    Renderer *inRenderer)
+    AppWindow *inWindow,
+    std::vector<std::unique_ptr<ViewportWindow>> &inViewports)
 {
+    auto renderer = inWindow->renderer();
 #if defined(D_BAM_PLATFORM_WINDOWS)
     ::MSG msg;
     auto run = true;
     for (;;)
     {
-        // get all messages
+        // get all messages, of every window
         while (::PeekMessage(&msg, 0, 0, 0, PM_REMOVE) != 0)
         {
             ::TranslateMessage(&msg);
@@ -68,10 +74,64 @@ event_loop(
         }
 
         // after all messages are processed, draw frames
-        inRenderer->draw_frame();
+        renderer->draw_frame();
+        if (renderer->finished())
+        {
+            ::PostQuitMessage(0);
+        }
     }
 
+    (void)inViewports; // closed through their window procedures
     return static_cast<int>(msg.wParam);
+#elif defined(D_BAM_PLATFORM_LINUX)
+    auto display = inWindow->linuxDisplay();
+    const auto deleteMessage = static_cast<long>(inWindow->linuxDeleteWindowMessage());
+    for (;;)
+    {
+        // get all events, without blocking, so that frames are drawn continuously
+        while (::XPending(display) > 0)
+        {
+            ::XEvent event;
+            ::XNextEvent(display, &event);
+            if ((ClientMessage == event.type) && (deleteMessage == event.xclient.data.l[0]))
+            {
+                inWindow->onClose();
+                return 0;
+            }
+        }
+
+        // each window has a display connection of its own
+        for (auto viewport_it = inViewports.begin(); viewport_it != inViewports.end();)
+        {
+            auto viewport = viewport_it->get();
+            auto viewportDisplay = viewport->linuxDisplay();
+            auto closed = false;
+            while (!closed && (::XPending(viewportDisplay) > 0))
+            {
+                ::XEvent event;
+                ::XNextEvent(viewportDisplay, &event);
+                closed = (ClientMessage == event.type) && (static_cast<long>(viewport->linuxDeleteWindowMessage()) == event.xclient.data.l[0]);
+            }
+            if (closed)
+            {
+                viewport->onClose();
+                ::XDestroyWindow(viewportDisplay, viewport->getNativeWindowHandle());
+                viewport_it = inViewports.erase(viewport_it);
+            }
+            else
+            {
+                ++viewport_it;
+            }
+        }
+
+        renderer->draw_frame();
+        if (renderer->finished())
+        {
+            return 0;
+        }
+    }
+#else
+#error Unsupported platform
 #endif
 }
 
@@ -94,12 +154,19 @@ main(
 #ifdef D_BAM_PLATFORM_WINDOWS
     Log::set_path(std::string(__argv[0]) + "\\..\\log.txt");
 #else
-    Log::set_path(std::string(argv[0]) + "/../log.txt");
+    // alongside the executable
+    const std::string executable(argv[0]);
+    Log::set_path(executable.substr(0, executable.find_last_of('/') + 1) + "log.txt");
 #endif
     Log().get() << "Vulkan cube test starting up..." << std::endl;
     try
     {
-        std::unique_ptr<AppWindow> window(new AppWindow);
+#ifdef D_BAM_PLATFORM_WINDOWS
+        const auto settings = parse_command_line(__argc, __argv);
+#else
+        const auto settings = parse_command_line(argc, argv);
+#endif
+        std::unique_ptr<AppWindow> window(new AppWindow(settings));
 #ifdef D_BAM_PLATFORM_WINDOWS
         (void)nCmdShow;
         (void)lpCmdLine;
@@ -111,7 +178,21 @@ main(
 
         window->show();
 
-        const auto result = event_loop(window->renderer());
+        // further windows onto the same scene, drawn by the first window's renderer
+        std::vector<std::unique_ptr<ViewportWindow>> viewports;
+        for (auto i = 1u; i < settings.windows; ++i)
+        {
+            std::unique_ptr<ViewportWindow> viewport(new ViewportWindow(window.get()));
+#ifdef D_BAM_PLATFORM_WINDOWS
+            viewport->win32SetInstanceHandle(hInstance);
+#endif
+            viewport->init(256, 256, "Vulkan Cube " + std::to_string(i + 1));
+            viewport->finalise();
+            viewport->show();
+            viewports.push_back(std::move(viewport));
+        }
+
+        const auto result = event_loop(window.get(), viewports);
         Log().get() << "Vulkan cube test finished successfully" << std::endl;
         return result;
     }
@@ -40,20 +40,22 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 std::string   Log::_filelog_path;
 std::ofstream Log::_filelog;
+std::mutex    Log::_mutex;
 
 Log::~Log()
 {
     auto message = this->_stream.str();
+    std::lock_guard<std::mutex> lock(_mutex);
 #ifdef D_BAM_PLATFORM_WINDOWS
     OutputDebugString(message.c_str());
 #else
     std::cout << message;
 #endif
-    _filelog.open(_filelog_path.c_str(), std::ios_base::out | std::ios_base::app);
-    if (_filelog)
+    // kept open from set_path, and flushed per message rather than reopened, so that nothing is lost on a crash
+    if (_filelog.is_open())
     {
         _filelog << message;
-        _filelog.close();
+        _filelog.flush();
     }
 }
 
@@ -61,13 +63,17 @@ void
 Log::set_path(
     const std::string &inPath)
 {
+    std::lock_guard<std::mutex> lock(_mutex);
     _filelog_path = inPath;
+    if (_filelog.is_open())
+    {
+        _filelog.close();
+    }
     _filelog.open(_filelog_path.c_str(), std::ios_base::out);
     if (!_filelog)
     {
         throw std::runtime_error("Unable to open log file");
     }
-    _filelog.close();
 }
 
 std::ostringstream &Log::get()
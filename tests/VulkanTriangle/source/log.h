@@ -30,9 +30,11 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef LOG_H
 #define LOG_H
 
+#include <mutex>
 #include <string>
 #include <sstream>
 
+// a message, written when the Log is destroyed; may be used from any thread, as whole messages are written under a lock
 class Log
 {
 public:
@@ -48,6 +50,7 @@ public:
 private:
     static std::string   _filelog_path;
     static std::ofstream _filelog;
+    static std::mutex    _mutex; // of the console and the file, so that messages from different threads do not interleave
     std::ostringstream _stream;
 };
 
@@ -0,0 +1,181 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "benchmark.h"
+#include "log.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+
+namespace
+{
+
+// nearest rank, of samples already sorted
+double
+percentile(
+    const std::vector<double> &inSorted,
+    const double inPercent)
+{
+    const auto rank = static_cast<size_t>(inPercent / 100.0 * (inSorted.size() - 1) + 0.5);
+    return inSorted[std::min(rank, inSorted.size() - 1)];
+}
+
+} // anonymous namespace
+
+Benchmark::Benchmark(
+    const std::string &inTitle,
+    const uint32_t inWarmupFrames,
+    const uint32_t inMeasuredFrames,
+    const std::string &inUnits)
+    :
+    _title(inTitle),
+    _units(inUnits),
+    _warmup_frames(inWarmupFrames),
+    _measured_frames(inMeasuredFrames)
+{}
+
+void
+Benchmark::add_case(
+    const std::string &inName,
+    const uint64_t inWorkUnits,
+    std::function<void()> inConfigure)
+{
+    Case new_case;
+    new_case.name = inName;
+    new_case.work_units = inWorkUnits;
+    new_case.configure = std::move(inConfigure);
+    new_case.samples.reserve(this->_measured_frames);
+    this->_cases.push_back(std::move(new_case));
+}
+
+bool
+Benchmark::begin_frame()
+{
+    if (this->finished())
+    {
+        return false;
+    }
+    if (0 == this->_current_frame)
+    {
+        const auto &current = this->_cases[this->_current_case];
+        Log().get() << "Benchmark '" << this->_title << "': running " << current.name << std::endl;
+        current.configure();
+    }
+    if (this->_current_frame == this->_warmup_frames)
+    {
+        this->_cases[this->_current_case].measure_start = Clock::now();
+    }
+    return true;
+}
+
+void
+Benchmark::end_frame(
+    const double inCpuMilliseconds)
+{
+    auto &current = this->_cases[this->_current_case];
+    if (this->_current_frame >= this->_warmup_frames)
+    {
+        current.samples.push_back(inCpuMilliseconds);
+    }
+    if (++this->_current_frame == this->_warmup_frames + this->_measured_frames)
+    {
+        current.measure_end = Clock::now();
+        this->_current_frame = 0;
+        if (++this->_current_case == this->_cases.size())
+        {
+            this->report();
+        }
+    }
+}
+
+void
+Benchmark::add_gpu_sample(
+    const double inGpuMilliseconds)
+{
+    if (this->finished() || this->_current_frame <= this->_warmup_frames)
+    {
+        return;
+    }
+    this->_cases[this->_current_case].gpu_samples.push_back(inGpuMilliseconds);
+}
+
+bool
+Benchmark::finished() const
+{
+    return this->_current_case >= this->_cases.size();
+}
+
+void
+Benchmark::report() const
+{
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## Benchmark '" << this->_title << "' (" << this->_measured_frames << " frames per case, after " << this->_warmup_frames << " warm up frames)" << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    for (const auto &current : this->_cases)
+    {
+        if (current.samples.empty())
+        {
+            continue;
+        }
+        auto sorted = current.samples;
+        std::sort(sorted.begin(), sorted.end());
+        const auto total = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+        const auto mean = total / sorted.size();
+        const std::chrono::duration<double> wall_time = current.measure_end - current.measure_start;
+        // the wall time runs from the start of the first measured frame to the end of the last, so spans every sample
+        const auto frames_per_second = (wall_time.count() > 0) ? sorted.size() / wall_time.count() : 0.0;
+        Log().get()
+            << std::fixed << std::setprecision(3)
+            << current.name
+            << ": CPU mean " << mean << " ms"
+            << ", p50 " << percentile(sorted, 50) << " ms"
+            << ", p95 " << percentile(sorted, 95) << " ms"
+            << ", p99 " << percentile(sorted, 99) << " ms"
+            << ", min " << sorted.front() << " ms"
+            << ", max " << sorted.back() << " ms"
+            << ", " << std::setprecision(1) << (current.work_units / mean) << " " << this->_units << "/CPU ms"
+            << ", " << std::setprecision(0) << (current.work_units * frames_per_second) << " " << this->_units << "/s"
+            << std::endl;
+        if (!current.gpu_samples.empty())
+        {
+            auto gpu_sorted = current.gpu_samples;
+            std::sort(gpu_sorted.begin(), gpu_sorted.end());
+            Log().get()
+                << std::fixed << std::setprecision(3)
+                << current.name
+                << ": GPU p50 " << percentile(gpu_sorted, 50) << " ms"
+                << ", p95 " << percentile(gpu_sorted, 95) << " ms"
+                << ", p99 " << percentile(gpu_sorted, 99) << " ms"
+                << ", max " << gpu_sorted.back() << " ms"
+                << " (" << gpu_sorted.size() << " frames resolved)"
+                << std::endl;
+        }
+    }
+}
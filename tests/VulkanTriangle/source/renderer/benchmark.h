@@ -0,0 +1,105 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_BENCHMARK_H
+#define VULKAN_RENDERER_BENCHMARK_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// steps the renderer through a series of configurations, each run for a number of
+// warm up frames and then a number of measured frames, and logs a summary once
+// every case has been measured
+// throughput is reported against both the CPU time of each frame and the wall clock time of the case
+class Benchmark
+{
+public:
+    Benchmark(
+        const std::string &inTitle,
+        const uint32_t inWarmupFrames,
+        const uint32_t inMeasuredFrames,
+        const std::string &inUnits);
+
+    // inWorkUnits is the amount of work done per frame, in the benchmark's units, used to report throughput
+    // inConfigure is invoked between frames, before the first frame of the case
+    void
+    add_case(
+        const std::string &inName,
+        const uint64_t inWorkUnits,
+        std::function<void()> inConfigure);
+
+    // call before recording a frame
+    // returns false if all cases have completed, and no frame should be drawn
+    bool
+    begin_frame();
+
+    // call once the frame has been submitted, with the CPU time measured for it
+    void
+    end_frame(
+        const double inCpuMilliseconds);
+
+    // GPU time of a frame of the current case; GPU timings arrive frames late, and are dropped
+    // during warm up
+    void
+    add_gpu_sample(
+        const double inGpuMilliseconds);
+
+    bool
+    finished() const;
+
+private:
+    typedef std::chrono::high_resolution_clock Clock;
+
+    void
+    report() const;
+
+    struct Case
+    {
+        std::string           name;
+        uint64_t              work_units;
+        std::function<void()> configure;
+        std::vector<double>   samples;
+        std::vector<double>   gpu_samples;
+        Clock::time_point     measure_start;
+        Clock::time_point     measure_end;
+    };
+
+    std::string       _title;
+    std::string       _units;
+    uint32_t          _warmup_frames;
+    uint32_t          _measured_frames;
+    std::vector<Case> _cases;
+    size_t            _current_case = 0;
+    uint32_t          _current_frame = 0;
+};
+
+#endif // VULKAN_RENDERER_BENCHMARK_H
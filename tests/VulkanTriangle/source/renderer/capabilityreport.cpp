@@ -0,0 +1,587 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "capabilityreport.h"
+#include "impl.h"
+#include "exception.h"
+#include "log.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+
+// minimal streaming JSON writer, placing each member and element on its own indented line
+class JsonWriter
+{
+public:
+    JsonWriter &
+    begin_object(
+        const char *inKey = nullptr)
+    {
+        this->open(inKey, '{', '}');
+        return *this;
+    }
+
+    JsonWriter &
+    begin_array(
+        const char *inKey = nullptr)
+    {
+        this->open(inKey, '[', ']');
+        return *this;
+    }
+
+    // closes the innermost object or array
+    JsonWriter &
+    end()
+    {
+        const bool empty = this->_first.back();
+        this->_first.pop_back();
+        if (!empty)
+        {
+            this->newline();
+        }
+        this->_stream << this->_closers.back();
+        this->_closers.pop_back();
+        return *this;
+    }
+
+    // inKey is nullptr for array elements
+    JsonWriter &
+    value(
+        const char *inKey,
+        const std::string &inValue)
+    {
+        this->prefix(inKey);
+        this->string(inValue);
+        return *this;
+    }
+
+    JsonWriter &
+    value(
+        const char *inKey,
+        const char *inValue)
+    {
+        return this->value(inKey, std::string(inValue));
+    }
+
+    JsonWriter &
+    value(
+        const char *inKey,
+        const uint64_t inValue)
+    {
+        this->prefix(inKey);
+        this->_stream << inValue;
+        return *this;
+    }
+
+    JsonWriter &
+    value(
+        const char *inKey,
+        const double inValue)
+    {
+        this->prefix(inKey);
+        this->_stream << inValue;
+        return *this;
+    }
+
+    JsonWriter &
+    boolean(
+        const char *inKey,
+        const bool inValue)
+    {
+        this->prefix(inKey);
+        this->_stream << (inValue ? "true" : "false");
+        return *this;
+    }
+
+    std::string
+    str() const
+    {
+        return this->_stream.str();
+    }
+
+private:
+    void
+    open(
+        const char *inKey,
+        const char inOpener,
+        const char inCloser)
+    {
+        this->prefix(inKey);
+        this->_stream << inOpener;
+        this->_first.push_back(true);
+        this->_closers.push_back(inCloser);
+    }
+
+    void
+    prefix(
+        const char *inKey)
+    {
+        if (!this->_first.empty())
+        {
+            if (!this->_first.back())
+            {
+                this->_stream << ",";
+            }
+            this->_first.back() = false;
+            this->newline();
+        }
+        if (nullptr != inKey)
+        {
+            this->string(inKey);
+            this->_stream << ": ";
+        }
+    }
+
+    void
+    newline()
+    {
+        this->_stream << "\n" << std::string(2 * this->_first.size(), ' ');
+    }
+
+    void
+    string(
+        const std::string &inValue)
+    {
+        this->_stream << '"';
+        for (const auto c : inValue)
+        {
+            switch (c)
+            {
+            case '"':
+                this->_stream << "\\\"";
+                break;
+            case '\\':
+                this->_stream << "\\\\";
+                break;
+            case '\n':
+                this->_stream << "\\n";
+                break;
+            case '\t':
+                this->_stream << "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    this->_stream << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+                }
+                else
+                {
+                    this->_stream << c;
+                }
+                break;
+            }
+        }
+        this->_stream << '"';
+    }
+
+    std::ostringstream  _stream;
+    std::vector<bool>   _first;   // per open object or array, whether nothing has been written to it yet
+    std::vector<char>   _closers;
+};
+
+struct FlagName
+{
+    ::VkFlags   bit;
+    const char *name;
+};
+
+#define FLAG_NAME(_flag) { _flag, #_flag }
+
+const FlagName memory_property_names[] =
+{
+    FLAG_NAME(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+    FLAG_NAME(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT),
+    FLAG_NAME(VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
+    FLAG_NAME(VK_MEMORY_PROPERTY_HOST_CACHED_BIT),
+    FLAG_NAME(VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+};
+
+const FlagName memory_heap_names[] =
+{
+    FLAG_NAME(VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+};
+
+const FlagName queue_names[] =
+{
+    FLAG_NAME(VK_QUEUE_GRAPHICS_BIT),
+    FLAG_NAME(VK_QUEUE_COMPUTE_BIT),
+    FLAG_NAME(VK_QUEUE_TRANSFER_BIT),
+    FLAG_NAME(VK_QUEUE_SPARSE_BINDING_BIT)
+};
+
+#undef FLAG_NAME
+
+// as an array of names, with any bits unknown to us as a single hexadecimal string
+template <size_t N>
+void
+write_flags(
+    JsonWriter &inWriter,
+    const char *inKey,
+    ::VkFlags inFlags,
+    const FlagName (&inNames)[N])
+{
+    inWriter.begin_array(inKey);
+    for (const auto &flag : inNames)
+    {
+        if (inFlags & flag.bit)
+        {
+            inWriter.value(nullptr, flag.name);
+            inFlags &= ~flag.bit;
+        }
+    }
+    if (0 != inFlags)
+    {
+        std::ostringstream unknown;
+        unknown << "0x" << std::hex << inFlags;
+        inWriter.value(nullptr, unknown.str());
+    }
+    inWriter.end();
+}
+
+std::string
+version_string(
+    const uint32_t inVersion)
+{
+    std::ostringstream stream;
+    stream << VK_VERSION_MAJOR(inVersion) << "." << VK_VERSION_MINOR(inVersion) << "." << VK_VERSION_PATCH(inVersion);
+    return stream.str();
+}
+
+const char *
+device_type_name(
+    const ::VkPhysicalDeviceType inType)
+{
+    switch (inType)
+    {
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+        return "integrated";
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+        return "discrete";
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+        return "virtual";
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:
+        return "cpu";
+    default:
+        return "other";
+    }
+}
+
+void
+write_extensions(
+    JsonWriter &inWriter,
+    const std::vector<::VkExtensionProperties> &inExtensions)
+{
+    inWriter.begin_array("extensions");
+    for (const auto &extension : inExtensions)
+    {
+        inWriter.begin_object()
+            .value("name", extension.extensionName)
+            .value("spec_version", static_cast<uint64_t>(extension.specVersion))
+            .end();
+    }
+    inWriter.end();
+}
+
+void
+write_layers(
+    JsonWriter &inWriter,
+    const std::vector<::VkLayerProperties> &inLayers)
+{
+    inWriter.begin_array("layers");
+    for (const auto &layer : inLayers)
+    {
+        inWriter.begin_object()
+            .value("name", layer.layerName)
+            .value("description", layer.description)
+            .value("spec_version", version_string(layer.specVersion))
+            .value("implementation_version", static_cast<uint64_t>(layer.implementationVersion))
+            .end();
+    }
+    inWriter.end();
+}
+
+} // anonymous namespace
+
+CapabilityReport::CapabilityReport(
+    ::VkInstance inInstance,
+    const std::vector<::VkPhysicalDevice> &inPhysicalDevices,
+    const size_t inSelectedDevice)
+    :
+    _instance(inInstance),
+    _physical_devices(inPhysicalDevices),
+    _selected_device(inSelectedDevice)
+{}
+
+const std::string &
+CapabilityReport::json()
+{
+    if (this->_json.empty())
+    {
+        this->_json = this->build();
+    }
+    return this->_json;
+}
+
+void
+CapabilityReport::write(
+    const std::string &inPath)
+{
+    std::ofstream file(inPath, std::ios::out | std::ios::trunc);
+    if (!file)
+    {
+        throw Exception("Unable to open capability report '" + inPath + "' for writing");
+    }
+    file << this->json() << std::endl;
+    if (!file)
+    {
+        throw Exception("Unable to write capability report '" + inPath + "'");
+    }
+    Log().get() << "Wrote capability report to " << inPath << std::endl;
+}
+
+std::string
+CapabilityReport::build() const
+{
+    auto instance = this->_instance;
+    JsonWriter writer;
+    writer.begin_object();
+
+    writer.begin_object("instance");
+    {
+        auto enumExtensionsFn = GETFN(vkEnumerateInstanceExtensionProperties);
+        uint32_t numExtensions = 0;
+        VK_ERR_CHECK_QUIET(enumExtensionsFn(nullptr, &numExtensions, nullptr));
+        std::vector<::VkExtensionProperties> extensions(numExtensions);
+        VK_ERR_CHECK_QUIET(enumExtensionsFn(nullptr, &numExtensions, extensions.data()));
+        write_extensions(writer, extensions);
+
+        auto enumLayersFn = GETFN(vkEnumerateInstanceLayerProperties);
+        uint32_t numLayers = 0;
+        VK_ERR_CHECK_QUIET(enumLayersFn(&numLayers, nullptr));
+        std::vector<::VkLayerProperties> layers(numLayers);
+        VK_ERR_CHECK_QUIET(enumLayersFn(&numLayers, layers.data()));
+        write_layers(writer, layers);
+    }
+    writer.end();
+
+    auto getPropertiesFn = GETIFN(instance, vkGetPhysicalDeviceProperties);
+    auto getMemoryPropertiesFn = GETIFN(instance, vkGetPhysicalDeviceMemoryProperties);
+    auto getFeaturesFn = GETIFN(instance, vkGetPhysicalDeviceFeatures);
+    auto getQueueFamilyPropertiesFn = GETIFN(instance, vkGetPhysicalDeviceQueueFamilyProperties);
+    auto enumDeviceExtensionsFn = GETIFN(instance, vkEnumerateDeviceExtensionProperties);
+    auto enumDeviceLayersFn = GETIFN(instance, vkEnumerateDeviceLayerProperties);
+
+    writer.begin_array("physical_devices");
+    for (auto index = 0u; index < this->_physical_devices.size(); ++index)
+    {
+        auto device = this->_physical_devices[index];
+        writer.begin_object();
+        writer.value("index", static_cast<uint64_t>(index));
+        writer.boolean("selected", index == this->_selected_device);
+
+        ::VkPhysicalDeviceProperties props;
+        getPropertiesFn(device, &props);
+        std::ostringstream uuid;
+        for (const auto byte : props.pipelineCacheUUID)
+        {
+            uuid << std::hex << std::setw(2) << std::setfill('0') << static_cast<uint32_t>(byte);
+        }
+        writer.begin_object("properties")
+            .value("device_name", props.deviceName)
+            .value("device_type", device_type_name(props.deviceType))
+            .value("api_version", version_string(props.apiVersion))
+            .value("driver_version", static_cast<uint64_t>(props.driverVersion))
+            .value("vendor_id", static_cast<uint64_t>(props.vendorID))
+            .value("device_id", static_cast<uint64_t>(props.deviceID))
+            .value("pipeline_cache_uuid", uuid.str())
+            .end();
+
+        // the limits that the renderer, or a reader choosing between devices, is most likely to care about
+        const auto &limits = props.limits;
+        writer.begin_object("limits")
+            .value("max_image_dimension_2d", static_cast<uint64_t>(limits.maxImageDimension2D))
+            .value("max_framebuffer_width", static_cast<uint64_t>(limits.maxFramebufferWidth))
+            .value("max_framebuffer_height", static_cast<uint64_t>(limits.maxFramebufferHeight))
+            .value("max_color_attachments", static_cast<uint64_t>(limits.maxColorAttachments))
+            .value("max_push_constants_size", static_cast<uint64_t>(limits.maxPushConstantsSize))
+            .value("max_bound_descriptor_sets", static_cast<uint64_t>(limits.maxBoundDescriptorSets))
+            .value("max_uniform_buffer_range", static_cast<uint64_t>(limits.maxUniformBufferRange))
+            .value("max_descriptor_set_uniform_buffers_dynamic", static_cast<uint64_t>(limits.maxDescriptorSetUniformBuffersDynamic))
+            .value("max_vertex_input_attributes", static_cast<uint64_t>(limits.maxVertexInputAttributes))
+            .value("max_vertex_input_bindings", static_cast<uint64_t>(limits.maxVertexInputBindings))
+            .value("max_memory_allocation_count", static_cast<uint64_t>(limits.maxMemoryAllocationCount))
+            .value("max_compute_work_group_invocations", static_cast<uint64_t>(limits.maxComputeWorkGroupInvocations));
+        writer.begin_array("max_compute_work_group_size");
+        for (const auto size : limits.maxComputeWorkGroupSize)
+        {
+            writer.value(nullptr, static_cast<uint64_t>(size));
+        }
+        writer.end();
+        writer.value("buffer_image_granularity", static_cast<uint64_t>(limits.bufferImageGranularity))
+            .value("min_uniform_buffer_offset_alignment", static_cast<uint64_t>(limits.minUniformBufferOffsetAlignment))
+            .value("min_storage_buffer_offset_alignment", static_cast<uint64_t>(limits.minStorageBufferOffsetAlignment))
+            .value("optimal_buffer_copy_offset_alignment", static_cast<uint64_t>(limits.optimalBufferCopyOffsetAlignment))
+            .value("optimal_buffer_copy_row_pitch_alignment", static_cast<uint64_t>(limits.optimalBufferCopyRowPitchAlignment))
+            .value("non_coherent_atom_size", static_cast<uint64_t>(limits.nonCoherentAtomSize))
+            .value("timestamp_period", static_cast<double>(limits.timestampPeriod))
+            .boolean("timestamp_compute_and_graphics", VK_TRUE == limits.timestampComputeAndGraphics)
+            .end();
+
+        ::VkPhysicalDeviceMemoryProperties memProps;
+        getMemoryPropertiesFn(device, &memProps);
+        writer.begin_object("memory");
+        writer.begin_array("heaps");
+        for (auto i = 0u; i < memProps.memoryHeapCount; ++i)
+        {
+            writer.begin_object();
+            writer.value("size", static_cast<uint64_t>(memProps.memoryHeaps[i].size));
+            write_flags(writer, "flags", memProps.memoryHeaps[i].flags, memory_heap_names);
+            writer.end();
+        }
+        writer.end();
+        writer.begin_array("types");
+        for (auto i = 0u; i < memProps.memoryTypeCount; ++i)
+        {
+            writer.begin_object();
+            writer.value("heap_index", static_cast<uint64_t>(memProps.memoryTypes[i].heapIndex));
+            write_flags(writer, "properties", memProps.memoryTypes[i].propertyFlags, memory_property_names);
+            writer.end();
+        }
+        writer.end();
+        writer.end();
+
+        ::VkPhysicalDeviceFeatures features;
+        getFeaturesFn(device, &features);
+        writer.begin_object("features");
+
+#define WRITE_FEATURE(_feature) writer.boolean(#_feature, VK_TRUE == features._feature)
+
+        WRITE_FEATURE(alphaToOne);
+        WRITE_FEATURE(depthBiasClamp);
+        WRITE_FEATURE(depthBounds);
+        WRITE_FEATURE(depthClamp);
+        WRITE_FEATURE(drawIndirectFirstInstance);
+        WRITE_FEATURE(dualSrcBlend);
+        WRITE_FEATURE(fillModeNonSolid);
+        WRITE_FEATURE(fragmentStoresAndAtomics);
+        WRITE_FEATURE(fullDrawIndexUint32);
+        WRITE_FEATURE(geometryShader);
+        WRITE_FEATURE(imageCubeArray);
+        WRITE_FEATURE(independentBlend);
+        WRITE_FEATURE(inheritedQueries);
+        WRITE_FEATURE(largePoints);
+        WRITE_FEATURE(logicOp);
+        WRITE_FEATURE(multiDrawIndirect);
+        WRITE_FEATURE(multiViewport);
+        WRITE_FEATURE(occlusionQueryPrecise);
+        WRITE_FEATURE(pipelineStatisticsQuery);
+        WRITE_FEATURE(robustBufferAccess);
+        WRITE_FEATURE(samplerAnisotropy);
+        WRITE_FEATURE(sampleRateShading);
+        WRITE_FEATURE(shaderClipDistance);
+        WRITE_FEATURE(shaderCullDistance);
+        WRITE_FEATURE(shaderFloat64);
+        WRITE_FEATURE(shaderImageGatherExtended);
+        WRITE_FEATURE(shaderInt16);
+        WRITE_FEATURE(shaderInt64);
+        WRITE_FEATURE(shaderResourceMinLod);
+        WRITE_FEATURE(shaderResourceResidency);
+        WRITE_FEATURE(shaderSampledImageArrayDynamicIndexing);
+        WRITE_FEATURE(shaderStorageBufferArrayDynamicIndexing);
+        WRITE_FEATURE(shaderStorageImageArrayDynamicIndexing);
+        WRITE_FEATURE(shaderStorageImageExtendedFormats);
+        WRITE_FEATURE(shaderStorageImageMultisample);
+        WRITE_FEATURE(shaderStorageImageReadWithoutFormat);
+        WRITE_FEATURE(shaderStorageImageWriteWithoutFormat);
+        WRITE_FEATURE(shaderTessellationAndGeometryPointSize);
+        WRITE_FEATURE(shaderUniformBufferArrayDynamicIndexing);
+        WRITE_FEATURE(sparseBinding);
+        WRITE_FEATURE(sparseResidency16Samples);
+        WRITE_FEATURE(sparseResidency2Samples);
+        WRITE_FEATURE(sparseResidency4Samples);
+        WRITE_FEATURE(sparseResidency8Samples);
+        WRITE_FEATURE(sparseResidencyAliased);
+        WRITE_FEATURE(sparseResidencyBuffer);
+        WRITE_FEATURE(sparseResidencyImage2D);
+        WRITE_FEATURE(sparseResidencyImage3D);
+        WRITE_FEATURE(tessellationShader);
+        WRITE_FEATURE(textureCompressionASTC_LDR);
+        WRITE_FEATURE(textureCompressionBC);
+        WRITE_FEATURE(textureCompressionETC2);
+        WRITE_FEATURE(variableMultisampleRate);
+        WRITE_FEATURE(vertexPipelineStoresAndAtomics);
+        WRITE_FEATURE(wideLines);
+
+#undef WRITE_FEATURE
+
+        writer.end();
+
+        uint32_t numQueueFamilies = 0;
+        getQueueFamilyPropertiesFn(device, &numQueueFamilies, nullptr);
+        std::vector<::VkQueueFamilyProperties> queueFamilies(numQueueFamilies);
+        getQueueFamilyPropertiesFn(device, &numQueueFamilies, queueFamilies.data());
+        writer.begin_array("queue_families");
+        for (const auto &family : queueFamilies)
+        {
+            writer.begin_object();
+            write_flags(writer, "flags", family.queueFlags, queue_names);
+            writer.value("count", static_cast<uint64_t>(family.queueCount));
+            writer.value("timestamp_valid_bits", static_cast<uint64_t>(family.timestampValidBits));
+            writer.begin_array("min_image_transfer_granularity")
+                .value(nullptr, static_cast<uint64_t>(family.minImageTransferGranularity.width))
+                .value(nullptr, static_cast<uint64_t>(family.minImageTransferGranularity.height))
+                .value(nullptr, static_cast<uint64_t>(family.minImageTransferGranularity.depth))
+                .end();
+            writer.end();
+        }
+        writer.end();
+
+        uint32_t numExtensions = 0;
+        VK_ERR_CHECK_QUIET(enumDeviceExtensionsFn(device, nullptr, &numExtensions, nullptr));
+        std::vector<::VkExtensionProperties> extensions(numExtensions);
+        VK_ERR_CHECK_QUIET(enumDeviceExtensionsFn(device, nullptr, &numExtensions, extensions.data()));
+        write_extensions(writer, extensions);
+
+        uint32_t numLayers = 0;
+        VK_ERR_CHECK_QUIET(enumDeviceLayersFn(device, &numLayers, nullptr));
+        std::vector<::VkLayerProperties> layers(numLayers);
+        VK_ERR_CHECK_QUIET(enumDeviceLayersFn(device, &numLayers, layers.data()));
+        write_layers(writer, layers);
+
+        writer.end();
+    }
+    writer.end();
+
+    writer.end();
+    return writer.str();
+}
@@ -0,0 +1,68 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_CAPABILITYREPORT_H
+#define VULKAN_RENDERER_CAPABILITYREPORT_H
+
+#include "vulkan/vulkan.h"
+
+#include <string>
+#include <vector>
+
+// JSON description of the instance's extensions and layers, and of every physical device's properties, limits,
+// memory heaps and types, features, queue families, extensions and layers
+// nothing is queried until the report is first requested, and the result is kept for later requests, as startup
+// only queries what it uses
+class CapabilityReport
+{
+public:
+    CapabilityReport(
+        ::VkInstance inInstance,
+        const std::vector<::VkPhysicalDevice> &inPhysicalDevices,
+        const size_t inSelectedDevice);
+
+    const std::string &
+    json();
+
+    // writes the report to inPath, throwing if it cannot be written
+    void
+    write(
+        const std::string &inPath);
+
+private:
+    std::string
+    build() const;
+
+    ::VkInstance                      _instance;
+    std::vector<::VkPhysicalDevice>   _physical_devices;
+    size_t                            _selected_device;
+    std::string                       _json; // empty until first requested
+};
+
+#endif // VULKAN_RENDERER_CAPABILITYREPORT_H
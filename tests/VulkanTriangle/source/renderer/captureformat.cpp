@@ -0,0 +1,105 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "captureformat.h"
+#include "exception.h"
+
+void
+CaptureWriter::u32(
+    const uint32_t inValue)
+{
+    this->bytes(&inValue, sizeof(inValue));
+}
+
+void
+CaptureWriter::u64(
+    const uint64_t inValue)
+{
+    this->bytes(&inValue, sizeof(inValue));
+}
+
+void
+CaptureWriter::bytes(
+    const void *inData,
+    const size_t inSize)
+{
+    const auto *data = static_cast<const char *>(inData);
+    this->_data.insert(this->_data.end(), data, data + inSize);
+}
+
+const std::vector<char> &
+CaptureWriter::data() const
+{
+    return this->_data;
+}
+
+void
+CaptureWriter::clear()
+{
+    this->_data.clear();
+}
+
+CaptureReader::CaptureReader(
+    const char *inData,
+    const size_t inSize)
+    :
+    _data(inData),
+    _size(inSize)
+{}
+
+uint32_t
+CaptureReader::u32()
+{
+    return this->raw<uint32_t>();
+}
+
+uint64_t
+CaptureReader::u64()
+{
+    return this->raw<uint64_t>();
+}
+
+const char *
+CaptureReader::bytes(
+    const size_t inSize)
+{
+    if (inSize > this->_size - this->_offset)
+    {
+        throw Exception("Capture is truncated, reading " + std::to_string(inSize) + " bytes at offset " + std::to_string(this->_offset) + " of " + std::to_string(this->_size));
+    }
+    const auto *data = this->_data + this->_offset;
+    this->_offset += inSize;
+    return data;
+}
+
+bool
+CaptureReader::at_end() const
+{
+    return this->_offset == this->_size;
+}
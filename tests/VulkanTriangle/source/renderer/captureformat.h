@@ -0,0 +1,203 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_CAPTUREFORMAT_H
+#define VULKAN_RENDERER_CAPTUREFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// the binary file written by FrameCapture, and read by VulkanReplay
+// a CaptureHeader, then records in the order in which they happened, each a CaptureRecord type, the byte size of
+// its payload, then the payload; integers are in host byte order, as the file is replayed on the same platform
+// objects are identified by their handle values in the capturing process, and the replayer maps each to the object
+// it creates from the identifier's latest record, as a handle value may be reused once its object is destroyed
+//
+// payloads, where id is a u64 object identifier, and arrays are a u32 count then the elements:
+//   ShaderModule    id, u32 stage, u32[] SPIR-V
+//   RenderPass      id, VkAttachmentDescription of its single colour attachment
+//   Framebuffer     id, render pass id, u32 width, u32 height
+//   PipelineLayout  id, bindings[] of each set, VkPushConstantRange[]
+//                   where bindings are u32 binding, u32 type, u32 count, u32 stages
+//   Pipeline        id, vertex shader id, fragment shader id, VkVertexInputBindingDescription[],
+//                   VkVertexInputAttributeDescription[], u32 topology, u32 cull mode, u32 front face, layout id,
+//                   render pass id, u32 subpass, (u32 constant id, u32 offset, u32 size)[] specialisation entries,
+//                   u32[] specialisation data
+//   Buffer          id, u64 size, u32 usage, u32 has contents, then size bytes of contents if it has
+//   BufferData      id, u64 offset, u64 size, then size bytes written by the host at that offset
+//   DescriptorSet   id, bindings[] of its layout, (u32 binding, u32 type, buffer id, u64 offset, u64 range)[]
+//   Frame           u32 byte size of its commands, then the commands, each a CaptureCommand then its arguments
+//
+// command arguments; secondary command buffers are inlined where they were executed:
+//   BeginRenderPass     render pass id, framebuffer id, VkRect2D render area, VkClearValue[]
+//   EndRenderPass
+//   BindPipeline        pipeline id, of a graphics pipeline
+//   SetViewport         VkViewport
+//   SetScissor          VkRect2D
+//   BindDescriptorSets  layout id, u32 first set, id[] sets, u32[] dynamic offsets
+//   PushConstants       layout id, u32 stages, u32 offset, u32 size, then size bytes
+//   BindVertexBuffers   u32 first binding, (buffer id, u64 offset)[]
+//   BindIndexBuffer     buffer id, u64 offset, u32 index type
+//   Draw                u32 vertex count, u32 instance count, u32 first vertex, u32 first instance
+//   DrawIndexed         u32 index count, u32 instance count, u32 first index, i32 vertex offset, u32 first instance
+
+const uint32_t CAPTURE_MAGIC = 0x43544b56; // "VKTC"
+const uint32_t CAPTURE_VERSION = 1;
+
+struct CaptureHeader
+{
+    uint32_t magic = CAPTURE_MAGIC;
+    uint32_t version = CAPTURE_VERSION;
+    uint32_t frames_in_flight = 0; // of the capturing renderer, whose per-frame host writes do not overlap across this many frames
+    uint32_t frame_count = 0;
+};
+
+enum class CaptureRecord : uint32_t
+{
+    ShaderModule = 1,
+    RenderPass,
+    Framebuffer,
+    PipelineLayout,
+    Pipeline,
+    Buffer,
+    BufferData,
+    DescriptorSet,
+    Frame
+};
+
+enum class CaptureCommand : uint32_t
+{
+    BeginRenderPass = 1,
+    EndRenderPass,
+    BindPipeline,
+    SetViewport,
+    SetScissor,
+    BindDescriptorSets,
+    PushConstants,
+    BindVertexBuffers,
+    BindIndexBuffer,
+    Draw,
+    DrawIndexed
+};
+
+// identifier of a Vulkan handle, whether a pointer or a 64-bit integer on this platform
+template <typename T>
+uint64_t
+capture_id(
+    T inHandle)
+{
+    return reinterpret_cast<uint64_t>(inHandle);
+}
+
+template <typename T>
+T
+capture_handle(
+    const uint64_t inId)
+{
+    return reinterpret_cast<T>(inId);
+}
+
+// appends to a growing byte buffer
+class CaptureWriter
+{
+public:
+    void
+    u32(
+        const uint32_t inValue);
+
+    void
+    u64(
+        const uint64_t inValue);
+
+    void
+    bytes(
+        const void *inData,
+        const size_t inSize);
+
+    // a Vulkan structure without pointers, as is
+    template <typename T>
+    void
+    raw(
+        const T &inValue)
+    {
+        this->bytes(&inValue, sizeof(inValue));
+    }
+
+    const std::vector<char> &
+    data() const;
+
+    void
+    clear();
+
+private:
+    std::vector<char> _data;
+};
+
+// consumes a byte buffer that it does not own
+// throws Exception on reading beyond its end
+class CaptureReader
+{
+public:
+    CaptureReader(
+        const char *inData,
+        const size_t inSize);
+
+    uint32_t
+    u32();
+
+    uint64_t
+    u64();
+
+    // inSize bytes, valid while the buffer is
+    const char *
+    bytes(
+        const size_t inSize);
+
+    template <typename T>
+    T
+    raw()
+    {
+        T value;
+        memcpy(&value, this->bytes(sizeof(value)), sizeof(value));
+        return value;
+    }
+
+    bool
+    at_end() const;
+
+private:
+    const char *_data;
+    size_t      _size;
+    size_t      _offset = 0;
+};
+
+#endif // VULKAN_RENDERER_CAPTUREFORMAT_H
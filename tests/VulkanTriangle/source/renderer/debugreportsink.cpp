@@ -0,0 +1,247 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "debugreportsink.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+
+// how long the draining thread sleeps when the ring is empty; bounds how late a message is logged
+const auto DRAIN_INTERVAL = std::chrono::milliseconds(5);
+
+void
+copy_truncated(
+    char       *outDestination,
+    const char *inSource,
+    const size_t inCapacity)
+{
+    if (nullptr == inSource)
+    {
+        outDestination[0] = '\0';
+        return;
+    }
+    const auto length = std::min(strlen(inSource), inCapacity - 1);
+    memcpy(outDestination, inSource, length);
+    outDestination[length] = '\0';
+}
+
+const char *
+severity(
+    VkDebugReportFlagsEXT inFlags)
+{
+    if (inFlags & VK_DEBUG_REPORT_ERROR_BIT_EXT)
+    {
+        return "error";
+    }
+    if (inFlags & VK_DEBUG_REPORT_WARNING_BIT_EXT)
+    {
+        return "warning";
+    }
+    if (inFlags & VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT)
+    {
+        return "performance";
+    }
+    if (inFlags & VK_DEBUG_REPORT_INFORMATION_BIT_EXT)
+    {
+        return "info";
+    }
+    return "debug";
+}
+
+} // anonymous namespace
+
+const size_t DebugReportSink::RING_SIZE;
+const size_t DebugReportSink::MAX_LAYER_PREFIX;
+const size_t DebugReportSink::MAX_MESSAGE;
+
+DebugReportSink::DebugReportSink(
+    const uint32_t inMessagesPerSecond)
+    :
+    _messages_per_second(inMessagesPerSecond),
+    _ring(new Record[RING_SIZE]),
+    _enqueue_position(0),
+    _dropped(0),
+    _window_start(Clock::now()),
+    _quit(false)
+{
+    static_assert(0 == (RING_SIZE & (RING_SIZE - 1)), "Ring size must be a power of two");
+    for (auto i = 0u; i < RING_SIZE; ++i)
+    {
+        this->_ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    this->_thread = std::thread(&DebugReportSink::drain_main, this);
+}
+
+DebugReportSink::~DebugReportSink()
+{
+    this->_quit.store(true, std::memory_order_release);
+    this->_thread.join();
+
+    // anything pushed after the thread's final drain
+    this->drain();
+    this->end_window();
+
+    std::vector<std::pair<MessageKey, Repeats>> repeated;
+    for (const auto &repeats : this->_repeats)
+    {
+        if (repeats.second.total_suppressed > 0)
+        {
+            repeated.push_back(repeats);
+        }
+    }
+    std::sort(repeated.begin(), repeated.end(), [](const std::pair<MessageKey, Repeats> &inA, const std::pair<MessageKey, Repeats> &inB)
+    {
+        return inA.second.total > inB.second.total;
+    });
+    for (const auto &repeats : repeated)
+    {
+        Log().get() << "Debug report: " << std::get<0>(repeats.first) << " message " << std::get<1>(repeats.first) << " reported " << repeats.second.total << " times in total" << std::endl;
+    }
+    const auto dropped = this->_dropped.load(std::memory_order_relaxed);
+    if (dropped > 0)
+    {
+        Log().get() << "Debug report: " << dropped << " messages dropped, as they were reported faster than they were logged" << std::endl;
+    }
+}
+
+bool
+DebugReportSink::push(
+    VkDebugReportFlagsEXT      inFlags,
+    VkDebugReportObjectTypeEXT inObjectType,
+    uint64_t                   inObject,
+    int32_t                    inMessageCode,
+    const char                *inLayerPrefix,
+    const char                *inMessage)
+{
+    // claim a position whose record the draining thread has finished with
+    auto position = this->_enqueue_position.load(std::memory_order_relaxed);
+    Record *record = nullptr;
+    for (;;)
+    {
+        record = &this->_ring[position & (RING_SIZE - 1)];
+        const auto sequence = record->sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+        if (0 == difference)
+        {
+            if (this->_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+            // position was reloaded by the failed exchange
+        }
+        else if (difference < 0)
+        {
+            // full; the record still holds a message written a lap ago
+            this->_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            position = this->_enqueue_position.load(std::memory_order_relaxed);
+        }
+    }
+
+    record->flags = inFlags;
+    record->object_type = inObjectType;
+    record->object = inObject;
+    record->message_code = inMessageCode;
+    copy_truncated(record->layer_prefix, inLayerPrefix, MAX_LAYER_PREFIX);
+    copy_truncated(record->message, inMessage, MAX_MESSAGE);
+    record->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+void
+DebugReportSink::drain_main()
+{
+    while (!this->_quit.load(std::memory_order_acquire))
+    {
+        this->drain();
+        if (Clock::now() - this->_window_start >= std::chrono::seconds(1))
+        {
+            this->end_window();
+        }
+        std::this_thread::sleep_for(DRAIN_INTERVAL);
+    }
+    this->drain();
+}
+
+void
+DebugReportSink::drain()
+{
+    for (;;)
+    {
+        auto &record = this->_ring[this->_dequeue_position & (RING_SIZE - 1)];
+        if (record.sequence.load(std::memory_order_acquire) != this->_dequeue_position + 1)
+        {
+            return; // empty, or the next message is still being written
+        }
+
+        const std::string layer(record.layer_prefix);
+        const auto code = record.message_code;
+        MessageKey key(layer, code, (0 == code) ? std::string(record.message) : std::string());
+        auto &repeats = this->_repeats[key];
+        ++repeats.total;
+        repeats.error = repeats.error || (0 != (record.flags & VK_DEBUG_REPORT_ERROR_BIT_EXT));
+        if (repeats.in_window < this->_messages_per_second)
+        {
+            ++repeats.in_window;
+            Log().get() << layer << " (" << severity(record.flags) << ", " << code << "): " << record.message << std::endl;
+        }
+        else
+        {
+            ++repeats.suppressed;
+            ++repeats.total_suppressed;
+        }
+
+        // hand the record back to the reporting threads, a lap on
+        record.sequence.store(this->_dequeue_position + RING_SIZE, std::memory_order_release);
+        ++this->_dequeue_position;
+    }
+}
+
+void
+DebugReportSink::end_window()
+{
+    for (auto &repeats : this->_repeats)
+    {
+        if (repeats.second.suppressed > 0)
+        {
+            Log().get() << std::get<0>(repeats.first) << " (" << (repeats.second.error ? "error" : "repeat") << ", " << std::get<1>(repeats.first) << "): suppressed " << repeats.second.suppressed << " further reports in the last second" << std::endl;
+        }
+        repeats.second.in_window = 0;
+        repeats.second.suppressed = 0;
+    }
+    this->_window_start = Clock::now();
+}
@@ -0,0 +1,124 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_DEBUGREPORTSINK_H
+#define VULKAN_RENDERER_DEBUGREPORTSINK_H
+
+#include "vulkan/vulkan.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+
+// takes VK_EXT_debug_report messages off the threads reporting them, which are often recording or submitting
+// the reporting thread only copies the message into a fixed size record of a bounded lock-free ring
+// a background thread drains the ring into the log, logging up to a limit of each message per second, and
+// summarising the repeats beyond it, so that noisy validation does not dominate frame time
+class DebugReportSink
+{
+public:
+    explicit DebugReportSink(
+        const uint32_t inMessagesPerSecond);
+    ~DebugReportSink(); // logs everything still in the ring
+
+    DebugReportSink(const DebugReportSink &) = delete;
+    DebugReportSink &operator=(const DebugReportSink &) = delete;
+
+    // callable from any thread, and never blocks
+    // returns false if the ring was full, in which case the message is dropped, and counted
+    bool
+    push(
+        VkDebugReportFlagsEXT      inFlags,
+        VkDebugReportObjectTypeEXT inObjectType,
+        uint64_t                   inObject,
+        int32_t                    inMessageCode,
+        const char                *inLayerPrefix,
+        const char                *inMessage);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    static const size_t RING_SIZE = 512; // power of two
+    static const size_t MAX_LAYER_PREFIX = 32;
+    static const size_t MAX_MESSAGE = 2048; // longer messages are truncated
+
+    struct Record
+    {
+        // position this record is next written at, or that plus one once written, and so readable
+        std::atomic<size_t>        sequence;
+        VkDebugReportFlagsEXT      flags;
+        VkDebugReportObjectTypeEXT object_type;
+        uint64_t                   object;
+        int32_t                    message_code;
+        char                       layer_prefix[MAX_LAYER_PREFIX];
+        char                       message[MAX_MESSAGE];
+    };
+
+    // messages are told apart by the layer and their code
+    // layers that do not assign codes report 0, so those are told apart by their text instead
+    typedef std::tuple<std::string, int32_t, std::string> MessageKey;
+
+    struct Repeats
+    {
+        uint32_t in_window = 0;  // logged in the current second
+        uint64_t suppressed = 0; // not logged in the current second
+        uint64_t total = 0;
+        uint64_t total_suppressed = 0;
+        bool     error = false;
+    };
+
+    void
+    drain_main();
+
+    // log every record in the ring
+    void
+    drain();
+
+    // log and reset the repeats suppressed in the second just ended
+    void
+    end_window();
+
+    uint32_t                   _messages_per_second;
+    std::unique_ptr<Record[]>  _ring;
+    std::atomic<size_t>        _enqueue_position;
+    size_t                     _dequeue_position = 0; // only used by the draining thread
+    std::atomic<uint64_t>      _dropped;
+    std::map<MessageKey, Repeats> _repeats;
+    Clock::time_point          _window_start;
+    std::atomic<bool>          _quit;
+    std::thread                _thread;
+};
+
+#endif // VULKAN_RENDERER_DEBUGREPORTSINK_H
@@ -0,0 +1,87 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "deletionqueue.h"
+#include "log.h"
+
+#include <algorithm>
+
+DeletionQueue::DeletionQueue() = default;
+
+DeletionQueue::~DeletionQueue()
+{
+    this->flush();
+    Log().get() << "Deletion queue: " << this->_deferred << " deferred destructions" << std::endl;
+}
+
+void
+DeletionQueue::retire(
+    const std::function<void()> &inDeleter,
+    const uint32_t inExtraFrames)
+{
+    const auto serial = this->_current + inExtraFrames;
+    // kept in order of serial, so that collect stops at the first entry still in use
+    auto insert_it = std::upper_bound(this->_entries.begin(), this->_entries.end(), serial, [](const Serial inSerial, const std::pair<Serial, std::function<void()>> &inEntry)
+    {
+        return inSerial < inEntry.first;
+    });
+    this->_entries.insert(insert_it, std::make_pair(serial, inDeleter));
+    ++this->_deferred;
+}
+
+DeletionQueue::Serial
+DeletionQueue::current() const
+{
+    return this->_current;
+}
+
+DeletionQueue::Serial
+DeletionQueue::advance()
+{
+    return this->_current++;
+}
+
+void
+DeletionQueue::collect(
+    const Serial inCompleted)
+{
+    while (!this->_entries.empty() && (this->_entries.front().first <= inCompleted))
+    {
+        // moved out first, as a deleter may retire further objects
+        auto deleter = std::move(this->_entries.front().second);
+        this->_entries.pop_front();
+        deleter();
+    }
+}
+
+void
+DeletionQueue::flush()
+{
+    this->collect(static_cast<Serial>(-1));
+}
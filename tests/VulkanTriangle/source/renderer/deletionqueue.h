@@ -0,0 +1,119 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_DELETIONQUEUE_H
+#define VULKAN_RENDERER_DELETIONQUEUE_H
+
+#include "uniquehandle.h"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <utility>
+
+// deferred destruction of objects that the GPU may still be using
+// each frame submitted is numbered with a serial; objects retired while a frame is recorded are destroyed once
+// that frame's fence has signalled, which the frame loop waits upon anyway before reusing its resources, so
+// destroying objects mid-run never needs the device to be idle
+// all functions are to be called from a single thread
+class DeletionQueue
+{
+public:
+    typedef uint64_t Serial;
+
+    DeletionQueue();
+
+    // runs any remaining deleters; the caller ensures that the GPU has finished with everything retired
+    ~DeletionQueue();
+
+    DeletionQueue(const DeletionQueue &) = delete;
+    DeletionQueue &operator=(const DeletionQueue &) = delete;
+
+    // inDeleter is run once the frame being recorded, and inExtraFrames after it, are complete
+    // extra frames cover use that no fence tracks, such as presentation
+    void
+    retire(
+        const std::function<void()> &inDeleter,
+        const uint32_t inExtraFrames = 0);
+
+    // destroys the object, held by a unique_ptr with a deleter, once the GPU has finished with it
+    template <typename T, typename D>
+    void
+    retire(
+        std::unique_ptr<T, D> &&inObject,
+        const uint32_t inExtraFrames = 0)
+    {
+        if (!inObject)
+        {
+            return;
+        }
+        std::shared_ptr<T> object(std::move(inObject));
+        this->retire([object]() mutable { object.reset(); }, inExtraFrames);
+    }
+
+    template <typename Handle>
+    void
+    retire(
+        UniqueHandle<Handle> &&inHandle,
+        const uint32_t inExtraFrames = 0)
+    {
+        if (!inHandle)
+        {
+            return;
+        }
+        const auto dispatch = inHandle.dispatch();
+        const auto handle = inHandle.release();
+        this->retire([dispatch, handle]() { DeviceHandleTraits<Handle>::destroy(*dispatch, handle); }, inExtraFrames);
+    }
+
+    // the serial of the frame being recorded
+    Serial
+    current() const;
+
+    // the frame being recorded has been submitted; returns its serial, and begins the next frame
+    Serial
+    advance();
+
+    // runs the deleters of every frame up to and including inCompleted
+    void
+    collect(
+        const Serial inCompleted);
+
+    // runs every deleter, once the GPU is known to have finished with everything
+    void
+    flush();
+
+private:
+    std::deque<std::pair<Serial, std::function<void()>>> _entries; // in order of serial
+    Serial                                               _current = 1;
+    uint64_t                                             _deferred = 0;
+};
+
+#endif // VULKAN_RENDERER_DELETIONQUEUE_H
@@ -0,0 +1,57 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "devicedispatch.h"
+#include "impl.h"
+
+DeviceDispatch::DeviceDispatch(
+    ::VkDevice inDevice,
+    const ::VkAllocationCallbacks *inAllocator)
+    :
+    device(inDevice),
+    allocator(inAllocator),
+    destroy_semaphore(GETDFN(inDevice, vkDestroySemaphore)),
+    destroy_fence(GETDFN(inDevice, vkDestroyFence)),
+    destroy_image(GETDFN(inDevice, vkDestroyImage)),
+    destroy_image_view(GETDFN(inDevice, vkDestroyImageView)),
+    destroy_sampler(GETDFN(inDevice, vkDestroySampler)),
+    destroy_buffer(GETDFN(inDevice, vkDestroyBuffer)),
+    free_memory(GETDFN(inDevice, vkFreeMemory)),
+    destroy_framebuffer(GETDFN(inDevice, vkDestroyFramebuffer)),
+    destroy_render_pass(GETDFN(inDevice, vkDestroyRenderPass)),
+    destroy_command_pool(GETDFN(inDevice, vkDestroyCommandPool)),
+    destroy_shader_module(GETDFN(inDevice, vkDestroyShaderModule)),
+    destroy_pipeline(GETDFN(inDevice, vkDestroyPipeline)),
+    destroy_pipeline_layout(GETDFN(inDevice, vkDestroyPipelineLayout)),
+    destroy_pipeline_cache(GETDFN(inDevice, vkDestroyPipelineCache)),
+    destroy_descriptor_set_layout(GETDFN(inDevice, vkDestroyDescriptorSetLayout)),
+    destroy_descriptor_pool(GETDFN(inDevice, vkDestroyDescriptorPool)),
+    destroy_query_pool(GETDFN(inDevice, vkDestroyQueryPool)),
+    destroy_swapchain(GETDFN(inDevice, vkDestroySwapchainKHR))
+{}
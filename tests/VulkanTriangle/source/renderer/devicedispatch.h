@@ -0,0 +1,67 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_DEVICEDISPATCH_H
+#define VULKAN_RENDERER_DEVICEDISPATCH_H
+
+#include "vulkan/vulkan.h"
+
+// device level functions destroying the device's objects, resolved once with vkGetDeviceProcAddr when the
+// device is created, rather than on every destruction, along with the allocation callbacks that every object
+// of the device is created and destroyed with
+// shared, by reference, by each UniqueHandle of the device, so must outlive them all
+struct DeviceDispatch
+{
+    explicit DeviceDispatch(
+        ::VkDevice inDevice,
+        const ::VkAllocationCallbacks *inAllocator);
+
+    ::VkDevice                         device;
+    const ::VkAllocationCallbacks     *allocator; // host allocation callbacks of the device, or nullptr
+    PFN_vkDestroySemaphore             destroy_semaphore;
+    PFN_vkDestroyFence                 destroy_fence;
+    PFN_vkDestroyImage                 destroy_image;
+    PFN_vkDestroyImageView             destroy_image_view;
+    PFN_vkDestroySampler               destroy_sampler;
+    PFN_vkDestroyBuffer                destroy_buffer;
+    PFN_vkFreeMemory                   free_memory;
+    PFN_vkDestroyFramebuffer           destroy_framebuffer;
+    PFN_vkDestroyRenderPass            destroy_render_pass;
+    PFN_vkDestroyCommandPool           destroy_command_pool;
+    PFN_vkDestroyShaderModule          destroy_shader_module;
+    PFN_vkDestroyPipeline              destroy_pipeline;
+    PFN_vkDestroyPipelineLayout        destroy_pipeline_layout;
+    PFN_vkDestroyPipelineCache         destroy_pipeline_cache;
+    PFN_vkDestroyDescriptorSetLayout   destroy_descriptor_set_layout;
+    PFN_vkDestroyDescriptorPool        destroy_descriptor_pool;
+    PFN_vkDestroyQueryPool             destroy_query_pool;
+    PFN_vkDestroySwapchainKHR          destroy_swapchain;
+};
+
+#endif // VULKAN_RENDERER_DEVICEDISPATCH_H
@@ -0,0 +1,566 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "framecapture.h"
+#include "pipelinecompiler.h"
+#include "exception.h"
+#include "log.h"
+
+#include <fstream>
+
+namespace
+{
+
+void
+write_bindings(
+    CaptureWriter &ioWriter,
+    const std::vector<::VkDescriptorSetLayoutBinding> &inBindings)
+{
+    ioWriter.u32(static_cast<uint32_t>(inBindings.size()));
+    for (const auto &binding : inBindings)
+    {
+        ioWriter.u32(binding.binding);
+        ioWriter.u32(binding.descriptorType);
+        ioWriter.u32(binding.descriptorCount);
+        ioWriter.u32(binding.stageFlags);
+    }
+}
+
+template <typename T>
+void
+write_raw_array(
+    CaptureWriter &ioWriter,
+    const std::vector<T> &inValues)
+{
+    ioWriter.u32(static_cast<uint32_t>(inValues.size()));
+    for (const auto &value : inValues)
+    {
+        ioWriter.raw(value);
+    }
+}
+
+} // anonymous namespace
+
+FrameCapture::FrameCapture(
+    const std::string &inPath,
+    const uint32_t inFrameCount,
+    const uint32_t inFramesInFlight)
+    :
+    _path(inPath),
+    _frame_count(inFrameCount),
+    _frames_in_flight(inFramesInFlight),
+    _complete(false)
+{
+    Log().get() << "Capturing " << inFrameCount << " frames to '" << inPath << "'" << std::endl;
+}
+
+FrameCapture::~FrameCapture()
+{
+    if (!this->_complete)
+    {
+        Log().get() << "Frame capture abandoned after " << this->_frames << " of " << this->_frame_count << " frames" << std::endl;
+    }
+}
+
+void
+FrameCapture::shader_module(
+    ::VkShaderModule inModule,
+    const ::VkShaderStageFlagBits inStage,
+    const std::vector<uint32_t> &inCode)
+{
+    CaptureWriter payload;
+    payload.u64(capture_id(inModule));
+    payload.u32(inStage);
+    write_raw_array(payload, inCode);
+    this->record(CaptureRecord::ShaderModule, payload);
+}
+
+void
+FrameCapture::render_pass(
+    ::VkRenderPass inRenderPass,
+    const ::VkAttachmentDescription &inColourAttachment)
+{
+    CaptureWriter payload;
+    payload.u64(capture_id(inRenderPass));
+    payload.raw(inColourAttachment);
+    this->record(CaptureRecord::RenderPass, payload);
+}
+
+void
+FrameCapture::framebuffer(
+    ::VkFramebuffer inFramebuffer,
+    ::VkRenderPass inRenderPass,
+    const ::VkExtent2D &inExtent)
+{
+    CaptureWriter payload;
+    payload.u64(capture_id(inFramebuffer));
+    payload.u64(capture_id(inRenderPass));
+    payload.u32(inExtent.width);
+    payload.u32(inExtent.height);
+    this->record(CaptureRecord::Framebuffer, payload);
+}
+
+void
+FrameCapture::pipeline_layout(
+    ::VkPipelineLayout inLayout,
+    const std::vector<std::vector<::VkDescriptorSetLayoutBinding>> &inSetBindings,
+    const std::vector<::VkPushConstantRange> &inPushConstantRanges)
+{
+    CaptureWriter payload;
+    payload.u64(capture_id(inLayout));
+    payload.u32(static_cast<uint32_t>(inSetBindings.size()));
+    for (const auto &bindings : inSetBindings)
+    {
+        write_bindings(payload, bindings);
+    }
+    write_raw_array(payload, inPushConstantRanges);
+    this->record(CaptureRecord::PipelineLayout, payload);
+}
+
+void
+FrameCapture::pipeline(
+    ::VkPipeline inPipeline,
+    const PipelineDesc &inDesc)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        if (!this->_pipelines.insert(inPipeline).second)
+        {
+            return;
+        }
+    }
+
+    CaptureWriter payload;
+    payload.u64(capture_id(inPipeline));
+    payload.u64(capture_id(inDesc.vertex_shader));
+    payload.u64(capture_id(inDesc.fragment_shader));
+    write_raw_array(payload, inDesc.vertex_bindings);
+    write_raw_array(payload, inDesc.vertex_attributes);
+    payload.u32(inDesc.topology);
+    payload.u32(inDesc.cull_mode);
+    payload.u32(inDesc.front_face);
+    payload.u64(capture_id(inDesc.layout));
+    payload.u64(capture_id(inDesc.render_pass));
+    payload.u32(inDesc.subpass);
+    // VkSpecializationMapEntry holds a size_t, so is written field by field
+    payload.u32(static_cast<uint32_t>(inDesc.specialization_entries.size()));
+    for (const auto &entry : inDesc.specialization_entries)
+    {
+        payload.u32(entry.constantID);
+        payload.u32(entry.offset);
+        payload.u32(static_cast<uint32_t>(entry.size));
+    }
+    write_raw_array(payload, inDesc.specialization_data);
+    this->record(CaptureRecord::Pipeline, payload);
+}
+
+void
+FrameCapture::buffer(
+    ::VkBuffer inBuffer,
+    const ::VkDeviceSize inSize,
+    const ::VkBufferUsageFlags inUsage,
+    const void *inContents)
+{
+    CaptureWriter payload;
+    payload.u64(capture_id(inBuffer));
+    payload.u64(inSize);
+    payload.u32(inUsage);
+    payload.u32((nullptr != inContents) ? 1 : 0);
+    if (nullptr != inContents)
+    {
+        payload.bytes(inContents, static_cast<size_t>(inSize));
+    }
+    this->record(CaptureRecord::Buffer, payload);
+}
+
+void
+FrameCapture::buffer_data(
+    ::VkBuffer inBuffer,
+    const ::VkDeviceSize inOffset,
+    const ::VkDeviceSize inSize,
+    const void *inData)
+{
+    CaptureWriter payload;
+    payload.u64(capture_id(inBuffer));
+    payload.u64(inOffset);
+    payload.u64(inSize);
+    payload.bytes(inData, static_cast<size_t>(inSize));
+    this->record(CaptureRecord::BufferData, payload);
+}
+
+void
+FrameCapture::descriptor_set(
+    ::VkDescriptorSet inSet,
+    const std::vector<::VkDescriptorSetLayoutBinding> &inBindings,
+    const std::vector<::VkWriteDescriptorSet> &inWrites)
+{
+    CaptureWriter payload;
+    payload.u64(capture_id(inSet));
+    write_bindings(payload, inBindings);
+
+    uint32_t num_writes = 0;
+    for (const auto &write : inWrites)
+    {
+        num_writes += write.descriptorCount;
+    }
+    payload.u32(num_writes);
+    for (const auto &write : inWrites)
+    {
+        if (nullptr == write.pBufferInfo)
+        {
+            throw Exception("Only buffer descriptors can be captured");
+        }
+        // array elements of a binding overflow into the next binding
+        for (auto i = 0u; i < write.descriptorCount; ++i)
+        {
+            const auto &info = write.pBufferInfo[i];
+            payload.u32(write.dstBinding + write.dstArrayElement + i);
+            payload.u32(write.descriptorType);
+            payload.u64(capture_id(info.buffer));
+            payload.u64(info.offset);
+            payload.u64(info.range);
+        }
+    }
+    this->record(CaptureRecord::DescriptorSet, payload);
+}
+
+void
+FrameCapture::begin(
+    ::VkCommandBuffer inCommandBuffer)
+{
+    if (this->_complete)
+    {
+        return;
+    }
+    this->stream(inCommandBuffer).clear();
+}
+
+void
+FrameCapture::begin_render_pass(
+    ::VkCommandBuffer inCommandBuffer,
+    const ::VkRenderPassBeginInfo &inBeginInfo)
+{
+    if (this->_complete)
+    {
+        return;
+    }
+    auto &stream = this->stream(inCommandBuffer);
+    stream.u32(static_cast<uint32_t>(CaptureCommand::BeginRenderPass));
+    stream.u64(capture_id(inBeginInfo.renderPass));
+    stream.u64(capture_id(inBeginInfo.framebuffer));
+    stream.raw(inBeginInfo.renderArea);
+    stream.u32(inBeginInfo.clearValueCount);
+    for (auto i = 0u; i < inBeginInfo.clearValueCount; ++i)
+    {
+        stream.raw(inBeginInfo.pClearValues[i]);
+    }
+}
+
+void
+FrameCapture::end_render_pass(
+    ::VkCommandBuffer inCommandBuffer)
+{
+    if (this->_complete)
+    {
+        return;
+    }
+    this->stream(inCommandBuffer).u32(static_cast<uint32_t>(CaptureCommand::EndRenderPass));
+}
+
+void
+FrameCapture::bind_pipeline(
+    ::VkCommandBuffer inCommandBuffer,
+    ::VkPipeline inPipeline)
+{
+    if (this->_complete)
+    {
+        return;
+    }
+    auto &stream = this->stream(inCommandBuffer);
+    stream.u32(static_cast<uint32_t>(CaptureCommand::BindPipeline));
+    stream.u64(capture_id(inPipeline));
+}
+
+void
+FrameCapture::set_viewport(
+    ::VkCommandBuffer inCommandBuffer,
+    const ::VkViewport &inViewport)
+{
+    if (this->_complete)
+    {
+        return;
+    }
+    auto &stream = this->stream(inCommandBuffer);
+    stream.u32(static_cast<uint32_t>(CaptureCommand::SetViewport));
+    stream.raw(inViewport);
+}
+
+void
+FrameCapture::set_scissor(
+    ::VkCommandBuffer inCommandBuffer,
+    const ::VkRect2D &inScissor)
+{
+    if (this->_complete)
+    {
+        return;
+    }
+    auto &stream = this->stream(inCommandBuffer);
+    stream.u32(static_cast<uint32_t>(CaptureCommand::SetScissor));
+    stream.raw(inScissor);
+}
+
+void
+FrameCapture::bind_descriptor_sets(
+    ::VkCommandBuffer inCommandBuffer,
+    ::VkPipelineLayout inLayout,
+    const uint32_t inFirstSet,
+    const uint32_t inSetCount,
+    const ::VkDescriptorSet *inSets,
+    const uint32_t inDynamicOffsetCount,
+    const uint32_t *inDynamicOffsets)
+{
+    if (this->_complete)
+    {
+        return;
+    }
+    auto &stream = this->stream(inCommandBuffer);
+    stream.u32(static_cast<uint32_t>(CaptureCommand::BindDescriptorSets));
+    stream.u64(capture_id(inLayout));
+    stream.u32(inFirstSet);
+    stream.u32(inSetCount);
+    for (auto i = 0u; i < inSetCount; ++i)
+    {
+        stream.u64(capture_id(inSets[i]));
+    }
+    stream.u32(inDynamicOffsetCount);
+    stream.bytes(inDynamicOffsets, inDynamicOffsetCount * sizeof(uint32_t));
+}
+
+void
+FrameCapture::push_constants(
+    ::VkCommandBuffer inCommandBuffer,
+    ::VkPipelineLayout inLayout,
+    const ::VkShaderStageFlags inStages,
+    const uint32_t inOffset,
+    const uint32_t inSize,
+    const void *inValues)
+{
+    if (this->_complete)
+    {
+        return;
+    }
+    auto &stream = this->stream(inCommandBuffer);
+    stream.u32(static_cast<uint32_t>(CaptureCommand::PushConstants));
+    stream.u64(capture_id(inLayout));
+    stream.u32(inStages);
+    stream.u32(inOffset);
+    stream.u32(inSize);
+    stream.bytes(inValues, inSize);
+}
+
+void
+FrameCapture::bind_vertex_buffers(
+    ::VkCommandBuffer inCommandBuffer,
+    const uint32_t inFirstBinding,
+    const uint32_t inBindingCount,
+    const ::VkBuffer *inBuffers,
+    const ::VkDeviceSize *inOffsets)
+{
+    if (this->_complete)
+    {
+        return;
+    }
+    auto &stream = this->stream(inCommandBuffer);
+    stream.u32(static_cast<uint32_t>(CaptureCommand::BindVertexBuffers));
+    stream.u32(inFirstBinding);
+    stream.u32(inBindingCount);
+    for (auto i = 0u; i < inBindingCount; ++i)
+    {
+        stream.u64(capture_id(inBuffers[i]));
+        stream.u64(inOffsets[i]);
+    }
+}
+
+void
+FrameCapture::bind_index_buffer(
+    ::VkCommandBuffer inCommandBuffer,
+    ::VkBuffer inBuffer,
+    const ::VkDeviceSize inOffset,
+    const ::VkIndexType inIndexType)
+{
+    if (this->_complete)
+    {
+        return;
+    }
+    auto &stream = this->stream(inCommandBuffer);
+    stream.u32(static_cast<uint32_t>(CaptureCommand::BindIndexBuffer));
+    stream.u64(capture_id(inBuffer));
+    stream.u64(inOffset);
+    stream.u32(inIndexType);
+}
+
+void
+FrameCapture::draw(
+    ::VkCommandBuffer inCommandBuffer,
+    const uint32_t inVertexCount,
+    const uint32_t inInstanceCount,
+    const uint32_t inFirstVertex,
+    const uint32_t inFirstInstance)
+{
+    if (this->_complete)
+    {
+        return;
+    }
+    auto &stream = this->stream(inCommandBuffer);
+    stream.u32(static_cast<uint32_t>(CaptureCommand::Draw));
+    stream.u32(inVertexCount);
+    stream.u32(inInstanceCount);
+    stream.u32(inFirstVertex);
+    stream.u32(inFirstInstance);
+}
+
+void
+FrameCapture::draw_indexed(
+    ::VkCommandBuffer inCommandBuffer,
+    const uint32_t inIndexCount,
+    const uint32_t inInstanceCount,
+    const uint32_t inFirstIndex,
+    const int32_t inVertexOffset,
+    const uint32_t inFirstInstance)
+{
+    if (this->_complete)
+    {
+        return;
+    }
+    auto &stream = this->stream(inCommandBuffer);
+    stream.u32(static_cast<uint32_t>(CaptureCommand::DrawIndexed));
+    stream.u32(inIndexCount);
+    stream.u32(inInstanceCount);
+    stream.u32(inFirstIndex);
+    stream.raw(inVertexOffset);
+    stream.u32(inFirstInstance);
+}
+
+void
+FrameCapture::execute_commands(
+    ::VkCommandBuffer inCommandBuffer,
+    const uint32_t inCount,
+    const ::VkCommandBuffer *inSecondaries)
+{
+    if (this->_complete)
+    {
+        return;
+    }
+    auto &stream = this->stream(inCommandBuffer);
+    for (auto i = 0u; i < inCount; ++i)
+    {
+        const auto &secondary = this->stream(inSecondaries[i]).data();
+        stream.bytes(secondary.data(), secondary.size());
+    }
+}
+
+void
+FrameCapture::submit(
+    ::VkCommandBuffer inCommandBuffer)
+{
+    if (this->_complete)
+    {
+        return;
+    }
+    const auto &commands = this->stream(inCommandBuffer).data();
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_records.u32(static_cast<uint32_t>(CaptureRecord::Frame));
+        this->_records.u32(static_cast<uint32_t>(sizeof(uint32_t) + commands.size()));
+        this->_records.u32(static_cast<uint32_t>(commands.size()));
+        this->_records.bytes(commands.data(), commands.size());
+    }
+    if (++this->_frames < this->_frame_count)
+    {
+        return;
+    }
+    this->write();
+    this->_complete = true;
+
+    // nothing more is recorded, so release the streams
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_streams.clear();
+    this->_records.clear();
+}
+
+bool
+FrameCapture::complete() const
+{
+    return this->_complete;
+}
+
+CaptureWriter &
+FrameCapture::stream(
+    ::VkCommandBuffer inCommandBuffer)
+{
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    return this->_streams[inCommandBuffer];
+}
+
+void
+FrameCapture::record(
+    const CaptureRecord inType,
+    const CaptureWriter &inPayload)
+{
+    if (this->_complete)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_records.u32(static_cast<uint32_t>(inType));
+    this->_records.u32(static_cast<uint32_t>(inPayload.data().size()));
+    this->_records.bytes(inPayload.data().data(), inPayload.data().size());
+}
+
+void
+FrameCapture::write() const
+{
+    CaptureHeader header;
+    header.frames_in_flight = this->_frames_in_flight;
+    header.frame_count = this->_frames;
+
+    std::ofstream file(this->_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw Exception("Unable to open capture '" + this->_path + "' for writing");
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    const auto &records = this->_records.data();
+    file.write(records.data(), static_cast<std::streamsize>(records.size()));
+    if (!file.good())
+    {
+        throw Exception("Unable to write capture '" + this->_path + "'");
+    }
+    Log().get() << "Captured " << this->_frames << " frames, " << (sizeof(header) + records.size()) << " bytes, to '" << this->_path << "'" << std::endl;
+}
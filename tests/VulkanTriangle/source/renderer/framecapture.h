@@ -0,0 +1,241 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_FRAMECAPTURE_H
+#define VULKAN_RENDERER_FRAMECAPTURE_H
+
+#include "captureformat.h"
+#include "vulkan/vulkan.h"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+struct PipelineDesc;
+
+// records the renderer's Vulkan workload alongside the calls making it, for VulkanReplay to re-execute offline
+// the objects that frames use, the host's writes to buffers, and the commands of a number of submitted frames,
+// are written to a file in the CaptureFormat once the last of those frames is submitted
+// each command is recorded into the stream of its command buffer, reset when that command buffer is begun, so that
+// command buffers recorded once and submitted many times are captured whenever they are submitted
+// queries, barriers and compute work are not captured, nor is anything about presentation
+// may be called from multiple threads, provided that each command buffer is recorded by one thread at a time
+class FrameCapture
+{
+public:
+    FrameCapture(
+        const std::string &inPath,
+        const uint32_t inFrameCount,
+        const uint32_t inFramesInFlight);
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture &) = delete;
+    FrameCapture &operator=(const FrameCapture &) = delete;
+
+    void
+    shader_module(
+        ::VkShaderModule inModule,
+        const ::VkShaderStageFlagBits inStage,
+        const std::vector<uint32_t> &inCode);
+
+    void
+    render_pass(
+        ::VkRenderPass inRenderPass,
+        const ::VkAttachmentDescription &inColourAttachment);
+
+    void
+    framebuffer(
+        ::VkFramebuffer inFramebuffer,
+        ::VkRenderPass inRenderPass,
+        const ::VkExtent2D &inExtent);
+
+    // inSetBindings has the bindings of every set, including empty sets for any gaps in set numbers
+    void
+    pipeline_layout(
+        ::VkPipelineLayout inLayout,
+        const std::vector<std::vector<::VkDescriptorSetLayoutBinding>> &inSetBindings,
+        const std::vector<::VkPushConstantRange> &inPushConstantRanges);
+
+    // recorded the first time that each pipeline is seen, so may be called whenever it is used
+    void
+    pipeline(
+        ::VkPipeline inPipeline,
+        const PipelineDesc &inDesc);
+
+    // inContents is inSize bytes of initial contents, or nullptr if the buffer is written later, if at all
+    void
+    buffer(
+        ::VkBuffer inBuffer,
+        const ::VkDeviceSize inSize,
+        const ::VkBufferUsageFlags inUsage,
+        const void *inContents);
+
+    // host writes to a buffer's memory, to be visible to the next frame submitted
+    void
+    buffer_data(
+        ::VkBuffer inBuffer,
+        const ::VkDeviceSize inOffset,
+        const ::VkDeviceSize inSize,
+        const void *inData);
+
+    // inWrites are the descriptor writes made to the set, of buffers only
+    void
+    descriptor_set(
+        ::VkDescriptorSet inSet,
+        const std::vector<::VkDescriptorSetLayoutBinding> &inBindings,
+        const std::vector<::VkWriteDescriptorSet> &inWrites);
+
+    // discards whatever was previously recorded into the command buffer
+    void
+    begin(
+        ::VkCommandBuffer inCommandBuffer);
+
+    void
+    begin_render_pass(
+        ::VkCommandBuffer inCommandBuffer,
+        const ::VkRenderPassBeginInfo &inBeginInfo);
+
+    void
+    end_render_pass(
+        ::VkCommandBuffer inCommandBuffer);
+
+    void
+    bind_pipeline(
+        ::VkCommandBuffer inCommandBuffer,
+        ::VkPipeline inPipeline);
+
+    void
+    set_viewport(
+        ::VkCommandBuffer inCommandBuffer,
+        const ::VkViewport &inViewport);
+
+    void
+    set_scissor(
+        ::VkCommandBuffer inCommandBuffer,
+        const ::VkRect2D &inScissor);
+
+    void
+    bind_descriptor_sets(
+        ::VkCommandBuffer inCommandBuffer,
+        ::VkPipelineLayout inLayout,
+        const uint32_t inFirstSet,
+        const uint32_t inSetCount,
+        const ::VkDescriptorSet *inSets,
+        const uint32_t inDynamicOffsetCount,
+        const uint32_t *inDynamicOffsets);
+
+    void
+    push_constants(
+        ::VkCommandBuffer inCommandBuffer,
+        ::VkPipelineLayout inLayout,
+        const ::VkShaderStageFlags inStages,
+        const uint32_t inOffset,
+        const uint32_t inSize,
+        const void *inValues);
+
+    void
+    bind_vertex_buffers(
+        ::VkCommandBuffer inCommandBuffer,
+        const uint32_t inFirstBinding,
+        const uint32_t inBindingCount,
+        const ::VkBuffer *inBuffers,
+        const ::VkDeviceSize *inOffsets);
+
+    void
+    bind_index_buffer(
+        ::VkCommandBuffer inCommandBuffer,
+        ::VkBuffer inBuffer,
+        const ::VkDeviceSize inOffset,
+        const ::VkIndexType inIndexType);
+
+    void
+    draw(
+        ::VkCommandBuffer inCommandBuffer,
+        const uint32_t inVertexCount,
+        const uint32_t inInstanceCount,
+        const uint32_t inFirstVertex,
+        const uint32_t inFirstInstance);
+
+    void
+    draw_indexed(
+        ::VkCommandBuffer inCommandBuffer,
+        const uint32_t inIndexCount,
+        const uint32_t inInstanceCount,
+        const uint32_t inFirstIndex,
+        const int32_t inVertexOffset,
+        const uint32_t inFirstInstance);
+
+    // inlines the secondaries' commands, as they are at the time of the call
+    void
+    execute_commands(
+        ::VkCommandBuffer inCommandBuffer,
+        const uint32_t inCount,
+        const ::VkCommandBuffer *inSecondaries);
+
+    // records a frame of the commands of the primary inCommandBuffer, as submitted
+    // once the last frame is recorded, writes the capture, and records nothing further
+    // throws Exception if the capture cannot be written
+    void
+    submit(
+        ::VkCommandBuffer inCommandBuffer);
+
+    // true once the capture has been written
+    bool
+    complete() const;
+
+private:
+    // the stream of commands recorded into inCommandBuffer, which remains valid while the capture does
+    CaptureWriter &
+    stream(
+        ::VkCommandBuffer inCommandBuffer);
+
+    void
+    record(
+        const CaptureRecord inType,
+        const CaptureWriter &inPayload);
+
+    void
+    write() const;
+
+    std::string                                  _path;
+    uint32_t                                     _frame_count;
+    uint32_t                                     _frames_in_flight;
+    uint32_t                                     _frames = 0;
+    std::atomic<bool>                            _complete;
+    std::mutex                                   _mutex;
+    CaptureWriter                                _records;
+    std::map<::VkCommandBuffer, CaptureWriter>   _streams; // a map, so that streams do not move while recorded into
+    std::set<::VkPipeline>                       _pipelines;
+};
+
+#endif // VULKAN_RENDERER_FRAMECAPTURE_H
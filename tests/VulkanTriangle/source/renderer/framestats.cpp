@@ -0,0 +1,150 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "framestats.h"
+#include "log.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+RollingHistogram::RollingHistogram(
+    const std::string &inName,
+    const uint32_t inWindow)
+    :
+    _name(inName),
+    _samples(std::max(1u, inWindow))
+{
+    this->_bins.fill(0);
+}
+
+uint32_t
+RollingHistogram::bin_index(
+    const double inMilliseconds)
+{
+    // bin i holds samples under (1/16 ms * 2^i), with the last bin unbounded
+    auto upper = 1.0 / 16.0;
+    for (auto i = 0u; i < NUM_BINS - 1; ++i, upper *= 2)
+    {
+        if (inMilliseconds < upper)
+        {
+            return i;
+        }
+    }
+    return NUM_BINS - 1;
+}
+
+void
+RollingHistogram::add(
+    const double inMilliseconds)
+{
+    if (this->_count == this->_samples.size())
+    {
+        // evict the oldest sample, which is about to be overwritten
+        --this->_bins[bin_index(this->_samples[this->_next])];
+    }
+    else
+    {
+        ++this->_count;
+    }
+    this->_samples[this->_next] = inMilliseconds;
+    ++this->_bins[bin_index(inMilliseconds)];
+    this->_next = (this->_next + 1) % this->_samples.size();
+}
+
+double
+RollingHistogram::percentile(
+    const double inPercent) const
+{
+    if (0 == this->_count)
+    {
+        return 0;
+    }
+    std::vector<double> sorted(this->_samples.begin(), this->_samples.begin() + this->_count);
+    const auto rank = static_cast<size_t>((inPercent / 100.0) * (sorted.size() - 1) + 0.5);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+void
+RollingHistogram::report() const
+{
+    std::ostringstream bins;
+    auto upper = 1.0 / 16.0;
+    for (auto i = 0u; i < NUM_BINS; ++i, upper *= 2)
+    {
+        if (0 == this->_bins[i])
+        {
+            continue;
+        }
+        if (i < NUM_BINS - 1)
+        {
+            bins << " <" << upper << ":" << this->_bins[i];
+        }
+        else
+        {
+            bins << " >=" << upper / 2 << ":" << this->_bins[i];
+        }
+    }
+    Log().get()
+        << std::fixed << std::setprecision(3)
+        << "\t" << this->_name
+        << ": p50 " << this->percentile(50) << " ms"
+        << ", p95 " << this->percentile(95) << " ms"
+        << ", p99 " << this->percentile(99) << " ms"
+        << ", max " << this->percentile(100) << " ms"
+        << " |" << bins.str()
+        << std::endl;
+}
+
+FrameStats::FrameStats(
+    const uint32_t inWindow,
+    const uint32_t inReportInterval)
+    :
+    fence_wait("fence wait", inWindow),
+    acquire("acquire", inWindow),
+    record("record", inWindow),
+    submit_to_present("submit to present", inWindow),
+    _window(inWindow),
+    _report_interval(std::max(1u, inReportInterval))
+{}
+
+void
+FrameStats::end_frame()
+{
+    if (0 != (++this->_frame_count % this->_report_interval))
+    {
+        return;
+    }
+    Log().get() << "Frame pacing over the last " << std::min<uint64_t>(this->_frame_count, this->_window) << " frames (frame " << this->_frame_count << "):" << std::endl;
+    this->fence_wait.report();
+    this->acquire.report();
+    this->record.report();
+    this->submit_to_present.report();
+}
@@ -0,0 +1,97 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_FRAMESTATS_H
+#define VULKAN_RENDERER_FRAMESTATS_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// distribution of the most recent samples of a timing, in milliseconds
+// samples are binned by powers of two, from under 1/16 ms up to over 2 s
+class RollingHistogram
+{
+public:
+    RollingHistogram(
+        const std::string &inName,
+        const uint32_t inWindow);
+
+    void
+    add(
+        const double inMilliseconds);
+
+    // exact percentile, in [0, 100], of the samples in the window
+    double
+    percentile(
+        const double inPercent) const;
+
+    void
+    report() const;
+
+private:
+    static const uint32_t NUM_BINS = 17;
+
+    static uint32_t
+    bin_index(
+        const double inMilliseconds);
+
+    std::string                      _name;
+    std::vector<double>              _samples;
+    size_t                           _next = 0;
+    size_t                           _count = 0;
+    std::array<uint32_t, NUM_BINS>   _bins;
+};
+
+// CPU side frame pacing of the renderer; each stage of a frame is timed into its own histogram
+// and all are logged every report interval
+class FrameStats
+{
+public:
+    FrameStats(
+        const uint32_t inWindow,
+        const uint32_t inReportInterval);
+
+    RollingHistogram fence_wait;        // waiting for the frame in flight to be retired by the GPU
+    RollingHistogram acquire;           // vkAcquireNextImageKHR
+    RollingHistogram record;            // recording, or choosing, the frame's command buffer
+    RollingHistogram submit_to_present; // vkQueueSubmit through vkQueuePresentKHR returning
+
+    // call once all stages of the frame have been added
+    void
+    end_frame();
+
+private:
+    uint32_t _window;
+    uint32_t _report_interval;
+    uint64_t _frame_count = 0;
+};
+
+#endif // VULKAN_RENDERER_FRAMESTATS_H
@@ -0,0 +1,552 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "gpuprofiler.h"
+#include "impl.h"
+#include "exception.h"
+#include "log.h"
+
+#include <cstring>
+
+namespace
+{
+
+struct StatisticName
+{
+    ::VkQueryPipelineStatisticFlagBits flag;
+    const char                        *name;
+};
+
+// in ascending order of their flags, which is the order of their results
+const StatisticName STATISTIC_NAMES[] =
+{
+    { VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT, "input_assembly_vertices" },
+    { VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT, "input_assembly_primitives" },
+    { VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT, "vertex_shader_invocations" },
+    { VK_QUERY_PIPELINE_STATISTIC_GEOMETRY_SHADER_INVOCATIONS_BIT, "geometry_shader_invocations" },
+    { VK_QUERY_PIPELINE_STATISTIC_GEOMETRY_SHADER_PRIMITIVES_BIT, "geometry_shader_primitives" },
+    { VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT, "clipping_invocations" },
+    { VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT, "clipping_primitives" },
+    { VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT, "fragment_shader_invocations" },
+    { VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_CONTROL_SHADER_PATCHES_BIT, "tessellation_control_shader_patches" },
+    { VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_EVALUATION_SHADER_INVOCATIONS_BIT, "tessellation_evaluation_shader_invocations" },
+    { VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT, "compute_shader_invocations" }
+};
+
+} // anonymous namespace
+
+const uint32_t GpuProfiler::NOT_COUNTED;
+
+GpuProfiler::GpuProfiler(
+    const DeviceDispatch &inDispatch,
+    const uint32_t inFramesInFlight,
+    const uint32_t inMaxScopes,
+    const float inTimestampPeriod,
+    const uint32_t inTimestampValidBits,
+    const ::VkQueryPipelineStatisticFlags inPipelineStatistics,
+    const bool inOcclusion,
+    const std::string &inCsvPath)
+    :
+    _device(inDispatch.device),
+    _cmd_reset_query_pool(GETDFN(inDispatch.device, vkCmdResetQueryPool)),
+    _cmd_write_timestamp(GETDFN(inDispatch.device, vkCmdWriteTimestamp)),
+    _cmd_begin_query(GETDFN(inDispatch.device, vkCmdBeginQuery)),
+    _cmd_end_query(GETDFN(inDispatch.device, vkCmdEndQuery)),
+    _get_query_pool_results(GETDFN(inDispatch.device, vkGetQueryPoolResults)),
+    _max_scopes(inMaxScopes),
+    _pipeline_statistics(inPipelineStatistics),
+    _occlusion(inOcclusion),
+    _nanoseconds_per_tick(inTimestampPeriod),
+    _timestamp_mask((inTimestampValidBits >= 64) ? ~0ull : ((1ull << inTimestampValidBits) - 1)),
+    _frames(inFramesInFlight),
+    _results(inMaxScopes * 4) // begin and end, each with availability
+{
+    if (0 == inTimestampValidBits)
+    {
+        throw Exception("Queue does not support timestamps");
+    }
+    for (const auto &statistic : STATISTIC_NAMES)
+    {
+        if (inPipelineStatistics & statistic.flag)
+        {
+            this->_statistic_names.push_back(statistic.name);
+        }
+    }
+    // each query's statistics, then its availability
+    this->_statistics_results.resize(inMaxScopes * (this->_statistic_names.size() + 1));
+    this->_occlusion_results.resize(inMaxScopes * 2);
+
+    ::VkQueryPoolCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+    createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    createInfo.queryCount = inMaxScopes * 2;
+
+    auto device = inDispatch.device;
+    auto createQueryPoolFn = GETDFN(device, vkCreateQueryPool);
+
+    for (auto &frame : this->_frames)
+    {
+        ::VkQueryPool queryPool;
+        VK_ERR_CHECK(createQueryPoolFn(
+            device,
+            &createInfo,
+            inDispatch.allocator,
+            &queryPool
+        ));
+        frame.query_pool = { inDispatch, queryPool };
+        frame.scopes.reserve(inMaxScopes);
+    }
+
+    // counted scopes are no more than scopes, so the counter pools are no larger than the timestamp pool
+    ::VkQueryPoolCreateInfo countersCreateInfo;
+    memset(&countersCreateInfo, 0, sizeof(countersCreateInfo));
+    countersCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    countersCreateInfo.queryCount = inMaxScopes;
+    for (auto &frame : this->_frames)
+    {
+        if (0 != inPipelineStatistics)
+        {
+            countersCreateInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            countersCreateInfo.pipelineStatistics = inPipelineStatistics;
+            ::VkQueryPool queryPool;
+            VK_ERR_CHECK(createQueryPoolFn(
+                device,
+                &countersCreateInfo,
+                inDispatch.allocator,
+                &queryPool
+            ));
+            frame.statistics_pool = { inDispatch, queryPool };
+        }
+        if (inOcclusion)
+        {
+            countersCreateInfo.queryType = VK_QUERY_TYPE_OCCLUSION;
+            countersCreateInfo.pipelineStatistics = 0;
+            ::VkQueryPool queryPool;
+            VK_ERR_CHECK(createQueryPoolFn(
+                device,
+                &countersCreateInfo,
+                inDispatch.allocator,
+                &queryPool
+            ));
+            frame.occlusion_pool = { inDispatch, queryPool };
+        }
+    }
+
+    if (!inCsvPath.empty())
+    {
+        this->_csv.open(inCsvPath.c_str());
+        if (!this->_csv)
+        {
+            throw Exception("Unable to open GPU profile output '" + inCsvPath + "'");
+        }
+        // counters are empty for scopes that were not counted
+        this->_csv << "frame,scope,cpu_ms,gpu_ms";
+        if (inOcclusion)
+        {
+            this->_csv << ",samples_passed";
+        }
+        for (const auto name : this->_statistic_names)
+        {
+            this->_csv << "," << name;
+        }
+        this->_csv << std::endl;
+    }
+    Log().get() << "GPU profiling " << inMaxScopes << " scopes per frame (" << inTimestampPeriod << " ns per tick, " << inTimestampValidBits << " valid bits)" << (inCsvPath.empty() ? std::string() : " to " + inCsvPath) << std::endl;
+    if (this->counting())
+    {
+        Log().get() << "GPU profiling counts " << this->_statistic_names.size() << " pipeline statistics" << (inOcclusion ? ", and samples passed," : "") << " of counted scopes" << std::endl;
+    }
+}
+
+GpuProfiler::~GpuProfiler()
+{
+    for (const auto &totals : this->_counter_totals)
+    {
+        const auto &counted = totals.second;
+        auto &log = Log().get();
+        log << "GPU counters of '" << totals.first << "', mean of " << counted.scopes << " scopes:";
+        if (this->_occlusion)
+        {
+            log << " samples_passed " << (counted.samples_passed / counted.scopes);
+        }
+        for (auto i = 0u; i < counted.statistics.size(); ++i)
+        {
+            log << " " << this->_statistic_names[i] << " " << (counted.statistics[i] / counted.scopes);
+        }
+        log << std::endl;
+    }
+}
+
+void
+GpuProfiler::set_listener(
+    Listener inListener)
+{
+    this->_listener = std::move(inListener);
+}
+
+void
+GpuProfiler::set_counter_listener(
+    CounterListener inListener)
+{
+    this->_counter_listener = std::move(inListener);
+}
+
+void
+GpuProfiler::begin_frame(
+    ::VkCommandBuffer inCommandBuffer,
+    const uint32_t inFrameIndex)
+{
+    auto &frame = this->_frames[inFrameIndex];
+    if (frame.pending)
+    {
+        this->resolve(frame);
+    }
+
+    this->_cmd_reset_query_pool(
+        inCommandBuffer,
+        frame.query_pool.get(),
+        0,
+        this->_max_scopes * 2
+    );
+    if (frame.statistics_pool)
+    {
+        this->_cmd_reset_query_pool(
+            inCommandBuffer,
+            frame.statistics_pool.get(),
+            0,
+            this->_max_scopes
+        );
+    }
+    if (frame.occlusion_pool)
+    {
+        this->_cmd_reset_query_pool(
+            inCommandBuffer,
+            frame.occlusion_pool.get(),
+            0,
+            this->_max_scopes
+        );
+    }
+    frame.scopes.clear();
+    frame.num_counted = 0;
+    this->_active_counted = NOT_COUNTED;
+    frame.frame_number = this->_frame_number++;
+    frame.pending = true;
+    this->_current = &frame;
+}
+
+uint32_t
+GpuProfiler::begin_scope(
+    ::VkCommandBuffer inCommandBuffer,
+    const char *inName,
+    const bool inCounted)
+{
+    auto frame = this->_current;
+    if (nullptr == frame || frame->scopes.size() == this->_max_scopes)
+    {
+        return static_cast<uint32_t>(-1);
+    }
+    const auto scope = static_cast<uint32_t>(frame->scopes.size());
+    ScopeRecord record;
+    record.name = inName;
+    record.cpu_begin = Clock::now();
+    frame->scopes.push_back(record);
+
+    this->_cmd_write_timestamp(
+        inCommandBuffer,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        frame->query_pool.get(),
+        scope * 2
+    );
+
+    // queries of the same type cannot nest, so only the outermost counted scope is counted
+    if (inCounted && this->counting() && (NOT_COUNTED == this->_active_counted))
+    {
+        const auto query = frame->num_counted++;
+        frame->scopes.back().counter_query = query;
+        if (frame->statistics_pool)
+        {
+            this->_cmd_begin_query(
+                inCommandBuffer,
+                frame->statistics_pool.get(),
+                query,
+                0
+            );
+        }
+        if (frame->occlusion_pool)
+        {
+            // not precise, which needs a device feature, as whether any samples passed is not the interest
+            this->_cmd_begin_query(
+                inCommandBuffer,
+                frame->occlusion_pool.get(),
+                query,
+                0
+            );
+        }
+        this->_active_counted = scope;
+    }
+    return scope;
+}
+
+void
+GpuProfiler::end_scope(
+    ::VkCommandBuffer inCommandBuffer,
+    const uint32_t inScope)
+{
+    auto frame = this->_current;
+    if (nullptr == frame || inScope >= frame->scopes.size())
+    {
+        return;
+    }
+    if (inScope == this->_active_counted)
+    {
+        const auto query = frame->scopes[inScope].counter_query;
+        if (frame->statistics_pool)
+        {
+            this->_cmd_end_query(
+                inCommandBuffer,
+                frame->statistics_pool.get(),
+                query
+            );
+        }
+        if (frame->occlusion_pool)
+        {
+            this->_cmd_end_query(
+                inCommandBuffer,
+                frame->occlusion_pool.get(),
+                query
+            );
+        }
+        this->_active_counted = NOT_COUNTED;
+    }
+    this->_cmd_write_timestamp(
+        inCommandBuffer,
+        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        frame->query_pool.get(),
+        inScope * 2 + 1
+    );
+    auto &record = frame->scopes[inScope];
+    const std::chrono::duration<double, std::milli> cpu_time = Clock::now() - record.cpu_begin;
+    record.cpu_milliseconds = cpu_time.count();
+}
+
+void
+GpuProfiler::resolve(
+    Frame &inFrame)
+{
+    inFrame.pending = false;
+    const auto num_queries = static_cast<uint32_t>(inFrame.scopes.size() * 2);
+    if (0 == num_queries)
+    {
+        return;
+    }
+
+    // no VK_QUERY_RESULT_WAIT_BIT; the frame's fence has signalled, but any query that
+    // is still not available is skipped rather than stalling on it
+    const auto result = this->_get_query_pool_results(
+        this->_device,
+        inFrame.query_pool.get(),
+        0,
+        num_queries,
+        num_queries * 2 * sizeof(uint64_t),
+        this->_results.data(),
+        2 * sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
+    );
+    if (VK_SUCCESS != result && VK_NOT_READY != result)
+    {
+        Log().get() << "Failed (" << result << ") to read GPU timestamps for frame " << inFrame.frame_number << std::endl;
+        return;
+    }
+
+    // as with the timestamps, counters not yet available are skipped
+    auto counters_read = true;
+    if (inFrame.num_counted > 0)
+    {
+        if (inFrame.statistics_pool)
+        {
+            const auto stride = (this->_statistic_names.size() + 1) * sizeof(uint64_t);
+            const auto statisticsResult = this->_get_query_pool_results(
+                this->_device,
+                inFrame.statistics_pool.get(),
+                0,
+                inFrame.num_counted,
+                inFrame.num_counted * stride,
+                this->_statistics_results.data(),
+                stride,
+                VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
+            );
+            counters_read = counters_read && ((VK_SUCCESS == statisticsResult) || (VK_NOT_READY == statisticsResult));
+        }
+        if (inFrame.occlusion_pool)
+        {
+            const auto occlusionResult = this->_get_query_pool_results(
+                this->_device,
+                inFrame.occlusion_pool.get(),
+                0,
+                inFrame.num_counted,
+                inFrame.num_counted * 2 * sizeof(uint64_t),
+                this->_occlusion_results.data(),
+                2 * sizeof(uint64_t),
+                VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
+            );
+            counters_read = counters_read && ((VK_SUCCESS == occlusionResult) || (VK_NOT_READY == occlusionResult));
+        }
+        if (!counters_read)
+        {
+            Log().get() << "Failed to read GPU counters for frame " << inFrame.frame_number << std::endl;
+        }
+    }
+
+    PassCounters counters;
+    for (auto i = 0u; i < inFrame.scopes.size(); ++i)
+    {
+        const auto *begin = &this->_results[i * 4];
+        const auto *end = begin + 2;
+        if (0 == begin[1] || 0 == end[1])
+        {
+            continue;
+        }
+        // mask the difference, so that a wrap of the valid bits is still a positive interval
+        const auto ticks = (end[0] - begin[0]) & this->_timestamp_mask;
+        const auto gpu_milliseconds = ticks * this->_nanoseconds_per_tick / 1000000.0;
+        const auto &scope = inFrame.scopes[i];
+        const auto counted = counters_read && (NOT_COUNTED != scope.counter_query) && this->resolve_counters(scope.counter_query, counters);
+        if (this->_csv.is_open())
+        {
+            this->_csv << inFrame.frame_number << "," << scope.name << "," << scope.cpu_milliseconds << "," << gpu_milliseconds;
+            if (this->_occlusion)
+            {
+                this->_csv << ",";
+                if (counted)
+                {
+                    this->_csv << counters.samples_passed;
+                }
+            }
+            for (auto s = 0u; s < this->_statistic_names.size(); ++s)
+            {
+                this->_csv << ",";
+                if (counted)
+                {
+                    this->_csv << counters.statistics[s].second;
+                }
+            }
+            this->_csv << "\n";
+        }
+        if (this->_listener)
+        {
+            this->_listener(scope.name, gpu_milliseconds);
+        }
+        if (!counted)
+        {
+            continue;
+        }
+        auto &totals = this->_counter_totals[scope.name];
+        ++totals.scopes;
+        totals.samples_passed += counters.samples_passed;
+        totals.statistics.resize(counters.statistics.size());
+        for (auto s = 0u; s < counters.statistics.size(); ++s)
+        {
+            totals.statistics[s] += counters.statistics[s].second;
+        }
+        if (this->_counter_listener)
+        {
+            this->_counter_listener(scope.name, counters);
+        }
+    }
+}
+
+bool
+GpuProfiler::resolve_counters(
+    const uint32_t inQuery,
+    PassCounters &outCounters) const
+{
+    const auto num_statistics = this->_statistic_names.size();
+    if (0 != this->_pipeline_statistics)
+    {
+        const auto *statistics = &this->_statistics_results[inQuery * (num_statistics + 1)];
+        if (0 == statistics[num_statistics])
+        {
+            return false;
+        }
+        outCounters.statistics.resize(num_statistics);
+        for (auto i = 0u; i < num_statistics; ++i)
+        {
+            outCounters.statistics[i] = std::make_pair(this->_statistic_names[i], statistics[i]);
+        }
+    }
+    if (this->_occlusion)
+    {
+        const auto *occlusion = &this->_occlusion_results[inQuery * 2];
+        if (0 == occlusion[1])
+        {
+            return false;
+        }
+        outCounters.samples_passed = occlusion[0];
+    }
+    outCounters.occlusion = this->_occlusion;
+    return true;
+}
+
+bool
+GpuProfiler::counting() const
+{
+    return (0 != this->_pipeline_statistics) || this->_occlusion;
+}
+
+GpuProfiler::Scope::Scope(
+    GpuProfiler *inProfiler,
+    ::VkCommandBuffer inCommandBuffer,
+    const char *inName,
+    const bool inCounted)
+    :
+    _profiler(inProfiler),
+    _command_buffer(inCommandBuffer),
+    _scope(static_cast<uint32_t>(-1))
+{
+    if (nullptr != this->_profiler)
+    {
+        this->_scope = this->_profiler->begin_scope(inCommandBuffer, inName, inCounted);
+    }
+}
+
+GpuProfiler::Scope::~Scope()
+{
+    this->end();
+}
+
+void
+GpuProfiler::Scope::end()
+{
+    if (nullptr != this->_profiler)
+    {
+        this->_profiler->end_scope(this->_command_buffer, this->_scope);
+        this->_profiler = nullptr;
+    }
+}
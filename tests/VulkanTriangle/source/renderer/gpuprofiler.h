@@ -0,0 +1,208 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_GPUPROFILER_H
+#define VULKAN_RENDERER_GPUPROFILER_H
+
+#include "uniquehandle.h"
+#include "vulkan/vulkan.h"
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// work done by the GPU within a counted scope
+struct PassCounters
+{
+    bool                                            occlusion = false; // whether samples_passed was counted
+    uint64_t                                        samples_passed = 0;
+    // name and count of each pipeline statistic requested of the profiler, in ascending order of their flags
+    std::vector<std::pair<const char *, uint64_t>>  statistics;
+};
+
+// GPU timings of named scopes, written as timestamp pairs into a query pool per frame in flight
+// results are resolved when the frame in flight is next begun, i.e. after its fence has signalled,
+// so reading them back never stalls
+// each resolved scope is exported, with the CPU time spent recording it, as a CSV row, and passed
+// to an optional listener
+// counted scopes, of which one may be active at a time, additionally have pipeline statistics and/or
+// occlusion queries around them, which are resolved alongside the timestamps; secondary command buffers
+// executed within them must inherit those queries
+// scopes must be recorded into the primary command buffer, from the thread that began the frame
+class GpuProfiler
+{
+public:
+    GpuProfiler(
+        const DeviceDispatch &inDispatch,
+        const uint32_t inFramesInFlight,
+        const uint32_t inMaxScopes,
+        const float inTimestampPeriod,
+        const uint32_t inTimestampValidBits,
+        const ::VkQueryPipelineStatisticFlags inPipelineStatistics, // 0 to not count pipeline statistics
+        const bool inOcclusion, // whether to count the samples passed
+        const std::string &inCsvPath); // empty to not write a CSV
+    ~GpuProfiler(); // logs the mean counters of each counted scope
+
+    GpuProfiler(const GpuProfiler &) = delete;
+    GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+    typedef std::function<void(const std::string &inScope, const double inGpuMilliseconds)> Listener;
+    typedef std::function<void(const std::string &inScope, const PassCounters &inCounters)> CounterListener;
+
+    // called as each scope is resolved, some frames after it was recorded
+    void
+    set_listener(
+        Listener inListener);
+
+    // called as each counted scope is resolved, after the listener
+    void
+    set_counter_listener(
+        CounterListener inListener);
+
+    // resolve the scopes last recorded for this frame in flight, and reset its queries
+    // must be recorded outside of a render pass
+    void
+    begin_frame(
+        ::VkCommandBuffer inCommandBuffer,
+        const uint32_t inFrameIndex);
+
+    // returns an index to pass to end_scope
+    // scopes beyond the maximum requested are ignored
+    // inCounted scopes are only counted while no other counted scope is active, and the profiler counts something
+    uint32_t
+    begin_scope(
+        ::VkCommandBuffer inCommandBuffer,
+        const char *inName,
+        const bool inCounted = false);
+
+    void
+    end_scope(
+        ::VkCommandBuffer inCommandBuffer,
+        const uint32_t inScope);
+
+    // begin_scope on construction, end_scope on end() or destruction; does nothing with a null profiler
+    // call end() explicitly if the command buffer is ended before the scope's destruction
+    class Scope
+    {
+    public:
+        Scope(
+            GpuProfiler *inProfiler,
+            ::VkCommandBuffer inCommandBuffer,
+            const char *inName,
+            const bool inCounted = false);
+        ~Scope();
+
+        void
+        end();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        GpuProfiler       *_profiler;
+        ::VkCommandBuffer  _command_buffer;
+        uint32_t           _scope;
+    };
+
+private:
+    typedef std::chrono::high_resolution_clock Clock;
+
+    static const uint32_t NOT_COUNTED = static_cast<uint32_t>(-1);
+
+    struct ScopeRecord
+    {
+        std::string       name;
+        Clock::time_point cpu_begin;
+        double            cpu_milliseconds = 0;
+        uint32_t          counter_query = NOT_COUNTED; // index into the frame's counter pools
+    };
+
+    struct CounterTotals
+    {
+        uint64_t              scopes = 0;
+        uint64_t              samples_passed = 0;
+        std::vector<uint64_t> statistics;
+    };
+
+    struct Frame
+    {
+        UniqueHandle<::VkQueryPool>                                          query_pool;
+        UniqueHandle<::VkQueryPool>                                          statistics_pool;
+        UniqueHandle<::VkQueryPool>                                          occlusion_pool;
+        uint32_t                                                             num_counted = 0;
+        std::vector<ScopeRecord>                                             scopes;
+        uint64_t                                                             frame_number = 0;
+        bool                                                                 pending = false;
+    };
+
+    void
+    resolve(
+        Frame &inFrame);
+
+    // whether the counter queries of a scope are available, reading them into outCounters if so
+    bool
+    resolve_counters(
+        const uint32_t inQuery,
+        PassCounters &outCounters) const;
+
+    bool
+    counting() const;
+
+    ::VkDevice                     _device;
+    PFN_vkCmdResetQueryPool        _cmd_reset_query_pool;
+    PFN_vkCmdWriteTimestamp        _cmd_write_timestamp;
+    PFN_vkCmdBeginQuery            _cmd_begin_query;
+    PFN_vkCmdEndQuery              _cmd_end_query;
+    PFN_vkGetQueryPoolResults      _get_query_pool_results;
+    uint32_t                       _max_scopes;
+    ::VkQueryPipelineStatisticFlags _pipeline_statistics;
+    std::vector<const char *>      _statistic_names; // of each requested statistic, in result order
+    bool                           _occlusion;
+    double                         _nanoseconds_per_tick;
+    uint64_t                       _timestamp_mask;
+    std::vector<Frame>             _frames;
+    Frame                         *_current = nullptr;
+    uint64_t                       _frame_number = 0;
+    std::vector<uint64_t>          _results;
+    std::vector<uint64_t>          _statistics_results;
+    std::vector<uint64_t>          _occlusion_results;
+    uint32_t                       _active_counted = NOT_COUNTED; // scope whose counter queries are active
+    std::map<std::string, CounterTotals> _counter_totals;
+    std::ofstream                  _csv;
+    Listener                       _listener;
+    CounterListener                _counter_listener;
+};
+
+#endif // VULKAN_RENDERER_GPUPROFILER_H
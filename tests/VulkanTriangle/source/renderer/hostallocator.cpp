@@ -0,0 +1,396 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "hostallocator.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+
+size_t
+align_up(
+    const size_t inValue,
+    const size_t inAlignment)
+{
+    return (inValue + inAlignment - 1) & ~(inAlignment - 1);
+}
+
+const char *
+scope_name(
+    const size_t inScope)
+{
+    switch (inScope)
+    {
+    case VK_SYSTEM_ALLOCATION_SCOPE_COMMAND:
+        return "command";
+    case VK_SYSTEM_ALLOCATION_SCOPE_OBJECT:
+        return "object";
+    case VK_SYSTEM_ALLOCATION_SCOPE_CACHE:
+        return "cache";
+    case VK_SYSTEM_ALLOCATION_SCOPE_DEVICE:
+        return "device";
+    case VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE:
+        return "instance";
+    default:
+        return "unknown";
+    }
+}
+
+} // anonymous namespace
+
+HostAllocator::HostAllocator()
+{
+    memset(&this->_callbacks, 0, sizeof(this->_callbacks));
+    this->_callbacks.pUserData = this;
+    this->_callbacks.pfnAllocation = allocation;
+    this->_callbacks.pfnReallocation = reallocation;
+    this->_callbacks.pfnFree = free;
+    this->_callbacks.pfnInternalAllocation = internal_allocation;
+    this->_callbacks.pfnInternalFree = internal_free;
+    std::fill(std::begin(this->_free_chunks), std::end(this->_free_chunks), nullptr);
+}
+
+HostAllocator::~HostAllocator()
+{
+    this->log_statistics();
+    for (auto block : this->_arena_blocks)
+    {
+        std::free(block);
+    }
+    for (auto slab : this->_slabs)
+    {
+        std::free(slab);
+    }
+}
+
+const ::VkAllocationCallbacks *
+HostAllocator::callbacks() const
+{
+    return &this->_callbacks;
+}
+
+HostAllocator::ScopeStatistics
+HostAllocator::statistics(
+    const ::VkSystemAllocationScope inScope) const
+{
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    return this->_statistics[inScope];
+}
+
+void
+HostAllocator::log_statistics() const
+{
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    Log().get() << "Host allocations by scope:" << std::endl;
+    for (size_t scope = 0; scope < NUM_SCOPES; ++scope)
+    {
+        const auto &statistics = this->_statistics[scope];
+        Log().get() << "\t" << scope_name(scope) << ": "
+            << statistics.allocations << " allocations, "
+            << statistics.reallocations << " reallocations, "
+            << statistics.frees << " frees, peak "
+            << statistics.peak_bytes << " bytes, "
+            << statistics.live_allocations << " live ("
+            << statistics.live_bytes << " bytes), internal peak "
+            << statistics.internal_peak_bytes << " bytes" << std::endl;
+    }
+    Log().get() << "\tarena of " << this->_arena_blocks.size() << " blocks rewound " << this->_arena_rewinds << " times, "
+        << this->_slabs.size() << " pool slabs, "
+        << this->_heap_allocations << " heap allocations" << std::endl;
+}
+
+void *VKAPI_PTR
+HostAllocator::allocation(
+    void                    *pUserData,
+    size_t                   size,
+    size_t                   alignment,
+    VkSystemAllocationScope  allocationScope)
+{
+    auto allocator = static_cast<HostAllocator *>(pUserData);
+    std::lock_guard<std::mutex> lock(allocator->_mutex);
+    auto memory = allocator->acquire(size, alignment, allocationScope);
+    if (nullptr != memory)
+    {
+        allocator->record_allocation(header_of(memory));
+    }
+    return memory;
+}
+
+void *VKAPI_PTR
+HostAllocator::reallocation(
+    void                    *pUserData,
+    void                    *pOriginal,
+    size_t                   size,
+    size_t                   alignment,
+    VkSystemAllocationScope  allocationScope)
+{
+    if (nullptr == pOriginal)
+    {
+        return allocation(pUserData, size, alignment, allocationScope);
+    }
+    if (0 == size)
+    {
+        free(pUserData, pOriginal);
+        return nullptr;
+    }
+
+    auto allocator = static_cast<HostAllocator *>(pUserData);
+    std::lock_guard<std::mutex> lock(allocator->_mutex);
+    auto &original = header_of(pOriginal);
+    ++allocator->_statistics[allocationScope].reallocations;
+
+    // a pooled chunk usually has room to grow, as the size classes are powers of two
+    if ((Source::Pool == original.source) && (0 == (reinterpret_cast<uintptr_t>(pOriginal) & (alignment - 1))))
+    {
+        const auto available = (size_t(1) << (MIN_CLASS_SHIFT + original.size_class)) - (static_cast<uint8_t *>(pOriginal) - static_cast<uint8_t *>(original.origin));
+        if (size <= available)
+        {
+            allocator->record_free(original);
+            original.size = size;
+            original.scope = allocationScope;
+            allocator->record_allocation(original);
+            return pOriginal;
+        }
+    }
+
+    // on failure, the original is left untouched
+    auto memory = allocator->acquire(size, alignment, allocationScope);
+    if (nullptr == memory)
+    {
+        return nullptr;
+    }
+    memcpy(memory, pOriginal, std::min(size, original.size));
+    allocator->record_allocation(header_of(memory));
+    allocator->record_free(original);
+    allocator->release(pOriginal);
+    return memory;
+}
+
+void VKAPI_PTR
+HostAllocator::free(
+    void                    *pUserData,
+    void                    *pMemory)
+{
+    if (nullptr == pMemory)
+    {
+        return;
+    }
+    auto allocator = static_cast<HostAllocator *>(pUserData);
+    std::lock_guard<std::mutex> lock(allocator->_mutex);
+    allocator->record_free(header_of(pMemory));
+    allocator->release(pMemory);
+}
+
+void VKAPI_PTR
+HostAllocator::internal_allocation(
+    void                     *pUserData,
+    size_t                    size,
+    VkInternalAllocationType  allocationType,
+    VkSystemAllocationScope   allocationScope)
+{
+    (void)allocationType;
+    auto allocator = static_cast<HostAllocator *>(pUserData);
+    std::lock_guard<std::mutex> lock(allocator->_mutex);
+    auto &statistics = allocator->_statistics[allocationScope];
+    statistics.internal_live_bytes += size;
+    statistics.internal_peak_bytes = std::max(statistics.internal_peak_bytes, statistics.internal_live_bytes);
+}
+
+void VKAPI_PTR
+HostAllocator::internal_free(
+    void                     *pUserData,
+    size_t                    size,
+    VkInternalAllocationType  allocationType,
+    VkSystemAllocationScope   allocationScope)
+{
+    (void)allocationType;
+    auto allocator = static_cast<HostAllocator *>(pUserData);
+    std::lock_guard<std::mutex> lock(allocator->_mutex);
+    allocator->_statistics[allocationScope].internal_live_bytes -= size;
+}
+
+void *
+HostAllocator::acquire(
+    const size_t inSize,
+    const size_t inAlignment,
+    const ::VkSystemAllocationScope inScope)
+{
+    // every underlying block is aligned at least as strictly as the header, which immediately precedes the
+    // memory handed out, so the header and the worst case padding always fit in this many bytes
+    const auto alignment = std::max(inAlignment, alignof(Header));
+    const auto bytes = sizeof(Header) + alignment + inSize;
+
+    void *origin = nullptr;
+    auto source = Source::Heap;
+    uint32_t size_class = 0;
+    if ((VK_SYSTEM_ALLOCATION_SCOPE_COMMAND == inScope) && (bytes <= ARENA_BLOCK_SIZE))
+    {
+        origin = this->acquire_arena(bytes);
+        source = Source::Arena;
+    }
+    else if (bytes <= (size_t(1) << MAX_CLASS_SHIFT))
+    {
+        while ((size_t(1) << (MIN_CLASS_SHIFT + size_class)) < bytes)
+        {
+            ++size_class;
+        }
+        origin = this->acquire_pool(size_class);
+        source = Source::Pool;
+    }
+    else
+    {
+        origin = std::malloc(bytes);
+        ++this->_heap_allocations;
+    }
+    if (nullptr == origin)
+    {
+        return nullptr;
+    }
+
+    auto memory = reinterpret_cast<void *>(align_up(reinterpret_cast<uintptr_t>(origin) + sizeof(Header), alignment));
+    auto &header = header_of(memory);
+    header.origin = origin;
+    header.size = inSize;
+    header.scope = inScope;
+    header.source = source;
+    header.size_class = size_class;
+    header.pad = 0;
+    return memory;
+}
+
+void
+HostAllocator::release(
+    void *inMemory)
+{
+    // copied, as returning a chunk to its free list overwrites the start of the block
+    const auto header = header_of(inMemory);
+    switch (header.source)
+    {
+    case Source::Arena:
+        // command scoped allocations are short lived, so the arena empties often, between commands
+        if (0 == --this->_arena_live)
+        {
+            this->_arena_block = 0;
+            this->_arena_offset = 0;
+            ++this->_arena_rewinds;
+        }
+        break;
+    case Source::Pool:
+        *static_cast<void **>(header.origin) = this->_free_chunks[header.size_class];
+        this->_free_chunks[header.size_class] = header.origin;
+        break;
+    case Source::Heap:
+        std::free(header.origin);
+        break;
+    }
+}
+
+void *
+HostAllocator::acquire_arena(
+    const size_t inBytes)
+{
+    if (!this->_arena_blocks.empty() && (this->_arena_offset + inBytes > ARENA_BLOCK_SIZE))
+    {
+        ++this->_arena_block;
+        this->_arena_offset = 0;
+    }
+    if (this->_arena_block == this->_arena_blocks.size())
+    {
+        auto block = std::malloc(ARENA_BLOCK_SIZE);
+        if (nullptr == block)
+        {
+            return nullptr;
+        }
+        this->_arena_blocks.push_back(block);
+    }
+    auto origin = static_cast<uint8_t *>(this->_arena_blocks[this->_arena_block]) + this->_arena_offset;
+    this->_arena_offset = align_up(this->_arena_offset + inBytes, alignof(Header));
+    ++this->_arena_live;
+    return origin;
+}
+
+void *
+HostAllocator::acquire_pool(
+    const uint32_t inSizeClass)
+{
+    auto &head = this->_free_chunks[inSizeClass];
+    if (nullptr == head)
+    {
+        // carve a new slab into chunks of the class, threaded onto its free list in address order
+        auto slab = static_cast<uint8_t *>(std::malloc(SLAB_SIZE));
+        if (nullptr == slab)
+        {
+            return nullptr;
+        }
+        this->_slabs.push_back(slab);
+        const auto chunk_size = size_t(1) << (MIN_CLASS_SHIFT + inSizeClass);
+        for (size_t offset = SLAB_SIZE; offset >= chunk_size; offset -= chunk_size)
+        {
+            auto chunk = slab + offset - chunk_size;
+            *reinterpret_cast<void **>(chunk) = head;
+            head = chunk;
+        }
+    }
+    auto chunk = head;
+    head = *static_cast<void **>(chunk);
+    return chunk;
+}
+
+void
+HostAllocator::record_allocation(
+    const Header &inHeader)
+{
+    auto &statistics = this->_statistics[inHeader.scope];
+    ++statistics.allocations;
+    ++statistics.live_allocations;
+    statistics.live_bytes += inHeader.size;
+    statistics.peak_bytes = std::max(statistics.peak_bytes, statistics.live_bytes);
+}
+
+void
+HostAllocator::record_free(
+    const Header &inHeader)
+{
+    auto &statistics = this->_statistics[inHeader.scope];
+    ++statistics.frees;
+    --statistics.live_allocations;
+    statistics.live_bytes -= inHeader.size;
+}
+
+HostAllocator::Header &
+HostAllocator::header_of(
+    void *inMemory)
+{
+    return *reinterpret_cast<Header *>(static_cast<uint8_t *>(inMemory) - sizeof(Header));
+}
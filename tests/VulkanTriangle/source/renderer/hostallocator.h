@@ -0,0 +1,189 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_HOSTALLOCATOR_H
+#define VULKAN_RENDERER_HOSTALLOCATOR_H
+
+#include "vulkan/vulkan.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// host memory for the Vulkan implementation's own allocations, handed to it as VkAllocationCallbacks
+// command scoped allocations, which live no longer than the command allocating them, are bumped from an arena
+// that rewinds whenever none are live; other allocations up to a size limit come from free lists of power of
+// two size classes; anything else comes from the C heap
+// every allocation is counted by VkSystemAllocationScope, as are the internal allocations the implementation
+// reports making itself
+// thread safe, as the implementation allocates on whichever thread calls into it
+class HostAllocator
+{
+public:
+    struct ScopeStatistics
+    {
+        uint64_t allocations = 0;        // including those moved by reallocation
+        uint64_t reallocations = 0;
+        uint64_t frees = 0;
+        uint64_t live_allocations = 0;
+        uint64_t live_bytes = 0;
+        uint64_t peak_bytes = 0;
+        uint64_t internal_live_bytes = 0; // made by the implementation itself, and only reported to us
+        uint64_t internal_peak_bytes = 0;
+    };
+
+    HostAllocator();
+
+    // logs the statistics of each scope; the instance and everything created through it must be destroyed first
+    ~HostAllocator();
+
+    HostAllocator(const HostAllocator &) = delete;
+    HostAllocator &operator=(const HostAllocator &) = delete;
+
+    // valid for the lifetime of the allocator; pass to every vkCreate*, vkAllocate* and matching vkDestroy*, vkFree*
+    const ::VkAllocationCallbacks *
+    callbacks() const;
+
+    ScopeStatistics
+    statistics(
+        const ::VkSystemAllocationScope inScope) const;
+
+    void
+    log_statistics() const;
+
+private:
+    enum class Source : uint32_t
+    {
+        Arena,
+        Pool,
+        Heap
+    };
+
+    // precedes every allocation handed out, recording how to release it
+    struct Header
+    {
+        void     *origin;     // start of the underlying block
+        size_t    size;       // as requested
+        uint32_t  scope;
+        Source    source;
+        uint32_t  size_class; // for Source::Pool
+        uint32_t  pad;
+    };
+
+    static const size_t   NUM_SCOPES = VK_SYSTEM_ALLOCATION_SCOPE_RANGE_SIZE;
+    static const uint32_t MIN_CLASS_SHIFT = 5;    // 32 bytes
+    static const uint32_t MAX_CLASS_SHIFT = 12;   // 4 KiB
+    static const size_t   NUM_CLASSES = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1;
+    static const size_t   SLAB_SIZE = 64 * 1024; // carved into chunks of one size class
+    static const size_t   ARENA_BLOCK_SIZE = 64 * 1024;
+
+    static void *VKAPI_PTR
+    allocation(
+        void                    *pUserData,
+        size_t                   size,
+        size_t                   alignment,
+        VkSystemAllocationScope  allocationScope);
+
+    static void *VKAPI_PTR
+    reallocation(
+        void                    *pUserData,
+        void                    *pOriginal,
+        size_t                   size,
+        size_t                   alignment,
+        VkSystemAllocationScope  allocationScope);
+
+    static void VKAPI_PTR
+    free(
+        void                    *pUserData,
+        void                    *pMemory);
+
+    static void VKAPI_PTR
+    internal_allocation(
+        void                     *pUserData,
+        size_t                    size,
+        VkInternalAllocationType  allocationType,
+        VkSystemAllocationScope   allocationScope);
+
+    static void VKAPI_PTR
+    internal_free(
+        void                     *pUserData,
+        size_t                    size,
+        VkInternalAllocationType  allocationType,
+        VkSystemAllocationScope   allocationScope);
+
+    // the following are called with _mutex held
+    void *
+    acquire(
+        const size_t inSize,
+        const size_t inAlignment,
+        const ::VkSystemAllocationScope inScope);
+
+    void
+    release(
+        void *inMemory);
+
+    void *
+    acquire_arena(
+        const size_t inBytes);
+
+    void *
+    acquire_pool(
+        const uint32_t inSizeClass);
+
+    void
+    record_allocation(
+        const Header &inHeader);
+
+    void
+    record_free(
+        const Header &inHeader);
+
+    static Header &
+    header_of(
+        void *inMemory);
+
+    ::VkAllocationCallbacks      _callbacks;
+    mutable std::mutex           _mutex;
+    ScopeStatistics              _statistics[NUM_SCOPES];
+
+    // command scope arena; rewound to its first block whenever _arena_live falls to zero
+    std::vector<void *>          _arena_blocks;
+    size_t                       _arena_block = 0;
+    size_t                       _arena_offset = 0;
+    uint64_t                     _arena_live = 0;
+    uint64_t                     _arena_rewinds = 0;
+
+    // size class pools; each free chunk stores the next free chunk of its class
+    std::vector<void *>          _slabs;
+    void                        *_free_chunks[NUM_CLASSES];
+    uint64_t                     _heap_allocations = 0;
+};
+
+#endif // VULKAN_RENDERER_HOSTALLOCATOR_H
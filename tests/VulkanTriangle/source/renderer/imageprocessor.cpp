@@ -0,0 +1,641 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "imageprocessor.h"
+#include "impl.h"
+#include "exception.h"
+#include "layoutcache.h"
+#include "log.h"
+#include "shaderreflection.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+
+const uint32_t GROUP_SIZE = 8; // local_size_x and local_size_y of the shaders
+
+// matches the push constant block of the shaders
+struct Extents
+{
+    uint32_t source[2];
+    uint32_t destination[2];
+};
+
+uint32_t
+channel(
+    const uint32_t inTexel,
+    const uint32_t inIndex)
+{
+    return (inTexel >> (8 * inIndex)) & 0xFF;
+}
+
+uint32_t
+pack(
+    const uint32_t inChannels[4])
+{
+    return inChannels[0] | (inChannels[1] << 8) | (inChannels[2] << 16) | (inChannels[3] << 24);
+}
+
+uint32_t
+clamped_texel(
+    const HostImage &inImage,
+    const int64_t inX,
+    const int64_t inY)
+{
+    const auto x = static_cast<uint32_t>(std::min<int64_t>(std::max<int64_t>(inX, 0), inImage.width - 1));
+    const auto y = static_cast<uint32_t>(std::min<int64_t>(std::max<int64_t>(inY, 0), inImage.height - 1));
+    return inImage.texels[y * inImage.width + x];
+}
+
+// filter.comp
+HostImage
+reference_filter(
+    const HostImage &inSource)
+{
+    HostImage result = inSource;
+    for (auto y = 0u; y < inSource.height; ++y)
+    {
+        for (auto x = 0u; x < inSource.width; ++x)
+        {
+            uint32_t sum[4] = { 0, 0, 0, 0 };
+            for (auto dy = -1; dy <= 1; ++dy)
+            {
+                for (auto dx = -1; dx <= 1; ++dx)
+                {
+                    const auto weight = static_cast<uint32_t>((2 - std::abs(dx)) * (2 - std::abs(dy)));
+                    const auto texel = clamped_texel(inSource, static_cast<int64_t>(x) + dx, static_cast<int64_t>(y) + dy);
+                    for (auto c = 0u; c < 4; ++c)
+                    {
+                        sum[c] += weight * channel(texel, c);
+                    }
+                }
+            }
+            for (auto c = 0u; c < 4; ++c)
+            {
+                sum[c] = (sum[c] + 8) >> 4;
+            }
+            result.texels[y * inSource.width + x] = pack(sum);
+        }
+    }
+    return result;
+}
+
+// convert.comp
+HostImage
+reference_convert(
+    const HostImage &inSource)
+{
+    HostImage result = inSource;
+    for (auto &texel : result.texels)
+    {
+        const auto alpha = channel(texel, 3);
+        uint32_t premultiplied[4];
+        for (auto c = 0u; c < 3; ++c)
+        {
+            premultiplied[2 - c] = (channel(texel, c) * alpha + 127) / 255;
+        }
+        premultiplied[3] = alpha;
+        texel = pack(premultiplied);
+    }
+    return result;
+}
+
+// downsample.comp
+HostImage
+reference_downsample(
+    const HostImage &inSource)
+{
+    HostImage result;
+    result.width = std::max(1u, inSource.width / 2);
+    result.height = std::max(1u, inSource.height / 2);
+    result.texels.resize(result.width * result.height);
+    for (auto y = 0u; y < result.height; ++y)
+    {
+        for (auto x = 0u; x < result.width; ++x)
+        {
+            uint32_t sum[4] = { 0, 0, 0, 0 };
+            for (auto i = 0u; i < 4; ++i)
+            {
+                // min rather than clamping below, as the shader works in unsigned coordinates
+                const auto sx = std::min(2 * x + (i & 1), inSource.width - 1);
+                const auto sy = std::min(2 * y + (i >> 1), inSource.height - 1);
+                const auto texel = inSource.texels[sy * inSource.width + sx];
+                for (auto c = 0u; c < 4; ++c)
+                {
+                    sum[c] += channel(texel, c);
+                }
+            }
+            for (auto c = 0u; c < 4; ++c)
+            {
+                sum[c] = (sum[c] + 2) >> 2;
+            }
+            result.texels[y * result.width + x] = pack(sum);
+        }
+    }
+    return result;
+}
+
+} // anonymous namespace
+
+ImageProcessor::ImageProcessor(
+    const DeviceDispatch &inDispatch,
+    const ::VkPhysicalDeviceMemoryProperties &inMemoryProperties,
+    const uint32_t inQueueFamily,
+    ::VkQueue inQueue,
+    LayoutCache &inLayoutCache,
+    const Shaders &inShaders)
+    :
+    _dispatch(inDispatch),
+    _device(inDispatch.device),
+    _memory_properties(inMemoryProperties),
+    _timeline(inDispatch, inQueue)
+{
+    auto device = this->_device;
+
+    // the three shaders have the same interface, so share a layout
+    ShaderReflection reflection(inShaders.filter, VK_SHADER_STAGE_COMPUTE_BIT);
+    reflection.merge(ShaderReflection(inShaders.convert, VK_SHADER_STAGE_COMPUTE_BIT));
+    reflection.merge(ShaderReflection(inShaders.downsample, VK_SHADER_STAGE_COMPUTE_BIT));
+    const auto set_layouts = inLayoutCache.descriptor_set_layouts(reflection);
+    if (1 != set_layouts.size())
+    {
+        throw Exception("Image processing shaders are expected to use a single descriptor set");
+    }
+    this->_set_layout = set_layouts[0];
+    this->_pipeline_layout = inLayoutCache.pipeline_layout(reflection);
+
+    auto createShaderModuleFn = GETDFN(device, vkCreateShaderModule);
+    auto createComputePipelinesFn = GETDFN(device, vkCreateComputePipelines);
+    auto create_pipeline = [&](const std::vector<uint32_t> &inCode)
+    {
+        ::VkShaderModuleCreateInfo moduleInfo;
+        memset(&moduleInfo, 0, sizeof(moduleInfo));
+        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = inCode.size() * sizeof(uint32_t);
+        moduleInfo.pCode = inCode.data();
+        ::VkShaderModule module;
+        VK_ERR_CHECK(createShaderModuleFn(
+            device,
+            &moduleInfo,
+            this->_dispatch.allocator,
+            &module
+        ));
+        UniqueHandle<::VkShaderModule> shader_module(this->_dispatch, module);
+
+        ::VkComputePipelineCreateInfo createInfo;
+        memset(&createInfo, 0, sizeof(createInfo));
+        createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        createInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        createInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        createInfo.stage.module = module;
+        createInfo.stage.pName = "main";
+        createInfo.layout = this->_pipeline_layout;
+        ::VkPipeline pipeline;
+        VK_ERR_CHECK(createComputePipelinesFn(
+            device,
+            VK_NULL_HANDLE,
+            1,
+            &createInfo,
+            this->_dispatch.allocator,
+            &pipeline
+        ));
+        return UniqueHandle<::VkPipeline>(this->_dispatch, pipeline);
+    };
+    this->_filter_pipeline = create_pipeline(inShaders.filter);
+    this->_convert_pipeline = create_pipeline(inShaders.convert);
+    this->_downsample_pipeline = create_pipeline(inShaders.downsample);
+
+    // command buffers are allocated per job, and freed when it is collected
+    ::VkCommandPoolCreateInfo poolInfo;
+    memset(&poolInfo, 0, sizeof(poolInfo));
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = inQueueFamily;
+    auto createCommandPoolFn = GETDFN(device, vkCreateCommandPool);
+    ::VkCommandPool pool;
+    VK_ERR_CHECK(createCommandPoolFn(
+        device,
+        &poolInfo,
+        this->_dispatch.allocator,
+        &pool
+    ));
+    this->_command_pool = { this->_dispatch, pool };
+    Log().get() << "Image processing on queue family " << inQueueFamily << std::endl;
+}
+
+ImageProcessor::~ImageProcessor() = default;
+
+ImageProcessor::Ticket
+ImageProcessor::process(
+    const HostImage &inSource)
+{
+    auto device = this->_device;
+    Job job;
+    job.images.push_back(this->create_image_buffer(inSource.width, inSource.height));
+    job.images.push_back(this->create_image_buffer(inSource.width, inSource.height));
+    job.images.push_back(this->create_image_buffer(inSource.width, inSource.height));
+    auto width = inSource.width;
+    auto height = inSource.height;
+    while ((width > 1) || (height > 1))
+    {
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+        job.images.push_back(this->create_image_buffer(width, height));
+    }
+
+    auto mapMemoryFn = GETDFN(device, vkMapMemory);
+    auto unmapMemoryFn = GETDFN(device, vkUnmapMemory);
+    void *mapped = nullptr;
+    VK_ERR_CHECK(mapMemoryFn(
+        device,
+        job.images[0].memory.get(),
+        0,
+        VK_WHOLE_SIZE,
+        0,
+        &mapped
+    ));
+    memcpy(mapped, inSource.texels.data(), inSource.texels.size() * sizeof(uint32_t));
+    unmapMemoryFn(device, job.images[0].memory.get());
+
+    // one set per dispatch, each reading one image and writing the next
+    const auto num_dispatches = static_cast<uint32_t>(job.images.size() - 1);
+    ::VkDescriptorPoolSize poolSize;
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = 2 * num_dispatches;
+    ::VkDescriptorPoolCreateInfo poolInfo;
+    memset(&poolInfo, 0, sizeof(poolInfo));
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = num_dispatches;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    auto createDescriptorPoolFn = GETDFN(device, vkCreateDescriptorPool);
+    ::VkDescriptorPool descriptorPool;
+    VK_ERR_CHECK_QUIET(createDescriptorPoolFn(
+        device,
+        &poolInfo,
+        this->_dispatch.allocator,
+        &descriptorPool
+    ));
+    job.descriptor_pool = { this->_dispatch, descriptorPool };
+
+    // one command buffer per stage
+    job.command_buffers.resize(3);
+    ::VkCommandBufferAllocateInfo allocInfo;
+    memset(&allocInfo, 0, sizeof(allocInfo));
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = this->_command_pool.get();
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = static_cast<uint32_t>(job.command_buffers.size());
+    auto allocateCommandBuffersFn = GETDFN(device, vkAllocateCommandBuffers);
+    VK_ERR_CHECK_QUIET(allocateCommandBuffersFn(
+        device,
+        &allocInfo,
+        job.command_buffers.data()
+    ));
+
+    ::VkCommandBufferBeginInfo beginInfo;
+    memset(&beginInfo, 0, sizeof(beginInfo));
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    auto beginCommandBufferFn = GETDFN(device, vkBeginCommandBuffer);
+    auto endCommandBufferFn = GETDFN(device, vkEndCommandBuffer);
+    auto cmdPipelineBarrierFn = GETDFN(device, vkCmdPipelineBarrier);
+
+    // every stage's results are read back, so are made visible to the host once written
+    // dependencies between stages are covered by the timeline's semaphores
+    ::VkMemoryBarrier hostBarrier;
+    memset(&hostBarrier, 0, sizeof(hostBarrier));
+    hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    hostBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    ::VkMemoryBarrier levelBarrier = hostBarrier;
+    levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    for (auto stage = 0u; stage < job.command_buffers.size(); ++stage)
+    {
+        auto commandBuffer = job.command_buffers[stage];
+        VK_ERR_CHECK_QUIET(beginCommandBufferFn(
+            commandBuffer,
+            &beginInfo
+        ));
+        switch (stage)
+        {
+            case 0:
+                this->record_dispatch(commandBuffer, this->_filter_pipeline.get(), descriptorPool, job.images[0], job.images[1]);
+                break;
+
+            case 1:
+                this->record_dispatch(commandBuffer, this->_convert_pipeline.get(), descriptorPool, job.images[1], job.images[2]);
+                break;
+
+            default:
+                // each level reads the one before, within the stage
+                for (auto level = 3u; level < job.images.size(); ++level)
+                {
+                    if (level > 3)
+                    {
+                        cmdPipelineBarrierFn(
+                            commandBuffer,
+                            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                            0,
+                            1, &levelBarrier,
+                            0, nullptr,
+                            0, nullptr
+                        );
+                    }
+                    this->record_dispatch(commandBuffer, this->_downsample_pipeline.get(), descriptorPool, job.images[level - 1], job.images[level]);
+                }
+                break;
+        }
+        cmdPipelineBarrierFn(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_HOST_BIT,
+            0,
+            1, &hostBarrier,
+            0, nullptr,
+            0, nullptr
+        );
+        VK_ERR_CHECK_QUIET(endCommandBufferFn(
+            commandBuffer
+        ));
+    }
+
+    // each stage waits for the previous, as if they were issued by independent systems
+    Ticket value = 0;
+    for (auto commandBuffer : job.command_buffers)
+    {
+        std::vector<Timeline::Wait> waits;
+        if (value > 0)
+        {
+            waits.push_back({ &this->_timeline, value, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT });
+        }
+        value = this->_timeline.submit({ commandBuffer }, waits);
+    }
+    this->_jobs[value] = std::move(job);
+    return value;
+}
+
+bool
+ImageProcessor::is_complete(
+    const Ticket inTicket)
+{
+    return this->_timeline.completed() >= inTicket;
+}
+
+std::vector<HostImage>
+ImageProcessor::collect(
+    const Ticket inTicket)
+{
+    auto job_it = this->_jobs.find(inTicket);
+    if (job_it == this->_jobs.end())
+    {
+        throw Exception("Unknown image processing ticket");
+    }
+    this->_timeline.wait(inTicket);
+
+    auto device = this->_device;
+    auto &job = job_it->second;
+    auto mapMemoryFn = GETDFN(device, vkMapMemory);
+    auto unmapMemoryFn = GETDFN(device, vkUnmapMemory);
+    std::vector<HostImage> results;
+    for (auto i = 1u; i < job.images.size(); ++i)
+    {
+        const auto &image = job.images[i];
+        HostImage result;
+        result.width = image.width;
+        result.height = image.height;
+        result.texels.resize(image.width * image.height);
+        void *mapped = nullptr;
+        VK_ERR_CHECK_QUIET(mapMemoryFn(
+            device,
+            image.memory.get(),
+            0,
+            VK_WHOLE_SIZE,
+            0,
+            &mapped
+        ));
+        memcpy(result.texels.data(), mapped, result.texels.size() * sizeof(uint32_t));
+        unmapMemoryFn(device, image.memory.get());
+        results.push_back(std::move(result));
+    }
+
+    auto freeCommandBuffersFn = GETDFN(device, vkFreeCommandBuffers);
+    freeCommandBuffersFn(
+        device,
+        this->_command_pool.get(),
+        static_cast<uint32_t>(job.command_buffers.size()),
+        job.command_buffers.data()
+    );
+    this->_jobs.erase(job_it);
+    return results;
+}
+
+std::vector<HostImage>
+ImageProcessor::reference(
+    const HostImage &inSource)
+{
+    std::vector<HostImage> results;
+    results.push_back(reference_filter(inSource));
+    results.push_back(reference_convert(results.back()));
+    while ((results.back().width > 1) || (results.back().height > 1))
+    {
+        results.push_back(reference_downsample(results.back()));
+    }
+    return results;
+}
+
+HostImage
+ImageProcessor::test_image(
+    const uint32_t inWidth,
+    const uint32_t inHeight)
+{
+    HostImage image;
+    image.width = inWidth;
+    image.height = inHeight;
+    image.texels.resize(inWidth * inHeight);
+    for (auto y = 0u; y < inHeight; ++y)
+    {
+        for (auto x = 0u; x < inWidth; ++x)
+        {
+            // integer hash, so that neighbouring texels differ in every channel
+            auto value = (x * 73856093u) ^ (y * 19349663u);
+            value ^= value >> 13;
+            value *= 0x5bd1e995u;
+            value ^= value >> 15;
+            image.texels[y * inWidth + x] = value;
+        }
+    }
+    return image;
+}
+
+ImageProcessor::Buffer
+ImageProcessor::create_image_buffer(
+    const uint32_t inWidth,
+    const uint32_t inHeight) const
+{
+    auto device = this->_device;
+
+    ::VkBufferCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+    createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    createInfo.size = static_cast<::VkDeviceSize>(inWidth) * inHeight * sizeof(uint32_t);
+    createInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    auto createBufferFn = GETDFN(device, vkCreateBuffer);
+    ::VkBuffer buffer;
+    VK_ERR_CHECK_QUIET(createBufferFn(
+        device,
+        &createInfo,
+        this->_dispatch.allocator,
+        &buffer
+    ));
+
+    Buffer result;
+    result.buffer = { this->_dispatch, buffer };
+    result.width = inWidth;
+    result.height = inHeight;
+
+    auto getBufferMemoryRequirementsFn = GETDFN(device, vkGetBufferMemoryRequirements);
+    ::VkMemoryRequirements requirements;
+    getBufferMemoryRequirementsFn(
+        device,
+        buffer,
+        &requirements
+    );
+
+    ::VkMemoryAllocateInfo allocateInfo;
+    memset(&allocateInfo, 0, sizeof(allocateInfo));
+    allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize = requirements.size;
+    allocateInfo.memoryTypeIndex = this->find_memory_type(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    auto allocateMemoryFn = GETDFN(device, vkAllocateMemory);
+    ::VkDeviceMemory memory;
+    VK_ERR_CHECK_QUIET(allocateMemoryFn(
+        device,
+        &allocateInfo,
+        this->_dispatch.allocator,
+        &memory
+    ));
+    result.memory = { this->_dispatch, memory };
+
+    auto bindBufferMemoryFn = GETDFN(device, vkBindBufferMemory);
+    VK_ERR_CHECK_QUIET(bindBufferMemoryFn(
+        device,
+        buffer,
+        memory,
+        0
+    ));
+    return result;
+}
+
+uint32_t
+ImageProcessor::find_memory_type(
+    const uint32_t inTypeBits,
+    const ::VkMemoryPropertyFlags inProperties) const
+{
+    for (auto i = 0u; i < this->_memory_properties.memoryTypeCount; ++i)
+    {
+        if ((inTypeBits & (1u << i)) && (inProperties == (this->_memory_properties.memoryTypes[i].propertyFlags & inProperties)))
+        {
+            return i;
+        }
+    }
+    throw Exception("No memory type suitable for image processing buffers");
+}
+
+void
+ImageProcessor::record_dispatch(
+    ::VkCommandBuffer inCommandBuffer,
+    ::VkPipeline inPipeline,
+    ::VkDescriptorPool inPool,
+    const Buffer &inSource,
+    const Buffer &inDestination) const
+{
+    auto device = this->_device;
+    ::VkDescriptorSetAllocateInfo allocInfo;
+    memset(&allocInfo, 0, sizeof(allocInfo));
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = inPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &this->_set_layout;
+    auto allocateDescriptorSetsFn = GETDFN(device, vkAllocateDescriptorSets);
+    ::VkDescriptorSet set;
+    VK_ERR_CHECK_QUIET(allocateDescriptorSetsFn(
+        device,
+        &allocInfo,
+        &set
+    ));
+
+    ::VkDescriptorBufferInfo bufferInfos[2];
+    memset(bufferInfos, 0, sizeof(bufferInfos));
+    bufferInfos[0].buffer = inSource.buffer.get();
+    bufferInfos[0].range = VK_WHOLE_SIZE;
+    bufferInfos[1].buffer = inDestination.buffer.get();
+    bufferInfos[1].range = VK_WHOLE_SIZE;
+    ::VkWriteDescriptorSet writes[2];
+    memset(writes, 0, sizeof(writes));
+    for (auto i = 0u; i < 2; ++i)
+    {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].pBufferInfo = &bufferInfos[i];
+    }
+    auto updateDescriptorSetsFn = GETDFN(device, vkUpdateDescriptorSets);
+    updateDescriptorSetsFn(device, 2, writes, 0, nullptr);
+
+    Extents extents;
+    extents.source[0] = inSource.width;
+    extents.source[1] = inSource.height;
+    extents.destination[0] = inDestination.width;
+    extents.destination[1] = inDestination.height;
+
+    auto cmdBindPipelineFn = GETDFN(device, vkCmdBindPipeline);
+    auto cmdBindDescriptorSetsFn = GETDFN(device, vkCmdBindDescriptorSets);
+    auto cmdPushConstantsFn = GETDFN(device, vkCmdPushConstants);
+    auto cmdDispatchFn = GETDFN(device, vkCmdDispatch);
+    cmdBindPipelineFn(inCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, inPipeline);
+    cmdBindDescriptorSetsFn(inCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->_pipeline_layout, 0, 1, &set, 0, nullptr);
+    cmdPushConstantsFn(inCommandBuffer, this->_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(extents), &extents);
+    cmdDispatchFn(
+        inCommandBuffer,
+        (inDestination.width + GROUP_SIZE - 1) / GROUP_SIZE,
+        (inDestination.height + GROUP_SIZE - 1) / GROUP_SIZE,
+        1
+    );
+}
@@ -0,0 +1,161 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_IMAGEPROCESSOR_H
+#define VULKAN_RENDERER_IMAGEPROCESSOR_H
+
+#include "timeline.h"
+#include "uniquehandle.h"
+#include "vulkan/vulkan.h"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+class LayoutCache;
+
+// an RGBA8 image in host memory, one texel per element with the first channel in the least significant byte
+struct HostImage
+{
+    uint32_t              width = 0;
+    uint32_t              height = 0;
+    std::vector<uint32_t> texels;
+};
+
+// texture processing in compute shaders, on a queue that may run asynchronously to rendering
+// a job filters its source, converts the result to premultiplied BGRA, then generates a full mip chain from that,
+// each stage a separate submission chained to the last through a Timeline
+// the shaders use integer arithmetic only, so that results are bit exact against the CPU reference
+// images are in host visible storage buffers, as they are uploaded and read back by the host
+// all functions are to be called from a single thread
+class ImageProcessor
+{
+public:
+    // SPIR-V of filter.comp, convert.comp and downsample.comp, which share a resource interface
+    struct Shaders
+    {
+        std::vector<uint32_t> filter;
+        std::vector<uint32_t> convert;
+        std::vector<uint32_t> downsample;
+    };
+
+    // the timeline value at which a job is complete
+    typedef uint64_t Ticket;
+
+    ImageProcessor(
+        const DeviceDispatch &inDispatch,
+        const ::VkPhysicalDeviceMemoryProperties &inMemoryProperties,
+        const uint32_t inQueueFamily,
+        ::VkQueue inQueue,
+        LayoutCache &inLayoutCache,
+        const Shaders &inShaders);
+
+    // waits for outstanding jobs
+    ~ImageProcessor();
+
+    ImageProcessor(const ImageProcessor &) = delete;
+    ImageProcessor &operator=(const ImageProcessor &) = delete;
+
+    Ticket
+    process(
+        const HostImage &inSource);
+
+    // without blocking
+    bool
+    is_complete(
+        const Ticket inTicket);
+
+    // blocks until the job is complete, then releases it
+    // the filtered image, the converted image, then each mip level below it down to 1x1
+    std::vector<HostImage>
+    collect(
+        const Ticket inTicket);
+
+    // the results of a job, computed on the CPU
+    static std::vector<HostImage>
+    reference(
+        const HostImage &inSource);
+
+    // a deterministic image exercising every channel and odd extents
+    static HostImage
+    test_image(
+        const uint32_t inWidth,
+        const uint32_t inHeight);
+
+private:
+    // declared such that the buffer is destroyed before its memory is freed
+    struct Buffer
+    {
+        UniqueHandle<::VkDeviceMemory> memory;
+        UniqueHandle<::VkBuffer>       buffer;
+        uint32_t                       width = 0;
+        uint32_t                       height = 0;
+    };
+
+    struct Job
+    {
+        std::vector<Buffer>              images; // source, filtered, converted, mips
+        UniqueHandle<::VkDescriptorPool> descriptor_pool;
+        std::vector<::VkCommandBuffer>   command_buffers;
+    };
+
+    Buffer
+    create_image_buffer(
+        const uint32_t inWidth,
+        const uint32_t inHeight) const;
+
+    uint32_t
+    find_memory_type(
+        const uint32_t inTypeBits,
+        const ::VkMemoryPropertyFlags inProperties) const;
+
+    // one dispatch of inPipeline from inSource to inDestination, using a new set from inPool
+    void
+    record_dispatch(
+        ::VkCommandBuffer inCommandBuffer,
+        ::VkPipeline inPipeline,
+        ::VkDescriptorPool inPool,
+        const Buffer &inSource,
+        const Buffer &inDestination) const;
+
+    const DeviceDispatch              &_dispatch;
+    ::VkDevice                         _device;
+    ::VkPhysicalDeviceMemoryProperties _memory_properties;
+    ::VkDescriptorSetLayout            _set_layout;      // owned by the layout cache
+    ::VkPipelineLayout                 _pipeline_layout; // owned by the layout cache
+    UniqueHandle<::VkPipeline>         _filter_pipeline;
+    UniqueHandle<::VkPipeline>         _convert_pipeline;
+    UniqueHandle<::VkPipeline>         _downsample_pipeline;
+    UniqueHandle<::VkCommandPool>      _command_pool;
+    std::map<Ticket, Job>              _jobs;
+    // declared last, so that outstanding submissions complete before the jobs they use are destroyed
+    Timeline                           _timeline;
+};
+
+#endif // VULKAN_RENDERER_IMAGEPROCESSOR_H
@@ -29,8 +29,29 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "impl.h"
 #include "exception.h"
+#include "threadpool.h"
+#include "benchmark.h"
+#include "gpuprofiler.h"
+#include "framestats.h"
+#include "rendergraph.h"
+#include "shadercompiler.h"
+#include "shaderreflection.h"
+#include "layoutcache.h"
+#include "pipelinecompiler.h"
+#include "pipelinevariants.h"
+#include "instancedscene.h"
+#include "imageprocessor.h"
+#include "deletionqueue.h"
+#include "hostallocator.h"
+#include "capabilityreport.h"
+#include "uniformring.h"
+#include "framecapture.h"
+#include "debugreportsink.h"
+#include "texturecache.h"
 #include "log.h"
 
+#include "texture.h"
+
 #include "../appwindow.h"
 
 #if defined(D_BAM_PLATFORM_OSX)
@@ -39,12 +60,19 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <algorithm>
 #include <array>
+#include <cmath>
 #include <functional>
 #include <vector>
 #include <fstream>
+#include <limits>
+#include <map>
+#include <thread>
+#include <sstream>
 
 #if defined(D_BAM_PLATFORM_OSX)
 #include <mach-o/dyld.h> // for _NSGetExecutablePath
+#elif defined(D_BAM_PLATFORM_LINUX)
+#include <unistd.h> // for readlink
 #endif
 
 namespace
@@ -64,6 +92,17 @@ readFile(
     std::string executable_dir(executable_path);
     executable_dir = executable_dir.substr(0, executable_dir.find_last_of("/") + 1);
     const std::string path = executable_dir + inFilename;
+#elif defined(D_BAM_PLATFORM_LINUX)
+    // alongside the executable, rather than in the working directory, which under a test harness is arbitrary
+    char executable_path[1024];
+    const auto length = ::readlink("/proc/self/exe", executable_path, sizeof(executable_path) - 1);
+    if (length < 0)
+    {
+        throw std::runtime_error("Unable to locate the executable");
+    }
+    std::string executable_dir(executable_path, static_cast<size_t>(length));
+    executable_dir = executable_dir.substr(0, executable_dir.find_last_of("/") + 1);
+    const std::string path = executable_dir + inFilename;
 #else
     const auto path = inFilename;
 #endif
@@ -83,41 +122,141 @@ readFile(
 
 ::VkShaderModule
 createShaderModule(
-    const std::vector<char> &inCode,
-    ::VkDevice inDevice)
+    const std::vector<uint32_t> &inCode,
+    ::VkDevice inDevice,
+    const ::VkAllocationCallbacks *inAllocator)
 {
     ::VkShaderModuleCreateInfo createInfo;
     memset(&createInfo, 0, sizeof(createInfo));
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = inCode.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(inCode.data());
+    createInfo.codeSize = inCode.size() * sizeof(uint32_t);
+    createInfo.pCode = inCode.data();
 
     ::VkShaderModule shaderModule;
     VK_ERR_CHECK(::vkCreateShaderModule(
         inDevice,
         &createInfo,
-        nullptr,
+        inAllocator,
         &shaderModule
     ));
     return shaderModule;
 }
 
+void
+blit_image(
+    ::VkCommandBuffer inCommandBuffer,
+    ::VkImage inSrc,
+    const ::VkExtent2D &inSrcExtent,
+    ::VkImage inDst,
+    const ::VkExtent2D &inDstExtent,
+    const ::VkFilter inFilter)
+{
+    ::VkImageBlit region;
+    memset(&region, 0, sizeof(region));
+    region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.srcSubresource.layerCount = 1;
+    region.srcOffsets[1].x = static_cast<int32_t>(inSrcExtent.width);
+    region.srcOffsets[1].y = static_cast<int32_t>(inSrcExtent.height);
+    region.srcOffsets[1].z = 1;
+    region.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.dstSubresource.layerCount = 1;
+    region.dstOffsets[1].x = static_cast<int32_t>(inDstExtent.width);
+    region.dstOffsets[1].y = static_cast<int32_t>(inDstExtent.height);
+    region.dstOffsets[1].z = 1;
+    vkCmdBlitImage(
+        inCommandBuffer,
+        inSrc,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        inDst,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        1,
+        &region,
+        inFilter
+    );
+}
+
+// the most recording threads per hardware thread; beyond a few, more threads and command pools only add contention
+const uint32_t RECORDING_THREADS_PER_CORE = 4;
+
+// draw counts swept by the benchmarks, from which the uniform ring is sized too
+const uint32_t DYNAMIC_BENCHMARK_DRAWS[] = { 1, 1000, 10000, 100000 };
+const uint32_t RECORDING_BENCHMARK_DRAWS[] = { 10000, 100000, 1000000 };
+
+// the interface of shader.vert; each must match its block there
+struct FrameUniforms
+{
+    float time[4]; // x seconds since startup
+};
+
+// per-object uniforms are allocated a block at a time, each bound by one dynamic offset and indexed by a push constant,
+// as a block per draw would cost a descriptor set bind per draw, and minUniformBufferOffsetAlignment bytes per object
+const uint32_t OBJECTS_PER_BLOCK = 256;
+
+struct ObjectUniforms
+{
+    float colour[OBJECTS_PER_BLOCK][4];
+};
+
+struct DrawConstants
+{
+    float    placement[4]; // xy offset, z scale, w rotation
+    uint32_t object;       // index into the bound ObjectUniforms block
+};
+
 } // anonymous namespace
 
 Renderer::Impl::Impl(
-    AppWindow *inWindow)
+    AppWindow *inWindow,
+    const RendererSettings &inSettings)
     :
+    _settings(inSettings),
+    _host_allocator(inSettings.host_allocator ? new HostAllocator() : nullptr),
+    _allocation_callbacks(this->_host_allocator ? this->_host_allocator->callbacks() : nullptr),
     _instance(nullptr, nullptr),
     _debug_callback(nullptr, nullptr),
-    _window(inWindow),
-    _surface(nullptr, nullptr),
     _logical_device(nullptr, nullptr),
-    _swapchain(nullptr, nullptr),
-    _renderPass(nullptr, nullptr),
-    _commandPool(nullptr, nullptr)
+    _frames_in_flight(inSettings.frames_in_flight),
+    _record_each_frame(inSettings.dynamic_frames || (inSettings.recording_threads > 0) || inSettings.render_graph || !inSettings.gpu_profile_path.empty() || (inSettings.instances > 0) || (inSettings.benchmark_frames > 0) || (inSettings.scene_chunks > 0) || (inSettings.windows > 1)),
+    _recording_slices(inSettings.recording_threads),
+    _draw_count(inSettings.draw_count)
+{
+    const auto max_recording_threads = std::max(1u, std::thread::hardware_concurrency()) * RECORDING_THREADS_PER_CORE;
+    if (this->_settings.recording_threads > max_recording_threads)
+    {
+        Log().get() << "Recording threads " << this->_settings.recording_threads << " exceed the limit of " << max_recording_threads << "; clamping" << std::endl;
+        this->_settings.recording_threads = max_recording_threads;
+        this->_recording_slices = max_recording_threads;
+    }
+    this->_swapchains.emplace_back(new SwapchainContext(inWindow));
+}
+
+Renderer::Impl::SwapchainContext::SwapchainContext(
+    WindowLibrary::GraphicsWindow *inWindow)
+    :
+    window(inWindow),
+    surface(nullptr, nullptr),
+    extent()
 {}
 
-Renderer::Impl::~Impl() = default;
+Renderer::Impl::~Impl()
+{
+    // the frames in flight, and their presents, are the only work using the objects destroyed with the Impl
+    // other users of the device, such as the image processor and pipeline compiler, wait for their own work
+    if (this->_deletion_queue)
+    {
+        // presents are not fenced, so the swapchains and render finished semaphores may still be in use by them;
+        // drained before the frames' retired objects, which include old swapchains, are destroyed
+        auto queueWaitIdleFn = GETDFN(this->_logical_device.get(), vkQueueWaitIdle);
+        VK_ERR_CHECK(queueWaitIdleFn(
+            this->_present_queue
+        ));
+        this->wait_for_frames();
+    }
+    if (!this->_scene_chunks.empty())
+    {
+        Log().get() << "Scene chunks: " << this->_chunk_recordings << " recorded of " << this->_chunk_executions << " executed" << std::endl;
+    }
+}
 
 void
 Renderer::Impl::create_instance()
@@ -148,11 +287,7 @@ Renderer::Impl::create_instance()
         &num_extensions,
         extensions.data()
     ));
-    Log().get() << "Found the following " << extensions.size() << " INSTANCE extensions:" << std::endl;
-    for (const auto &ext : extensions)
-    {
-        Log().get() << "\t" << ext.extensionName << ", v" << ext.specVersion << std::endl;
-    }
+    Log().get() << "Found " << extensions.size() << " INSTANCE extensions" << std::endl;
 
     // query layers
     auto query_layers_fn = GETFN(vkEnumerateInstanceLayerProperties);
@@ -166,11 +301,7 @@ Renderer::Impl::create_instance()
         &num_layers,
         layers.data()
     ));
-    Log().get() << "Found the following " << layers.size() << " INSTANCE layers:" << std::endl;
-    for (const auto &layer : layers)
-    {
-        Log().get() << "\t" << layer.layerName << ", " << layer.description << ", " << layer.implementationVersion << ", " << layer.specVersion << std::endl;
-    }
+    Log().get() << "Found " << layers.size() << " INSTANCE layers" << std::endl;
 
     // now look for extensions we want to use
     std::vector<const char *> instanceExtensionNames;
@@ -223,6 +354,18 @@ Renderer::Impl::create_instance()
         }
         instanceExtensionNames.push_back(VK_MVK_MACOS_SURFACE_EXTENSION_NAME);
     }
+#elif defined(D_BAM_PLATFORM_LINUX)
+    {
+        auto khr_xlib_surface_it = std::find_if(extensions.begin(), extensions.end(), [](::VkExtensionProperties &extension)
+        {
+            return (0 == strcmp(extension.extensionName, VK_KHR_XLIB_SURFACE_EXTENSION_NAME));
+        });
+        if (khr_xlib_surface_it == extensions.end())
+        {
+            throw Exception("Instance does not support the " VK_KHR_XLIB_SURFACE_EXTENSION_NAME " extension");
+        }
+        instanceExtensionNames.push_back(VK_KHR_XLIB_SURFACE_EXTENSION_NAME);
+    }
 #else
 #error Unsupported platform
 #endif
@@ -280,17 +423,16 @@ Renderer::Impl::create_instance()
     createInfo.ppEnabledLayerNames = instanceLayerNames.data();
     createInfo.enabledExtensionCount = static_cast<uint32_t>(instanceExtensionNames.size());
     createInfo.ppEnabledExtensionNames = instanceExtensionNames.data();
-    //::VkAllocationCallbacks allocCbs;
-    //memset(&allocCbs, 0, sizeof(allocCbs));
     ::VkInstance instance;
     auto createInstanceFn = GETFN(vkCreateInstance);
-    VK_ERR_CHECK(createInstanceFn(&createInfo, nullptr, &instance));
+    VK_ERR_CHECK(createInstanceFn(&createInfo, this->_allocation_callbacks, &instance));
 
-    auto instance_deleter = [](::VkInstance inInstance)
+    auto allocator = this->_allocation_callbacks;
+    auto instance_deleter = [allocator](::VkInstance inInstance)
     {
         auto deleter = GETIFN(inInstance, vkDestroyInstance);
         Log().get() << "Destroying VkInstance 0x" << std::hex << inInstance << std::endl;
-        deleter(inInstance, nullptr);
+        deleter(inInstance, allocator);
     };
     this->_instance = { instance, instance_deleter };
 }
@@ -310,6 +452,11 @@ Renderer::Impl::init_debug_callback()
         return;
     }
 
+    if (this->_settings.debug_report_rate > 0)
+    {
+        this->_debug_report_sink.reset(new DebugReportSink(this->_settings.debug_report_rate));
+    }
+
     ::VkDebugReportCallbackCreateInfoEXT createInfo;
     memset(&createInfo, 0, sizeof(createInfo));
     createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_REPORT_CREATE_INFO_EXT;
@@ -320,19 +467,21 @@ Renderer::Impl::init_debug_callback()
         VK_DEBUG_REPORT_ERROR_BIT_EXT |
         VK_DEBUG_REPORT_DEBUG_BIT_EXT;
     createInfo.pfnCallback = debug_callback;
+    createInfo.pUserData = this->_debug_report_sink.get();
     ::VkDebugReportCallbackEXT callback;
     VK_ERR_CHECK(create_debug_report_cb_fn(
         instance,
         &createInfo,
-        nullptr,
+        this->_allocation_callbacks,
         &callback
     ));
 
-    auto debug_callback_deleter = [instance](::VkDebugReportCallbackEXT inDebugReportCB)
+    auto allocator = this->_allocation_callbacks;
+    auto debug_callback_deleter = [instance, allocator](::VkDebugReportCallbackEXT inDebugReportCB)
     {
         auto deleter = GETIFN(instance, vkDestroyDebugReportCallbackEXT);
         Log().get() << "Destroying VkDebugReportCallbackEXT 0x" << std::hex << inDebugReportCB << std::endl;
-        deleter(instance, inDebugReportCB, nullptr);
+        deleter(instance, inDebugReportCB, allocator);
     };
     this->_debug_callback = { callback, debug_callback_deleter };
 }
@@ -348,13 +497,16 @@ Renderer::Impl::debug_callback(
     const char*                                 pMessage,
     void*                                       pUserData)
 {
-    (void)flags;
-    (void)objectType;
-    (void)object;
     (void)location;
-    (void)messageCode;
-    (void)pUserData;
-    Log().get() << pLayerPrefix << ": " << pMessage << std::endl;
+    auto sink = static_cast<DebugReportSink*>(pUserData);
+    if (nullptr != sink)
+    {
+        sink->push(flags, objectType, object, messageCode, pLayerPrefix, pMessage);
+    }
+    else
+    {
+        Log().get() << pLayerPrefix << ": " << pMessage << std::endl;
+    }
     if (VK_DEBUG_REPORT_ERROR_BIT_EXT == (flags & VK_DEBUG_REPORT_ERROR_BIT_EXT))
     {
         return VK_TRUE;
@@ -363,7 +515,8 @@ Renderer::Impl::debug_callback(
 }
 
 void
-Renderer::Impl::create_window_surface()
+Renderer::Impl::create_window_surface(
+    SwapchainContext &inContext)
 {
     Log().get() << "==================================================" << std::endl;
     Log().get() << "## " << __FUNCTION__ << std::endl;
@@ -374,7 +527,7 @@ Renderer::Impl::create_window_surface()
     ::VkWin32SurfaceCreateInfoKHR createInfo;
     memset(&createInfo, 0, sizeof(createInfo));
     createInfo.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
-    createInfo.hwnd = this->_window->getNativeWindowHandle();
+    createInfo.hwnd = inContext.window->getNativeWindowHandle();
     createInfo.hinstance = ::GetModuleHandle(nullptr);
 
     auto createWindowSurfaceFn = GETIFN(instance, vkCreateWin32SurfaceKHR);
@@ -382,34 +535,50 @@ Renderer::Impl::create_window_surface()
     VK_ERR_CHECK(createWindowSurfaceFn(
         instance,
         &createInfo,
-        nullptr,
+        this->_allocation_callbacks,
         &surface
     ));
 #elif defined(D_BAM_PLATFORM_OSX)
     ::VkMacOSSurfaceCreateInfoMVK createInfo;
     memset(&createInfo, 0, sizeof(createInfo));
     createInfo.sType = VK_STRUCTURE_TYPE_MACOS_SURFACE_CREATE_INFO_MVK;
-    createInfo.pView = this->_window->macosGetViewHandle();
+    createInfo.pView = inContext.window->macosGetViewHandle();
 
     auto createWindowSurfaceFn = GETIFN(instance, vkCreateMacOSSurfaceMVK);
     ::VkSurfaceKHR surface;
     VK_ERR_CHECK(createWindowSurfaceFn(
         instance,
         &createInfo,
-        nullptr,
+        this->_allocation_callbacks,
+        &surface
+    ));
+#elif defined(D_BAM_PLATFORM_LINUX)
+    ::VkXlibSurfaceCreateInfoKHR createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+    createInfo.sType = VK_STRUCTURE_TYPE_XLIB_SURFACE_CREATE_INFO_KHR;
+    createInfo.dpy = inContext.window->linuxDisplay();
+    createInfo.window = inContext.window->getNativeWindowHandle();
+
+    auto createWindowSurfaceFn = GETIFN(instance, vkCreateXlibSurfaceKHR);
+    ::VkSurfaceKHR surface;
+    VK_ERR_CHECK(createWindowSurfaceFn(
+        instance,
+        &createInfo,
+        this->_allocation_callbacks,
         &surface
     ));
 #else
 #error Unsupported platform
 #endif
 
-    auto surfaceDeleter = [instance](::VkSurfaceKHR inSurface)
+    auto allocator = this->_allocation_callbacks;
+    auto surfaceDeleter = [instance, allocator](::VkSurfaceKHR inSurface)
     {
         auto destroy = GETIFN(instance, vkDestroySurfaceKHR);
         Log().get() << "Destroying VkSurfaceKHR 0x" << std::hex << inSurface << std::endl;
-        destroy(instance, inSurface, nullptr);
+        destroy(instance, inSurface, allocator);
     };
-    this->_surface = { surface, surfaceDeleter };
+    inContext.surface = { surface, surfaceDeleter };
 }
 
 void
@@ -434,121 +603,210 @@ Renderer::Impl::enumerate_physical_devices()
     this->_physical_devices.resize(numPhysicalDevices);
     VK_ERR_CHECK(enumPhysDevicesFn(instance, &numPhysicalDevices, this->_physical_devices.data()));
 
-    auto enumeratePhysicalDevicePropsFn = GETIFN(instance, vkGetPhysicalDeviceProperties);
-    auto enumeratePhysicalMemoryDeviceFn = GETIFN(instance, vkGetPhysicalDeviceMemoryProperties);
-    auto getPhysDeviceFeaturesFn = GETIFN(instance, vkGetPhysicalDeviceFeatures);
+    // everything else about the devices is only queried for the capability report, when it is requested
+    // the highest scoring device that can render to, and present on, the window
+    int64_t best_score = -1;
     for (auto pdevice_index = 0u; pdevice_index < numPhysicalDevices; ++pdevice_index)
     {
-        auto device = this->_physical_devices[pdevice_index];
-        Log().get() << "PHYSICAL DEVICE " << pdevice_index << std::endl;
-        // enumerate physical device properties
-        {
-            ::VkPhysicalDeviceProperties props;
-            enumeratePhysicalDevicePropsFn(device, &props);
-            Log().get() << "\tProperties of physical device" << std::endl;
-            Log().get() << "\t\tAPI version : " << props.apiVersion << std::endl;
-            Log().get() << "\t\tDevice ID : " << props.deviceID << std::endl;
-            Log().get() << "\t\tDevice name : " << props.deviceName << std::endl;
-            Log().get() << "\t\tDevice type : " << props.deviceType << std::endl;
-            Log().get() << "\t\tDriver version : " << props.driverVersion << std::endl;
-            Log().get() << "\t\tPipeline Cache UUID : " << props.pipelineCacheUUID << std::endl;
-            Log().get() << "\t\tLimits... TODO" << std::endl;
-            Log().get() << "\t\tSparse properties... TODO" << std::endl;
+        const auto score = this->score_physical_device(this->_physical_devices[pdevice_index]);
+        Log().get() << "Physical device " << pdevice_index << " scores " << score << std::endl;
+        if (score > best_score)
+        {
+            best_score = score;
+            this->_physical_device_index = pdevice_index;
         }
-        // enumerate physical device memory properties
+    }
+    if (best_score < 0)
+    {
+        throw Exception("No physical device supports graphics and presentation on the window surface");
+    }
+    this->_queue_families = this->find_queue_families(this->_physical_devices[this->_physical_device_index]);
+    Log().get() << "Choosing PHYSICAL device " << this->_physical_device_index << std::endl;
+    this->_capability_report.reset(new CapabilityReport(instance, this->_physical_devices, this->_physical_device_index));
+}
+
+bool
+Renderer::Impl::QueueFamilies::complete() const
+{
+    const auto unset = static_cast<uint32_t>(-1);
+    return (unset != this->graphics) && (unset != this->present) && (unset != this->compute) && (unset != this->transfer);
+}
+
+Renderer::Impl::QueueFamilies
+Renderer::Impl::find_queue_families(
+    ::VkPhysicalDevice inDevice) const
+{
+    auto instance = this->_instance.get();
+    auto getPDeviceQueueFamilyPropsFn = GETIFN(instance, vkGetPhysicalDeviceQueueFamilyProperties);
+    uint32_t numQueueFamilyProperties = 0;
+    getPDeviceQueueFamilyPropsFn(inDevice, &numQueueFamilyProperties, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilyProperties(numQueueFamilyProperties);
+    getPDeviceQueueFamilyPropsFn(inDevice, &numQueueFamilyProperties, queueFamilyProperties.data());
+
+    auto getPDeviceSurfaceSupportFn = GETIFN(instance, vkGetPhysicalDeviceSurfaceSupportKHR);
+    std::vector<bool> presents(numQueueFamilyProperties);
+    for (auto i = 0u; i < numQueueFamilyProperties; ++i)
+    {
+        ::VkBool32 presentSupport = VK_FALSE;
+        VK_ERR_CHECK_QUIET(getPDeviceSurfaceSupportFn(
+            inDevice,
+            i,
+            this->_swapchains[0]->surface.get(), // the only window when the device is chosen; others are checked as they are added
+            &presentSupport
+        ));
+        presents[i] = (VK_TRUE == presentSupport) && (queueFamilyProperties[i].queueCount > 0);
+    }
+
+    // first family having all of inRequired, and none of inExcluded
+    auto find = [&queueFamilyProperties](const ::VkQueueFlags inRequired, const ::VkQueueFlags inExcluded, const std::vector<bool> *inMustPresent)
+    {
+        for (auto i = 0u; i < queueFamilyProperties.size(); ++i)
         {
-            ::VkPhysicalDeviceMemoryProperties memProps;
-            enumeratePhysicalMemoryDeviceFn(device, &memProps);
-            Log().get() << "\tMemory properties of physical device" << std::endl;
-            Log().get() << "\t\tMemory heap count : " << memProps.memoryHeapCount << std::endl;
-            for (auto i = 0u; i < memProps.memoryHeapCount; ++i)
+            const auto flags = queueFamilyProperties[i].queueFlags;
+            if ((0 == queueFamilyProperties[i].queueCount) ||
+                (inRequired != (flags & inRequired)) ||
+                (0 != (flags & inExcluded)) ||
+                ((nullptr != inMustPresent) && !(*inMustPresent)[i]))
             {
-                Log().get() << "\t\t\tHeap " << i << std::endl;
-                Log().get() << "\t\t\t\tFlags : " << to_string(static_cast<::VkMemoryHeapFlagBits>(memProps.memoryHeaps[i].flags)) << std::endl;
-                const auto bytes = memProps.memoryHeaps[i].size;
-                const auto kbytes = bytes / 1024;
-                const auto mbytes = kbytes / 1024;
-                const auto gbytes = mbytes / 1024;
-                Log().get() << "\t\t\t\tSize : " << bytes << " bytes / " << kbytes << " KB / " << mbytes << " MB / " << gbytes << " GB" << std::endl;
+                continue;
             }
-            Log().get() << "\t\tMemory type count : " << memProps.memoryTypeCount << std::endl;
-            for (auto i = 0u; i < memProps.memoryTypeCount; ++i)
+            return i;
+        }
+        return static_cast<uint32_t>(-1);
+    };
+    const auto unset = static_cast<uint32_t>(-1);
+
+    QueueFamilies families;
+    // prefer graphics and presentation from the same family, so that swapchain images need not be shared between families
+    families.graphics = find(VK_QUEUE_GRAPHICS_BIT, 0, &presents);
+    if (unset == families.graphics)
+    {
+        families.graphics = find(VK_QUEUE_GRAPHICS_BIT, 0, nullptr);
+    }
+    if (unset != families.graphics && presents[families.graphics])
+    {
+        families.present = families.graphics;
+    }
+    else
+    {
+        for (auto i = 0u; i < numQueueFamilyProperties && unset == families.present; ++i)
+        {
+            if (presents[i])
             {
-                Log().get() << "\t\t\tMemory type " << i << std::endl;
-                Log().get() << "\t\t\t\tHeap index : " << memProps.memoryTypes[i].heapIndex << std::endl;
-                Log().get() << "\t\t\t\tProperties : " << to_string(static_cast<::VkMemoryPropertyFlagBits>(memProps.memoryTypes[i].propertyFlags)) << std::endl;
+                families.present = i;
             }
         }
-        // enumerate physical device features
-        {
-            VkPhysicalDeviceFeatures features;
-            getPhysDeviceFeaturesFn(device, &features);
-            Log().get() << "\tFeatures of physical device" << std::endl;
-
-#define LOG_FEATURE(_feature) Log().get() << "\t\t"#_feature << ": " << features._feature << std::endl
-
-            LOG_FEATURE(alphaToOne);
-            LOG_FEATURE(depthBiasClamp);
-            LOG_FEATURE(depthBounds);
-            LOG_FEATURE(depthClamp);
-            LOG_FEATURE(drawIndirectFirstInstance);
-            LOG_FEATURE(dualSrcBlend);
-            LOG_FEATURE(fillModeNonSolid);
-            LOG_FEATURE(fragmentStoresAndAtomics);
-            LOG_FEATURE(fullDrawIndexUint32);
-            LOG_FEATURE(geometryShader);
-            LOG_FEATURE(imageCubeArray);
-            LOG_FEATURE(independentBlend);
-            LOG_FEATURE(inheritedQueries);
-            LOG_FEATURE(largePoints);
-            LOG_FEATURE(logicOp);
-            LOG_FEATURE(multiDrawIndirect);
-            LOG_FEATURE(multiViewport);
-            LOG_FEATURE(occlusionQueryPrecise);
-            LOG_FEATURE(pipelineStatisticsQuery);
-            LOG_FEATURE(robustBufferAccess);
-            LOG_FEATURE(samplerAnisotropy);
-            LOG_FEATURE(sampleRateShading);
-            LOG_FEATURE(shaderClipDistance);
-            LOG_FEATURE(shaderCullDistance);
-            LOG_FEATURE(shaderFloat64);
-            LOG_FEATURE(shaderImageGatherExtended);
-            LOG_FEATURE(shaderInt16);
-            LOG_FEATURE(shaderInt64);
-            LOG_FEATURE(shaderResourceMinLod);
-            LOG_FEATURE(shaderResourceResidency);
-            LOG_FEATURE(shaderSampledImageArrayDynamicIndexing);
-            LOG_FEATURE(shaderStorageBufferArrayDynamicIndexing);
-            LOG_FEATURE(shaderStorageImageArrayDynamicIndexing);
-            LOG_FEATURE(shaderStorageImageExtendedFormats);
-            LOG_FEATURE(shaderStorageImageMultisample);
-            LOG_FEATURE(shaderStorageImageReadWithoutFormat);
-            LOG_FEATURE(shaderStorageImageWriteWithoutFormat);
-            LOG_FEATURE(shaderTessellationAndGeometryPointSize);
-            LOG_FEATURE(shaderUniformBufferArrayDynamicIndexing);
-            LOG_FEATURE(sparseBinding);
-            LOG_FEATURE(sparseResidency16Samples);
-            LOG_FEATURE(sparseResidency2Samples);
-            LOG_FEATURE(sparseResidency4Samples);
-            LOG_FEATURE(sparseResidency8Samples);
-            LOG_FEATURE(sparseResidencyAliased);
-            LOG_FEATURE(sparseResidencyBuffer);
-            LOG_FEATURE(sparseResidencyImage2D);
-            LOG_FEATURE(sparseResidencyImage3D);
-            LOG_FEATURE(tessellationShader);
-            LOG_FEATURE(textureCompressionASTC_LDR);
-            LOG_FEATURE(textureCompressionBC);
-            LOG_FEATURE(textureCompressionETC2);
-            LOG_FEATURE(variableMultisampleRate);
-            LOG_FEATURE(vertexPipelineStoresAndAtomics);
-
-#undef LOG_FEATURE
+    }
+    families.compute = find(VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT, nullptr);
+    if (unset == families.compute)
+    {
+        families.compute = find(VK_QUEUE_COMPUTE_BIT, 0, nullptr);
+    }
+    // graphics and compute families implicitly support transfers
+    families.transfer = find(VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, nullptr);
+    if (unset == families.transfer)
+    {
+        families.transfer = families.compute;
+    }
+    return families;
+}
+
+int64_t
+Renderer::Impl::score_physical_device(
+    ::VkPhysicalDevice inDevice) const
+{
+    auto instance = this->_instance.get();
+
+    const auto families = this->find_queue_families(inDevice);
+    if (!families.complete())
+    {
+        return -1;
+    }
+
+    auto enumDeviceExtensionPropertiesFn = GETIFN(instance, vkEnumerateDeviceExtensionProperties);
+    uint32_t numDeviceExtensions = 0;
+    VK_ERR_CHECK_QUIET(enumDeviceExtensionPropertiesFn(inDevice, nullptr, &numDeviceExtensions, nullptr));
+    std::vector<::VkExtensionProperties> deviceExtensions(numDeviceExtensions);
+    VK_ERR_CHECK_QUIET(enumDeviceExtensionPropertiesFn(inDevice, nullptr, &numDeviceExtensions, deviceExtensions.data()));
+    auto swap_chain_ext_it = std::find_if(deviceExtensions.begin(), deviceExtensions.end(), [](const ::VkExtensionProperties &extProp)
+    {
+        return (0 == strcmp(extProp.extensionName, VK_KHR_SWAPCHAIN_EXTENSION_NAME));
+    });
+    if (swap_chain_ext_it == deviceExtensions.end())
+    {
+        return -1;
+    }
+
+    auto getPhysicalDevicePropsFn = GETIFN(instance, vkGetPhysicalDeviceProperties);
+    auto getPhysicalMemoryPropsFn = GETIFN(instance, vkGetPhysicalDeviceMemoryProperties);
+    auto getPhysDeviceFeaturesFn = GETIFN(instance, vkGetPhysicalDeviceFeatures);
+    auto getPDeviceQueueFamilyPropsFn = GETIFN(instance, vkGetPhysicalDeviceQueueFamilyProperties);
+    ::VkPhysicalDeviceProperties props;
+    getPhysicalDevicePropsFn(inDevice, &props);
+    ::VkPhysicalDeviceMemoryProperties memProps;
+    getPhysicalMemoryPropsFn(inDevice, &memProps);
+    ::VkPhysicalDeviceFeatures features;
+    getPhysDeviceFeaturesFn(inDevice, &features);
+    uint32_t numQueueFamilyProperties = 0;
+    getPDeviceQueueFamilyPropsFn(inDevice, &numQueueFamilyProperties, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilyProperties(numQueueFamilyProperties);
+    getPDeviceQueueFamilyPropsFn(inDevice, &numQueueFamilyProperties, queueFamilyProperties.data());
+
+    // the device type dominates, so that a discrete GPU is always chosen over an integrated one
+    int64_t score = 0;
+    switch (props.deviceType)
+    {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+            score += 100000;
+            break;
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+            score += 50000;
+            break;
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+            score += 20000;
+            break;
+        case VK_PHYSICAL_DEVICE_TYPE_CPU:
+            score += 10000;
+            break;
+        default:
+            break;
+    }
+
+    // then the largest device local heap, per 256MB
+    ::VkDeviceSize device_local = 0;
+    for (auto i = 0u; i < memProps.memoryHeapCount; ++i)
+    {
+        if (memProps.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+        {
+            device_local = std::max(device_local, memProps.memoryHeaps[i].size);
         }
     }
+    score += static_cast<int64_t>(device_local / (256 * 1024 * 1024));
 
-    // arbitrary choice
-    this->_physical_device_index = 0;
-    Log().get() << "Choosing PHYSICAL device " << this->_physical_device_index << std::endl;
+    // then queues that can execute in parallel with graphics
+    if (families.compute != families.graphics)
+    {
+        score += 100;
+    }
+    if ((families.transfer != families.graphics) && (families.transfer != families.compute))
+    {
+        score += 50;
+    }
+
+    // then features that the renderer makes use of
+    if (queueFamilyProperties[families.graphics].timestampValidBits > 0)
+    {
+        score += 10;
+    }
+    if (features.pipelineStatisticsQuery)
+    {
+        score += 10;
+    }
+    if (features.samplerAnisotropy)
+    {
+        score += 10;
+    }
+    return score;
 }
 
 void
@@ -559,7 +817,6 @@ Renderer::Impl::create_logical_device()
     Log().get() << "==================================================" << std::endl;
     auto instance = this->_instance.get();
     auto pDevice = this->_physical_devices[this->_physical_device_index];
-    auto surface = this->_surface.get();
 
     // enumerate physical device extensions
     auto enumDeviceExtensionPropertiesFn = GETIFN(instance, vkEnumerateDeviceExtensionProperties);
@@ -567,12 +824,7 @@ Renderer::Impl::create_logical_device()
     VK_ERR_CHECK(enumDeviceExtensionPropertiesFn(pDevice, nullptr, &numDeviceExtensions, nullptr));
     std::vector<::VkExtensionProperties> deviceExtensions(numDeviceExtensions);
     VK_ERR_CHECK(enumDeviceExtensionPropertiesFn(pDevice, nullptr, &numDeviceExtensions, deviceExtensions.data()));
-    Log().get() << "Found the following " << numDeviceExtensions << " DEVICE extensions:" << std::endl;
-    for (auto i = 0u; i < numDeviceExtensions; ++i)
-    {
-        const auto &ext = deviceExtensions[i];
-        Log().get() << "\t" << i << ": " << ext.extensionName << ", " << ext.specVersion << std::endl;
-    }
+    Log().get() << "Found " << numDeviceExtensions << " DEVICE extensions" << std::endl;
 
     // enumerate physical device layers
     auto enumDeviceLayerPropertiesFn = GETIFN(instance, vkEnumerateDeviceLayerProperties);
@@ -580,12 +832,7 @@ Renderer::Impl::create_logical_device()
     VK_ERR_CHECK(enumDeviceLayerPropertiesFn(pDevice, &numDeviceLayers, nullptr));
     std::vector<::VkLayerProperties> deviceLayers(numDeviceLayers);
     VK_ERR_CHECK(enumDeviceLayerPropertiesFn(pDevice, &numDeviceLayers, deviceLayers.data()));
-    Log().get() << "Found the following " << numDeviceLayers << " DEVICE layers:" << std::endl;
-    for (auto i = 0u; i < numDeviceLayers; ++i)
-    {
-        const auto &layer = deviceLayers[i];
-        Log().get() << "\t" << i << ": " << layer.layerName << ", " << layer.description << ", " << layer.implementationVersion << ", " << layer.specVersion << std::endl;
-    }
+    Log().get() << "Found " << numDeviceLayers << " DEVICE layers" << std::endl;
 
     // query the family of queues available
     auto getPDeviceQueueFamilyPropsFn = GETIFN(instance, vkGetPhysicalDeviceQueueFamilyProperties);
@@ -597,37 +844,66 @@ Renderer::Impl::create_logical_device()
     }
     std::vector<VkQueueFamilyProperties> queueFamilyProperties(numQueueFamilyProperties);
     getPDeviceQueueFamilyPropsFn(pDevice, &numQueueFamilyProperties, queueFamilyProperties.data());
-    Log().get() << "Found the following " << numQueueFamilyProperties << " QUEUE FAMILIES on physical device " << this->_physical_device_index << std::endl;
-    for (auto i = 0u; i < numQueueFamilyProperties; ++i)
-    {
-        Log().get() << "\tQueue family " << i << std::endl;
-        Log().get() << "\t\tFlags : " << to_string(static_cast<::VkQueueFlagBits>(queueFamilyProperties[i].queueFlags)) << std::endl;
-        Log().get() << "\t\tCount : " << queueFamilyProperties[i].queueCount << std::endl;
-        Log().get() << "\t\tTimestampValidBits : " << queueFamilyProperties[i].timestampValidBits << std::endl;
-    }
 
-    // assume that the first queue family is capable of graphics
-    auto graphics_family_queue_index = 0;
-    // assume that the same queue family is capable of presentation
-    auto present_family_queue_index = 0;
+    // families were chosen, and checked for completeness, when the device was scored
+    const auto &families = this->_queue_families;
+    Log().get() << "Using queue families: graphics " << families.graphics << ", present " << families.present << ", compute " << families.compute << ", transfer " << families.transfer << std::endl;
+    this->_timestamp_valid_bits = queueFamilyProperties[families.graphics].timestampValidBits;
 
-    if (0 == (queueFamilyProperties[graphics_family_queue_index].queueFlags & VK_QUEUE_GRAPHICS_BIT))
+    // the GPU profiler counts the work of each pass, which executes secondary command buffers when recording
+    // on threads or in chunks, so these must then inherit its queries
+    ::VkPhysicalDeviceFeatures enabledFeatures;
+    memset(&enabledFeatures, 0, sizeof(enabledFeatures));
+    if (!this->_settings.gpu_profile_path.empty())
     {
-        throw Exception("Unable to find queue family with graphics support on this physical device");
+        auto getPhysDeviceFeaturesFn = GETIFN(instance, vkGetPhysicalDeviceFeatures);
+        ::VkPhysicalDeviceFeatures features;
+        getPhysDeviceFeaturesFn(pDevice, &features);
+        const auto secondaries = (this->_settings.recording_threads > 0) || this->_settings.benchmark_recording || (this->_settings.scene_chunks > 0);
+        if (!secondaries || features.inheritedQueries)
+        {
+            enabledFeatures.inheritedQueries = secondaries ? VK_TRUE : VK_FALSE;
+            this->_occlusion_queries = true;
+            if (features.pipelineStatisticsQuery)
+            {
+                enabledFeatures.pipelineStatisticsQuery = VK_TRUE;
+                this->_pipeline_statistics =
+                    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+                    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+                    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+                    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+                    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+                    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+            }
+            else
+            {
+                Log().get() << "Device does not support pipeline statistics queries; only samples passed are counted" << std::endl;
+            }
+        }
+        else
+        {
+            Log().get() << "Device cannot inherit queries into secondary command buffers; passes are not counted" << std::endl;
+        }
     }
 
-    ::VkBool32 presentSupport = false;
-    auto getPDeviceSurfaceSupportFn = GETIFN(instance, vkGetPhysicalDeviceSurfaceSupportKHR);
-    VK_ERR_CHECK(getPDeviceSurfaceSupportFn(
-        pDevice,
-        present_family_queue_index,
-        surface,
-        &presentSupport
-    ));
-    if (!presentSupport)
+    // one queue per role, from the role's family; roles sharing a family each take their own queue while
+    // the family has enough, so that they can execute in parallel, and otherwise share its last queue
+    std::map<uint32_t, uint32_t> queues_per_family;
+    auto claim_queue = [&queues_per_family, &queueFamilyProperties](const uint32_t inFamily)
     {
-        throw Exception("Physical device cannot support presentation on the window surface");
-    }
+        auto &claimed = queues_per_family[inFamily];
+        const auto available = queueFamilyProperties[inFamily].queueCount;
+        if (claimed < available)
+        {
+            return claimed++;
+        }
+        return available - 1;
+    };
+    const auto graphics_queue_index = claim_queue(families.graphics);
+    const auto compute_queue_index = claim_queue(families.compute);
+    const auto transfer_queue_index = claim_queue(families.transfer);
+    // present from the graphics queue where possible
+    const auto present_queue_index = (families.present == families.graphics) ? graphics_queue_index : claim_queue(families.present);
 
     std::vector<const char *> deviceExtensionsRequired;
     auto swap_chain_ext_it = std::find_if(deviceExtensions.begin(), deviceExtensions.end(), [](const ::VkExtensionProperties &extProp)
@@ -674,13 +950,22 @@ Renderer::Impl::create_logical_device()
 #endif
 
     // logical devices need a queue
-    VkDeviceQueueCreateInfo queue_info;
-    memset(&queue_info, 0, sizeof(queue_info));
-    queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    queue_info.queueFamilyIndex = graphics_family_queue_index;
-    queue_info.queueCount = 1;
-    float queuePriority = 1.0f;
-    queue_info.pQueuePriorities = &queuePriority; // Note: this is essential for at least MoltenVK, which does not check whether this is null or not
+    std::vector<float> queuePriorities;
+    for (const auto &family : queues_per_family)
+    {
+        queuePriorities.resize(std::max<size_t>(queuePriorities.size(), family.second), 1.0f);
+    }
+    std::vector<VkDeviceQueueCreateInfo> queue_infos;
+    for (const auto &family : queues_per_family)
+    {
+        VkDeviceQueueCreateInfo queue_info;
+        memset(&queue_info, 0, sizeof(queue_info));
+        queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        queue_info.queueFamilyIndex = family.first;
+        queue_info.queueCount = family.second;
+        queue_info.pQueuePriorities = queuePriorities.data(); // Note: this is essential for at least MoltenVK, which does not check whether this is null or not
+        queue_infos.push_back(queue_info);
+    }
 
     Log().get() << "Creating a LOGICAL DEVICE with the following layers:" << std::endl;
     for (const auto &layer : deviceLayersRequired)
@@ -698,56 +983,68 @@ Renderer::Impl::create_logical_device()
     VkDeviceCreateInfo deviceCreateInfo;
     memset(&deviceCreateInfo, 0, sizeof(deviceCreateInfo));
     deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    deviceCreateInfo.queueCreateInfoCount = 1;
-    deviceCreateInfo.pQueueCreateInfos = &queue_info;
+    deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queue_infos.size());
+    deviceCreateInfo.pQueueCreateInfos = queue_infos.data();
     deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensionsRequired.size());
     deviceCreateInfo.ppEnabledExtensionNames = deviceExtensionsRequired.data();
     deviceCreateInfo.enabledLayerCount = static_cast<uint32_t>(deviceLayersRequired.size());
     deviceCreateInfo.ppEnabledLayerNames = deviceLayersRequired.data();
+    deviceCreateInfo.pEnabledFeatures = &enabledFeatures;
     ::VkDevice device;
-    VK_ERR_CHECK(createDeviceFn(pDevice, &deviceCreateInfo, nullptr, &device));
+    VK_ERR_CHECK(createDeviceFn(pDevice, &deviceCreateInfo, this->_allocation_callbacks, &device));
 
-    auto destroy_device = [device](::VkDevice inDevice)
+    // no wait for the device to be idle; by now everything using it has completed, see ~Impl
+    auto allocator = this->_allocation_callbacks;
+    auto destroy_device = [device, allocator](::VkDevice inDevice)
     {
-        auto wait_idle = GETDFN(device, vkDeviceWaitIdle);
-        Log().get() << "Wait for VkDevice idle 0x" << std::hex << inDevice << std::endl;
-        wait_idle(device);
-
         auto destroy = GETDFN(device, vkDestroyDevice);
         Log().get() << "Destroying VkDevice 0x" << std::hex << inDevice << std::endl;
-        destroy(inDevice, nullptr);
+        destroy(inDevice, allocator);
     };
 
     this->_logical_device = { device, destroy_device };
+    this->_dispatch.reset(new DeviceDispatch(device, this->_allocation_callbacks));
+    this->_deletion_queue.reset(new DeletionQueue());
 
     auto logical_device = this->_logical_device.get();
 
     auto getQueueFn = GETDFN(logical_device, vkGetDeviceQueue);
-    auto graphics_queue_index = 0;
     getQueueFn(
         logical_device,
-        graphics_family_queue_index,
+        families.graphics,
         graphics_queue_index,
         &this->_graphics_queue
     );
-    auto present_queue_index = 0;
     getQueueFn(
         logical_device,
-        present_family_queue_index,
+        families.present,
         present_queue_index,
         &this->_present_queue
     );
+    getQueueFn(
+        logical_device,
+        families.compute,
+        compute_queue_index,
+        &this->_compute_queue
+    );
+    getQueueFn(
+        logical_device,
+        families.transfer,
+        transfer_queue_index,
+        &this->_transfer_queue
+    );
 }
 
 void
-Renderer::Impl::create_swapchain()
+Renderer::Impl::create_swapchain(
+    SwapchainContext &inContext)
 {
     Log().get() << "==================================================" << std::endl;
     Log().get() << "## " << __FUNCTION__ << std::endl;
     Log().get() << "==================================================" << std::endl;
     auto instance = this->_instance.get();
     auto pDevice = this->_physical_devices[this->_physical_device_index];
-    auto surface = this->_surface.get();
+    auto surface = inContext.surface.get();
 
     auto getSurfaceCapsFn = GETIFN(instance, vkGetPhysicalDeviceSurfaceCapabilitiesKHR);
     ::VkSurfaceCapabilitiesKHR surfaceCaps;
@@ -802,86 +1099,156 @@ Renderer::Impl::create_swapchain()
         Log().get() << "\t" << pMode << std::endl;
     }
 
-    this->_swapchain_imageFormat = surfaceFormats[0].format;
-    this->_swapchain_extent = surfaceCaps.maxImageExtent;
+    // the render pass, and so the pipeline, is compatible only with the format it was created with, so once it
+    // exists, every swapchain, of every window, must have that format
+    auto surfaceFormat = surfaceFormats[0];
+    if (this->_renderPass)
+    {
+        auto format_it = std::find_if(surfaceFormats.begin(), surfaceFormats.end(), [this](const ::VkSurfaceFormatKHR &inFormat)
+        {
+            return inFormat.format == this->_swapchain_imageFormat;
+        });
+        if (format_it == surfaceFormats.end())
+        {
+            throw Exception("Swapchain image format is unsupported by the surface; the render pass would need rebuilding");
+        }
+        surfaceFormat = *format_it;
+    }
+    this->_swapchain_imageFormat = surfaceFormat.format;
+    if (std::numeric_limits<uint32_t>::max() != surfaceCaps.currentExtent.width)
+    {
+        inContext.extent = surfaceCaps.currentExtent;
+    }
+    else
+    {
+        // the surface size is determined by the swapchain extent
+        inContext.extent = surfaceCaps.maxImageExtent;
+    }
+
+    auto imageCount = surfaceCaps.minImageCount;
+    if (this->_settings.swapchain_images > 0)
+    {
+        imageCount = std::max(imageCount, this->_settings.swapchain_images);
+        if (surfaceCaps.maxImageCount > 0) // 0 means unlimited
+        {
+            imageCount = std::min(imageCount, surfaceCaps.maxImageCount);
+        }
+    }
+    Log().get() << "Requesting " << imageCount << " swapchain images" << std::endl;
+
+    ::VkPresentModeKHR requestedPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+    switch (this->_settings.present_mode)
+    {
+        case PresentMode::Fifo:
+            requestedPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+            break;
+        case PresentMode::FifoRelaxed:
+            requestedPresentMode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+            break;
+        case PresentMode::Mailbox:
+            requestedPresentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+            break;
+        case PresentMode::Immediate:
+            requestedPresentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+            break;
+    }
+    auto presentMode = VK_PRESENT_MODE_FIFO_KHR; // the only mode guaranteed to be supported
+    if (std::find(presentModes.begin(), presentModes.end(), requestedPresentMode) != presentModes.end())
+    {
+        presentMode = requestedPresentMode;
+    }
+    else
+    {
+        Log().get() << "Present mode " << requestedPresentMode << " is unsupported; falling back to FIFO" << std::endl;
+    }
+    Log().get() << "Using present mode " << presentMode << std::endl;
 
     auto logical_device = this->_logical_device.get();
     ::VkSwapchainCreateInfoKHR createInfo;
     memset(&createInfo, 0, sizeof(createInfo));
     createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
     createInfo.surface = surface;
-    createInfo.minImageCount = surfaceCaps.minImageCount;
+    createInfo.minImageCount = imageCount;
     createInfo.imageFormat = this->_swapchain_imageFormat;
-    createInfo.imageColorSpace = surfaceFormats[0].colorSpace;
-    createInfo.imageExtent = this->_swapchain_extent;
+    createInfo.imageColorSpace = surfaceFormat.colorSpace;
+    createInfo.imageExtent = inContext.extent;
     createInfo.imageArrayLayers = 1;
     createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-    createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    createInfo.queueFamilyIndexCount = 0;
-    createInfo.pQueueFamilyIndices = nullptr;
+    if (this->_settings.render_graph)
+    {
+        // the render graph blits its final image into the swapchain
+        if (0 == (surfaceCaps.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT))
+        {
+            throw Exception("Swapchain images cannot be transfer destinations, as required by the render graph");
+        }
+        createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    }
+    // rendered on the graphics family and presented on the present family; where they differ, the images are shared
+    // concurrently, rather than recording ownership transfers around each present
+    const uint32_t queueFamilyIndices[] = { this->_queue_families.graphics, this->_queue_families.present };
+    if (this->_queue_families.graphics != this->_queue_families.present)
+    {
+        createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+        createInfo.queueFamilyIndexCount = 2;
+        createInfo.pQueueFamilyIndices = queueFamilyIndices;
+    }
+    else
+    {
+        createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        createInfo.queueFamilyIndexCount = 0;
+        createInfo.pQueueFamilyIndices = nullptr;
+    }
     createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    createInfo.presentMode = presentModes[0];
+    createInfo.presentMode = presentMode;
     createInfo.clipped = VK_TRUE;
-    createInfo.oldSwapchain = VK_NULL_HANDLE;
+    createInfo.oldSwapchain = inContext.swapchain.get(); // retired once the new swapchain is created
     ::VkSwapchainKHR swapchain;
     auto createSwapchainFn = GETDFN(logical_device, vkCreateSwapchainKHR);
     VK_ERR_CHECK(createSwapchainFn(
         logical_device,
         &createInfo,
-        nullptr,
+        this->_dispatch->allocator,
         &swapchain
     ));
 
-    auto destroy_swapchain = [logical_device](::VkSwapchainKHR inSwapchain)
-    {
-        auto deleter = GETDFN(logical_device, vkDestroySwapchainKHR);
-        Log().get() << "Destroying VkSwapchainKHR 0x" << std::hex << inSwapchain << std::endl;
-        deleter(logical_device, inSwapchain, nullptr);
-    };
-    this->_swapchain = { swapchain, destroy_swapchain };
+    // presents outstanding on the old swapchain are not tracked by any fence, so it outlives another round of frames
+    this->_deletion_queue->retire(std::move(inContext.swapchain), this->_frames_in_flight);
+    inContext.swapchain = { *this->_dispatch, swapchain };
 
     auto getswapchainimagesFn = GETDFN(logical_device, vkGetSwapchainImagesKHR);
     uint32_t swapchain_imagecount = 0;
     VK_ERR_CHECK(getswapchainimagesFn(
         logical_device,
-        this->_swapchain.get(),
+        inContext.swapchain.get(),
         &swapchain_imagecount,
         nullptr
     ));
-    this->_swapchain_images.resize(swapchain_imagecount);
+    inContext.images.resize(swapchain_imagecount);
     VK_ERR_CHECK(getswapchainimagesFn(
         logical_device,
-        this->_swapchain.get(),
+        inContext.swapchain.get(),
         &swapchain_imagecount,
-        this->_swapchain_images.data()
+        inContext.images.data()
     ));
 }
 
 void
-Renderer::Impl::create_imageviews()
+Renderer::Impl::create_imageviews(
+    SwapchainContext &inContext)
 {
     Log().get() << "==================================================" << std::endl;
     Log().get() << "## " << __FUNCTION__ << std::endl;
     Log().get() << "==================================================" << std::endl;
     auto logical_device = this->_logical_device.get();
 
-    // no resize of this->_swapchain_imageViews, since there is no valid
-    // default constructor of a std::unique_ptr with a custom deleter
     auto createImageViewFn = GETDFN(logical_device, vkCreateImageView);
 
-    auto destroy_imageview = [logical_device](::VkImageView inImageView)
-    {
-        auto deleter = GETDFN(logical_device, vkDestroyImageView);
-        Log().get() << "Destroying VkImageView 0x" << std::hex << inImageView << std::endl;
-        deleter(logical_device, inImageView, nullptr);
-    };
-
-    for (auto i = 0u; i < this->_swapchain_images.size(); ++i)
+    for (auto i = 0u; i < inContext.images.size(); ++i)
     {
         ::VkImageViewCreateInfo createInfo;
         memset(&createInfo, 0, sizeof(createInfo));
-        createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-        createInfo.image = this->_swapchain_images[i];
+        createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        createInfo.image = inContext.images[i];
         createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
         createInfo.format = this->_swapchain_imageFormat;
         createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -898,200 +1265,415 @@ Renderer::Impl::create_imageviews()
         VK_ERR_CHECK(createImageViewFn(
             logical_device,
             &createInfo,
-            nullptr,
+            this->_dispatch->allocator,
             &view
         ));
-        this->_swapchain_imageViews.emplace_back(view, destroy_imageview);
+        inContext.imageViews.emplace_back(*this->_dispatch, view);
     }
 }
 
-void
-Renderer::Impl::create_graphics_pipeline()
+bool
+Renderer::Impl::recreate_swapchain(
+    SwapchainContext &inContext)
 {
-    auto logical_device = this->_logical_device.get();
-
-    ::VkPipelineVertexInputStateCreateInfo vertex_input_info;
-    memset(&vertex_input_info, 0, sizeof(vertex_input_info));
-    vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertex_input_info.vertexBindingDescriptionCount = 0;
-    vertex_input_info.pVertexBindingDescriptions = nullptr;
-    vertex_input_info.vertexAttributeDescriptionCount = 0;
-    vertex_input_info.pVertexAttributeDescriptions = nullptr;
-
-    ::VkPipelineInputAssemblyStateCreateInfo input_assembly;
-    memset(&input_assembly, 0, sizeof(input_assembly));
-    input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    input_assembly.primitiveRestartEnable = VK_FALSE;
-
-    ::VkViewport viewport;
-    memset(&viewport, 0, sizeof(viewport));
-    viewport.x = 0;
-    viewport.y = 0;
-    viewport.width = static_cast<float>(this->_swapchain_extent.width);
-    viewport.height = static_cast<float>(this->_swapchain_extent.height);
-    viewport.minDepth = 0;
-    viewport.maxDepth = 1;
-
-    ::VkRect2D scissor;
-    memset(&scissor, 0, sizeof(scissor));
-    scissor.offset = { 0, 0 };
-    scissor.extent = this->_swapchain_extent;
-
-    ::VkPipelineViewportStateCreateInfo viewport_state;
-    memset(&viewport_state, 0, sizeof(viewport_state));
-    viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewport_state.viewportCount = 1;
-    viewport_state.pViewports = &viewport;
-    viewport_state.scissorCount = 1;
-    viewport_state.pScissors = &scissor;
-
-    ::VkPipelineRasterizationStateCreateInfo rasterizer;
-    memset(&rasterizer, 0, sizeof(rasterizer));
-    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizer.depthClampEnable = VK_FALSE;
-    rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterizer.lineWidth = 1;
-    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-    rasterizer.depthBiasEnable = VK_FALSE;
-    rasterizer.depthBiasConstantFactor = 0;
-    rasterizer.depthBiasClamp = 0;
-    rasterizer.depthBiasSlopeFactor = 0;
-
-    ::VkPipelineMultisampleStateCreateInfo multisampling;
-    memset(&multisampling, 0, sizeof(multisampling));
-    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-    multisampling.minSampleShading = 1;
-    multisampling.pSampleMask = nullptr;
-    multisampling.alphaToCoverageEnable = VK_FALSE;
-    multisampling.alphaToOneEnable = VK_FALSE;
-
-    ::VkPipelineColorBlendAttachmentState color_blend_attachment;
-    memset(&color_blend_attachment, 0, sizeof(color_blend_attachment));
-    color_blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    color_blend_attachment.blendEnable = VK_FALSE;
-    color_blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-    color_blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-    color_blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
-    color_blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-    color_blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    color_blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-    VkPipelineColorBlendStateCreateInfo color_blending;
-    memset(&color_blending, 0, sizeof(color_blending));
-    color_blending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    color_blending.logicOpEnable = VK_FALSE;
-    color_blending.logicOp = VK_LOGIC_OP_COPY; // Optional
-    color_blending.attachmentCount = 1;
-    color_blending.pAttachments = &color_blend_attachment;
-    color_blending.blendConstants[0] = 0.0f; // Optional
-    color_blending.blendConstants[1] = 0.0f; // Optional
-    color_blending.blendConstants[2] = 0.0f; // Optional
-    color_blending.blendConstants[3] = 0.0f; // Optional
-
-    ::VkDynamicState dynamicStates[] = {
-        VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_LINE_WIDTH
-    };
-
-    ::VkPipelineDynamicStateCreateInfo dynamicState;
-    memset(&dynamicState, 0, sizeof(dynamicState));
-    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynamicState.dynamicStateCount = 2;
-    dynamicState.pDynamicStates = dynamicStates;
-
-    ::VkPipelineLayoutCreateInfo pipelineLayoutInfo;
-    memset(&pipelineLayoutInfo, 0, sizeof(pipelineLayoutInfo));
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 0;
-    pipelineLayoutInfo.pSetLayouts = nullptr;
-    pipelineLayoutInfo.pushConstantRangeCount = 0;
-    pipelineLayoutInfo.pPushConstantRanges = nullptr;
-
-    auto destroy_pipeline_layout = [logical_device](::VkPipelineLayout inPipelineLayout)
-    {
-        auto destroy = GETDFN(logical_device, vkDestroyPipelineLayout);
-        Log().get() << "Destroying VkPipelineLayout 0x" << std::hex << inPipelineLayout << std::endl;
-        destroy(logical_device, inPipelineLayout, nullptr);
-    };
-
-    ::VkPipelineLayout pipelineLayout;
-    VK_ERR_CHECK(::vkCreatePipelineLayout(
-        logical_device,
-        &pipelineLayoutInfo,
-        nullptr,
-        &pipelineLayout
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    auto getSurfaceCapsFn = GETIFN(this->_instance.get(), vkGetPhysicalDeviceSurfaceCapabilitiesKHR);
+    ::VkSurfaceCapabilitiesKHR surfaceCaps;
+    VK_ERR_CHECK(getSurfaceCapsFn(
+        this->_physical_devices[this->_physical_device_index],
+        inContext.surface.get(),
+        &surfaceCaps
     ));
-    this->_pipeline_layout = {pipelineLayout, destroy_pipeline_layout};
-
-    auto destroy_shader_module = [logical_device](::VkShaderModule inShaderModule)
+    if (0 == surfaceCaps.currentExtent.width || 0 == surfaceCaps.currentExtent.height)
     {
-        auto destroy = GETDFN(logical_device, vkDestroyShaderModule);
-        Log().get() << "Destroying VkShaderModule 0x" << std::hex << inShaderModule << std::endl;
-        destroy(logical_device, inShaderModule, nullptr);
-    };
+        // minimised; try again next frame
+        return false;
+    }
 
-    const auto vert_shader_code = readFile("shader_vert.spv");
-    this->_vert_shader_module = { createShaderModule(vert_shader_code, logical_device), destroy_shader_module };
-    const auto frag_shader_code = readFile("shader_frag.spv");
-    this->_frag_shader_module = { createShaderModule(frag_shader_code, logical_device), destroy_shader_module };
-
-    ::VkPipelineShaderStageCreateInfo vert_shader_stage_info;
-    memset(&vert_shader_stage_info, 0, sizeof(vert_shader_stage_info));
-    vert_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vert_shader_stage_info.stage = VK_SHADER_STAGE_VERTEX_BIT;
-    vert_shader_stage_info.module = this->_vert_shader_module.get();
-    vert_shader_stage_info.pName = "main";
-
-    ::VkPipelineShaderStageCreateInfo frag_shader_stage_info;
-    memset(&frag_shader_stage_info, 0, sizeof(frag_shader_stage_info));
-    frag_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    frag_shader_stage_info.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    frag_shader_stage_info.module = this->_frag_shader_module.get();
-    frag_shader_stage_info.pName = "main";
-
-    ::VkPipelineShaderStageCreateInfo shader_stages[] = { vert_shader_stage_info, frag_shader_stage_info };
-
-    ::VkGraphicsPipelineCreateInfo pipelineInfo;
-    memset(&pipelineInfo, 0, sizeof(pipelineInfo));
-    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount = 2;
-    pipelineInfo.pStages = shader_stages;
-    pipelineInfo.pVertexInputState = &vertex_input_info;
-    pipelineInfo.pInputAssemblyState = &input_assembly;
-    pipelineInfo.pViewportState = &viewport_state;
-    pipelineInfo.pRasterizationState = &rasterizer;
-    pipelineInfo.pMultisampleState = &multisampling;
-    pipelineInfo.pDepthStencilState = nullptr;
-    pipelineInfo.pColorBlendState = &color_blending;
-    pipelineInfo.pDynamicState = nullptr;
-    pipelineInfo.layout = pipelineLayout;
-    pipelineInfo.renderPass = this->_renderPass.get();
-    pipelineInfo.subpass = 0;
-    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
-    pipelineInfo.basePipelineIndex = -1;
-
-    auto destroy_pipeline = [logical_device](::VkPipeline inPipeline)
-    {
-        auto destroy = GETDFN(logical_device, vkDestroyPipeline);
-        Log().get() << "Destroying VkPipeline 0x" << std::hex << inPipeline << std::endl;
-        destroy(logical_device, inPipeline, nullptr);
-    };
+    // only that which depends upon the swapchain images is rebuilt; the device, render pass
+    // and pipeline (with dynamic viewport and scissor) are kept
+    // frames in flight may still be using the old objects, so they are retired rather than destroyed,
+    // without waiting for the device to be idle
+    // the static command buffers, render graph and scene chunks are all sized for the first window
+    const auto first_window = (&inContext == this->_swapchains[0].get());
+    if (first_window)
+    {
+        auto logical_device = this->_logical_device.get();
+        auto commandPool = this->_commandPool.get();
+        auto commandBuffers = this->_commandBuffers;
+        this->_deletion_queue->retire([logical_device, commandPool, commandBuffers]()
+        {
+            auto freeCommandBuffersFn = GETDFN(logical_device, vkFreeCommandBuffers);
+            freeCommandBuffersFn(
+                logical_device,
+                commandPool,
+                static_cast<uint32_t>(commandBuffers.size()),
+                commandBuffers.data()
+            );
+        });
+        this->_commandBuffers.clear();
+        this->_deletion_queue->retire(std::move(this->_render_graph));
+    }
+    for (auto &framebuffer : inContext.framebuffers)
+    {
+        this->_deletion_queue->retire(std::move(framebuffer));
+    }
+    inContext.framebuffers.clear();
+    for (auto &imageView : inContext.imageViews)
+    {
+        this->_deletion_queue->retire(std::move(imageView));
+    }
+    inContext.imageViews.clear();
 
-    ::VkPipeline pipeline;
-    VK_ERR_CHECK(::vkCreateGraphicsPipelines(
-        logical_device,
-        VK_NULL_HANDLE,
-        1,
-        &pipelineInfo,
-        nullptr,
-        &pipeline
+    this->create_swapchain(inContext);
+    this->create_imageviews(inContext);
+    this->create_framebuffers(inContext);
+    if (first_window)
+    {
+        this->create_commandbuffers();
+        if (this->_settings.render_graph)
+        {
+            this->create_render_graph();
+        }
+        // the chunks' secondaries hold the old viewport and scissor
+        for (auto i = 0u; i < this->_scene_chunks.size(); ++i)
+        {
+            this->mark_scene_chunk_dirty(i);
+        }
+    }
+    inContext.dirty = false;
+    return true;
+}
+
+void
+Renderer::Impl::add_window(
+    WindowLibrary::GraphicsWindow *inWindow)
+{
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    if (this->_swapchains.size() >= this->_settings.windows)
+    {
+        throw Exception("Cannot draw to more windows than the windows setting, for which the uniform ring is sized");
+    }
+    // the render graph's images, and the benchmarks' command buffers, are sized for the first window
+    if (this->_settings.render_graph)
+    {
+        throw Exception("The render graph cannot draw to more than one window");
+    }
+    if (this->_settings.benchmark_recording || this->_settings.benchmark_dynamic)
+    {
+        throw Exception("The recording benchmarks cannot draw to more than one window");
+    }
+
+    std::unique_ptr<SwapchainContext> context(new SwapchainContext(inWindow));
+    this->create_window_surface(*context);
+
+    // the device was chosen for the first window's surface alone
+    auto getPDeviceSurfaceSupportFn = GETIFN(this->_instance.get(), vkGetPhysicalDeviceSurfaceSupportKHR);
+    ::VkBool32 presentSupport = VK_FALSE;
+    VK_ERR_CHECK(getPDeviceSurfaceSupportFn(
+        this->_physical_devices[this->_physical_device_index],
+        this->_queue_families.present,
+        context->surface.get(),
+        &presentSupport
+    ));
+    if (VK_TRUE != presentSupport)
+    {
+        throw Exception("The present queue cannot present to the window");
+    }
+
+    this->create_swapchain(*context);
+    this->create_imageviews(*context);
+    this->create_framebuffers(*context);
+    this->create_acquire_semaphores(*context);
+    this->_swapchains.push_back(std::move(context));
+    Log().get() << "Drawing to " << this->_swapchains.size() << " windows" << std::endl;
+}
+
+void
+Renderer::Impl::remove_window(
+    WindowLibrary::GraphicsWindow *inWindow)
+{
+    // not the first window, which lives as long as the renderer
+    auto context_it = std::find_if(this->_swapchains.begin() + 1, this->_swapchains.end(), [inWindow](const std::unique_ptr<SwapchainContext> &inContext)
+    {
+        return inContext->window == inWindow;
+    });
+    if (context_it == this->_swapchains.end())
+    {
+        return;
+    }
+    // its acquire semaphores, and any swapchain it has retired, may be in use by the frames in flight, and presents
+    // are tracked by no fence, so the present queue is drained too; a rare event, unlike a resize
+    this->wait_for_frames();
+    auto queueWaitIdleFn = GETDFN(this->_logical_device.get(), vkQueueWaitIdle);
+    VK_ERR_CHECK(queueWaitIdleFn(
+        this->_present_queue
+    ));
+    this->_deletion_queue->flush();
+    this->_swapchains.erase(context_it);
+    Log().get() << "Drawing to " << this->_swapchains.size() << " windows" << std::endl;
+}
+
+void
+Renderer::Impl::create_shader_compiler()
+{
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "Compiling shaders from " << this->_settings.shader_dir << ", cached in " << (this->_settings.shader_cache_dir.empty() ? std::string("memory") : this->_settings.shader_cache_dir) << std::endl;
+    this->_shader_compiler.reset(new ShaderCompiler(this->_settings.shader_cache_dir));
+}
+
+std::vector<uint32_t>
+Renderer::Impl::load_shader(
+    const std::string &inSourceName,
+    const ::VkShaderStageFlagBits inStage,
+    const std::string &inSpirvName)
+{
+    if (this->_shader_compiler)
+    {
+        return this->_shader_compiler->compile_file(this->_settings.shader_dir + "/" + inSourceName, inStage);
+    }
+    const auto bytes = readFile(inSpirvName);
+    if (0 != (bytes.size() % sizeof(uint32_t)))
+    {
+        throw Exception("SPIR-V file " + inSpirvName + " is not a whole number of words");
+    }
+    std::vector<uint32_t> code(bytes.size() / sizeof(uint32_t));
+    memcpy(code.data(), bytes.data(), bytes.size());
+    return code;
+}
+
+void
+Renderer::Impl::create_texture_cache()
+{
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    // the instanced scene's vertex shader has no texture coordinates
+    if (this->_settings.instances > 0)
+    {
+        throw Exception("Textures cannot be used with the instanced scene");
+    }
+
+    // a header, whose data pointer is meaningless once sent, then the texels
+    std::ifstream file(this->_settings.texture_path, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw Exception("Unable to open texture " + this->_settings.texture_path);
+    }
+    TextureHeader header;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)))
+    {
+        throw Exception("Texture " + this->_settings.texture_path + " is too short for its header");
+    }
+    std::vector<char> texels(header.mu32TotalTextureDataSize);
+    if (!file.read(texels.data(), static_cast<std::streamsize>(texels.size())))
+    {
+        throw Exception("Texture " + this->_settings.texture_path + " is too short for its " + std::to_string(header.mu32TotalTextureDataSize) + " bytes of texels");
+    }
+    header.mpData = texels.data();
+
+    auto instance = this->_instance.get();
+    auto physical_device = this->_physical_devices[this->_physical_device_index];
+    auto getMemoryPropsFn = GETIFN(instance, vkGetPhysicalDeviceMemoryProperties);
+    ::VkPhysicalDeviceMemoryProperties memoryProperties;
+    getMemoryPropsFn(
+        physical_device,
+        &memoryProperties
+    );
+    auto getPropertiesFn = GETIFN(instance, vkGetPhysicalDeviceProperties);
+    ::VkPhysicalDeviceProperties properties;
+    getPropertiesFn(
+        physical_device,
+        &properties
+    );
+    auto getFormatPropertiesFn = GETIFN(instance, vkGetPhysicalDeviceFormatProperties);
+    ::VkFormatProperties formatProperties;
+    getFormatPropertiesFn(
+        physical_device,
+        VK_FORMAT_R8G8B8A8_UNORM,
+        &formatProperties
+    );
+
+    // on the graphics queue, as blits require it, and so that the frames sampling the texture are ordered after it
+    const ::VkDeviceSize staging_size = 16 * 1024 * 1024;
+    this->_texture_cache.reset(new TextureCache(
+        *this->_dispatch,
+        memoryProperties,
+        properties.limits,
+        formatProperties,
+        this->_queue_families.graphics,
+        this->_graphics_queue,
+        std::max<::VkDeviceSize>(staging_size, header.mu32TotalTextureDataSize),
+        1
+    ));
+    this->_texture = this->_texture_cache->upload(header);
+    this->_texture_cache->flush();
+}
+
+void
+Renderer::Impl::create_graphics_pipeline()
+{
+    auto logical_device = this->_logical_device.get();
+
+    const auto instanced = (this->_settings.instances > 0);
+    const auto vert_shader_code = instanced ?
+        this->load_shader("instanced.vert", VK_SHADER_STAGE_VERTEX_BIT, "instanced_vert.spv") :
+        this->load_shader("shader.vert", VK_SHADER_STAGE_VERTEX_BIT, "shader_vert.spv");
+    this->_vert_shader_module = { *this->_dispatch, createShaderModule(vert_shader_code, logical_device, this->_dispatch->allocator) };
+    const auto textured = static_cast<bool>(this->_texture_cache);
+    const auto frag_shader_code = textured ?
+        this->load_shader("textured.frag", VK_SHADER_STAGE_FRAGMENT_BIT, "textured_frag.spv") :
+        this->load_shader("shader.frag", VK_SHADER_STAGE_FRAGMENT_BIT, "shader_frag.spv");
+    this->_frag_shader_module = { *this->_dispatch, createShaderModule(frag_shader_code, logical_device, this->_dispatch->allocator) };
+    auto capture = this->_frame_capture.get();
+    if (nullptr != capture)
+    {
+        capture->shader_module(this->_vert_shader_module.get(), VK_SHADER_STAGE_VERTEX_BIT, vert_shader_code);
+        capture->shader_module(this->_frag_shader_module.get(), VK_SHADER_STAGE_FRAGMENT_BIT, frag_shader_code);
+    }
+
+    // the pipeline's resource interface and vertex layout come from the shaders themselves
+    ShaderReflection reflection(vert_shader_code, VK_SHADER_STAGE_VERTEX_BIT);
+    reflection.merge(ShaderReflection(frag_shader_code, VK_SHADER_STAGE_FRAGMENT_BIT));
+    if (instanced)
+    {
+        reflection.set_instance_rate(InstancedScene::FIRST_INSTANCE_LOCATION);
+    }
+    // uniforms are sub-allocated from the uniform ring, and bound by offset
+    reflection.use_dynamic_uniform_buffers();
+    // textures share one sampler, so it is part of the layout rather than of each descriptor
+    if (textured)
+    {
+        reflection.use_immutable_sampler(&this->_texture_cache->sampler());
+    }
+
+    if (!this->_layout_cache)
+    {
+        this->_layout_cache.reset(new LayoutCache(*this->_dispatch));
+    }
+    this->_pipeline_layout = this->_layout_cache->pipeline_layout(reflection);
+    if (nullptr != capture)
+    {
+        const auto &sets = reflection.descriptor_sets();
+        std::vector<std::vector<::VkDescriptorSetLayoutBinding>> set_bindings(sets.empty() ? 0 : (sets.rbegin()->first + 1));
+        for (const auto &set : sets)
+        {
+            set_bindings[set.first] = set.second;
+        }
+        capture->pipeline_layout(this->_pipeline_layout, set_bindings, reflection.push_constant_ranges());
+    }
+    if (!instanced && !this->_uniform_ring)
+    {
+        this->create_uniform_ring(reflection.descriptor_sets().at(0));
+    }
+    if (textured && (VK_NULL_HANDLE == this->_texture_set))
+    {
+        const auto texture_bindings = reflection.descriptor_sets().find(1);
+        if (texture_bindings == reflection.descriptor_sets().end())
+        {
+            throw Exception("Textured shaders are expected to sample from descriptor set 1");
+        }
+        this->_texture_set = this->_texture_cache->descriptor_set(this->_texture, this->_layout_cache->descriptor_set_layout(texture_bindings->second));
+    }
+
+    if (!this->_pipeline_compiler)
+    {
+        this->_pipeline_compiler.reset(new PipelineCompiler(*this->_dispatch, this->_settings.pipeline_threads, this->_settings.pipeline_cache_path));
+    }
+
+    PipelineDesc desc;
+    desc.vertex_shader = this->_vert_shader_module.get();
+    desc.fragment_shader = this->_frag_shader_module.get();
+    desc.vertex_bindings = reflection.vertex_bindings();
+    desc.vertex_attributes = reflection.vertex_attributes();
+    desc.layout = this->_pipeline_layout;
+    desc.render_pass = this->_renderPass.get();
+    desc.subpass = 0;
+
+    // one module per stage serves every combination of the shaders' specialisation constants
+    this->_pipeline_variants.reset(new PipelineVariants(*this->_pipeline_compiler, desc, reflection.specialization_constants()));
+    if (!this->_settings.pipeline_variant_manifest.empty())
+    {
+        this->_pipeline_variants->prewarm(this->_settings.pipeline_variant_manifest);
+    }
+    this->_pipeline = this->_pipeline_variants->variant(this->_pipeline_variants->parse(this->_settings.pipeline_variant));
+}
+
+void
+Renderer::Impl::create_uniform_ring(
+    const std::vector<::VkDescriptorSetLayoutBinding> &inBindings)
+{
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    auto instance = this->_instance.get();
+    auto physical_device = this->_physical_devices[this->_physical_device_index];
+    auto getMemoryPropsFn = GETIFN(instance, vkGetPhysicalDeviceMemoryProperties);
+    ::VkPhysicalDeviceMemoryProperties memoryProperties;
+    getMemoryPropsFn(
+        physical_device,
+        &memoryProperties
+    );
+    auto getPropertiesFn = GETIFN(instance, vkGetPhysicalDeviceProperties);
+    ::VkPhysicalDeviceProperties properties;
+    getPropertiesFn(
+        physical_device,
+        &properties
+    );
+
+    // enough for the most draws that will be recorded into one frame, including by the benchmarks
+    auto max_draws = this->_draw_count;
+    if (this->_settings.benchmark_dynamic)
+    {
+        max_draws = std::max(max_draws, *std::max_element(std::begin(DYNAMIC_BENCHMARK_DRAWS), std::end(DYNAMIC_BENCHMARK_DRAWS)));
+    }
+    if (this->_settings.benchmark_recording)
+    {
+        max_draws = std::max(max_draws, *std::max_element(std::begin(RECORDING_BENCHMARK_DRAWS), std::end(RECORDING_BENCHMARK_DRAWS)));
+    }
+    // each slice recorded in parallel, or scene chunk, starts a block of its own, so may leave one partially used
+    // every other window draws them all again, inline
+    const auto blocks_per_window = (max_draws + OBJECTS_PER_BLOCK - 1) / OBJECTS_PER_BLOCK;
+    const auto blocks = blocks_per_window * std::max(1u, this->_settings.windows) + std::max(this->recording_slice_limit(), this->_settings.scene_chunks);
+    const auto alignment = std::max(properties.limits.minUniformBufferOffsetAlignment, properties.limits.nonCoherentAtomSize);
+    const auto aligned_size = [alignment](const ::VkDeviceSize inSize)
+    {
+        return (inSize + alignment - 1) / alignment * alignment;
+    };
+    const auto bytes_per_frame = aligned_size(sizeof(FrameUniforms)) + blocks * aligned_size(sizeof(ObjectUniforms));
+
+    this->_uniform_ring.reset(new UniformRing(
+        *this->_dispatch,
+        memoryProperties,
+        properties.limits,
+        this->_frames_in_flight,
+        bytes_per_frame,
+        *this->_layout_cache,
+        inBindings,
+        { sizeof(FrameUniforms), sizeof(ObjectUniforms) },
+        this->_frame_capture.get()
     ));
-    this->_pipeline = {pipeline, destroy_pipeline};
+}
+
+void
+Renderer::Impl::write_frame_uniforms(
+    const uint32_t inFrame,
+    const float inTime)
+{
+    this->_uniform_ring->begin_frame(inFrame);
+    auto allocation = this->_uniform_ring->allocate(sizeof(FrameUniforms));
+    auto uniforms = static_cast<FrameUniforms *>(allocation.data);
+    uniforms->time[0] = inTime;
+    uniforms->time[1] = 0;
+    uniforms->time[2] = 0;
+    uniforms->time[3] = 0;
+    this->_frame_uniforms_offset = allocation.offset;
 }
 
 void
@@ -1147,41 +1729,30 @@ Renderer::Impl::create_renderpass()
     VK_ERR_CHECK(createRenderPassFn(
         logical_device,
         &createInfo,
-        nullptr,
+        this->_dispatch->allocator,
         &renderPass
     ));
 
-    auto destroy_renderpass = [logical_device](::VkRenderPass inRenderPass)
+    this->_renderPass = { *this->_dispatch, renderPass };
+    if (this->_frame_capture)
     {
-        auto deleter = GETDFN(logical_device, vkDestroyRenderPass);
-        Log().get() << "Destroying VkRenderPass 0x" << std::hex << inRenderPass << std::endl;
-        deleter(logical_device, inRenderPass, nullptr);
-    };
-
-    this->_renderPass = { renderPass, destroy_renderpass };
+        this->_frame_capture->render_pass(renderPass, colorAttachment);
+    }
 }
 
 void
-Renderer::Impl::create_framebuffers()
+Renderer::Impl::create_framebuffers(
+    SwapchainContext &inContext)
 {
     Log().get() << "==================================================" << std::endl;
     Log().get() << "## " << __FUNCTION__ << std::endl;
     Log().get() << "==================================================" << std::endl;
     auto logical_device = this->_logical_device.get();
-    // no resize of this->_framebuffers since there is no default constructor for
-    // std::unique_ptr with a custom deleter
     auto createFrameBufferFn = GETDFN(logical_device, vkCreateFramebuffer);
 
-    auto destroy_framebuffer = [logical_device](::VkFramebuffer inFrameBuffer)
-    {
-        auto deleter = GETDFN(logical_device, vkDestroyFramebuffer);
-        Log().get() << "Destroying VkFramebuffer 0x" << std::hex << inFrameBuffer << std::endl;
-        deleter(logical_device, inFrameBuffer, nullptr);
-    };
-
-    for (auto i = 0u; i < this->_swapchain_images.size(); ++i)
+    for (auto i = 0u; i < inContext.images.size(); ++i)
     {
-        ::VkImageView attachments[] = { this->_swapchain_imageViews[i].get() };
+        ::VkImageView attachments[] = { inContext.imageViews[i].get() };
 
         ::VkFramebufferCreateInfo createInfo;
         memset(&createInfo, 0, sizeof(createInfo));
@@ -1189,18 +1760,22 @@ Renderer::Impl::create_framebuffers()
         createInfo.renderPass = this->_renderPass.get();
         createInfo.attachmentCount = 1;
         createInfo.pAttachments = attachments;
-        createInfo.width = this->_swapchain_extent.width;
-        createInfo.height = this->_swapchain_extent.height;
+        createInfo.width = inContext.extent.width;
+        createInfo.height = inContext.extent.height;
         createInfo.layers = 1;
 
         ::VkFramebuffer frameBuffer;
         VK_ERR_CHECK(createFrameBufferFn(
             logical_device,
             &createInfo,
-            nullptr,
+            this->_dispatch->allocator,
             &frameBuffer
         ));
-        this->_framebuffers.emplace_back(frameBuffer, destroy_framebuffer);
+        inContext.framebuffers.emplace_back(*this->_dispatch, frameBuffer);
+        if (this->_frame_capture)
+        {
+            this->_frame_capture->framebuffer(frameBuffer, this->_renderPass.get(), inContext.extent);
+        }
     }
 }
 
@@ -1213,8 +1788,8 @@ Renderer::Impl::create_commandpool()
     ::VkCommandPoolCreateInfo createInfo;
     memset(&createInfo, 0, sizeof(createInfo));
     createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    createInfo.queueFamilyIndex = 0; // TODO: hook up
-    createInfo.flags = 0;
+    createInfo.queueFamilyIndex = this->_queue_families.graphics;
+    createInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT; // static command buffers may be re-recorded by benchmarks
 
     auto logical_device = this->_logical_device.get();
     auto createCommandPoolFn = GETDFN(logical_device, vkCreateCommandPool);
@@ -1222,18 +1797,11 @@ Renderer::Impl::create_commandpool()
     VK_ERR_CHECK(createCommandPoolFn(
         logical_device,
         &createInfo,
-        nullptr,
+        this->_dispatch->allocator,
         &commandPool
     ));
 
-    auto destroy_commandpool = [logical_device](VkCommandPool inCommandPool)
-    {
-        auto deleter = GETDFN(logical_device, vkDestroyCommandPool);
-        Log().get() << "Destroying VkCommandPool 0x" << std::hex << inCommandPool << std::endl;
-        deleter(logical_device, inCommandPool, nullptr);
-    };
-
-    this->_commandPool = { commandPool, destroy_commandpool };
+    this->_commandPool = { *this->_dispatch, commandPool };
 }
 
 void
@@ -1242,7 +1810,7 @@ Renderer::Impl::create_commandbuffers()
     Log().get() << "==================================================" << std::endl;
     Log().get() << "## " << __FUNCTION__ << std::endl;
     Log().get() << "==================================================" << std::endl;
-    this->_commandBuffers.resize(this->_swapchain_images.size());
+    this->_commandBuffers.resize(this->_swapchains[0]->images.size());
 
     ::VkCommandBufferAllocateInfo allocateInfo;
     memset(&allocateInfo, 0, sizeof(allocateInfo));
@@ -1259,10 +1827,25 @@ Renderer::Impl::create_commandbuffers()
         this->_commandBuffers.data()
     ));
 
+    this->record_static_commandbuffers();
+}
+
+void
+Renderer::Impl::record_static_commandbuffers()
+{
+    auto logical_device = this->_logical_device.get();
     auto beginCommandBufferFn = GETDFN(logical_device , vkBeginCommandBuffer);
     auto cmdBeginRenderPassFn = GETDFN(logical_device, vkCmdBeginRenderPass);
     auto cmdEndRenderPassFn = GETDFN(logical_device, vkCmdEndRenderPass);
     auto endCommandBufferFn = GETDFN(logical_device, vkEndCommandBuffer);
+    // recorded once, so cannot skip draws while the pipeline compiles
+    auto pipeline = this->_pipeline_compiler->wait(this->_pipeline);
+    auto capture = this->_frame_capture.get();
+    if (nullptr != capture)
+    {
+        capture->pipeline(pipeline, this->_pipeline_compiler->desc(this->_pipeline));
+    }
+    const auto &target = *this->_swapchains[0];
     for (auto i = 0u; i < this->_commandBuffers.size(); ++i)
     {
         ::VkCommandBufferBeginInfo beginInfo;
@@ -1274,14 +1857,18 @@ Renderer::Impl::create_commandbuffers()
             this->_commandBuffers[i],
             &beginInfo
         ));
+        if (nullptr != capture)
+        {
+            capture->begin(this->_commandBuffers[i]);
+        }
 
         ::VkRenderPassBeginInfo renderPassInfo;
         memset(&renderPassInfo, 0, sizeof(renderPassInfo));
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
         renderPassInfo.renderPass = this->_renderPass.get();
-        renderPassInfo.framebuffer = this->_framebuffers[i].get();
+        renderPassInfo.framebuffer = target.framebuffers[i].get();
         renderPassInfo.renderArea.offset = {0, 0};
-        renderPassInfo.renderArea.extent = this->_swapchain_extent;
+        renderPassInfo.renderArea.extent = target.extent;
 
         ::VkClearValue clearColour;
         if (0 == i)
@@ -1300,27 +1887,252 @@ Renderer::Impl::create_commandbuffers()
             &renderPassInfo,
             VK_SUBPASS_CONTENTS_INLINE
         );
+        if (nullptr != capture)
+        {
+            capture->begin_render_pass(this->_commandBuffers[i], renderPassInfo);
+        }
 
-        vkCmdBindPipeline(
-            this->_commandBuffers[i],
+        // every command buffer records identical uniforms, so each may overwrite the last's in the persistent region
+        if (this->_uniform_ring)
+        {
+            this->write_frame_uniforms(this->_uniform_ring->persistent_frame(), 0);
+        }
+        this->record_draws(this->_commandBuffers[i], pipeline, 0, 1, target.extent);
+
+        cmdEndRenderPassFn(
+            this->_commandBuffers[i]
+        );
+        if (nullptr != capture)
+        {
+            capture->end_render_pass(this->_commandBuffers[i]);
+        }
+
+        VK_ERR_CHECK(endCommandBufferFn(
+            this->_commandBuffers[i]
+        ));
+    }
+    if (this->_uniform_ring)
+    {
+        this->_uniform_ring->flush();
+    }
+}
+
+void
+Renderer::Impl::set_viewport_and_scissor(
+    ::VkCommandBuffer inCommandBuffer,
+    const ::VkExtent2D &inExtent) const
+{
+    ::VkViewport viewport;
+    memset(&viewport, 0, sizeof(viewport));
+    viewport.x = 0;
+    viewport.y = 0;
+    viewport.width = static_cast<float>(inExtent.width);
+    viewport.height = static_cast<float>(inExtent.height);
+    viewport.minDepth = 0;
+    viewport.maxDepth = 1;
+    vkCmdSetViewport(
+        inCommandBuffer,
+        0,
+        1,
+        &viewport
+    );
+    if (this->_frame_capture)
+    {
+        this->_frame_capture->set_viewport(inCommandBuffer, viewport);
+    }
+
+    ::VkRect2D scissor;
+    memset(&scissor, 0, sizeof(scissor));
+    scissor.offset = { 0, 0 };
+    scissor.extent = inExtent;
+    vkCmdSetScissor(
+        inCommandBuffer,
+        0,
+        1,
+        &scissor
+    );
+    if (this->_frame_capture)
+    {
+        this->_frame_capture->set_scissor(inCommandBuffer, scissor);
+    }
+}
+
+void
+Renderer::Impl::record_draws(
+    ::VkCommandBuffer inCommandBuffer,
+    ::VkPipeline inPipeline,
+    const uint32_t inSlice,
+    const uint32_t inNumSlices,
+    const ::VkExtent2D &inExtent) const
+{
+    vkCmdBindPipeline(
+        inCommandBuffer,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        inPipeline
+    );
+    if (this->_frame_capture)
+    {
+        this->_frame_capture->bind_pipeline(inCommandBuffer, inPipeline);
+    }
+    // dynamic state is not inherited by secondary command buffers
+    this->set_viewport_and_scissor(inCommandBuffer, inExtent);
+
+    if (this->_instanced_scene)
+    {
+        this->_instanced_scene->record(inCommandBuffer, inSlice, inNumSlices);
+        return;
+    }
+
+    // even split of the draws, with any remainder spread over the slices
+    const auto first_draw = static_cast<uint32_t>((static_cast<uint64_t>(this->_draw_count) * inSlice) / inNumSlices);
+    const auto end_draw = static_cast<uint32_t>((static_cast<uint64_t>(this->_draw_count) * (inSlice + 1)) / inNumSlices);
+    this->record_triangles(inCommandBuffer, first_draw, end_draw, nullptr);
+}
+
+void
+Renderer::Impl::record_triangles(
+    ::VkCommandBuffer inCommandBuffer,
+    const uint32_t inFirstDraw,
+    const uint32_t inEndDraw,
+    const SceneChunk *inChunk) const
+{
+    // a grid of cells covering normalised device coordinates, one triangle per cell, so that one draw fills the viewport
+    const auto pi = 3.14159265358979f;
+    const auto columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(std::max(1u, this->_draw_count)))));
+    const auto rows = (this->_draw_count + columns - 1) / columns;
+    const auto cell_width = 2.0f / columns;
+    const auto cell_height = 2.0f / std::max(1u, rows);
+    const auto scale = 0.5f * std::min(cell_width, cell_height);
+
+    // per-object data is written straight into the mapped ring, and bound by offset; small per-draw data is pushed
+    // a chunk's colours change with each version, so that its changes are visible
+    auto descriptor_set = this->_uniform_ring->descriptor_set();
+    uint32_t dynamic_offsets[] = { this->_frame_uniforms_offset, 0 };
+    const auto block_stride = this->_uniform_ring->aligned_size(sizeof(ObjectUniforms));
+    const auto hue_shift = (nullptr != inChunk) ? (inChunk->version % 10) * 0.1f : 0.0f;
+    auto capture = this->_frame_capture.get();
+    // set 1 stays bound while set 0 is rebound below, as both are bound with the same pipeline layout
+    if ((VK_NULL_HANDLE != this->_texture_set) && (inFirstDraw < inEndDraw))
+    {
+        vkCmdBindDescriptorSets(
+            inCommandBuffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
-            this->_pipeline.get()
+            this->_pipeline_layout,
+            1,
+            1,
+            &this->_texture_set,
+            0,
+            nullptr
+        );
+    }
+    ObjectUniforms *objects = nullptr;
+    for (auto draw = inFirstDraw; draw < inEndDraw; ++draw)
+    {
+        const auto object = (draw - inFirstDraw) % OBJECTS_PER_BLOCK;
+        if (0 == object)
+        {
+            const auto block = (draw - inFirstDraw) / OBJECTS_PER_BLOCK;
+            auto allocation = (nullptr != inChunk) ?
+                this->_uniform_ring->retained(inChunk->uniform_offset + block * block_stride) :
+                this->_uniform_ring->allocate(sizeof(ObjectUniforms));
+            objects = static_cast<ObjectUniforms *>(allocation.data);
+            dynamic_offsets[1] = allocation.offset;
+            vkCmdBindDescriptorSets(
+                inCommandBuffer,
+                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                this->_pipeline_layout,
+                0,
+                1,
+                &descriptor_set,
+                2,
+                dynamic_offsets
+            );
+            if (nullptr != capture)
+            {
+                capture->bind_descriptor_sets(inCommandBuffer, this->_pipeline_layout, 0, 1, &descriptor_set, 2, dynamic_offsets);
+            }
+        }
+        auto colour = objects->colour[object];
+        colour[0] = 0.5f + 0.5f * std::fmod(draw * 0.618034f + hue_shift, 1.0f);
+        colour[1] = 0.5f + 0.5f * std::fmod(draw * 0.381966f, 1.0f);
+        colour[2] = 0.5f + 0.5f * std::fmod(draw * 0.236068f, 1.0f);
+        colour[3] = 1;
+
+        DrawConstants constants;
+        constants.placement[0] = -1 + (draw % columns + 0.5f) * cell_width;
+        constants.placement[1] = -1 + (draw / columns + 0.5f) * cell_height;
+        constants.placement[2] = scale;
+        constants.placement[3] = std::fmod(draw * 0.618034f, 1.0f) * 2 * pi;
+        constants.object = object;
+        vkCmdPushConstants(
+            inCommandBuffer,
+            this->_pipeline_layout,
+            VK_SHADER_STAGE_VERTEX_BIT,
+            0,
+            sizeof(constants),
+            &constants
         );
+        if (nullptr != capture)
+        {
+            capture->push_constants(inCommandBuffer, this->_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+        }
 
         vkCmdDraw(
-            this->_commandBuffers[i],
+            inCommandBuffer,
             3,
             1,
             0,
             0
         );
+        if (nullptr != capture)
+        {
+            capture->draw(inCommandBuffer, 3, 1, 0, 0);
+        }
+    }
+}
 
-        cmdEndRenderPassFn(
-            this->_commandBuffers[i]
-        );
+void
+Renderer::Impl::create_frame_commandpools()
+{
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    auto logical_device = this->_logical_device.get();
 
-        VK_ERR_CHECK(endCommandBufferFn(
-            this->_commandBuffers[i]
+    // one transient pool per frame in flight, so that all of a frame's command buffers
+    // can be released with a single vkResetCommandPool once its fence has signalled
+    ::VkCommandPoolCreateInfo poolCreateInfo;
+    memset(&poolCreateInfo, 0, sizeof(poolCreateInfo));
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolCreateInfo.queueFamilyIndex = this->_queue_families.graphics;
+    poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    ::VkCommandBufferAllocateInfo allocateInfo;
+    memset(&allocateInfo, 0, sizeof(allocateInfo));
+    allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocateInfo.commandBufferCount = 1;
+
+    auto createCommandPoolFn = GETDFN(logical_device, vkCreateCommandPool);
+    auto allocateCommandBuffersFn = GETDFN(logical_device, vkAllocateCommandBuffers);
+
+    this->_frame_commandBuffers.resize(this->_frames_in_flight);
+    for (auto i = 0u; i < this->_frames_in_flight; ++i)
+    {
+        ::VkCommandPool commandPool;
+        VK_ERR_CHECK(createCommandPoolFn(
+            logical_device,
+            &poolCreateInfo,
+            this->_dispatch->allocator,
+            &commandPool
+        ));
+        this->_frame_commandPools.emplace_back(*this->_dispatch, commandPool);
+
+        allocateInfo.commandPool = commandPool;
+        VK_ERR_CHECK(allocateCommandBuffersFn(
+            logical_device,
+            &allocateInfo,
+            &this->_frame_commandBuffers[i]
         ));
     }
 }
@@ -1345,114 +2157,891 @@ Renderer::Impl::create_semaphores()
     auto createSemaphoreFn = GETDFN(logical_device, vkCreateSemaphore);
     ::VkSemaphore sem;
 
-    auto destroy_semaphore = [logical_device](::VkSemaphore inSemaphore)
-    {
-        auto deleter = GETDFN(logical_device, vkDestroySemaphore);
-        Log().get() << "Destroying VkSemaphore 0x" << std::hex << inSemaphore << std::endl;
-        deleter(logical_device, inSemaphore, nullptr);
-    };
-
     auto createFenceFn = GETDFN(logical_device, vkCreateFence);
     ::VkFence fence;
 
-    auto destroy_fence = [logical_device](::VkFence inFence)
-    {
-        auto deleter = GETDFN(logical_device, vkDestroyFence);
-        Log().get() << "Destroying VkFence 0x" << std::hex << inFence << std::endl;
-        deleter(logical_device, inFence, nullptr);
-    };
-
-    for (auto i = 0u; i < this->MAX_FRAMES_IN_FLIGHT; ++i)
+    for (auto i = 0u; i < this->_frames_in_flight; ++i)
     {
         VK_ERR_CHECK(createSemaphoreFn(
             logical_device,
             &semaphoreCreateInfo,
-            nullptr,
+            this->_dispatch->allocator,
             &sem
         ));
-        this->_image_available.emplace_back(sem, destroy_semaphore);
+        this->_render_finished.emplace_back(*this->_dispatch, sem);
+
+        VK_ERR_CHECK(createFenceFn(
+            logical_device,
+            &fenceCreateInfo,
+            this->_dispatch->allocator,
+            &fence
+        ));
+        this->_inflight_fence.emplace_back(*this->_dispatch, fence);
+    }
+    this->_frame_serials.assign(this->_frames_in_flight, 0);
+
+    for (auto &context : this->_swapchains)
+    {
+        this->create_acquire_semaphores(*context);
+    }
+}
+
+void
+Renderer::Impl::create_acquire_semaphores(
+    SwapchainContext &inContext)
+{
+    auto logical_device = this->_logical_device.get();
+
+    ::VkSemaphoreCreateInfo semaphoreCreateInfo;
+    memset(&semaphoreCreateInfo, 0, sizeof(semaphoreCreateInfo));
+    semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
+    auto createSemaphoreFn = GETDFN(logical_device, vkCreateSemaphore);
+    for (auto i = 0u; i < this->_frames_in_flight; ++i)
+    {
+        ::VkSemaphore sem;
         VK_ERR_CHECK(createSemaphoreFn(
             logical_device,
             &semaphoreCreateInfo,
-            nullptr,
+            this->_dispatch->allocator,
             &sem
         ));
-        this->_render_finished.emplace_back(sem, destroy_semaphore);
+        inContext.image_available.emplace_back(*this->_dispatch, sem);
+    }
+}
 
-        VK_ERR_CHECK(createFenceFn(
+void
+Renderer::Impl::wait_for_frames()
+{
+    std::vector<::VkFence> fences;
+    for (const auto &fence : this->_inflight_fence)
+    {
+        fences.push_back(fence.get());
+    }
+    if (!fences.empty())
+    {
+        auto waitForFencesFn = GETDFN(this->_logical_device.get(), vkWaitForFences);
+        VK_ERR_CHECK(waitForFencesFn(
+            this->_logical_device.get(),
+            static_cast<uint32_t>(fences.size()),
+            fences.data(),
+            VK_TRUE,
+            std::numeric_limits<uint64_t>::max()
+        ));
+    }
+    // everything submitted is complete, though not necessarily presented
+    this->_deletion_queue->collect(this->_deletion_queue->current() - 1);
+}
+
+bool
+Renderer::Impl::records_each_frame() const
+{
+    return this->_record_each_frame;
+}
+
+uint32_t
+Renderer::Impl::recording_slice_limit() const
+{
+    auto max_slices = std::max(1u, this->_settings.recording_threads);
+    if (this->_settings.benchmark_recording)
+    {
+        max_slices = std::max(max_slices, std::thread::hardware_concurrency());
+    }
+    return max_slices;
+}
+
+void
+Renderer::Impl::create_recording_workers()
+{
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    auto logical_device = this->_logical_device.get();
+
+    const auto max_slices = this->recording_slice_limit();
+    this->_max_recording_slices = max_slices;
+
+    // the calling thread records a slice too
+    this->_thread_pool.reset(new ThreadPool(max_slices - 1));
+    Log().get() << "Recording up to " << max_slices << " secondary command buffers in parallel per frame" << std::endl;
+
+    ::VkCommandBufferAllocateInfo allocateInfo;
+    memset(&allocateInfo, 0, sizeof(allocateInfo));
+    allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    allocateInfo.commandBufferCount = 1;
+    auto allocateCommandBuffersFn = GETDFN(logical_device, vkAllocateCommandBuffers);
+
+    // secondaries, one per transient pool, so that each slice of each frame can be
+    // recorded without synchronisation, and reset wholesale when the frame's fence signals
+    ::VkCommandPoolCreateInfo poolCreateInfo;
+    memset(&poolCreateInfo, 0, sizeof(poolCreateInfo));
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolCreateInfo.queueFamilyIndex = this->_queue_families.graphics;
+    poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    auto createCommandPoolFn = GETDFN(logical_device, vkCreateCommandPool);
+
+    const auto num_pools = this->_frames_in_flight * max_slices;
+    this->_slice_commandBuffers.resize(num_pools);
+    for (auto i = 0u; i < num_pools; ++i)
+    {
+        ::VkCommandPool commandPool;
+        VK_ERR_CHECK(createCommandPoolFn(
             logical_device,
-            &fenceCreateInfo,
-            nullptr,
-            &fence
+            &poolCreateInfo,
+            this->_dispatch->allocator,
+            &commandPool
+        ));
+        this->_slice_commandPools.emplace_back(*this->_dispatch, commandPool);
+
+        allocateInfo.commandPool = commandPool;
+        VK_ERR_CHECK(allocateCommandBuffersFn(
+            logical_device,
+            &allocateInfo,
+            &this->_slice_commandBuffers[i]
         ));
-        this->_inflight_fence.emplace_back(fence, destroy_fence);
     }
 }
 
-#define LOG_FLAG(_type,_flag) \
-if (inFlags & _flag)\
-{\
-    stream << #_flag;\
-    inFlags = static_cast<_type>(inFlags & ~_flag);\
+void
+Renderer::Impl::create_scene_chunks()
+{
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    if (!this->_uniform_ring)
+    {
+        Log().get() << "Scene chunks are only used for the triangle draws" << std::endl;
+        return;
+    }
+    auto logical_device = this->_logical_device.get();
+    const auto num_chunks = std::min(this->_settings.scene_chunks, std::max(1u, this->_draw_count));
+
+    // individually reset, as each chunk's secondaries are re-recorded at different times
+    ::VkCommandPoolCreateInfo poolCreateInfo;
+    memset(&poolCreateInfo, 0, sizeof(poolCreateInfo));
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolCreateInfo.queueFamilyIndex = this->_queue_families.graphics;
+    poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+    ::VkCommandBufferAllocateInfo allocateInfo;
+    memset(&allocateInfo, 0, sizeof(allocateInfo));
+    allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    allocateInfo.commandBufferCount = this->_frames_in_flight;
+
+    auto createCommandPoolFn = GETDFN(logical_device, vkCreateCommandPool);
+    auto allocateCommandBuffersFn = GETDFN(logical_device, vkAllocateCommandBuffers);
+
+    // each chunk's object uniforms are at a fixed offset in every region of the uniform ring, so that its recordings
+    // remain valid until it changes
+    const auto block_bytes = this->_uniform_ring->aligned_size(sizeof(ObjectUniforms));
+    ::VkDeviceSize uniform_offset = 0;
+    this->_scene_chunks.resize(num_chunks);
+    this->_chunk_commandBuffers.resize(this->_frames_in_flight * num_chunks);
+    std::vector<::VkCommandBuffer> commandBuffers(this->_frames_in_flight);
+    for (auto i = 0u; i < num_chunks; ++i)
+    {
+        auto &chunk = this->_scene_chunks[i];
+        chunk.first_draw = static_cast<uint32_t>((static_cast<uint64_t>(this->_draw_count) * i) / num_chunks);
+        chunk.end_draw = static_cast<uint32_t>((static_cast<uint64_t>(this->_draw_count) * (i + 1)) / num_chunks);
+        chunk.uniform_offset = uniform_offset;
+        uniform_offset += block_bytes * ((chunk.end_draw - chunk.first_draw + OBJECTS_PER_BLOCK - 1) / OBJECTS_PER_BLOCK);
+        chunk.recorded_version.assign(this->_frames_in_flight, 0);
+
+        ::VkCommandPool commandPool;
+        VK_ERR_CHECK(createCommandPoolFn(
+            logical_device,
+            &poolCreateInfo,
+            this->_dispatch->allocator,
+            &commandPool
+        ));
+        chunk.command_pool = { *this->_dispatch, commandPool };
+
+        allocateInfo.commandPool = commandPool;
+        VK_ERR_CHECK(allocateCommandBuffersFn(
+            logical_device,
+            &allocateInfo,
+            commandBuffers.data()
+        ));
+        for (auto frame = 0u; frame < this->_frames_in_flight; ++frame)
+        {
+            this->_chunk_commandBuffers[frame * num_chunks + i] = commandBuffers[frame];
+        }
+    }
+    this->_uniform_ring->set_retained_size(uniform_offset);
+    Log().get() << "Recording " << this->_draw_count << " draws in " << num_chunks << " chunks, changing " << this->_settings.dirty_chunks << " per frame" << std::endl;
 }
 
-std::string
-Renderer::Impl::to_string(
-    ::VkMemoryPropertyFlagBits inFlags)
+void
+Renderer::Impl::mark_scene_chunk_dirty(
+    const uint32_t inChunk)
 {
-    std::stringstream stream;
-    while (inFlags != 0)
-    {
-        LOG_FLAG(::VkMemoryPropertyFlagBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
-        else LOG_FLAG(::VkMemoryPropertyFlagBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
-        else LOG_FLAG(::VkMemoryPropertyFlagBits, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
-        else LOG_FLAG(::VkMemoryPropertyFlagBits, VK_MEMORY_PROPERTY_HOST_CACHED_BIT)
-        else LOG_FLAG(::VkMemoryPropertyFlagBits, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
-        else
+    ++this->_scene_chunks[inChunk].version;
+}
+
+void
+Renderer::Impl::update_scene_chunks(
+    const uint32_t inFrameIndex,
+    ::VkPipeline inPipeline)
+{
+    const auto num_chunks = static_cast<uint32_t>(this->_scene_chunks.size());
+    for (auto i = 0u; i < this->_settings.dirty_chunks; ++i)
+    {
+        this->mark_scene_chunk_dirty(this->_next_dirty_chunk);
+        this->_next_dirty_chunk = (this->_next_dirty_chunk + 1) % num_chunks;
+    }
+
+    // a change reaches each frame in flight as it comes round, as every frame has its own recording
+    std::vector<uint32_t> dirty;
+    for (auto i = 0u; i < num_chunks; ++i)
+    {
+        const auto &chunk = this->_scene_chunks[i];
+        if (chunk.recorded_version[inFrameIndex] != chunk.version)
+        {
+            dirty.push_back(i);
+        }
+    }
+
+    auto logical_device = this->_logical_device.get();
+    auto beginCommandBufferFn = GETDFN(logical_device, vkBeginCommandBuffer);
+    auto endCommandBufferFn = GETDFN(logical_device, vkEndCommandBuffer);
+    auto renderPass = this->_renderPass.get();
+    const auto record = [&](uint32_t inIndex)
+    {
+        const auto chunk_index = dirty[inIndex];
+        auto &chunk = this->_scene_chunks[chunk_index];
+
+        // no framebuffer, as the recording is executed with whichever swapchain image the frame acquires
+        ::VkCommandBufferInheritanceInfo inheritanceInfo;
+        memset(&inheritanceInfo, 0, sizeof(inheritanceInfo));
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = renderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+        inheritanceInfo.occlusionQueryEnable = this->_occlusion_queries ? VK_TRUE : VK_FALSE;
+        inheritanceInfo.pipelineStatistics = this->_pipeline_statistics;
+
+        // implicitly resets the command buffer, whose previous recording the frame's fence shows to be complete
+        ::VkCommandBufferBeginInfo beginInfo;
+        memset(&beginInfo, 0, sizeof(beginInfo));
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        auto commandBuffer = this->_chunk_commandBuffers[inFrameIndex * num_chunks + chunk_index];
+        VK_ERR_CHECK_QUIET(beginCommandBufferFn(
+            commandBuffer,
+            &beginInfo
+        ));
+        vkCmdBindPipeline(
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            inPipeline
+        );
+        if (this->_frame_capture)
+        {
+            this->_frame_capture->begin(commandBuffer);
+            this->_frame_capture->bind_pipeline(commandBuffer, inPipeline);
+        }
+        // the chunks are only executed in the first window
+        this->set_viewport_and_scissor(commandBuffer, this->_swapchains[0]->extent);
+        this->record_triangles(commandBuffer, chunk.first_draw, chunk.end_draw, &chunk);
+        VK_ERR_CHECK_QUIET(endCommandBufferFn(
+            commandBuffer
+        ));
+        chunk.recorded_version[inFrameIndex] = chunk.version;
+    };
+
+    // chunks have a command pool each, so may be recorded in parallel
+    const auto num_dirty = static_cast<uint32_t>(dirty.size());
+    if (this->_thread_pool && (num_dirty > 1))
+    {
+        this->_thread_pool->parallel_for(num_dirty, record);
+    }
+    else
+    {
+        for (auto i = 0u; i < num_dirty; ++i)
         {
-            throw Exception("Unknown memory property bit");
+            record(i);
         }
-        stream << " | ";
     }
-    return stream.str();
+    this->_chunk_recordings += num_dirty;
+    this->_chunk_executions += num_chunks;
 }
 
-std::string
-Renderer::Impl::to_string(
-    ::VkMemoryHeapFlagBits inFlags)
+void
+Renderer::Impl::create_benchmark()
 {
-    std::stringstream stream;
-    while (inFlags != 0)
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    this->_benchmark.reset(new Benchmark("command recording", 10, 50, "draws"));
+
+    if (this->_settings.benchmark_dynamic)
     {
-        LOG_FLAG(::VkMemoryHeapFlagBits, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
-        else
+        // the static cases re-record the pre-recorded command buffers up front, which
+        // requires the GPU to have finished with them
+        for (const auto draws : DYNAMIC_BENCHMARK_DRAWS)
         {
-            throw Exception("Unknown memory heap bit");
+            std::ostringstream static_name;
+            static_name << "static draws=" << draws;
+            this->_benchmark->add_case(static_name.str(), draws, [this, draws]()
+            {
+                this->wait_for_frames();
+                this->_record_each_frame = false;
+                this->_draw_count = draws;
+                this->record_static_commandbuffers();
+            });
+
+            std::ostringstream dynamic_name;
+            dynamic_name << "dynamic draws=" << draws;
+            this->_benchmark->add_case(dynamic_name.str(), draws, [this, draws]()
+            {
+                this->_record_each_frame = true;
+                this->_recording_slices = 0;
+                this->_draw_count = draws;
+            });
+        }
+    }
+
+    if (this->_settings.benchmark_recording)
+    {
+        const auto max_slices = this->_max_recording_slices;
+        for (const auto draws : RECORDING_BENCHMARK_DRAWS)
+        {
+            for (auto slices = 1u; ; slices = std::min(slices * 2, max_slices))
+            {
+                std::ostringstream name;
+                name << "parallel draws=" << draws << " threads=" << slices;
+                this->_benchmark->add_case(name.str(), draws, [this, draws, slices]()
+                {
+                    this->_record_each_frame = true;
+                    this->_recording_slices = slices;
+                    this->_draw_count = draws;
+                });
+                if (slices == max_slices)
+                {
+                    break;
+                }
+            }
         }
-        stream << " | ";
     }
-    return stream.str();
 }
 
-std::string
-Renderer::Impl::to_string(
-    ::VkQueueFlagBits inFlags)
+void
+Renderer::Impl::create_instanced_scene()
 {
-    std::stringstream stream;
-    while (inFlags != 0)
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    auto getMemoryPropsFn = GETIFN(this->_instance.get(), vkGetPhysicalDeviceMemoryProperties);
+    ::VkPhysicalDeviceMemoryProperties memoryProperties;
+    getMemoryPropsFn(
+        this->_physical_devices[this->_physical_device_index],
+        &memoryProperties
+    );
+
+    this->_instanced_scene.reset(new InstancedScene(
+        *this->_dispatch,
+        memoryProperties,
+        this->_commandPool.get(),
+        this->_graphics_queue,
+        this->_settings.instances,
+        this->_frame_capture.get()
+    ));
+}
+
+void
+Renderer::Impl::create_frame_benchmark()
+{
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    const auto warmup_frames = 10u;
+    if (this->_instanced_scene)
     {
-        LOG_FLAG(::VkQueueFlagBits, VK_QUEUE_GRAPHICS_BIT)
-        else LOG_FLAG(::VkQueueFlagBits, VK_QUEUE_COMPUTE_BIT)
-        else LOG_FLAG(::VkQueueFlagBits, VK_QUEUE_TRANSFER_BIT)
-        else LOG_FLAG(::VkQueueFlagBits, VK_QUEUE_SPARSE_BINDING_BIT)
-        else
+        this->_benchmark.reset(new Benchmark("instanced scene", warmup_frames, this->_settings.benchmark_frames, "triangles"));
+        this->_benchmark->add_case("instances=" + std::to_string(this->_instanced_scene->instance_count()), this->_instanced_scene->triangles_per_frame(), []() {});
+    }
+    else
+    {
+        this->_benchmark.reset(new Benchmark("triangle", warmup_frames, this->_settings.benchmark_frames, "triangles"));
+        this->_benchmark->add_case("draws=" + std::to_string(this->_draw_count), this->_draw_count, []() {});
+    }
+
+    // GPU frame times come from the profiler's outermost scope
+    if (0 == this->_timestamp_valid_bits)
+    {
+        Log().get() << "The graphics queue does not support timestamps; only CPU frame times will be reported" << std::endl;
+        return;
+    }
+    if (!this->_gpu_profiler)
+    {
+        this->create_gpu_profiler();
+    }
+    auto benchmark = this->_benchmark.get();
+    this->_gpu_profiler->set_listener([benchmark](const std::string &inScope, const double inGpuMilliseconds)
+    {
+        if ("frame" == inScope)
+        {
+            benchmark->add_gpu_sample(inGpuMilliseconds);
+        }
+    });
+}
+
+void
+Renderer::Impl::create_image_processor()
+{
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    auto getMemoryPropsFn = GETIFN(this->_instance.get(), vkGetPhysicalDeviceMemoryProperties);
+    ::VkPhysicalDeviceMemoryProperties memoryProperties;
+    getMemoryPropsFn(
+        this->_physical_devices[this->_physical_device_index],
+        &memoryProperties
+    );
+
+    ImageProcessor::Shaders shaders;
+    shaders.filter = this->load_shader("filter.comp", VK_SHADER_STAGE_COMPUTE_BIT, "filter_comp.spv");
+    shaders.convert = this->load_shader("convert.comp", VK_SHADER_STAGE_COMPUTE_BIT, "convert_comp.spv");
+    shaders.downsample = this->load_shader("downsample.comp", VK_SHADER_STAGE_COMPUTE_BIT, "downsample_comp.spv");
+
+    // on the async compute queue, where the device has one, so that the job overlaps the frames rendered meanwhile
+    this->_image_processor.reset(new ImageProcessor(
+        *this->_dispatch,
+        memoryProperties,
+        this->_queue_families.compute,
+        this->_compute_queue,
+        *this->_layout_cache,
+        shaders
+    ));
+    const auto size = this->_settings.image_processing_size;
+    this->_image_processing_ticket = this->_image_processor->process(ImageProcessor::test_image(size, size * 3 / 4 + 1));
+    this->_image_processing_frames = 0;
+}
+
+void
+Renderer::Impl::check_image_processing()
+{
+    ++this->_image_processing_frames;
+    if (!this->_image_processor->is_complete(this->_image_processing_ticket))
+    {
+        return;
+    }
+    const auto results = this->_image_processor->collect(this->_image_processing_ticket);
+    this->_image_processing_ticket = 0;
+
+    const auto size = this->_settings.image_processing_size;
+    const auto expected = ImageProcessor::reference(ImageProcessor::test_image(size, size * 3 / 4 + 1));
+    if (results.size() != expected.size())
+    {
+        throw Exception("Image processing produced " + std::to_string(results.size()) + " images, rather than " + std::to_string(expected.size()));
+    }
+    for (auto i = 0u; i < results.size(); ++i)
+    {
+        const auto &result = results[i];
+        const auto &reference = expected[i];
+        const auto mismatch = std::mismatch(result.texels.begin(), result.texels.end(), reference.texels.begin());
+        if (mismatch.first != result.texels.end())
         {
-            throw Exception("Unknown queue bit");
+            const auto index = static_cast<uint32_t>(mismatch.first - result.texels.begin());
+            std::ostringstream message;
+            message << "Image processing result " << i << " (" << result.width << "x" << result.height << ") differs from the CPU reference at (";
+            message << (index % result.width) << ", " << (index / result.width) << "): 0x" << std::hex << *mismatch.first << " rather than 0x" << *mismatch.second;
+            throw Exception(message.str());
         }
-        stream << " | ";
     }
-    return stream.str();
+    Log().get() << "Image processing: " << results.size() << " images bit exact against the CPU reference, completing during " << this->_image_processing_frames << " frames" << std::endl;
 }
 
-#undef LOG_FLAG
+void
+Renderer::Impl::create_gpu_profiler()
+{
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    auto getPhysicalDevicePropsFn = GETIFN(this->_instance.get(), vkGetPhysicalDeviceProperties);
+    ::VkPhysicalDeviceProperties properties;
+    getPhysicalDevicePropsFn(
+        this->_physical_devices[this->_physical_device_index],
+        &properties
+    );
+
+    const auto max_scopes = 16u;
+    this->_gpu_profiler.reset(new GpuProfiler(
+        *this->_dispatch,
+        this->_frames_in_flight,
+        max_scopes,
+        properties.limits.timestampPeriod,
+        this->_timestamp_valid_bits,
+        this->_pipeline_statistics,
+        this->_occlusion_queries,
+        this->_settings.gpu_profile_path
+    ));
+}
+
+void
+Renderer::Impl::create_frame_capture()
+{
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    // the render graph's passes, and the benchmarks' command buffers, are recorded outside of the capture's hooks
+    if (this->_settings.render_graph)
+    {
+        throw Exception("Frame capture cannot be used with the render graph");
+    }
+    if (this->_settings.benchmark_recording || this->_settings.benchmark_dynamic || (this->_settings.benchmark_frames > 0))
+    {
+        throw Exception("Frame capture cannot be used with the benchmarks");
+    }
+    if (0 == this->_settings.capture_frames)
+    {
+        throw Exception("Frame capture requires at least one frame");
+    }
+    if (this->_settings.windows > 1)
+    {
+        throw Exception("Frame capture cannot be used with more than one window");
+    }
+    // the capture format has no images to replay the texture from
+    if (!this->_settings.texture_path.empty())
+    {
+        throw Exception("Frame capture cannot be used with textures");
+    }
+    this->_frame_capture.reset(new FrameCapture(
+        this->_settings.capture_path,
+        this->_settings.capture_frames,
+        this->_frames_in_flight
+    ));
+}
+
+void
+Renderer::Impl::create_render_graph()
+{
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    auto instance = this->_instance.get();
+    auto pDevice = this->_physical_devices[this->_physical_device_index];
+
+    // the post-process is made of blits, so the format must support them
+    auto getFormatPropsFn = GETIFN(instance, vkGetPhysicalDeviceFormatProperties);
+    ::VkFormatProperties formatProperties;
+    getFormatPropsFn(
+        pDevice,
+        this->_swapchain_imageFormat,
+        &formatProperties
+    );
+    const ::VkFormatFeatureFlags required = VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+    if (required != (formatProperties.optimalTilingFeatures & required))
+    {
+        throw Exception("Swapchain format does not support the blits used by the render graph");
+    }
+    const auto downsample_filter = (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+
+    auto getMemoryPropsFn = GETIFN(instance, vkGetPhysicalDeviceMemoryProperties);
+    ::VkPhysicalDeviceMemoryProperties memoryProperties;
+    getMemoryPropsFn(
+        pDevice,
+        &memoryProperties
+    );
+
+    this->_render_graph.reset(new RenderGraph(*this->_dispatch, memoryProperties));
+    auto graph = this->_render_graph.get();
+
+    // scene -> half resolution -> full resolution -> swapchain, i.e. a pixelated post-process
+    // the scene and upscaled images never live at the same time, so share memory
+    RenderGraph::ImageDesc full;
+    full.format = this->_swapchain_imageFormat;
+    full.extent = this->_swapchains[0]->extent; // only drawn to the first window
+    RenderGraph::ImageDesc half = full;
+    half.extent.width = std::max(1u, full.extent.width / 2);
+    half.extent.height = std::max(1u, full.extent.height / 2);
+
+    const auto scene = graph->create_image("scene", full);
+    const auto half_res = graph->create_image("half resolution", half);
+    const auto upscaled = graph->create_image("upscaled", full);
+    const auto overlay = graph->create_image("debug overlay", full);
+    this->_graph_backbuffer = graph->import_image("swapchain", full, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    const auto backbuffer = this->_graph_backbuffer;
+
+    const ::VkClearColorValue clear_colour = {{0.1f, 0.1f, 0.1f, 1}};
+    auto scene_pass = graph->add_pass("scene", [this](const RenderGraph::PassContext &inContext)
+    {
+        auto pipeline = this->_pipeline_compiler->pipeline(this->_pipeline);
+        if (VK_NULL_HANDLE == pipeline)
+        {
+            return; // still compiling, so only the clear is visible
+        }
+        this->record_draws(inContext.command_buffer, pipeline, 0, 1, this->_swapchains[0]->extent);
+    });
+    graph->write_colour(scene_pass, scene, &clear_colour);
+
+    auto downsample_pass = graph->add_pass("downsample", [scene, half_res, downsample_filter](const RenderGraph::PassContext &inContext)
+    {
+        const auto &graph = inContext.graph;
+        blit_image(inContext.command_buffer, graph.image(scene), graph.desc(scene).extent, graph.image(half_res), graph.desc(half_res).extent, downsample_filter);
+    });
+    graph->read_transfer(downsample_pass, scene);
+    graph->write_transfer(downsample_pass, half_res);
+
+    auto upsample_pass = graph->add_pass("upsample", [half_res, upscaled](const RenderGraph::PassContext &inContext)
+    {
+        const auto &graph = inContext.graph;
+        blit_image(inContext.command_buffer, graph.image(half_res), graph.desc(half_res).extent, graph.image(upscaled), graph.desc(upscaled).extent, VK_FILTER_NEAREST);
+    });
+    graph->read_transfer(upsample_pass, half_res);
+    graph->write_transfer(upsample_pass, upscaled);
+
+    // nothing reads this, so it is culled
+    auto overlay_pass = graph->add_pass("debug overlay", [](const RenderGraph::PassContext &)
+    {
+    });
+    graph->write_colour(overlay_pass, overlay, &clear_colour);
+
+    auto present_pass = graph->add_pass("present", [upscaled, backbuffer](const RenderGraph::PassContext &inContext)
+    {
+        const auto &graph = inContext.graph;
+        blit_image(inContext.command_buffer, graph.image(upscaled), graph.desc(upscaled).extent, graph.image(backbuffer), graph.desc(backbuffer).extent, VK_FILTER_NEAREST);
+    });
+    graph->read_transfer(present_pass, upscaled);
+    graph->write_transfer(present_pass, backbuffer);
+
+    graph->compile();
+    this->_acquire_wait_stage = graph->first_stage(backbuffer);
+}
+
+::VkCommandBuffer
+Renderer::Impl::record_frame(
+    const uint32_t inFrameIndex,
+    const std::vector<SwapchainContext*> &inTargets)
+{
+    auto logical_device = this->_logical_device.get();
+    auto resetCommandPoolFn = GETDFN(logical_device, vkResetCommandPool);
+    auto beginCommandBufferFn = GETDFN(logical_device, vkBeginCommandBuffer);
+    auto endCommandBufferFn = GETDFN(logical_device, vkEndCommandBuffer);
+
+    const auto num_slices = this->_recording_slices;
+    const auto first_pool = inFrameIndex * this->_max_recording_slices;
+    auto renderPass = this->_renderPass.get();
+    const auto &target = *inTargets[0];
+    auto framebuffer = target.framebuffers[target.image_index].get();
+    // skip the draws until the pipeline has compiled, leaving only the clear
+    auto pipeline = this->_pipeline_compiler->pipeline(this->_pipeline);
+    // the chunks hold the first window's viewport, so are not used when only other windows are drawn
+    const auto chunked = !this->_scene_chunks.empty() && (VK_NULL_HANDLE != pipeline) && (&target == this->_swapchains[0].get());
+    const auto secondaries = chunked || (num_slices > 0);
+    auto capture = this->_frame_capture.get();
+    if ((nullptr != capture) && (VK_NULL_HANDLE != pipeline))
+    {
+        capture->pipeline(pipeline, this->_pipeline_compiler->desc(this->_pipeline));
+    }
+
+    // the fence for this frame has signalled, so nothing allocated from its pools is still in use
+    VK_ERR_CHECK_QUIET(resetCommandPoolFn(
+        logical_device,
+        this->_frame_commandPools[inFrameIndex].get(),
+        0
+    ));
+
+    auto primary = this->_frame_commandBuffers[inFrameIndex];
+    ::VkCommandBufferBeginInfo beginInfo;
+    memset(&beginInfo, 0, sizeof(beginInfo));
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_ERR_CHECK_QUIET(beginCommandBufferFn(
+        primary,
+        &beginInfo
+    ));
+    if (nullptr != capture)
+    {
+        capture->begin(primary);
+    }
+
+    // query resets must be outside of the render pass
+    auto profiler = this->_gpu_profiler.get();
+    if (nullptr != profiler)
+    {
+        profiler->begin_frame(primary, inFrameIndex);
+    }
+    GpuProfiler::Scope frameScope(profiler, primary, "frame");
+
+    if (this->_render_graph)
+    {
+        GpuProfiler::Scope graphScope(profiler, primary, "render graph", true);
+        // the render graph is only used with a single window
+        this->_render_graph->set_imported(this->_graph_backbuffer, target.images[target.image_index], target.imageViews[target.image_index].get());
+        this->_render_graph->execute(primary);
+        graphScope.end();
+        frameScope.end();
+
+        VK_ERR_CHECK_QUIET(endCommandBufferFn(
+            primary
+        ));
+        return primary;
+    }
+
+    if (chunked)
+    {
+        this->update_scene_chunks(inFrameIndex, pipeline);
+    }
+    else if (num_slices > 0)
+    {
+        this->_thread_pool->parallel_for(num_slices, [&](uint32_t inSlice)
+        {
+            auto pool_index = first_pool + inSlice;
+            VK_ERR_CHECK_QUIET(resetCommandPoolFn(
+                logical_device,
+                this->_slice_commandPools[pool_index].get(),
+                0
+            ));
+
+            ::VkCommandBufferInheritanceInfo inheritanceInfo;
+            memset(&inheritanceInfo, 0, sizeof(inheritanceInfo));
+            inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+            inheritanceInfo.renderPass = renderPass;
+            inheritanceInfo.subpass = 0;
+            inheritanceInfo.framebuffer = framebuffer;
+            // the profiler's queries, active around the render pass
+            inheritanceInfo.occlusionQueryEnable = this->_occlusion_queries ? VK_TRUE : VK_FALSE;
+            inheritanceInfo.pipelineStatistics = this->_pipeline_statistics;
+
+            ::VkCommandBufferBeginInfo beginInfo;
+            memset(&beginInfo, 0, sizeof(beginInfo));
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+            beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+            auto commandBuffer = this->_slice_commandBuffers[pool_index];
+            VK_ERR_CHECK_QUIET(beginCommandBufferFn(
+                commandBuffer,
+                &beginInfo
+            ));
+            if (nullptr != capture)
+            {
+                capture->begin(commandBuffer);
+            }
+
+            if (VK_NULL_HANDLE != pipeline)
+            {
+                this->record_draws(commandBuffer, pipeline, inSlice, num_slices, target.extent);
+            }
+
+            VK_ERR_CHECK_QUIET(endCommandBufferFn(
+                commandBuffer
+            ));
+        });
+    }
+
+    const auto clear_colour = [](const uint32_t inImageIndex)
+    {
+        ::VkClearValue clearColour;
+        if (0 == inImageIndex)
+        {
+            clearColour.color = {{1, 0, 0, 1}};
+        }
+        else
+        {
+            clearColour.color = {{0, 0, 1, 1}};
+        }
+        return clearColour;
+    };
+    const auto clearColour = clear_colour(target.image_index);
+
+    // timestamps cannot be written inside a render pass whose contents are secondary command buffers
+    GpuProfiler::Scope renderPassScope(profiler, primary, "render pass", true);
+    ::VkRenderPassBeginInfo renderPassInfo;
+    memset(&renderPassInfo, 0, sizeof(renderPassInfo));
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = renderPass;
+    renderPassInfo.framebuffer = framebuffer;
+    renderPassInfo.renderArea.offset = {0, 0};
+    renderPassInfo.renderArea.extent = target.extent;
+    renderPassInfo.clearValueCount = 1;
+    renderPassInfo.pClearValues = &clearColour;
+
+    vkCmdBeginRenderPass(
+        primary,
+        &renderPassInfo,
+        secondaries ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE
+    );
+    if (nullptr != capture)
+    {
+        capture->begin_render_pass(primary, renderPassInfo);
+    }
+
+    if (chunked)
+    {
+        // every chunk is executed, whether or not it was re-recorded
+        const auto num_chunks = static_cast<uint32_t>(this->_scene_chunks.size());
+        vkCmdExecuteCommands(
+            primary,
+            num_chunks,
+            &this->_chunk_commandBuffers[inFrameIndex * num_chunks]
+        );
+        if (nullptr != capture)
+        {
+            capture->execute_commands(primary, num_chunks, &this->_chunk_commandBuffers[inFrameIndex * num_chunks]);
+        }
+    }
+    else if (num_slices > 0)
+    {
+        vkCmdExecuteCommands(
+            primary,
+            num_slices,
+            &this->_slice_commandBuffers[first_pool]
+        );
+        if (nullptr != capture)
+        {
+            capture->execute_commands(primary, num_slices, &this->_slice_commandBuffers[first_pool]);
+        }
+    }
+    else if (VK_NULL_HANDLE != pipeline)
+    {
+        this->record_draws(primary, pipeline, 0, 1, target.extent);
+    }
+
+    vkCmdEndRenderPass(
+        primary
+    );
+    if (nullptr != capture)
+    {
+        capture->end_render_pass(primary);
+    }
+    renderPassScope.end();
+
+    // every other window is drawn inline, in a render pass of its own, sharing the pipeline and the frame's uniforms
+    if (inTargets.size() > 1)
+    {
+        GpuProfiler::Scope windowsScope(profiler, primary, "other windows");
+        for (auto target_index = 1u; target_index < inTargets.size(); ++target_index)
+        {
+            const auto &other = *inTargets[target_index];
+            const auto otherClearColour = clear_colour(other.image_index);
+            renderPassInfo.framebuffer = other.framebuffers[other.image_index].get();
+            renderPassInfo.renderArea.extent = other.extent;
+            renderPassInfo.pClearValues = &otherClearColour;
+            vkCmdBeginRenderPass(
+                primary,
+                &renderPassInfo,
+                VK_SUBPASS_CONTENTS_INLINE
+            );
+            if (VK_NULL_HANDLE != pipeline)
+            {
+                this->record_draws(primary, pipeline, 0, 1, other.extent);
+            }
+            vkCmdEndRenderPass(
+                primary
+            );
+        }
+    }
+    frameScope.end();
+
+    VK_ERR_CHECK_QUIET(endCommandBufferFn(
+        primary
+    ));
+    return primary;
+}
@@ -31,14 +31,36 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define VULKAN_RENDERER_IMPL_H
 
 #include "renderer.h"
+#include "settings.h"
+#include "uniquehandle.h"
 #include "vulkan/vulkan.h"
 
 #include <vector>
 #include <memory>
+#include <chrono>
 #include <functional>
 #include <cassert>
 #include <string>
 
+class ThreadPool;
+class Benchmark;
+class GpuProfiler;
+class FrameStats;
+class RenderGraph;
+class ShaderCompiler;
+class LayoutCache;
+class PipelineCompiler;
+class PipelineVariants;
+class InstancedScene;
+class ImageProcessor;
+class DeletionQueue;
+class HostAllocator;
+class CapabilityReport;
+class UniformRing;
+class FrameCapture;
+class DebugReportSink;
+class TextureCache;
+
 // these macros avoid repetition between stating the name of the function and the PFN_* type
 #define GETPFN(_name) PFN_##_name
 #define GETFN(_name) reinterpret_cast<GETPFN(_name)>(vkGetInstanceProcAddr(nullptr, #_name))
@@ -65,37 +87,139 @@ assert(VK_SUCCESS == result);\
 
 struct Renderer::Impl
 {
-    const uint32_t MAX_FRAMES_IN_FLIGHT = 2u;
+    // a contiguous range of the triangle draws, recorded into a secondary command buffer per frame in flight that is
+    // kept until the chunk changes
+    struct SceneChunk
+    {
+        uint32_t                      first_draw = 0;
+        uint32_t                      end_draw = 0;
+        ::VkDeviceSize                uniform_offset = 0; // of its object uniforms, within the uniform ring's retained bytes
+        uint64_t                      version = 1;        // advanced on each change
+        std::vector<uint64_t>         recorded_version;   // per frame in flight, of the recording it holds; 0 if none
+        UniqueHandle<::VkCommandPool> command_pool;       // of its secondaries, so that chunks may be recorded in parallel
+    };
+
+    // a window rendered to; its surface, swapchain and everything sized by them
+    // the device, render pass, pipelines and frames in flight are shared by every window
+    struct SwapchainContext
+    {
+        WindowLibrary::GraphicsWindow                                           *window = nullptr;
+        std::unique_ptr<::VkSurfaceKHR_T, std::function<void(::VkSurfaceKHR)>> surface;
+        ::VkExtent2D                                                            extent;
+        UniqueHandle<::VkSwapchainKHR>                                          swapchain;
+        std::vector<::VkImage>                                                  images;
+        std::vector<UniqueHandle<::VkImageView>>                                imageViews;
+        std::vector<UniqueHandle<::VkFramebuffer>>                              framebuffers;
+        std::vector<UniqueHandle<::VkSemaphore>>                                image_available; // per frame in flight
+        uint32_t                                                                image_index = 0; // acquired by the frame being recorded
+        bool                                                                    dirty = false;
+
+        explicit SwapchainContext(
+            WindowLibrary::GraphicsWindow *inWindow);
+    };
+
+    // queue family chosen for each role; roles share a family where the device has no dedicated one
+    struct QueueFamilies
+    {
+        uint32_t graphics = static_cast<uint32_t>(-1);
+        uint32_t present = static_cast<uint32_t>(-1);
+        uint32_t compute = static_cast<uint32_t>(-1);  // async compute, i.e. without graphics, if available
+        uint32_t transfer = static_cast<uint32_t>(-1); // DMA, i.e. without graphics or compute, if available
 
+        bool
+        complete() const;
+    };
+
+    RendererSettings                                                                               _settings;
+    // declared before the instance, so outlives everything allocated through it
+    std::unique_ptr<HostAllocator>                                                                 _host_allocator;
+    const ::VkAllocationCallbacks                                                                 *_allocation_callbacks = nullptr; // passed to every create and destroy
     std::unique_ptr<::VkInstance_T, std::function<void(::VkInstance)>>                             _instance;
+    // declared before the debug callback, so outlives it
+    std::unique_ptr<DebugReportSink>                                                               _debug_report_sink;
     std::unique_ptr<::VkDebugReportCallbackEXT_T, std::function<void(::VkDebugReportCallbackEXT)>> _debug_callback;
-    AppWindow                                                                                     *_window = nullptr;
-    std::unique_ptr< ::VkSurfaceKHR_T, std::function<void(::VkSurfaceKHR)>>                        _surface;
     std::vector< ::VkPhysicalDevice>                                                               _physical_devices;
     size_t                                                                                         _physical_device_index = static_cast<size_t>(-1);
+    std::unique_ptr<CapabilityReport>                                                              _capability_report;
+    // declared before the device, so outlives the subsystems recording into it
+    std::unique_ptr<FrameCapture>                                                                  _frame_capture;
     std::unique_ptr< ::VkDevice_T, std::function<void(::VkDevice)>>                                _logical_device;
+    // destruction functions of the device, shared by the handles below; declared after the device, so destroyed before it
+    std::unique_ptr<DeviceDispatch>                                                                _dispatch;
+    QueueFamilies                                                                                  _queue_families;
     ::VkQueue                                                                                      _graphics_queue;
+    uint32_t                                                                                       _timestamp_valid_bits = 0;
+    // counted by the GPU profiler around each pass, where the device supports them
+    ::VkQueryPipelineStatisticFlags                                                                _pipeline_statistics = 0;
+    bool                                                                                           _occlusion_queries = false;
     ::VkQueue                                                                                      _present_queue;
-    ::VkFormat                                                                                     _swapchain_imageFormat;
-    ::VkExtent2D                                                                                   _swapchain_extent;
-    std::unique_ptr<::VkSwapchainKHR_T, std::function<void(::VkSwapchainKHR)>>                     _swapchain;
-    std::vector<::VkImage>                                                                         _swapchain_images;
-    std::vector<std::unique_ptr<::VkImageView_T, std::function<void(::VkImageView)>>>              _swapchain_imageViews;
-    std::unique_ptr<::VkShaderModule_T, std::function<void(::VkShaderModule)>>                     _vert_shader_module;
-    std::unique_ptr<::VkShaderModule_T, std::function<void(::VkShaderModule)>>                     _frag_shader_module;
-    std::unique_ptr<::VkRenderPass_T, std::function<void(::VkRenderPass)>>                         _renderPass;
-    std::unique_ptr<::VkPipelineLayout_T, std::function<void(::VkPipelineLayout)>>                 _pipeline_layout;
-    std::unique_ptr<::VkPipeline_T, std::function<void(::VkPipeline)>>                             _pipeline;
-    std::vector<std::unique_ptr<::VkFramebuffer_T, std::function<void(::VkFramebuffer)>>>          _framebuffers;
-    std::unique_ptr<::VkCommandPool_T, std::function<void(::VkCommandPool)>>                       _commandPool;
-    std::vector<::VkCommandBuffer>                                                                 _commandBuffers;
-    std::vector<std::unique_ptr<::VkSemaphore_T, std::function<void(::VkSemaphore)>>>              _image_available;
-    std::vector<std::unique_ptr<::VkSemaphore_T, std::function<void(::VkSemaphore)>>>              _render_finished;
-    std::vector<std::unique_ptr<::VkFence_T, std::function<void(::VkFence)>>>                      _inflight_fence;
+    ::VkQueue                                                                                      _compute_queue;
+    ::VkQueue                                                                                      _transfer_queue;
+    // the first is the window the renderer was created with; more are added with add_window
+    // declared before the deletion queue, so that the surfaces outlive any swapchains it has retired
+    std::vector<std::unique_ptr<SwapchainContext>>                                                 _swapchains;
+    // objects retired while frames may still use them; declared after the device, so destroyed before it
+    std::unique_ptr<DeletionQueue>                                                                 _deletion_queue;
+    ::VkFormat                                                                                     _swapchain_imageFormat; // of every swapchain, as the render pass is shared
+    std::unique_ptr<ShaderCompiler>                                                                _shader_compiler;
+    UniqueHandle<::VkShaderModule>                                                                 _vert_shader_module;
+    UniqueHandle<::VkShaderModule>                                                                 _frag_shader_module;
+    UniqueHandle<::VkRenderPass>                                                                   _renderPass;
+    // declared before the layout cache, so that its sampler outlives the set layouts it is immutable in
+    std::unique_ptr<TextureCache>                                                                  _texture_cache;
+    ::VkDescriptorSet                                                                              _texture_set = VK_NULL_HANDLE; // set 1 of the triangles, owned by _texture_cache
+    uint32_t                                                                                       _texture = 0; // index in _texture_cache of the settings' texture
+    std::unique_ptr<LayoutCache>                                                                   _layout_cache;
+    ::VkPipelineLayout                                                                             _pipeline_layout = VK_NULL_HANDLE; // owned by _layout_cache
+    // declared after everything that a compile uses, so that outstanding compiles finish before they are destroyed
+    std::unique_ptr<PipelineCompiler>                                                              _pipeline_compiler;
+    std::unique_ptr<PipelineVariants>                                                              _pipeline_variants;
+    uint32_t                                                                                       _pipeline = 0; // handle from _pipeline_compiler, of the variant chosen by the settings
+    // uniforms of the triangle draws; absent for the instanced scene
+    std::unique_ptr<UniformRing>                                                                   _uniform_ring;
+    uint32_t                                                                                       _frame_uniforms_offset = 0; // dynamic offset of the FrameUniforms being recorded
+    std::chrono::high_resolution_clock::time_point                                                 _start_time = std::chrono::high_resolution_clock::now();
+    UniqueHandle<::VkCommandPool>                                                                  _commandPool;
+    std::vector<::VkCommandBuffer>                                                                 _commandBuffers; // per swapchain image of the first window
+    // signalled once a frame's commands complete, and waited on by the present of every window it drew
+    std::vector<UniqueHandle<::VkSemaphore>>                                                       _render_finished;
+    std::vector<UniqueHandle<::VkFence>>                                                           _inflight_fence;
+    std::vector<uint64_t>                                                                          _frame_serials; // deletion queue serial last submitted with each fence
+    uint32_t                                                                                       _frames_in_flight;
     uint32_t                                                                                       _current_frame = 0;
 
+    // per-frame recording; one pool and primary per frame in flight, reset wholesale once the frame's fence
+    // has signalled, with the primary either recorded inline or stitching together secondaries recorded
+    // in parallel from pools indexed [frame * _max_recording_slices + slice]
+    bool                                                                                           _record_each_frame = false;
+    std::vector<UniqueHandle<::VkCommandPool>>                                                     _frame_commandPools;
+    std::vector<::VkCommandBuffer>                                                                 _frame_commandBuffers;
+    std::vector<UniqueHandle<::VkCommandPool>>                                                     _slice_commandPools;
+    std::vector<::VkCommandBuffer>                                                                 _slice_commandBuffers;
+    uint32_t                                                                                       _max_recording_slices = 0;
+    uint32_t                                                                                       _recording_slices = 0;
+    uint32_t                                                                                       _draw_count = 0;
+    // retained recording; secondaries indexed [frame * _scene_chunks.size() + chunk]
+    std::vector<SceneChunk>                                                                        _scene_chunks;
+    std::vector<::VkCommandBuffer>                                                                 _chunk_commandBuffers;
+    uint32_t                                                                                       _next_dirty_chunk = 0;
+    uint64_t                                                                                       _chunk_recordings = 0;
+    uint64_t                                                                                       _chunk_executions = 0;
+    std::unique_ptr<ThreadPool>                                                                    _thread_pool;
+    std::unique_ptr<Benchmark>                                                                     _benchmark;
+    std::unique_ptr<GpuProfiler>                                                                   _gpu_profiler;
+    std::unique_ptr<FrameStats>                                                                    _frame_stats;
+    std::unique_ptr<RenderGraph>                                                                   _render_graph;
+    std::unique_ptr<InstancedScene>                                                                _instanced_scene;
+    std::unique_ptr<ImageProcessor>                                                                _image_processor;
+    uint64_t                                                                                       _image_processing_ticket = 0;
+    uint32_t                                                                                       _image_processing_frames = 0; // rendered while the job ran
+    uint32_t                                                                                       _graph_backbuffer = 0;
+    ::VkPipelineStageFlags                                                                         _acquire_wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
     Impl(
-        AppWindow *inWindow);
+        AppWindow *inWindow,
+        const RendererSettings &inSettings);
     ~Impl();
 
     void
@@ -116,28 +240,81 @@ struct Renderer::Impl
         void*                                       pUserData);
 
     void
-    create_window_surface();
+    create_window_surface(
+        SwapchainContext &inContext);
 
     void
     enumerate_physical_devices();
 
+    QueueFamilies
+    find_queue_families(
+        ::VkPhysicalDevice inDevice) const;
+
+    // negative if the device cannot be used at all
+    int64_t
+    score_physical_device(
+        ::VkPhysicalDevice inDevice) const;
+
     void
     create_logical_device();
 
     void
-    create_swapchain();
+    create_swapchain(
+        SwapchainContext &inContext);
+
+    void
+    create_imageviews(
+        SwapchainContext &inContext);
+
+    // false if the window is minimised, so cannot be drawn to
+    bool
+    recreate_swapchain(
+        SwapchainContext &inContext);
+
+    // a further window drawn each frame, sharing the device; throws Exception if the settings cannot draw to it
+    void
+    add_window(
+        WindowLibrary::GraphicsWindow *inWindow);
+
+    // waits for the frames in flight, which may be drawing to the window
+    void
+    remove_window(
+        WindowLibrary::GraphicsWindow *inWindow);
 
     void
-    create_imageviews();
+    create_shader_compiler();
+
+    std::vector<uint32_t>
+    load_shader(
+        const std::string &inSourceName,
+        const ::VkShaderStageFlagBits inStage,
+        const std::string &inSpirvName);
+
+    // uploads the texture of the settings, for create_graphics_pipeline to sample
+    void
+    create_texture_cache();
 
     void
     create_graphics_pipeline();
 
+    // sized for the most draws, and recording slices, that a frame may have
+    // inBindings are those of descriptor set 0 of the triangle's shaders
+    void
+    create_uniform_ring(
+        const std::vector<::VkDescriptorSetLayoutBinding> &inBindings);
+
+    // begins region inFrame of the uniform ring with the uniforms shared by every draw of the frame
+    void
+    write_frame_uniforms(
+        const uint32_t inFrame,
+        const float inTime);
+
     void
     create_renderpass();
 
     void
-    create_framebuffers();
+    create_framebuffers(
+        SwapchainContext &inContext);
 
     void
     create_commandpool();
@@ -145,20 +322,104 @@ struct Renderer::Impl
     void
     create_commandbuffers();
 
+    void
+    record_static_commandbuffers();
+
+    void
+    set_viewport_and_scissor(
+        ::VkCommandBuffer inCommandBuffer,
+        const ::VkExtent2D &inExtent) const;
+
+    // binds the pipeline, then draws slice inSlice, of inNumSlices, of the triangles or instanced scene, filling inExtent
+    // the triangles' uniforms are allocated from the uniform ring's current region
+    void
+    record_draws(
+        ::VkCommandBuffer inCommandBuffer,
+        ::VkPipeline inPipeline,
+        const uint32_t inSlice,
+        const uint32_t inNumSlices,
+        const ::VkExtent2D &inExtent) const;
+
+    // draws triangles [inFirstDraw, inEndDraw) with the pipeline, viewport and scissor already set
+    // their object uniforms are written to inChunk's retained bytes of the uniform ring, or allocated from the ring if nullptr
+    void
+    record_triangles(
+        ::VkCommandBuffer inCommandBuffer,
+        const uint32_t inFirstDraw,
+        const uint32_t inEndDraw,
+        const SceneChunk *inChunk) const;
+
+    void
+    create_frame_commandpools();
+
     void
     create_semaphores();
 
-    static std::string
-    to_string(
-        ::VkMemoryPropertyFlagBits inFlags);
+    void
+    create_acquire_semaphores(
+        SwapchainContext &inContext);
+
+    // blocks until every frame in flight is complete, then destroys what they retired
+    // a fence wait, rather than idling the device, so work on other queues continues
+    void
+    wait_for_frames();
+
+    bool
+    records_each_frame() const;
+
+    // the most secondary command buffers that a frame may be recorded into in parallel
+    uint32_t
+    recording_slice_limit() const;
+
+    void
+    create_recording_workers();
+
+    void
+    create_scene_chunks();
+
+    void
+    mark_scene_chunk_dirty(
+        const uint32_t inChunk);
+
+    // re-records, into frame inFrameIndex's secondaries, each chunk that has changed since they were last recorded
+    void
+    update_scene_chunks(
+        const uint32_t inFrameIndex,
+        ::VkPipeline inPipeline);
+
+    void
+    create_benchmark();
+
+    void
+    create_instanced_scene();
+
+    void
+    create_frame_benchmark();
+
+    void
+    create_image_processor();
 
-    static std::string
-    to_string(
-        ::VkMemoryHeapFlagBits inFlags);
+    // once the image processing job is complete, compares its results with the CPU reference
+    // throws Exception on any difference
+    void
+    check_image_processing();
+
+    void
+    create_gpu_profiler();
+
+    // throws Exception if the settings use anything that cannot be captured
+    void
+    create_frame_capture();
+
+    void
+    create_render_graph();
 
-    static std::string
-    to_string(
-        ::VkQueueFlagBits inFlags);
+    // draws to each of inTargets, at the image each has acquired
+    // the first window is drawn as configured by the settings; other windows are drawn inline, in render passes of their own
+    ::VkCommandBuffer
+    record_frame(
+        const uint32_t inFrameIndex,
+        const std::vector<SwapchainContext*> &inTargets);
 };
 
 #endif // VULKAN_RENDERER_IMPL_H
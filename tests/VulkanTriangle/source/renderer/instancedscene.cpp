@@ -0,0 +1,354 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "instancedscene.h"
+#include "impl.h"
+#include "exception.h"
+#include "framecapture.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+
+const uint32_t MESH_SEGMENTS = 8;
+
+struct Vertex
+{
+    float position[2];
+};
+
+struct Instance
+{
+    float placement[4]; // xy offset, z scale, w rotation
+    float colour[4];
+};
+
+} // anonymous namespace
+
+InstancedScene::InstancedScene(
+    const DeviceDispatch &inDispatch,
+    const ::VkPhysicalDeviceMemoryProperties &inMemoryProperties,
+    ::VkCommandPool inCommandPool,
+    ::VkQueue inQueue,
+    const uint32_t inInstanceCount,
+    FrameCapture *inCapture)
+    :
+    _dispatch(inDispatch),
+    _device(inDispatch.device),
+    _capture(inCapture),
+    _memory_properties(inMemoryProperties),
+    _instance_count(inInstanceCount)
+{
+    const auto pi = 3.14159265358979f;
+
+    // a disc, as a fan of triangles around its centre, wound to match the triangle
+    std::vector<Vertex> vertices;
+    vertices.push_back({{0, 0}});
+    for (auto i = 0u; i < MESH_SEGMENTS; ++i)
+    {
+        const auto angle = 2 * pi * i / MESH_SEGMENTS;
+        vertices.push_back({{std::cos(angle), std::sin(angle)}});
+    }
+    std::vector<uint16_t> indices;
+    for (auto i = 0u; i < MESH_SEGMENTS; ++i)
+    {
+        indices.push_back(0);
+        indices.push_back(static_cast<uint16_t>(1 + i));
+        indices.push_back(static_cast<uint16_t>(1 + (i + 1) % MESH_SEGMENTS));
+    }
+    this->_index_count = static_cast<uint32_t>(indices.size());
+
+    // a grid of cells covering normalised device coordinates, one instance per cell
+    const auto columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(inInstanceCount))));
+    const auto rows = (inInstanceCount + columns - 1) / columns;
+    const auto cell_width = 2.0f / columns;
+    const auto cell_height = 2.0f / rows;
+    const auto scale = 0.45f * std::min(cell_width, cell_height);
+    std::vector<Instance> instances(inInstanceCount);
+    for (auto i = 0u; i < inInstanceCount; ++i)
+    {
+        auto &instance = instances[i];
+        instance.placement[0] = -1 + (i % columns + 0.5f) * cell_width;
+        instance.placement[1] = -1 + (i / columns + 0.5f) * cell_height;
+        instance.placement[2] = scale;
+        instance.placement[3] = std::fmod(i * 0.618034f, 1.0f) * 2 * pi;
+        const auto hue = std::fmod(i * 0.381966f, 1.0f) * 2 * pi;
+        instance.colour[0] = 0.5f + 0.5f * std::cos(hue);
+        instance.colour[1] = 0.5f + 0.5f * std::cos(hue - 2 * pi / 3);
+        instance.colour[2] = 0.5f + 0.5f * std::cos(hue + 2 * pi / 3);
+        instance.colour[3] = 1;
+    }
+
+    const auto vertex_bytes = vertices.size() * sizeof(Vertex);
+    const auto index_bytes = indices.size() * sizeof(uint16_t);
+    const auto instance_bytes = instances.size() * sizeof(Instance);
+    this->_vertices = this->create_buffer(vertex_bytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    this->_indices = this->create_buffer(index_bytes, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    this->_instances = this->create_buffer(instance_bytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    // upload everything through one staging buffer, in one submission
+    auto device = this->_device;
+    auto staging = this->create_buffer(vertex_bytes + index_bytes + instance_bytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    auto mapMemoryFn = GETDFN(device, vkMapMemory);
+    auto unmapMemoryFn = GETDFN(device, vkUnmapMemory);
+    void *mapped = nullptr;
+    VK_ERR_CHECK(mapMemoryFn(
+        device,
+        staging.memory.get(),
+        0,
+        VK_WHOLE_SIZE,
+        0,
+        &mapped
+    ));
+    auto *bytes = static_cast<char *>(mapped);
+    memcpy(bytes, vertices.data(), vertex_bytes);
+    memcpy(bytes + vertex_bytes, indices.data(), index_bytes);
+    memcpy(bytes + vertex_bytes + index_bytes, instances.data(), instance_bytes);
+    unmapMemoryFn(device, staging.memory.get());
+
+    ::VkCommandBufferAllocateInfo allocInfo;
+    memset(&allocInfo, 0, sizeof(allocInfo));
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = inCommandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+    auto allocateCommandBuffersFn = GETDFN(device, vkAllocateCommandBuffers);
+    ::VkCommandBuffer commandBuffer;
+    VK_ERR_CHECK(allocateCommandBuffersFn(
+        device,
+        &allocInfo,
+        &commandBuffer
+    ));
+
+    ::VkCommandBufferBeginInfo beginInfo;
+    memset(&beginInfo, 0, sizeof(beginInfo));
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    auto beginCommandBufferFn = GETDFN(device, vkBeginCommandBuffer);
+    VK_ERR_CHECK(beginCommandBufferFn(
+        commandBuffer,
+        &beginInfo
+    ));
+
+    auto cmdCopyBufferFn = GETDFN(device, vkCmdCopyBuffer);
+    ::VkBufferCopy region;
+    memset(&region, 0, sizeof(region));
+    region.srcOffset = 0;
+    region.size = vertex_bytes;
+    cmdCopyBufferFn(commandBuffer, staging.buffer.get(), this->_vertices.buffer.get(), 1, &region);
+    region.srcOffset = vertex_bytes;
+    region.size = index_bytes;
+    cmdCopyBufferFn(commandBuffer, staging.buffer.get(), this->_indices.buffer.get(), 1, &region);
+    region.srcOffset = vertex_bytes + index_bytes;
+    region.size = instance_bytes;
+    cmdCopyBufferFn(commandBuffer, staging.buffer.get(), this->_instances.buffer.get(), 1, &region);
+
+    auto endCommandBufferFn = GETDFN(device, vkEndCommandBuffer);
+    VK_ERR_CHECK(endCommandBufferFn(
+        commandBuffer
+    ));
+
+    ::VkSubmitInfo submitInfo;
+    memset(&submitInfo, 0, sizeof(submitInfo));
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+
+    // the queue is idle once the copy completes, so no barrier is needed before the first frame's vertex input
+    auto queueSubmitFn = GETDFN(device, vkQueueSubmit);
+    auto queueWaitIdleFn = GETDFN(device, vkQueueWaitIdle);
+    VK_ERR_CHECK(queueSubmitFn(
+        inQueue,
+        1,
+        &submitInfo,
+        VK_NULL_HANDLE
+    ));
+    VK_ERR_CHECK(queueWaitIdleFn(
+        inQueue
+    ));
+
+    auto freeCommandBuffersFn = GETDFN(device, vkFreeCommandBuffers);
+    freeCommandBuffersFn(
+        device,
+        inCommandPool,
+        1,
+        &commandBuffer
+    );
+
+    // captured with their contents, rather than as the upload
+    if (nullptr != this->_capture)
+    {
+        this->_capture->buffer(this->_vertices.buffer.get(), vertex_bytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertices.data());
+        this->_capture->buffer(this->_indices.buffer.get(), index_bytes, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indices.data());
+        this->_capture->buffer(this->_instances.buffer.get(), instance_bytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, instances.data());
+    }
+
+    Log().get() << "Instanced scene: " << inInstanceCount << " instances of " << MESH_SEGMENTS << " triangles, in a " << columns << "x" << rows << " grid" << std::endl;
+}
+
+InstancedScene::~InstancedScene() = default;
+
+void
+InstancedScene::record(
+    ::VkCommandBuffer inCommandBuffer,
+    const uint32_t inSlice,
+    const uint32_t inNumSlices) const
+{
+    // even split of the instances, with any remainder spread over the slices
+    const auto first_instance = static_cast<uint32_t>((static_cast<uint64_t>(this->_instance_count) * inSlice) / inNumSlices);
+    const auto end_instance = static_cast<uint32_t>((static_cast<uint64_t>(this->_instance_count) * (inSlice + 1)) / inNumSlices);
+    if (first_instance == end_instance)
+    {
+        return;
+    }
+
+    ::VkBuffer buffers[] = { this->_vertices.buffer.get(), this->_instances.buffer.get() };
+    ::VkDeviceSize offsets[] = { 0, 0 };
+    vkCmdBindVertexBuffers(
+        inCommandBuffer,
+        0,
+        2,
+        buffers,
+        offsets
+    );
+    vkCmdBindIndexBuffer(
+        inCommandBuffer,
+        this->_indices.buffer.get(),
+        0,
+        VK_INDEX_TYPE_UINT16
+    );
+    vkCmdDrawIndexed(
+        inCommandBuffer,
+        this->_index_count,
+        end_instance - first_instance,
+        0,
+        0,
+        first_instance
+    );
+    if (nullptr != this->_capture)
+    {
+        this->_capture->bind_vertex_buffers(inCommandBuffer, 0, 2, buffers, offsets);
+        this->_capture->bind_index_buffer(inCommandBuffer, this->_indices.buffer.get(), 0, VK_INDEX_TYPE_UINT16);
+        this->_capture->draw_indexed(inCommandBuffer, this->_index_count, end_instance - first_instance, 0, 0, first_instance);
+    }
+}
+
+uint32_t
+InstancedScene::instance_count() const
+{
+    return this->_instance_count;
+}
+
+uint64_t
+InstancedScene::triangles_per_frame() const
+{
+    return static_cast<uint64_t>(this->_index_count / 3) * this->_instance_count;
+}
+
+InstancedScene::Buffer
+InstancedScene::create_buffer(
+    const ::VkDeviceSize inSize,
+    const ::VkBufferUsageFlags inUsage,
+    const ::VkMemoryPropertyFlags inProperties) const
+{
+    auto device = this->_device;
+
+    ::VkBufferCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+    createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    createInfo.size = inSize;
+    createInfo.usage = inUsage;
+    createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    auto createBufferFn = GETDFN(device, vkCreateBuffer);
+    ::VkBuffer buffer;
+    VK_ERR_CHECK(createBufferFn(
+        device,
+        &createInfo,
+        this->_dispatch.allocator,
+        &buffer
+    ));
+
+    Buffer result;
+    result.buffer = { this->_dispatch, buffer };
+
+    auto getBufferMemoryRequirementsFn = GETDFN(device, vkGetBufferMemoryRequirements);
+    ::VkMemoryRequirements requirements;
+    getBufferMemoryRequirementsFn(
+        device,
+        buffer,
+        &requirements
+    );
+
+    ::VkMemoryAllocateInfo allocateInfo;
+    memset(&allocateInfo, 0, sizeof(allocateInfo));
+    allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize = requirements.size;
+    allocateInfo.memoryTypeIndex = this->find_memory_type(requirements.memoryTypeBits, inProperties);
+
+    auto allocateMemoryFn = GETDFN(device, vkAllocateMemory);
+    ::VkDeviceMemory memory;
+    VK_ERR_CHECK(allocateMemoryFn(
+        device,
+        &allocateInfo,
+        this->_dispatch.allocator,
+        &memory
+    ));
+    result.memory = { this->_dispatch, memory };
+
+    auto bindBufferMemoryFn = GETDFN(device, vkBindBufferMemory);
+    VK_ERR_CHECK(bindBufferMemoryFn(
+        device,
+        buffer,
+        memory,
+        0
+    ));
+    return result;
+}
+
+uint32_t
+InstancedScene::find_memory_type(
+    const uint32_t inTypeBits,
+    const ::VkMemoryPropertyFlags inProperties) const
+{
+    for (auto i = 0u; i < this->_memory_properties.memoryTypeCount; ++i)
+    {
+        if ((inTypeBits & (1u << i)) && (inProperties == (this->_memory_properties.memoryTypes[i].propertyFlags & inProperties)))
+        {
+            return i;
+        }
+    }
+    throw Exception("No memory type suitable for the instanced scene's buffers");
+}
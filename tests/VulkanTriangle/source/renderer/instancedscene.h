@@ -0,0 +1,106 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_INSTANCEDSCENE_H
+#define VULKAN_RENDERER_INSTANCEDSCENE_H
+
+#include "uniquehandle.h"
+#include "vulkan/vulkan.h"
+
+#include <cstdint>
+
+// stress scene of many instances of a small indexed mesh, laid out in a grid over the viewport
+// mesh vertices (binding 0) and per-instance placement and colour (binding 1) are in device local
+// buffers, uploaded once through a staging buffer
+class FrameCapture;
+
+class InstancedScene
+{
+public:
+    // vertex inputs at or beyond this location are per instance
+    static const uint32_t FIRST_INSTANCE_LOCATION = 1;
+
+    // inCommandPool and inQueue are used, and waited upon, for the upload
+    // inCapture, if not nullptr, records the buffers and their contents, and the commands drawing them
+    InstancedScene(
+        const DeviceDispatch &inDispatch,
+        const ::VkPhysicalDeviceMemoryProperties &inMemoryProperties,
+        ::VkCommandPool inCommandPool,
+        ::VkQueue inQueue,
+        const uint32_t inInstanceCount,
+        FrameCapture *inCapture);
+    ~InstancedScene();
+
+    InstancedScene(const InstancedScene &) = delete;
+    InstancedScene &operator=(const InstancedScene &) = delete;
+
+    // draws the instances of slice inSlice, of inNumSlices even slices, with the pipeline already bound
+    void
+    record(
+        ::VkCommandBuffer inCommandBuffer,
+        const uint32_t inSlice,
+        const uint32_t inNumSlices) const;
+
+    uint32_t
+    instance_count() const;
+
+    uint64_t
+    triangles_per_frame() const;
+
+private:
+    // declared such that the buffer is destroyed before its memory is freed
+    struct Buffer
+    {
+        UniqueHandle<::VkDeviceMemory> memory;
+        UniqueHandle<::VkBuffer>       buffer;
+    };
+
+    Buffer
+    create_buffer(
+        const ::VkDeviceSize inSize,
+        const ::VkBufferUsageFlags inUsage,
+        const ::VkMemoryPropertyFlags inProperties) const;
+
+    uint32_t
+    find_memory_type(
+        const uint32_t inTypeBits,
+        const ::VkMemoryPropertyFlags inProperties) const;
+
+    const DeviceDispatch              &_dispatch;
+    ::VkDevice                         _device;
+    FrameCapture                      *_capture;
+    ::VkPhysicalDeviceMemoryProperties _memory_properties;
+    uint32_t                           _instance_count;
+    uint32_t                           _index_count = 0;
+    Buffer                             _vertices;
+    Buffer                             _indices;
+    Buffer                             _instances;
+};
+
+#endif // VULKAN_RENDERER_INSTANCEDSCENE_H
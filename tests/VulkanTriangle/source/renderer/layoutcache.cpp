@@ -0,0 +1,224 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "layoutcache.h"
+#include "shaderreflection.h"
+#include "impl.h"
+#include "hash.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+// non-dispatchable handles are pointers or 64-bit integers depending on the platform
+template <typename HANDLE>
+uint64_t
+handle_bits(
+    const HANDLE inHandle)
+{
+    uint64_t bits = 0;
+    memcpy(&bits, &inHandle, sizeof(inHandle));
+    return bits;
+}
+
+} // anonymous namespace
+
+LayoutCache::LayoutCache(
+    const DeviceDispatch &inDispatch)
+    :
+    _dispatch(inDispatch),
+    _device(inDispatch.device)
+{}
+
+LayoutCache::~LayoutCache()
+{
+    Log().get() << "Layout cache: " << this->_creations << " layouts created, " << this->_hits << " cache hits" << std::endl;
+}
+
+uint64_t
+LayoutCache::hash(
+    const Key &inKey)
+{
+    auto result = FNV_OFFSET_BASIS;
+    fnv1a(result, inKey.data(), inKey.size() * sizeof(uint64_t));
+    return result;
+}
+
+::VkDescriptorSetLayout
+LayoutCache::descriptor_set_layout(
+    const std::vector<::VkDescriptorSetLayoutBinding> &inBindings)
+{
+    // binding order does not affect the layout
+    auto bindings = inBindings;
+    std::sort(bindings.begin(), bindings.end(), [](const ::VkDescriptorSetLayoutBinding &inLhs, const ::VkDescriptorSetLayoutBinding &inRhs)
+    {
+        return inLhs.binding < inRhs.binding;
+    });
+
+    Key key;
+    for (const auto &binding : bindings)
+    {
+        key.push_back(binding.binding);
+        key.push_back(binding.descriptorType);
+        key.push_back(binding.descriptorCount);
+        key.push_back(binding.stageFlags);
+        key.push_back(nullptr != binding.pImmutableSamplers);
+        if (nullptr != binding.pImmutableSamplers)
+        {
+            for (auto i = 0u; i < binding.descriptorCount; ++i)
+            {
+                key.push_back(handle_bits(binding.pImmutableSamplers[i]));
+            }
+        }
+    }
+    const auto key_hash = hash(key);
+
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    auto &bucket = this->_descriptor_set_layouts[key_hash];
+    for (const auto &entry : bucket)
+    {
+        if (entry.key == key)
+        {
+            ++this->_hits;
+            return entry.layout.get();
+        }
+    }
+
+    auto device = this->_device;
+
+    ::VkDescriptorSetLayoutCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    createInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    createInfo.pBindings = bindings.data();
+
+    auto createFn = GETDFN(device, vkCreateDescriptorSetLayout);
+    ::VkDescriptorSetLayout layout;
+    VK_ERR_CHECK(createFn(
+        device,
+        &createInfo,
+        this->_dispatch.allocator,
+        &layout
+    ));
+
+    DescriptorSetLayoutEntry entry;
+    entry.key = std::move(key);
+    entry.layout = { this->_dispatch, layout };
+    bucket.push_back(std::move(entry));
+    ++this->_creations;
+    return layout;
+}
+
+::VkPipelineLayout
+LayoutCache::pipeline_layout(
+    const std::vector<::VkDescriptorSetLayout> &inSetLayouts,
+    const std::vector<::VkPushConstantRange> &inPushConstantRanges)
+{
+    // set layouts are unique per content, so their handles identify them
+    Key key;
+    key.push_back(inSetLayouts.size());
+    for (const auto &setLayout : inSetLayouts)
+    {
+        key.push_back(handle_bits(setLayout));
+    }
+    for (const auto &range : inPushConstantRanges)
+    {
+        key.push_back(range.stageFlags);
+        key.push_back(range.offset);
+        key.push_back(range.size);
+    }
+    const auto key_hash = hash(key);
+
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    auto &bucket = this->_pipeline_layouts[key_hash];
+    for (const auto &entry : bucket)
+    {
+        if (entry.key == key)
+        {
+            ++this->_hits;
+            return entry.layout.get();
+        }
+    }
+
+    auto device = this->_device;
+
+    ::VkPipelineLayoutCreateInfo pipelineLayoutInfo;
+    memset(&pipelineLayoutInfo, 0, sizeof(pipelineLayoutInfo));
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(inSetLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = inSetLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(inPushConstantRanges.size());
+    pipelineLayoutInfo.pPushConstantRanges = inPushConstantRanges.data();
+
+    auto createFn = GETDFN(device, vkCreatePipelineLayout);
+    ::VkPipelineLayout pipelineLayout;
+    VK_ERR_CHECK(createFn(
+        device,
+        &pipelineLayoutInfo,
+        this->_dispatch.allocator,
+        &pipelineLayout
+    ));
+
+    PipelineLayoutEntry entry;
+    entry.key = std::move(key);
+    entry.layout = { this->_dispatch, pipelineLayout };
+    bucket.push_back(std::move(entry));
+    ++this->_creations;
+    return pipelineLayout;
+}
+
+std::vector<::VkDescriptorSetLayout>
+LayoutCache::descriptor_set_layouts(
+    const ShaderReflection &inReflection)
+{
+    const auto &sets = inReflection.descriptor_sets();
+    std::vector<::VkDescriptorSetLayout> layouts;
+    if (sets.empty())
+    {
+        return layouts;
+    }
+    const auto num_sets = sets.rbegin()->first + 1;
+    for (auto set = 0u; set < num_sets; ++set)
+    {
+        const auto bindings = sets.find(set);
+        layouts.push_back(this->descriptor_set_layout(
+            (bindings != sets.end()) ? bindings->second : std::vector<::VkDescriptorSetLayoutBinding>()));
+    }
+    return layouts;
+}
+
+::VkPipelineLayout
+LayoutCache::pipeline_layout(
+    const ShaderReflection &inReflection)
+{
+    return this->pipeline_layout(this->descriptor_set_layouts(inReflection), inReflection.push_constant_ranges());
+}
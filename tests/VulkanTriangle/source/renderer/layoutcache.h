@@ -0,0 +1,105 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_LAYOUTCACHE_H
+#define VULKAN_RENDERER_LAYOUTCACHE_H
+
+#include "uniquehandle.h"
+#include "vulkan/vulkan.h"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class ShaderReflection;
+
+// descriptor set and pipeline layouts, deduplicated by a hash of their contents
+// identical layouts are the same object, so pipelines built from the same interface share layouts, and
+// descriptor sets bound for one pipeline remain compatible with the next
+// the cache owns every layout it returns, which live until it is destroyed
+// may be called from multiple threads
+class LayoutCache
+{
+public:
+    explicit LayoutCache(
+        const DeviceDispatch &inDispatch);
+    ~LayoutCache();
+
+    LayoutCache(const LayoutCache &) = delete;
+    LayoutCache &operator=(const LayoutCache &) = delete;
+
+    ::VkDescriptorSetLayout
+    descriptor_set_layout(
+        const std::vector<::VkDescriptorSetLayoutBinding> &inBindings);
+
+    ::VkPipelineLayout
+    pipeline_layout(
+        const std::vector<::VkDescriptorSetLayout> &inSetLayouts,
+        const std::vector<::VkPushConstantRange> &inPushConstantRanges);
+
+    // one descriptor set layout per set number up to the highest used, with empty layouts for any gaps
+    std::vector<::VkDescriptorSetLayout>
+    descriptor_set_layouts(
+        const ShaderReflection &inReflection);
+
+    ::VkPipelineLayout
+    pipeline_layout(
+        const ShaderReflection &inReflection);
+
+private:
+    typedef std::vector<uint64_t> Key;
+
+    struct DescriptorSetLayoutEntry
+    {
+        Key                                   key;
+        UniqueHandle<::VkDescriptorSetLayout> layout;
+    };
+
+    struct PipelineLayoutEntry
+    {
+        Key                                   key;
+        UniqueHandle<::VkPipelineLayout>      layout;
+    };
+
+    static uint64_t
+    hash(
+        const Key &inKey);
+
+    const DeviceDispatch                                                  &_dispatch;
+    ::VkDevice                                                             _device;
+    std::mutex                                                             _mutex;
+    // declared such that pipeline layouts are destroyed before the set layouts they use
+    std::unordered_map<uint64_t, std::vector<DescriptorSetLayoutEntry>>   _descriptor_set_layouts;
+    std::unordered_map<uint64_t, std::vector<PipelineLayoutEntry>>        _pipeline_layouts;
+    uint32_t                                                               _hits = 0;
+    uint32_t                                                               _creations = 0;
+};
+
+#endif // VULKAN_RENDERER_LAYOUTCACHE_H
@@ -0,0 +1,433 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "pipelinecompiler.h"
+#include "threadpool.h"
+#include "impl.h"
+#include "exception.h"
+#include "log.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+PipelineCompiler::PipelineCompiler(
+    const DeviceDispatch &inDispatch,
+    const uint32_t inNumThreads,
+    const std::string &inCachePath)
+    :
+    _dispatch(inDispatch),
+    _device(inDispatch.device),
+    _cache_path(inCachePath)
+{
+    std::vector<char> initialData;
+    if (!this->_cache_path.empty())
+    {
+        // the driver checks the header, and ignores data from a different device or driver version
+        std::ifstream file(this->_cache_path, std::ios::binary);
+        if (file)
+        {
+            initialData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            Log().get() << "Loaded " << initialData.size() << " bytes of pipeline cache from " << this->_cache_path << std::endl;
+        }
+    }
+    this->_merged_cache = this->create_cache(initialData);
+    if (inNumThreads > 0)
+    {
+        this->_thread_pool.reset(new ThreadPool(inNumThreads));
+    }
+}
+
+PipelineCompiler::~PipelineCompiler()
+{
+    this->wait_idle();
+    this->_thread_pool.reset();
+
+    if (!this->_cache_path.empty())
+    {
+        const auto data = this->cache_data(this->_merged_cache.get());
+        std::ofstream file(this->_cache_path, std::ios::binary);
+        file.write(data.data(), data.size());
+        if (file)
+        {
+            Log().get() << "Saved " << data.size() << " bytes of pipeline cache to " << this->_cache_path << std::endl;
+        }
+        else
+        {
+            Log().get() << "Unable to save the pipeline cache to " << this->_cache_path << std::endl;
+        }
+    }
+}
+
+PipelineCompiler::Handle
+PipelineCompiler::compile(
+    const PipelineDesc &inDesc)
+{
+    const auto handle = static_cast<Handle>(this->_entries.size());
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_entries.emplace_back();
+        this->_entries.back().desc = inDesc;
+        ++this->_pending;
+    }
+    auto &entry = this->_entries.back();
+    if (this->_thread_pool)
+    {
+        this->_thread_pool->submit([this, &entry]()
+        {
+            this->run(entry);
+        });
+    }
+    else
+    {
+        this->run(entry);
+    }
+    return handle;
+}
+
+::VkPipeline
+PipelineCompiler::pipeline(
+    const Handle inHandle)
+{
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    auto &entry = this->_entries[inHandle];
+    if (!entry.done)
+    {
+        return VK_NULL_HANDLE;
+    }
+    this->report(inHandle, entry);
+    return entry.pipeline.get();
+}
+
+::VkPipeline
+PipelineCompiler::wait(
+    const Handle inHandle)
+{
+    std::unique_lock<std::mutex> lock(this->_mutex);
+    auto &entry = this->_entries[inHandle];
+    this->_compiled.wait(lock, [&entry]() { return entry.done; });
+    this->report(inHandle, entry);
+    return entry.pipeline.get();
+}
+
+const PipelineDesc &
+PipelineCompiler::desc(
+    const Handle inHandle) const
+{
+    // entries are only added by the calling thread, and their descriptions are not modified once added
+    return this->_entries[inHandle].desc;
+}
+
+void
+PipelineCompiler::wait_idle()
+{
+    {
+        std::unique_lock<std::mutex> lock(this->_mutex);
+        this->_compiled.wait(lock, [this]() { return 0 == this->_pending; });
+    }
+    this->merge_caches();
+}
+
+void
+PipelineCompiler::run(
+    Entry &ioEntry)
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    // a cache is only ever used by one compile at a time, so needs no external synchronisation
+    UniquePipelineCache cache;
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        if (!this->_thread_caches.empty())
+        {
+            cache = std::move(this->_thread_caches.back());
+            this->_thread_caches.pop_back();
+        }
+    }
+    if (!cache)
+    {
+        // the merged cache is only modified when no compile is pending, i.e. not now
+        cache = this->create_cache(this->cache_data(this->_merged_cache.get()));
+    }
+
+    const auto start = Clock::now();
+    ::VkPipeline pipeline = VK_NULL_HANDLE;
+    std::exception_ptr error;
+    try
+    {
+        pipeline = this->create_pipeline(ioEntry.desc, cache.get());
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        if (VK_NULL_HANDLE != pipeline)
+        {
+            ioEntry.pipeline = { this->_dispatch, pipeline };
+        }
+        ioEntry.error = error;
+        ioEntry.milliseconds = elapsed.count();
+        ioEntry.done = true;
+        this->_thread_caches.push_back(std::move(cache));
+        this->_unmerged = true;
+        --this->_pending;
+    }
+    this->_compiled.notify_all();
+}
+
+PipelineCompiler::UniquePipelineCache
+PipelineCompiler::create_cache(
+    const std::vector<char> &inInitialData) const
+{
+    auto device = this->_device;
+    ::VkPipelineCacheCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = inInitialData.size();
+    createInfo.pInitialData = inInitialData.empty() ? nullptr : inInitialData.data();
+
+    auto createFn = GETDFN(device, vkCreatePipelineCache);
+    ::VkPipelineCache cache;
+    VK_ERR_CHECK_QUIET(createFn(
+        device,
+        &createInfo,
+        this->_dispatch.allocator,
+        &cache
+    ));
+    return UniquePipelineCache(this->_dispatch, cache);
+}
+
+std::vector<char>
+PipelineCompiler::cache_data(
+    ::VkPipelineCache inCache) const
+{
+    auto getDataFn = GETDFN(this->_device, vkGetPipelineCacheData);
+    size_t size = 0;
+    VK_ERR_CHECK_QUIET(getDataFn(
+        this->_device,
+        inCache,
+        &size,
+        nullptr
+    ));
+    std::vector<char> data(size);
+    VK_ERR_CHECK_QUIET(getDataFn(
+        this->_device,
+        inCache,
+        &size,
+        data.data()
+    ));
+    data.resize(size);
+    return data;
+}
+
+::VkPipeline
+PipelineCompiler::create_pipeline(
+    const PipelineDesc &inDesc,
+    ::VkPipelineCache inCache) const
+{
+    const auto &vertex_bindings = inDesc.vertex_bindings;
+    const auto &vertex_attributes = inDesc.vertex_attributes;
+    ::VkPipelineVertexInputStateCreateInfo vertex_input_info;
+    memset(&vertex_input_info, 0, sizeof(vertex_input_info));
+    vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertex_input_info.vertexBindingDescriptionCount = static_cast<uint32_t>(vertex_bindings.size());
+    vertex_input_info.pVertexBindingDescriptions = vertex_bindings.empty() ? nullptr : vertex_bindings.data();
+    vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertex_attributes.size());
+    vertex_input_info.pVertexAttributeDescriptions = vertex_attributes.empty() ? nullptr : vertex_attributes.data();
+
+    ::VkPipelineInputAssemblyStateCreateInfo input_assembly;
+    memset(&input_assembly, 0, sizeof(input_assembly));
+    input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    input_assembly.topology = inDesc.topology;
+    input_assembly.primitiveRestartEnable = VK_FALSE;
+
+    // viewport and scissor are dynamic, but the counts are still required
+    ::VkPipelineViewportStateCreateInfo viewport_state;
+    memset(&viewport_state, 0, sizeof(viewport_state));
+    viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewport_state.viewportCount = 1;
+    viewport_state.pViewports = nullptr;
+    viewport_state.scissorCount = 1;
+    viewport_state.pScissors = nullptr;
+
+    ::VkPipelineRasterizationStateCreateInfo rasterizer;
+    memset(&rasterizer, 0, sizeof(rasterizer));
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.depthClampEnable = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.lineWidth = 1;
+    rasterizer.cullMode = inDesc.cull_mode;
+    rasterizer.frontFace = inDesc.front_face;
+    rasterizer.depthBiasEnable = VK_FALSE;
+    rasterizer.depthBiasConstantFactor = 0;
+    rasterizer.depthBiasClamp = 0;
+    rasterizer.depthBiasSlopeFactor = 0;
+
+    ::VkPipelineMultisampleStateCreateInfo multisampling;
+    memset(&multisampling, 0, sizeof(multisampling));
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampling.minSampleShading = 1;
+    multisampling.pSampleMask = nullptr;
+    multisampling.alphaToCoverageEnable = VK_FALSE;
+    multisampling.alphaToOneEnable = VK_FALSE;
+
+    ::VkPipelineColorBlendAttachmentState color_blend_attachment;
+    memset(&color_blend_attachment, 0, sizeof(color_blend_attachment));
+    color_blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    color_blend_attachment.blendEnable = VK_FALSE;
+    color_blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    color_blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+    color_blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
+    color_blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    color_blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    color_blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+    ::VkPipelineColorBlendStateCreateInfo color_blending;
+    memset(&color_blending, 0, sizeof(color_blending));
+    color_blending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    color_blending.logicOpEnable = VK_FALSE;
+    color_blending.logicOp = VK_LOGIC_OP_COPY; // Optional
+    color_blending.attachmentCount = 1;
+    color_blending.pAttachments = &color_blend_attachment;
+
+    // dynamic so that the pipeline survives swapchain recreation at a different size
+    ::VkDynamicState dynamicStates[] = {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR
+    };
+
+    ::VkPipelineDynamicStateCreateInfo dynamicState;
+    memset(&dynamicState, 0, sizeof(dynamicState));
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates = dynamicStates;
+
+    // entries for ids that a stage does not declare are ignored by that stage
+    ::VkSpecializationInfo specialization;
+    memset(&specialization, 0, sizeof(specialization));
+    specialization.mapEntryCount = static_cast<uint32_t>(inDesc.specialization_entries.size());
+    specialization.pMapEntries = inDesc.specialization_entries.data();
+    specialization.dataSize = inDesc.specialization_data.size() * sizeof(uint32_t);
+    specialization.pData = inDesc.specialization_data.data();
+    const auto specialized = !inDesc.specialization_entries.empty();
+
+    ::VkPipelineShaderStageCreateInfo shader_stages[2];
+    memset(shader_stages, 0, sizeof(shader_stages));
+    shader_stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shader_stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    shader_stages[0].module = inDesc.vertex_shader;
+    shader_stages[0].pName = "main";
+    shader_stages[0].pSpecializationInfo = specialized ? &specialization : nullptr;
+    shader_stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shader_stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    shader_stages[1].module = inDesc.fragment_shader;
+    shader_stages[1].pName = "main";
+    shader_stages[1].pSpecializationInfo = specialized ? &specialization : nullptr;
+
+    ::VkGraphicsPipelineCreateInfo pipelineInfo;
+    memset(&pipelineInfo, 0, sizeof(pipelineInfo));
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages = shader_stages;
+    pipelineInfo.pVertexInputState = &vertex_input_info;
+    pipelineInfo.pInputAssemblyState = &input_assembly;
+    pipelineInfo.pViewportState = &viewport_state;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pDepthStencilState = nullptr;
+    pipelineInfo.pColorBlendState = &color_blending;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = inDesc.layout;
+    pipelineInfo.renderPass = inDesc.render_pass;
+    pipelineInfo.subpass = inDesc.subpass;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineInfo.basePipelineIndex = -1;
+
+    auto createFn = GETDFN(this->_device, vkCreateGraphicsPipelines);
+    ::VkPipeline pipeline = VK_NULL_HANDLE;
+    const auto result = createFn(
+        this->_device,
+        inCache,
+        1,
+        &pipelineInfo,
+        this->_dispatch.allocator,
+        &pipeline
+    );
+    if (VK_SUCCESS != result)
+    {
+        throw Exception("Unable to create graphics pipeline (" + std::to_string(result) + ")");
+    }
+    return pipeline;
+}
+
+void
+PipelineCompiler::report(
+    const Handle inHandle,
+    Entry &ioEntry)
+{
+    if (ioEntry.error)
+    {
+        std::rethrow_exception(ioEntry.error);
+    }
+    if (!ioEntry.reported)
+    {
+        Log().get() << "Compiled pipeline " << inHandle << " in " << ioEntry.milliseconds << " ms" << std::endl;
+        ioEntry.reported = true;
+    }
+}
+
+void
+PipelineCompiler::merge_caches()
+{
+    if (!this->_unmerged || this->_thread_caches.empty())
+    {
+        return;
+    }
+    std::vector<::VkPipelineCache> sources;
+    for (const auto &cache : this->_thread_caches)
+    {
+        sources.push_back(cache.get());
+    }
+    auto mergeFn = GETDFN(this->_device, vkMergePipelineCaches);
+    VK_ERR_CHECK(mergeFn(
+        this->_device,
+        this->_merged_cache.get(),
+        static_cast<uint32_t>(sources.size()),
+        sources.data()
+    ));
+    this->_unmerged = false;
+}
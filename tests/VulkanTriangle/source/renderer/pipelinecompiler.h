@@ -0,0 +1,167 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_PIPELINECOMPILER_H
+#define VULKAN_RENDERER_PIPELINECOMPILER_H
+
+#include "uniquehandle.h"
+#include "vulkan/vulkan.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// everything that varies between the graphics pipelines of this renderer
+// the shader modules, layout and render pass must outlive the compilation
+struct PipelineDesc
+{
+    ::VkShaderModule                                 vertex_shader = VK_NULL_HANDLE;
+    ::VkShaderModule                                 fragment_shader = VK_NULL_HANDLE;
+    std::vector<::VkVertexInputBindingDescription>   vertex_bindings;
+    std::vector<::VkVertexInputAttributeDescription> vertex_attributes;
+    ::VkPrimitiveTopology                            topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    ::VkCullModeFlags                                cull_mode = VK_CULL_MODE_BACK_BIT;
+    ::VkFrontFace                                    front_face = VK_FRONT_FACE_CLOCKWISE;
+    ::VkPipelineLayout                               layout = VK_NULL_HANDLE;
+    ::VkRenderPass                                   render_pass = VK_NULL_HANDLE;
+    uint32_t                                         subpass = 0;
+    // values of specialisation constants, given to both stages; empty for the shaders' defaults
+    std::vector<::VkSpecializationMapEntry>          specialization_entries;
+    std::vector<uint32_t>                            specialization_data;
+};
+
+// builds graphics pipelines on background threads, so that compilation stays off the frame thread
+// compile() returns immediately with a handle; pipeline() is VK_NULL_HANDLE until the pipeline is ready,
+// so that draws using it can be skipped in the meantime
+// each compile borrows a VkPipelineCache that no other thread is using, and these are merged into a single
+// cache, optionally persisted to disk, once compilation is idle
+// all functions are to be called from a single thread
+class PipelineCompiler
+{
+public:
+    typedef uint32_t Handle;
+
+    // inNumThreads of 0 compiles on the calling thread, within compile()
+    // inCachePath is a file from which the pipeline cache is loaded, and to which it is saved; empty to not persist it
+    PipelineCompiler(
+        const DeviceDispatch &inDispatch,
+        const uint32_t inNumThreads,
+        const std::string &inCachePath);
+
+    // waits for outstanding compiles
+    ~PipelineCompiler();
+
+    PipelineCompiler(const PipelineCompiler &) = delete;
+    PipelineCompiler &operator=(const PipelineCompiler &) = delete;
+
+    Handle
+    compile(
+        const PipelineDesc &inDesc);
+
+    // VK_NULL_HANDLE while still compiling
+    // rethrows the exception of a failed compile
+    ::VkPipeline
+    pipeline(
+        const Handle inHandle);
+
+    // blocks until the pipeline is compiled
+    ::VkPipeline
+    wait(
+        const Handle inHandle);
+
+    // the description that the pipeline was compiled from
+    const PipelineDesc &
+    desc(
+        const Handle inHandle) const;
+
+    // blocks until every pipeline is compiled, then merges the per-thread caches
+    void
+    wait_idle();
+
+private:
+    typedef UniqueHandle<::VkPipelineCache> UniquePipelineCache;
+
+    struct Entry
+    {
+        PipelineDesc                                                  desc;
+        UniqueHandle<::VkPipeline>                                    pipeline;
+        std::exception_ptr                                            error;
+        double                                                        milliseconds = 0;
+        bool                                                          done = false;
+        bool                                                          reported = false;
+    };
+
+    void
+    run(
+        Entry &ioEntry);
+
+    UniquePipelineCache
+    create_cache(
+        const std::vector<char> &inInitialData) const;
+
+    std::vector<char>
+    cache_data(
+        ::VkPipelineCache inCache) const;
+
+    ::VkPipeline
+    create_pipeline(
+        const PipelineDesc &inDesc,
+        ::VkPipelineCache inCache) const;
+
+    // logs the compile of a finished entry, once; workers do not log
+    void
+    report(
+        const Handle inHandle,
+        Entry &ioEntry);
+
+    void
+    merge_caches();
+
+    const DeviceDispatch            &_dispatch;
+    ::VkDevice                       _device;
+    std::string                      _cache_path;
+    UniquePipelineCache              _merged_cache;
+    std::vector<UniquePipelineCache> _thread_caches; // not currently borrowed by a compile
+    bool                             _unmerged = false;
+    std::deque<Entry>                _entries; // a deque, so that entries do not move while workers use them
+    uint32_t                         _pending = 0;
+    std::mutex                       _mutex;
+    std::condition_variable          _compiled;
+    // declared last, so that workers have finished before anything they use is destroyed
+    std::unique_ptr<ThreadPool>      _thread_pool;
+};
+
+#endif // VULKAN_RENDERER_PIPELINECOMPILER_H
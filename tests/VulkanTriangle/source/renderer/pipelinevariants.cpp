@@ -0,0 +1,228 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "pipelinevariants.h"
+#include "exception.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+
+uint32_t
+parse_value(
+    const ShaderReflection::SpecializationConstant &inConstant,
+    const std::string &inValue)
+{
+    typedef ShaderReflection::SpecializationConstant::Type Type;
+    try
+    {
+        size_t used = 0;
+        uint32_t bits = 0;
+        switch (inConstant.type)
+        {
+        case Type::Boolean:
+            if ("true" == inValue || "1" == inValue)
+            {
+                return 1;
+            }
+            if ("false" == inValue || "0" == inValue)
+            {
+                return 0;
+            }
+            break;
+        case Type::Int:
+            bits = static_cast<uint32_t>(std::stoi(inValue, &used));
+            break;
+        case Type::UInt:
+            bits = static_cast<uint32_t>(std::stoul(inValue, &used));
+            break;
+        case Type::Float:
+        {
+            const auto value = std::stof(inValue, &used);
+            memcpy(&bits, &value, sizeof(bits));
+            break;
+        }
+        }
+        if (!inValue.empty() && used == inValue.size())
+        {
+            return bits;
+        }
+    }
+    catch (const std::exception &)
+    {
+    }
+    throw Exception("Invalid value '" + inValue + "' for specialisation constant '" + inConstant.name + "'");
+}
+
+} // anonymous namespace
+
+PipelineVariants::PipelineVariants(
+    PipelineCompiler &inCompiler,
+    const PipelineDesc &inBase,
+    const std::vector<ShaderReflection::SpecializationConstant> &inConstants)
+    :
+    _compiler(inCompiler),
+    _base(inBase),
+    _constants(inConstants)
+{
+    // every variant specialises every constant, at the same offset, so the map entries are shared
+    this->_base.specialization_entries.clear();
+    this->_base.specialization_data.clear();
+    for (auto i = 0u; i < this->_constants.size(); ++i)
+    {
+        ::VkSpecializationMapEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.constantID = this->_constants[i].constant_id;
+        entry.offset = static_cast<uint32_t>(i * sizeof(uint32_t));
+        entry.size = sizeof(uint32_t);
+        this->_base.specialization_entries.push_back(entry);
+    }
+}
+
+PipelineVariants::Key
+PipelineVariants::parse(
+    const std::string &inAssignments) const
+{
+    Key key;
+    for (const auto &constant : this->_constants)
+    {
+        key.push_back(constant.default_value);
+    }
+
+    auto assignments = inAssignments;
+    std::replace(assignments.begin(), assignments.end(), ',', ' ');
+    std::istringstream stream(assignments);
+    std::string assignment;
+    while (stream >> assignment)
+    {
+        const auto equals = assignment.find('=');
+        if (std::string::npos == equals)
+        {
+            throw Exception("Expected name=value, not '" + assignment + "'");
+        }
+        const auto name = assignment.substr(0, equals);
+        auto constant = std::find_if(this->_constants.begin(), this->_constants.end(), [&name](const ShaderReflection::SpecializationConstant &inConstant)
+        {
+            return inConstant.name == name;
+        });
+        if (constant == this->_constants.end())
+        {
+            throw Exception("The shaders have no specialisation constant '" + name + "'");
+        }
+        key[constant - this->_constants.begin()] = parse_value(*constant, assignment.substr(equals + 1));
+    }
+    return key;
+}
+
+PipelineCompiler::Handle
+PipelineVariants::variant(
+    const Key &inKey)
+{
+    auto existing = this->_variants.find(inKey);
+    if (existing != this->_variants.end())
+    {
+        return existing->second;
+    }
+
+    auto desc = this->_base;
+    desc.specialization_data = inKey;
+    const auto handle = this->_compiler.compile(desc);
+    this->_variants.insert(std::make_pair(inKey, handle));
+    Log().get() << "Pipeline variant {" << this->describe(inKey) << "} is pipeline " << handle << std::endl;
+    return handle;
+}
+
+size_t
+PipelineVariants::prewarm(
+    const std::string &inManifestPath)
+{
+    std::ifstream file(inManifestPath);
+    if (!file)
+    {
+        throw Exception("Unable to open pipeline variant manifest '" + inManifestPath + "'");
+    }
+    size_t count = 0;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        const auto first = line.find_first_not_of(" \t\r");
+        if (std::string::npos == first || '#' == line[first])
+        {
+            continue;
+        }
+        this->variant(this->parse(line));
+        ++count;
+    }
+    Log().get() << "Prewarmed " << count << " pipeline variants from " << inManifestPath << std::endl;
+    return count;
+}
+
+size_t
+PipelineVariants::size() const
+{
+    return this->_variants.size();
+}
+
+std::string
+PipelineVariants::describe(
+    const Key &inKey) const
+{
+    typedef ShaderReflection::SpecializationConstant::Type Type;
+    std::ostringstream stream;
+    for (auto i = 0u; i < this->_constants.size(); ++i)
+    {
+        const auto &constant = this->_constants[i];
+        stream << (i > 0 ? " " : "") << constant.name << "=";
+        switch (constant.type)
+        {
+        case Type::Boolean:
+            stream << (inKey[i] ? "true" : "false");
+            break;
+        case Type::Int:
+            stream << static_cast<int32_t>(inKey[i]);
+            break;
+        case Type::UInt:
+            stream << inKey[i];
+            break;
+        case Type::Float:
+        {
+            float value;
+            memcpy(&value, &inKey[i], sizeof(value));
+            stream << value;
+            break;
+        }
+        }
+    }
+    return stream.str();
+}
@@ -0,0 +1,93 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_PIPELINEVARIANTS_H
+#define VULKAN_RENDERER_PIPELINEVARIANTS_H
+
+#include "pipelinecompiler.h"
+#include "shaderreflection.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+// graphics pipelines that differ only in the values of their shaders' specialisation constants, so that one
+// SPIR-V module per stage serves every variation, such as colour modes and feature toggles
+// each distinct set of values is compiled once, either when first requested or when prewarmed from a manifest,
+// and cached by those values
+// all functions are to be called from a single thread
+class PipelineVariants
+{
+public:
+    // the value of every constant, in constant id order, as the bit patterns given to VkSpecializationInfo
+    typedef std::vector<uint32_t> Key;
+
+    // inBase describes every variant other than the values of inConstants; the compiler must outlive this
+    PipelineVariants(
+        PipelineCompiler &inCompiler,
+        const PipelineDesc &inBase,
+        const std::vector<ShaderReflection::SpecializationConstant> &inConstants);
+
+    PipelineVariants(const PipelineVariants &) = delete;
+    PipelineVariants &operator=(const PipelineVariants &) = delete;
+
+    // from whitespace or comma separated name=value assignments; constants not assigned keep their defaults
+    // throws Exception for an unknown name, or a value that does not parse as the constant's type
+    Key
+    parse(
+        const std::string &inAssignments) const;
+
+    // starts compiling the variant, unless it has been already
+    PipelineCompiler::Handle
+    variant(
+        const Key &inKey);
+
+    // starts compiling every variant in the manifest, a file of one set of assignments per line, where blank
+    // lines and those starting with # are ignored
+    // returns the number of variants listed; throws Exception if the manifest cannot be read or parsed
+    size_t
+    prewarm(
+        const std::string &inManifestPath);
+
+    // number of distinct variants compiled
+    size_t
+    size() const;
+
+private:
+    std::string
+    describe(
+        const Key &inKey) const;
+
+    PipelineCompiler                                         &_compiler;
+    PipelineDesc                                              _base;
+    std::vector<ShaderReflection::SpecializationConstant>     _constants;
+    std::map<Key, PipelineCompiler::Handle>                   _variants;
+};
+
+#endif // VULKAN_RENDERER_PIPELINEVARIANTS_H
@@ -29,14 +29,27 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "impl.h"
 #include "exception.h"
+#include "benchmark.h"
+#include "framestats.h"
+#include "deletionqueue.h"
+#include "capabilityreport.h"
+#include "startupprofile.h"
+#include "uniformring.h"
+#include "framecapture.h"
 #include "log.h"
 
 #include "../appwindow.h"
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <vector>
+
 Renderer::Renderer(
-    AppWindow *inWindow)
+    AppWindow *inWindow,
+    const RendererSettings &inSettings)
     :
-    _impl(new Impl(inWindow))
+    _impl(new Impl(inWindow, inSettings))
 {}
 
 Renderer::~Renderer() = default;
@@ -45,28 +58,156 @@ void
 Renderer::init()
 {
     auto impl = this->_impl.get();
+    StartupProfile profile;
+    profile.begin("create_instance");
     impl->create_instance();
+    profile.begin("init_debug_callback");
     impl->init_debug_callback();
-    impl->create_window_surface();
+    auto &first_window = *impl->_swapchains[0];
+    profile.begin("create_window_surface");
+    impl->create_window_surface(first_window);
+    profile.begin("enumerate_physical_devices");
     impl->enumerate_physical_devices();
+    profile.begin("create_logical_device");
     impl->create_logical_device();
-    impl->create_swapchain();
-    impl->create_imageviews();
+    if (!impl->_settings.capture_path.empty())
+    {
+        profile.begin("create_frame_capture");
+        impl->create_frame_capture();
+    }
+    profile.begin("create_swapchain");
+    impl->create_swapchain(first_window);
+    profile.begin("create_imageviews");
+    impl->create_imageviews(first_window);
+    profile.begin("create_renderpass");
     impl->create_renderpass();
+    if (!impl->_settings.shader_dir.empty())
+    {
+        profile.begin("create_shader_compiler");
+        impl->create_shader_compiler();
+    }
+    if (!impl->_settings.texture_path.empty())
+    {
+        profile.begin("create_texture_cache");
+        impl->create_texture_cache();
+    }
+    profile.begin("create_graphics_pipeline");
     impl->create_graphics_pipeline();
-    impl->create_framebuffers();
+    profile.begin("create_framebuffers");
+    impl->create_framebuffers(first_window);
+    profile.begin("create_commandpool");
     impl->create_commandpool();
+    profile.begin("create_commandbuffers");
     impl->create_commandbuffers();
+    profile.begin("create_frame_commandpools");
+    impl->create_frame_commandpools();
+    profile.begin("create_semaphores");
     impl->create_semaphores();
+    if (impl->_settings.instances > 0)
+    {
+        profile.begin("create_instanced_scene");
+        impl->create_instanced_scene();
+    }
+    if (impl->_settings.image_processing_size > 0)
+    {
+        profile.begin("create_image_processor");
+        impl->create_image_processor();
+    }
+    if ((impl->_settings.recording_threads > 0) || impl->_settings.benchmark_recording)
+    {
+        profile.begin("create_recording_workers");
+        impl->create_recording_workers();
+    }
+    if ((impl->_settings.scene_chunks > 0) && !impl->_settings.benchmark_recording && !impl->_settings.benchmark_dynamic)
+    {
+        profile.begin("create_scene_chunks");
+        impl->create_scene_chunks();
+    }
+    if (impl->_settings.benchmark_recording || impl->_settings.benchmark_dynamic)
+    {
+        profile.begin("create_benchmark");
+        impl->create_benchmark();
+    }
+    if (!impl->_settings.gpu_profile_path.empty())
+    {
+        profile.begin("create_gpu_profiler");
+        impl->create_gpu_profiler();
+    }
+    if ((impl->_settings.benchmark_frames > 0) && !impl->_benchmark)
+    {
+        profile.begin("create_frame_benchmark");
+        impl->create_frame_benchmark();
+    }
+    if (impl->_settings.render_graph)
+    {
+        profile.begin("create_render_graph");
+        impl->create_render_graph();
+    }
+    if (impl->_settings.frame_stats_interval > 0)
+    {
+        const auto window = std::max(1024u, impl->_settings.frame_stats_interval);
+        impl->_frame_stats.reset(new FrameStats(window, impl->_settings.frame_stats_interval));
+    }
+    profile.end();
+    profile.report();
+
+    // after the report, as it is not part of the renderer's own startup
+    if (!impl->_settings.capability_report_path.empty())
+    {
+        impl->_capability_report->write(impl->_settings.capability_report_path);
+    }
+}
+
+const std::string &
+Renderer::capability_report() const
+{
+    return this->_impl->_capability_report->json();
+}
+
+void
+Renderer::add_window(
+    WindowLibrary::GraphicsWindow *inWindow)
+{
+    this->_impl->add_window(inWindow);
+}
+
+void
+Renderer::remove_window(
+    WindowLibrary::GraphicsWindow *inWindow)
+{
+    this->_impl->remove_window(inWindow);
 }
 
 void
 Renderer::draw_frame() const
 {
     auto impl = this->_impl.get();
+    if (impl->_benchmark && !impl->_benchmark->begin_frame())
+    {
+        return;
+    }
+
+    // windows that are minimised are skipped until they can be drawn to again
+    std::vector<Impl::SwapchainContext*> windows;
+    for (auto &context : impl->_swapchains)
+    {
+        if (!context->dirty || impl->recreate_swapchain(*context))
+        {
+            windows.push_back(context.get());
+        }
+    }
+    if (windows.empty())
+    {
+        return;
+    }
+
+    typedef std::chrono::high_resolution_clock Clock;
+    typedef std::chrono::duration<double, std::milli> Milliseconds;
+
     auto waitForFencesFn = GETIFN(impl->_instance.get(), vkWaitForFences);
     auto resetFencesFn = GETIFN(impl->_instance.get(), vkResetFences);
     auto fence = impl->_inflight_fence[impl->_current_frame].get();
+    const auto fence_wait_start = Clock::now();
     VK_ERR_CHECK_QUIET(waitForFencesFn(
         impl->_logical_device.get(),
         1,
@@ -74,64 +215,171 @@ Renderer::draw_frame() const
         VK_TRUE,
         std::numeric_limits<uint64_t>::max()
     ));
+    // the frame last submitted with this fence is complete, so whatever was retired up to it can be destroyed
+    impl->_deletion_queue->collect(impl->_frame_serials[impl->_current_frame]);
+    const auto acquire_start = Clock::now();
+
+    // an image from every window, each signalling its own semaphore, all waited on by the one submit
+    auto acquireNextImageFn = GETIFN(impl->_instance.get(), vkAcquireNextImageKHR);
+    std::vector<Impl::SwapchainContext*> targets;
+    std::vector<::VkSemaphore> waitSemaphores;
+    for (auto context : windows)
+    {
+        auto acquired = context->image_available[impl->_current_frame].get();
+        const auto acquireResult = acquireNextImageFn(
+            impl->_logical_device.get(),
+            context->swapchain.get(),
+            std::numeric_limits<uint64_t>::max(),
+            acquired,
+            VK_NULL_HANDLE,
+            &context->image_index
+        );
+        if (VK_ERROR_OUT_OF_DATE_KHR == acquireResult)
+        {
+            // nothing was acquired, so the window is not drawn this frame
+            context->dirty = true;
+            continue;
+        }
+        if (VK_SUBOPTIMAL_KHR == acquireResult)
+        {
+            // the image is still presentable, so finish this frame before recreating
+            context->dirty = true;
+        }
+        else if (VK_SUCCESS != acquireResult)
+        {
+            throw Exception("Failed to acquire swapchain image");
+        }
+        targets.push_back(context);
+        waitSemaphores.push_back(acquired);
+    }
+    if (targets.empty())
+    {
+        // the fence is left signalled for the next attempt
+        return;
+    }
+
+    // only reset once work is certain to be submitted with it
     VK_ERR_CHECK_QUIET(resetFencesFn(
         impl->_logical_device.get(),
         1,
         &fence
     ));
 
-    auto acquireNextImageFn = GETIFN(impl->_instance.get(), vkAcquireNextImageKHR);
-    uint32_t imageIndex;
-    VK_ERR_CHECK_QUIET(acquireNextImageFn(
-        impl->_logical_device.get(),
-        impl->_swapchain.get(),
-        std::numeric_limits<uint64_t>::max(),
-        impl->_image_available[impl->_current_frame].get(),
-        VK_NULL_HANDLE,
-        &imageIndex
-    ));
+    // CPU cost of the frame, from recording (if any) through to submission
+    const auto record_start = Clock::now();
+    ::VkCommandBuffer commandBuffer;
+    if (impl->records_each_frame())
+    {
+        // the fence has signalled, so the GPU has finished reading this frame's region of the uniform ring
+        auto uniform_ring = impl->_uniform_ring.get();
+        if (nullptr != uniform_ring)
+        {
+            const std::chrono::duration<float> time = Clock::now() - impl->_start_time;
+            impl->write_frame_uniforms(impl->_current_frame, time.count());
+        }
+        commandBuffer = impl->record_frame(impl->_current_frame, targets);
+        if (nullptr != uniform_ring)
+        {
+            uniform_ring->flush();
+        }
+    }
+    else
+    {
+        // only ever the one window, as more windows imply recording each frame
+        commandBuffer = impl->_commandBuffers[targets[0]->image_index];
+    }
 
-    ::VkSemaphore waitSemaphores[] = { impl->_image_available[impl->_current_frame].get() };
     ::VkSemaphore signalSemaphores[] = { impl->_render_finished[impl->_current_frame].get() };
-    ::VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+    const std::vector<::VkPipelineStageFlags> waitStages(waitSemaphores.size(), impl->_acquire_wait_stage);
 
     ::VkSubmitInfo submitInfo;
     memset(&submitInfo, 0, sizeof(submitInfo));
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
+    submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+    submitInfo.pWaitSemaphores = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
     submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &impl->_commandBuffers[imageIndex];
+    submitInfo.pCommandBuffers = &commandBuffer;
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
+    if (impl->_frame_capture)
+    {
+        impl->_frame_capture->submit(commandBuffer);
+    }
+
     auto queueSubmitFn = GETIFN(impl->_instance.get(), vkQueueSubmit);
+    const auto submit_start = Clock::now();
     VK_ERR_CHECK_QUIET(queueSubmitFn(
         impl->_graphics_queue,
         1,
         &submitInfo,
         impl->_inflight_fence[impl->_current_frame].get()
     ));
+    impl->_frame_serials[impl->_current_frame] = impl->_deletion_queue->advance();
+    if (impl->_benchmark)
+    {
+        const Milliseconds cpu_time = Clock::now() - record_start;
+        impl->_benchmark->end_frame(cpu_time.count());
+    }
 
-    ::VkSwapchainKHR swapchains[] = { impl->_swapchain.get() };
+    // every window presented by one call, all waiting on the one semaphore
+    std::vector<::VkSwapchainKHR> swapchains;
+    std::vector<uint32_t> imageIndices;
+    for (auto context : targets)
+    {
+        swapchains.push_back(context->swapchain.get());
+        imageIndices.push_back(context->image_index);
+    }
+    std::vector<::VkResult> presentResults(targets.size(), VK_SUCCESS);
     ::VkPresentInfoKHR presentInfo;
     memset(&presentInfo, 0, sizeof(presentInfo));
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
     presentInfo.waitSemaphoreCount = 1;
     presentInfo.pWaitSemaphores = signalSemaphores;
-    presentInfo.swapchainCount = 1;
-    presentInfo.pSwapchains = swapchains;
-    presentInfo.pImageIndices = &imageIndex;
-    presentInfo.pResults = nullptr;
+    presentInfo.swapchainCount = static_cast<uint32_t>(swapchains.size());
+    presentInfo.pSwapchains = swapchains.data();
+    presentInfo.pImageIndices = imageIndices.data();
+    presentInfo.pResults = presentResults.data();
 
     auto queuePresentFn = GETIFN(impl->_instance.get(), vkQueuePresentKHR);
-    VK_ERR_CHECK_QUIET(queuePresentFn(
+    const auto presentResult = queuePresentFn(
         impl->_present_queue,
         &presentInfo
-    ));
+    );
+    if (impl->_frame_stats)
+    {
+        auto stats = impl->_frame_stats.get();
+        stats->fence_wait.add(Milliseconds(acquire_start - fence_wait_start).count());
+        stats->acquire.add(Milliseconds(record_start - acquire_start).count());
+        stats->record.add(Milliseconds(submit_start - record_start).count());
+        stats->submit_to_present.add(Milliseconds(Clock::now() - submit_start).count());
+        stats->end_frame();
+    }
+    // the call returns the most severe of the windows' results; each window is recreated only on its own
+    if ((VK_SUCCESS != presentResult) && (VK_SUBOPTIMAL_KHR != presentResult) && (VK_ERROR_OUT_OF_DATE_KHR != presentResult))
+    {
+        throw Exception("Failed to present swapchain image");
+    }
+    for (auto i = 0u; i < targets.size(); ++i)
+    {
+        const auto result = presentResults[i];
+        if ((VK_ERROR_OUT_OF_DATE_KHR == result) || (VK_SUBOPTIMAL_KHR == result))
+        {
+            targets[i]->dirty = true;
+        }
+        else if (VK_SUCCESS != result)
+        {
+            throw Exception("Failed to present swapchain image");
+        }
+    }
 
-    impl->_current_frame = (impl->_current_frame + 1) % impl->MAX_FRAMES_IN_FLIGHT;
+    impl->_current_frame = (impl->_current_frame + 1) % impl->_frames_in_flight;
+
+    if (impl->_image_processing_ticket > 0)
+    {
+        impl->check_image_processing();
+    }
 
 #if 0
     // naive way of not queueing too much work for the GPU
@@ -141,3 +389,14 @@ Renderer::draw_frame() const
     ));
 #endif
 }
+
+bool
+Renderer::finished() const
+{
+    auto impl = this->_impl.get();
+    if (impl->_frame_capture && impl->_frame_capture->complete())
+    {
+        return true;
+    }
+    return impl->_benchmark && impl->_benchmark->finished();
+}
@@ -31,22 +31,50 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define VULKAN_RENDERER_H
 
 #include <memory>
+#include <string>
 
 class AppWindow;
+struct RendererSettings;
+namespace WindowLibrary
+{
+class GraphicsWindow;
+}
 
 class Renderer
 {
 public:
     Renderer(
-        AppWindow *inWindow);
+        AppWindow *inWindow,
+        const RendererSettings &inSettings);
     ~Renderer();
 
     void
     init();
 
+    // draws to the window the renderer was created with, and any added since, presenting to all of them at once
     void
     draw_frame() const;
 
+    // also draw to inWindow, from the same device, pipelines and memory; up to the windows setting in all
+    // throws Exception if the window cannot be presented to, or the settings cannot draw to more than one window
+    void
+    add_window(
+        WindowLibrary::GraphicsWindow *inWindow);
+
+    // stop drawing to inWindow, before it is destroyed
+    void
+    remove_window(
+        WindowLibrary::GraphicsWindow *inWindow);
+
+    // JSON description of the instance and of every physical device, queried on the first call after init
+    // and cached thereafter
+    const std::string &
+    capability_report() const;
+
+    // true once a benchmark has completed, and the application should exit
+    bool
+    finished() const;
+
 private:
     struct Impl;
     std::unique_ptr<Impl> _impl;
@@ -0,0 +1,809 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "rendergraph.h"
+#include "impl.h"
+#include "exception.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+const ::VkAccessFlags WRITE_ACCESS_MASK =
+    VK_ACCESS_SHADER_WRITE_BIT |
+    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_TRANSFER_WRITE_BIT |
+    VK_ACCESS_HOST_WRITE_BIT |
+    VK_ACCESS_MEMORY_WRITE_BIT;
+
+} // anonymous namespace
+
+RenderGraph::RenderGraph(
+    const DeviceDispatch &inDispatch,
+    const ::VkPhysicalDeviceMemoryProperties &inMemoryProperties)
+    :
+    _dispatch(inDispatch),
+    _device(inDispatch.device),
+    _memory_properties(inMemoryProperties)
+{}
+
+RenderGraph::~RenderGraph() = default;
+
+RenderGraph::UsageInfo
+RenderGraph::usage_info(
+    const Usage inUsage)
+{
+    UsageInfo info;
+    switch (inUsage)
+    {
+        case Usage::ColourAttachment:
+            info.stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            info.access = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+            info.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            info.image_usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+            info.write = true;
+            break;
+        case Usage::TransferSrc:
+            info.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            info.access = VK_ACCESS_TRANSFER_READ_BIT;
+            info.layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            info.image_usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            info.write = false;
+            break;
+        case Usage::TransferDst:
+            info.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            info.access = VK_ACCESS_TRANSFER_WRITE_BIT;
+            info.layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            info.image_usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+            info.write = true;
+            break;
+    }
+    return info;
+}
+
+RenderGraph::Resource
+RenderGraph::create_image(
+    const std::string &inName,
+    const ImageDesc &inDesc)
+{
+    ResourceData resource;
+    resource.name = inName;
+    resource.desc = inDesc;
+    resource.imported = false;
+    resource.final_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    this->_resources.push_back(std::move(resource));
+    return static_cast<Resource>(this->_resources.size() - 1);
+}
+
+RenderGraph::Resource
+RenderGraph::import_image(
+    const std::string &inName,
+    const ImageDesc &inDesc,
+    const ::VkImageLayout inFinalLayout)
+{
+    ResourceData resource;
+    resource.name = inName;
+    resource.desc = inDesc;
+    resource.imported = true;
+    resource.final_layout = inFinalLayout;
+    this->_resources.push_back(std::move(resource));
+    return static_cast<Resource>(this->_resources.size() - 1);
+}
+
+RenderGraph::Pass
+RenderGraph::add_pass(
+    const std::string &inName,
+    Execute inExecute)
+{
+    PassData pass;
+    pass.name = inName;
+    pass.execute = std::move(inExecute);
+    this->_passes.push_back(std::move(pass));
+    return static_cast<Pass>(this->_passes.size() - 1);
+}
+
+void
+RenderGraph::write_colour(
+    const Pass inPass,
+    const Resource inResource,
+    const ::VkClearColorValue *inClear)
+{
+    Access access;
+    memset(&access, 0, sizeof(access));
+    access.resource = inResource;
+    access.usage = Usage::ColourAttachment;
+    access.clear = (nullptr != inClear);
+    if (access.clear)
+    {
+        access.clear_value = *inClear;
+    }
+    this->_passes[inPass].accesses.push_back(access);
+}
+
+void
+RenderGraph::read_transfer(
+    const Pass inPass,
+    const Resource inResource)
+{
+    Access access;
+    memset(&access, 0, sizeof(access));
+    access.resource = inResource;
+    access.usage = Usage::TransferSrc;
+    this->_passes[inPass].accesses.push_back(access);
+}
+
+void
+RenderGraph::write_transfer(
+    const Pass inPass,
+    const Resource inResource)
+{
+    Access access;
+    memset(&access, 0, sizeof(access));
+    access.resource = inResource;
+    access.usage = Usage::TransferDst;
+    this->_passes[inPass].accesses.push_back(access);
+}
+
+void
+RenderGraph::compile()
+{
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    if (this->_compiled)
+    {
+        throw Exception("Render graph has already been compiled");
+    }
+    this->cull();
+
+    // lifetimes, and the union of usages, of each resource over the passes that remain
+    for (auto p = 0u; p < this->_passes.size(); ++p)
+    {
+        const auto &pass = this->_passes[p];
+        if (!pass.alive)
+        {
+            continue;
+        }
+        for (const auto &access : pass.accesses)
+        {
+            auto &resource = this->_resources[access.resource];
+            const auto info = usage_info(access.usage);
+            if (static_cast<uint32_t>(-1) == resource.first_pass)
+            {
+                resource.first_pass = p;
+                resource.first_stage = info.stage;
+            }
+            resource.last_pass = p;
+            resource.usage |= info.image_usage;
+        }
+    }
+
+    this->allocate_transients();
+    this->derive_barriers();
+    this->create_render_passes();
+    this->_compiled = true;
+}
+
+void
+RenderGraph::cull()
+{
+    // walking backwards, a pass is needed if it writes a resource that is imported, or is read by
+    // a later pass that is needed
+    std::vector<bool> needed(this->_resources.size(), false);
+    for (auto r = 0u; r < this->_resources.size(); ++r)
+    {
+        needed[r] = this->_resources[r].imported;
+    }
+    for (auto p = this->_passes.size(); p-- > 0;)
+    {
+        auto &pass = this->_passes[p];
+        pass.alive = std::any_of(pass.accesses.begin(), pass.accesses.end(), [&](const Access &inAccess)
+        {
+            return usage_info(inAccess.usage).write && needed[inAccess.resource];
+        });
+        if (!pass.alive)
+        {
+            Log().get() << "Render graph: culled pass '" << pass.name << "'" << std::endl;
+            continue;
+        }
+        for (const auto &access : pass.accesses)
+        {
+            if (!usage_info(access.usage).write)
+            {
+                needed[access.resource] = true;
+            }
+        }
+    }
+}
+
+uint32_t
+RenderGraph::find_memory_type(
+    const uint32_t inTypeBits) const
+{
+    for (auto i = 0u; i < this->_memory_properties.memoryTypeCount; ++i)
+    {
+        if ((inTypeBits & (1u << i)) &&
+            (this->_memory_properties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+        {
+            return i;
+        }
+    }
+    return static_cast<uint32_t>(-1);
+}
+
+void
+RenderGraph::allocate_transients()
+{
+    auto device = this->_device;
+    auto createImageFn = GETDFN(device, vkCreateImage);
+    auto getImageMemoryRequirementsFn = GETDFN(device, vkGetImageMemoryRequirements);
+    auto allocateMemoryFn = GETDFN(device, vkAllocateMemory);
+    auto bindImageMemoryFn = GETDFN(device, vkBindImageMemory);
+    auto createImageViewFn = GETDFN(device, vkCreateImageView);
+
+    // transient images used by the passes that remain, in order of first use
+    std::vector<Resource> transients;
+    for (auto r = 0u; r < this->_resources.size(); ++r)
+    {
+        const auto &resource = this->_resources[r];
+        if (!resource.imported && static_cast<uint32_t>(-1) != resource.first_pass)
+        {
+            transients.push_back(r);
+        }
+    }
+    std::stable_sort(transients.begin(), transients.end(), [this](Resource inA, Resource inB)
+    {
+        return this->_resources[inA].first_pass < this->_resources[inB].first_pass;
+    });
+
+    std::vector<::VkMemoryRequirements> requirements(this->_resources.size());
+    ::VkDeviceSize requested = 0;
+    for (const auto r : transients)
+    {
+        auto &resource = this->_resources[r];
+
+        ::VkImageCreateInfo createInfo;
+        memset(&createInfo, 0, sizeof(createInfo));
+        createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        createInfo.imageType = VK_IMAGE_TYPE_2D;
+        createInfo.format = resource.desc.format;
+        createInfo.extent.width = resource.desc.extent.width;
+        createInfo.extent.height = resource.desc.extent.height;
+        createInfo.extent.depth = 1;
+        createInfo.mipLevels = 1;
+        createInfo.arrayLayers = 1;
+        createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        createInfo.usage = resource.usage;
+        createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        ::VkImage image;
+        VK_ERR_CHECK(createImageFn(
+            device,
+            &createInfo,
+            this->_dispatch.allocator,
+            &image
+        ));
+        resource.owned_image = { this->_dispatch, image };
+        resource.image = image;
+
+        getImageMemoryRequirementsFn(
+            device,
+            image,
+            &requirements[r]
+        );
+        requested += requirements[r].size;
+
+        // reuse the memory of an image whose last use precedes this image's first use
+        const auto &req = requirements[r];
+        auto block_index = static_cast<uint32_t>(-1);
+        for (auto b = 0u; b < this->_memory_blocks.size(); ++b)
+        {
+            const auto &block = this->_memory_blocks[b];
+            if (block.last_pass < resource.first_pass &&
+                static_cast<uint32_t>(-1) != this->find_memory_type(block.type_bits & req.memoryTypeBits))
+            {
+                block_index = b;
+                break;
+            }
+        }
+        if (static_cast<uint32_t>(-1) == block_index)
+        {
+            if (static_cast<uint32_t>(-1) == this->find_memory_type(req.memoryTypeBits))
+            {
+                throw Exception("No device local memory type for render graph image '" + resource.name + "'");
+            }
+            block_index = static_cast<uint32_t>(this->_memory_blocks.size());
+            this->_memory_blocks.emplace_back();
+        }
+        else
+        {
+            resource.aliases = this->_memory_blocks[block_index].last_resource;
+            Log().get() << "Render graph: '" << resource.name << "' aliases the memory of '" << this->_resources[resource.aliases].name << "'" << std::endl;
+        }
+        auto &block = this->_memory_blocks[block_index];
+        // images are bound at offset 0, which satisfies any alignment
+        block.size = std::max(block.size, req.size);
+        block.type_bits &= req.memoryTypeBits;
+        block.last_pass = resource.last_pass;
+        block.last_resource = r;
+        resource.memory_block = block_index;
+    }
+
+    ::VkDeviceSize allocated = 0;
+    for (auto &block : this->_memory_blocks)
+    {
+        ::VkMemoryAllocateInfo allocateInfo;
+        memset(&allocateInfo, 0, sizeof(allocateInfo));
+        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocateInfo.allocationSize = block.size;
+        allocateInfo.memoryTypeIndex = this->find_memory_type(block.type_bits);
+
+        ::VkDeviceMemory memory;
+        VK_ERR_CHECK(allocateMemoryFn(
+            device,
+            &allocateInfo,
+            this->_dispatch.allocator,
+            &memory
+        ));
+        block.memory = { this->_dispatch, memory };
+        allocated += block.size;
+    }
+    Log().get() << "Render graph: " << transients.size() << " transient images requiring " << requested << " bytes placed in " << this->_memory_blocks.size() << " allocations totalling " << allocated << " bytes" << std::endl;
+
+    for (const auto r : transients)
+    {
+        auto &resource = this->_resources[r];
+        VK_ERR_CHECK(bindImageMemoryFn(
+            device,
+            resource.image,
+            this->_memory_blocks[resource.memory_block].memory.get(),
+            0
+        ));
+
+        ::VkImageViewCreateInfo viewInfo;
+        memset(&viewInfo, 0, sizeof(viewInfo));
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = resource.image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = resource.desc.format;
+        viewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+        viewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+        viewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+        viewInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        ::VkImageView view;
+        VK_ERR_CHECK(createImageViewFn(
+            device,
+            &viewInfo,
+            this->_dispatch.allocator,
+            &view
+        ));
+        resource.owned_view = { this->_dispatch, view };
+        resource.view = view;
+    }
+}
+
+void
+RenderGraph::derive_barriers()
+{
+    // what each resource has last been used for; reads since the last write are accumulated so
+    // that a further read is only synchronised if it is in a stage not already made visible to
+    struct State
+    {
+        ::VkImageLayout        layout;
+        ::VkPipelineStageFlags write_stages;
+        ::VkAccessFlags        write_access;
+        ::VkPipelineStageFlags read_stages;
+        ::VkAccessFlags        read_access;
+    };
+    std::vector<State> initial(this->_resources.size());
+    for (auto r = 0u; r < this->_resources.size(); ++r)
+    {
+        auto &state = initial[r];
+        memset(&state, 0, sizeof(state));
+        state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        // an imported image is made available by a semaphore wait at the stage of its first use
+        state.write_stages = this->_resources[r].imported ? this->_resources[r].first_stage : 0;
+    }
+
+    // walks the passes from inInitial, returning the state of each resource at the end of the execution,
+    // and adding each pass's barriers if inRecord
+    auto barrier_count = 0u;
+    auto walk = [this, &barrier_count](const std::vector<State> &inInitial, const bool inRecord)
+    {
+        auto states = inInitial;
+        for (auto p = 0u; p < this->_passes.size(); ++p)
+        {
+            auto &pass = this->_passes[p];
+            if (!pass.alive)
+            {
+                continue;
+            }
+            for (const auto &access : pass.accesses)
+            {
+                const auto &resource = this->_resources[access.resource];
+                auto &state = states[access.resource];
+                if (p == resource.first_pass && static_cast<Resource>(-1) != resource.aliases)
+                {
+                    // the previous occupant of the memory must be finished with before it is overwritten
+                    const auto &previous = states[resource.aliases];
+                    state.write_stages = previous.write_stages | previous.read_stages;
+                    state.write_access = previous.write_access;
+                }
+
+                const auto info = usage_info(access.usage);
+                Barrier barrier;
+                barrier.resource = access.resource;
+                barrier.dst_stage = info.stage;
+                barrier.dst_access = info.access;
+                barrier.old_layout = state.layout;
+                barrier.new_layout = info.layout;
+                if (info.write)
+                {
+                    // write after read, and write after write
+                    barrier.src_stage = state.write_stages | state.read_stages;
+                    barrier.src_access = state.write_access & WRITE_ACCESS_MASK;
+                    state.write_stages = info.stage;
+                    state.write_access = info.access & WRITE_ACCESS_MASK;
+                    state.read_stages = 0;
+                    state.read_access = 0;
+                }
+                else if (state.layout != info.layout)
+                {
+                    // a layout transition is itself a write, visible to this stage alone
+                    barrier.src_stage = state.write_stages | state.read_stages;
+                    barrier.src_access = state.write_access & WRITE_ACCESS_MASK;
+                    state.write_stages = info.stage;
+                    state.write_access = 0;
+                    state.read_stages = info.stage;
+                    state.read_access = info.access;
+                }
+                else if ((info.stage & ~state.read_stages) || (info.access & ~state.read_access))
+                {
+                    // read after write, in a stage not yet synchronised with the write
+                    barrier.src_stage = state.write_stages;
+                    barrier.src_access = state.write_access & WRITE_ACCESS_MASK;
+                    state.read_stages |= info.stage;
+                    state.read_access |= info.access;
+                }
+                else
+                {
+                    // read after read in the same layout
+                    continue;
+                }
+                state.layout = info.layout;
+                if (inRecord)
+                {
+                    pass.barriers.push_back(barrier);
+                    ++barrier_count;
+                }
+            }
+        }
+        return states;
+    };
+
+    // the transients are shared by every frame in flight, so the first use of each block of memory in an execution
+    // must wait for its last use in the previous execution, which may still be running; the end state does not
+    // depend on these source stages, so a first walk finds it
+    const auto previous = walk(initial, false);
+    for (auto r = 0u; r < this->_resources.size(); ++r)
+    {
+        const auto &resource = this->_resources[r];
+        if (resource.imported || static_cast<uint32_t>(-1) == resource.memory_block || static_cast<Resource>(-1) != resource.aliases)
+        {
+            continue;
+        }
+        const auto &last = previous[this->_memory_blocks[resource.memory_block].last_resource];
+        initial[r].write_stages = last.write_stages | last.read_stages;
+        initial[r].write_access = last.write_access;
+    }
+    const auto states = walk(initial, true);
+
+    for (auto r = 0u; r < this->_resources.size(); ++r)
+    {
+        const auto &resource = this->_resources[r];
+        const auto &state = states[r];
+        if (!resource.imported || state.layout == resource.final_layout)
+        {
+            continue;
+        }
+        Barrier barrier;
+        barrier.resource = r;
+        barrier.src_stage = state.write_stages | state.read_stages;
+        barrier.src_access = state.write_access & WRITE_ACCESS_MASK;
+        barrier.dst_stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        barrier.dst_access = 0;
+        barrier.old_layout = state.layout;
+        barrier.new_layout = resource.final_layout;
+        this->_final_barriers.push_back(barrier);
+        ++barrier_count;
+    }
+    Log().get() << "Render graph: " << barrier_count << " image barriers per execution" << std::endl;
+}
+
+void
+RenderGraph::create_render_passes()
+{
+    auto device = this->_device;
+    auto createRenderPassFn = GETDFN(device, vkCreateRenderPass);
+
+    for (auto p = 0u; p < this->_passes.size(); ++p)
+    {
+        auto &pass = this->_passes[p];
+        if (!pass.alive)
+        {
+            continue;
+        }
+
+        std::vector<::VkAttachmentDescription> attachments;
+        std::vector<::VkAttachmentReference> references;
+        for (const auto &access : pass.accesses)
+        {
+            if (Usage::ColourAttachment != access.usage)
+            {
+                continue;
+            }
+            const auto &resource = this->_resources[access.resource];
+
+            // layout transitions are all made by the graph's barriers, and the contents need only
+            // be stored if a later pass, or the importer, uses them
+            ::VkAttachmentDescription attachment;
+            memset(&attachment, 0, sizeof(attachment));
+            attachment.format = resource.desc.format;
+            attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+            attachment.loadOp = access.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+            attachment.storeOp = (resource.imported || resource.last_pass > p) ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            ::VkAttachmentReference reference;
+            memset(&reference, 0, sizeof(reference));
+            reference.attachment = static_cast<uint32_t>(attachments.size());
+            reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            ::VkClearValue clear;
+            memset(&clear, 0, sizeof(clear));
+            clear.color = access.clear_value;
+
+            attachments.push_back(attachment);
+            references.push_back(reference);
+            pass.attachments.push_back(access.resource);
+            pass.clear_values.push_back(clear);
+        }
+        if (attachments.empty())
+        {
+            continue;
+        }
+
+        ::VkSubpassDescription subpass;
+        memset(&subpass, 0, sizeof(subpass));
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = static_cast<uint32_t>(references.size());
+        subpass.pColorAttachments = references.data();
+
+        ::VkRenderPassCreateInfo createInfo;
+        memset(&createInfo, 0, sizeof(createInfo));
+        createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        createInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        createInfo.pAttachments = attachments.data();
+        createInfo.subpassCount = 1;
+        createInfo.pSubpasses = &subpass;
+
+        ::VkRenderPass renderPass;
+        VK_ERR_CHECK(createRenderPassFn(
+            device,
+            &createInfo,
+            this->_dispatch.allocator,
+            &renderPass
+        ));
+        pass.render_pass = { this->_dispatch, renderPass };
+    }
+}
+
+::VkPipelineStageFlags
+RenderGraph::first_stage(
+    const Resource inResource) const
+{
+    return this->_resources[inResource].first_stage;
+}
+
+void
+RenderGraph::set_imported(
+    const Resource inResource,
+    ::VkImage inImage,
+    ::VkImageView inView)
+{
+    auto &resource = this->_resources[inResource];
+    if (!resource.imported)
+    {
+        throw Exception("Render graph resource '" + resource.name + "' is not imported");
+    }
+    resource.image = inImage;
+    resource.view = inView;
+}
+
+::VkImage
+RenderGraph::image(
+    const Resource inResource) const
+{
+    return this->_resources[inResource].image;
+}
+
+const RenderGraph::ImageDesc &
+RenderGraph::desc(
+    const Resource inResource) const
+{
+    return this->_resources[inResource].desc;
+}
+
+::VkFramebuffer
+RenderGraph::framebuffer(
+    PassData &inPass)
+{
+    std::vector<::VkImageView> views;
+    for (const auto r : inPass.attachments)
+    {
+        views.push_back(this->_resources[r].view);
+    }
+    auto it = inPass.framebuffers.find(views);
+    if (it != inPass.framebuffers.end())
+    {
+        return it->second.get();
+    }
+
+    const auto &extent = this->_resources[inPass.attachments[0]].desc.extent;
+    ::VkFramebufferCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+    createInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    createInfo.renderPass = inPass.render_pass.get();
+    createInfo.attachmentCount = static_cast<uint32_t>(views.size());
+    createInfo.pAttachments = views.data();
+    createInfo.width = extent.width;
+    createInfo.height = extent.height;
+    createInfo.layers = 1;
+
+    auto device = this->_device;
+    auto createFrameBufferFn = GETDFN(device, vkCreateFramebuffer);
+    ::VkFramebuffer frameBuffer;
+    VK_ERR_CHECK(createFrameBufferFn(
+        device,
+        &createInfo,
+        this->_dispatch.allocator,
+        &frameBuffer
+    ));
+    inPass.framebuffers[views] = { this->_dispatch, frameBuffer };
+    return frameBuffer;
+}
+
+void
+RenderGraph::record_barriers(
+    ::VkCommandBuffer inCommandBuffer,
+    const std::vector<Barrier> &inBarriers) const
+{
+    if (inBarriers.empty())
+    {
+        return;
+    }
+    ::VkPipelineStageFlags src_stages = 0;
+    ::VkPipelineStageFlags dst_stages = 0;
+    std::vector<::VkImageMemoryBarrier> imageBarriers(inBarriers.size());
+    for (auto i = 0u; i < inBarriers.size(); ++i)
+    {
+        const auto &barrier = inBarriers[i];
+        auto &imageBarrier = imageBarriers[i];
+        memset(&imageBarrier, 0, sizeof(imageBarrier));
+        imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarrier.srcAccessMask = barrier.src_access;
+        imageBarrier.dstAccessMask = barrier.dst_access;
+        imageBarrier.oldLayout = barrier.old_layout;
+        imageBarrier.newLayout = barrier.new_layout;
+        imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.image = this->_resources[barrier.resource].image;
+        imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        imageBarrier.subresourceRange.baseMipLevel = 0;
+        imageBarrier.subresourceRange.levelCount = 1;
+        imageBarrier.subresourceRange.baseArrayLayer = 0;
+        imageBarrier.subresourceRange.layerCount = 1;
+        src_stages |= barrier.src_stage;
+        dst_stages |= barrier.dst_stage;
+    }
+    vkCmdPipelineBarrier(
+        inCommandBuffer,
+        (0 != src_stages) ? src_stages : static_cast<::VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT),
+        dst_stages,
+        0,
+        0,
+        nullptr,
+        0,
+        nullptr,
+        static_cast<uint32_t>(imageBarriers.size()),
+        imageBarriers.data()
+    );
+}
+
+void
+RenderGraph::execute(
+    ::VkCommandBuffer inCommandBuffer)
+{
+    if (!this->_compiled)
+    {
+        throw Exception("Render graph must be compiled before execution");
+    }
+    for (auto &pass : this->_passes)
+    {
+        if (!pass.alive)
+        {
+            continue;
+        }
+        this->record_barriers(inCommandBuffer, pass.barriers);
+
+        PassContext context = { inCommandBuffer, { 0, 0 }, *this };
+        if (!pass.render_pass)
+        {
+            pass.execute(context);
+            continue;
+        }
+
+        context.extent = this->_resources[pass.attachments[0]].desc.extent;
+        ::VkRenderPassBeginInfo renderPassInfo;
+        memset(&renderPassInfo, 0, sizeof(renderPassInfo));
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = pass.render_pass.get();
+        renderPassInfo.framebuffer = this->framebuffer(pass);
+        renderPassInfo.renderArea.offset = {0, 0};
+        renderPassInfo.renderArea.extent = context.extent;
+        renderPassInfo.clearValueCount = static_cast<uint32_t>(pass.clear_values.size());
+        renderPassInfo.pClearValues = pass.clear_values.data();
+
+        vkCmdBeginRenderPass(
+            inCommandBuffer,
+            &renderPassInfo,
+            VK_SUBPASS_CONTENTS_INLINE
+        );
+        pass.execute(context);
+        vkCmdEndRenderPass(
+            inCommandBuffer
+        );
+    }
+    this->record_barriers(inCommandBuffer, this->_final_barriers);
+}
@@ -0,0 +1,256 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_RENDERGRAPH_H
+#define VULKAN_RENDERER_RENDERGRAPH_H
+
+#include "uniquehandle.h"
+#include "vulkan/vulkan.h"
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// frame graph of passes declaring the images that they read and write
+// compile() culls passes that do not contribute to an imported image, derives the minimal set of
+// pipeline barriers and layout transitions between the remaining passes, and places transient
+// images whose lifetimes do not overlap into shared device memory
+// passes writing colour attachments are wrapped in a render pass created by the graph
+class RenderGraph
+{
+public:
+    typedef uint32_t Resource;
+    typedef uint32_t Pass;
+
+    struct ImageDesc
+    {
+        ::VkFormat   format;
+        ::VkExtent2D extent;
+    };
+
+    struct PassContext
+    {
+        ::VkCommandBuffer  command_buffer;
+        ::VkExtent2D       extent; // of the render area, for passes writing colour attachments
+        const RenderGraph &graph;
+    };
+    typedef std::function<void(const PassContext &)> Execute;
+
+    RenderGraph(
+        const DeviceDispatch &inDispatch,
+        const ::VkPhysicalDeviceMemoryProperties &inMemoryProperties);
+    ~RenderGraph();
+
+    RenderGraph(const RenderGraph &) = delete;
+    RenderGraph &operator=(const RenderGraph &) = delete;
+
+    // an image created, and owned, by the graph, whose contents do not outlive the frame
+    Resource
+    create_image(
+        const std::string &inName,
+        const ImageDesc &inDesc);
+
+    // an image owned elsewhere, e.g. a swapchain image, whose contents are discarded on entry and
+    // left in inFinalLayout on exit; passes contributing to an imported image are never culled
+    // its VkImage and VkImageView are bound each frame with set_imported
+    Resource
+    import_image(
+        const std::string &inName,
+        const ImageDesc &inDesc,
+        const ::VkImageLayout inFinalLayout);
+
+    Pass
+    add_pass(
+        const std::string &inName,
+        Execute inExecute);
+
+    // inClear is null to load the existing contents
+    void
+    write_colour(
+        const Pass inPass,
+        const Resource inResource,
+        const ::VkClearColorValue *inClear);
+
+    void
+    read_transfer(
+        const Pass inPass,
+        const Resource inResource);
+
+    void
+    write_transfer(
+        const Pass inPass,
+        const Resource inResource);
+
+    void
+    compile();
+
+    // stage of the first access to the resource, i.e. that at which a semaphore signalling the
+    // availability of an imported image should be waited upon
+    ::VkPipelineStageFlags
+    first_stage(
+        const Resource inResource) const;
+
+    void
+    set_imported(
+        const Resource inResource,
+        ::VkImage inImage,
+        ::VkImageView inView);
+
+    void
+    execute(
+        ::VkCommandBuffer inCommandBuffer);
+
+    ::VkImage
+    image(
+        const Resource inResource) const;
+
+    const ImageDesc &
+    desc(
+        const Resource inResource) const;
+
+private:
+    enum class Usage
+    {
+        ColourAttachment,
+        TransferSrc,
+        TransferDst
+    };
+
+    struct UsageInfo
+    {
+        ::VkPipelineStageFlags stage;
+        ::VkAccessFlags        access;
+        ::VkImageLayout        layout;
+        ::VkImageUsageFlags    image_usage;
+        bool                   write;
+    };
+
+    static UsageInfo
+    usage_info(
+        const Usage inUsage);
+
+    struct Access
+    {
+        Resource            resource;
+        Usage               usage;
+        bool                clear;
+        ::VkClearColorValue clear_value;
+    };
+
+    struct Barrier
+    {
+        Resource               resource;
+        ::VkPipelineStageFlags src_stage;
+        ::VkPipelineStageFlags dst_stage;
+        ::VkAccessFlags        src_access;
+        ::VkAccessFlags        dst_access;
+        ::VkImageLayout        old_layout;
+        ::VkImageLayout        new_layout;
+    };
+
+    struct PassData
+    {
+        std::string                                                                  name;
+        Execute                                                                      execute;
+        std::vector<Access>                                                          accesses;
+        bool                                                                         alive = false;
+        std::vector<Barrier>                                                         barriers;
+        UniqueHandle<::VkRenderPass>                                                 render_pass;
+        std::vector<Resource>                                                        attachments;
+        std::vector<::VkClearValue>                                                  clear_values;
+        std::map<std::vector<::VkImageView>, UniqueHandle<::VkFramebuffer>>          framebuffers;
+    };
+
+    struct ResourceData
+    {
+        std::string                                                            name;
+        ImageDesc                                                              desc;
+        bool                                                                   imported;
+        ::VkImageLayout                                                        final_layout;
+        ::VkImageUsageFlags                                                    usage = 0;
+        ::VkPipelineStageFlags                                                 first_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        uint32_t                                                               first_pass = static_cast<uint32_t>(-1);
+        uint32_t                                                               last_pass = 0;
+        uint32_t                                                               memory_block = static_cast<uint32_t>(-1);
+        Resource                                                               aliases = static_cast<Resource>(-1); // previous occupant of the memory
+        ::VkImage                                                              image = VK_NULL_HANDLE;
+        ::VkImageView                                                          view = VK_NULL_HANDLE;
+        UniqueHandle<::VkImage>                                                owned_image;
+        UniqueHandle<::VkImageView>                                            owned_view;
+    };
+
+    struct MemoryBlock
+    {
+        ::VkDeviceSize                                                             size = 0;
+        uint32_t                                                                   type_bits = ~0u;
+        uint32_t                                                                   last_pass = 0;
+        Resource                                                                   last_resource;
+        UniqueHandle<::VkDeviceMemory>                                             memory;
+    };
+
+    void
+    cull();
+
+    void
+    allocate_transients();
+
+    void
+    derive_barriers();
+
+    void
+    create_render_passes();
+
+    uint32_t
+    find_memory_type(
+        const uint32_t inTypeBits) const;
+
+    ::VkFramebuffer
+    framebuffer(
+        PassData &inPass);
+
+    void
+    record_barriers(
+        ::VkCommandBuffer inCommandBuffer,
+        const std::vector<Barrier> &inBarriers) const;
+
+    // declared such that framebuffers, then images, are destroyed before the memory they use
+    const DeviceDispatch                &_dispatch;
+    ::VkDevice                           _device;
+    ::VkPhysicalDeviceMemoryProperties   _memory_properties;
+    std::vector<MemoryBlock>             _memory_blocks;
+    std::vector<ResourceData>            _resources;
+    std::vector<PassData>                _passes;
+    std::vector<Barrier>                 _final_barriers;
+    bool                                 _compiled = false;
+};
+
+#endif // VULKAN_RENDERER_RENDERGRAPH_H
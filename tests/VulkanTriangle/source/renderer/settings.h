@@ -0,0 +1,166 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_SETTINGS_H
+#define VULKAN_RENDERER_SETTINGS_H
+
+#include <cstdint>
+#include <string>
+
+// swapchain presentation, trading latency against power and tearing
+enum class PresentMode
+{
+    Fifo,        // vsync, always available
+    FifoRelaxed, // vsync, but tears rather than waits when a frame is late
+    Mailbox,     // no tearing, latest frame replaces any queued frame
+    Immediate    // no vsync, may tear
+};
+
+// each frame in flight has its own fences, semaphores and command pools, and delays the destruction of retired objects
+const uint32_t MAX_FRAMES_IN_FLIGHT = 16;
+
+// runtime configuration of the renderer, usually populated from the command line
+struct RendererSettings
+{
+    // falls back to Fifo if the surface does not support the requested mode
+    PresentMode present_mode = PresentMode::Fifo;
+
+    // number of swapchain images requested, clamped to the surface limits
+    // 0 uses the surface minimum
+    uint32_t swapchain_images = 0;
+
+    // number of frames the CPU may record ahead of the GPU; more trades latency for throughput
+    // from 1 to MAX_FRAMES_IN_FLIGHT
+    uint32_t frames_in_flight = 2;
+
+    // log histograms of CPU frame pacing every this many frames, over a rolling window
+    // 0 disables the statistics
+    uint32_t frame_stats_interval = 0;
+
+    // re-record each frame's command buffer, from a command pool owned by that frame in flight,
+    // rather than using the command buffers pre-recorded once at startup
+    bool     dynamic_frames = false;
+
+    // number of secondary command buffers recorded in parallel each frame
+    // 0 records the frame on the calling thread, when recording each frame
+    // non-zero implies dynamic_frames; clamped to four per hardware thread
+    uint32_t recording_threads = 0;
+
+    // number of triangle draws recorded
+    uint32_t draw_count = 1;
+
+    // split the draws into this many chunks, each recorded into secondary command buffers that are kept from frame to
+    // frame, and re-recorded only once the chunk changes; 0 records every draw every frame
+    // non-zero implies dynamic_frames; with recording_threads, changed chunks are re-recorded in parallel
+    // ignored by the instanced scene, the render graph and the recording benchmarks
+    uint32_t scene_chunks = 0;
+
+    // number of chunks changed each frame, in turn, simulating a scene that is mostly static
+    uint32_t dirty_chunks = 0;
+
+    // sweep draw counts and recording thread counts, logging the CPU cost of recording
+    bool     benchmark_recording = false;
+
+    // sweep draw counts over static and dynamic frames, logging the CPU cost of each frame
+    bool     benchmark_dynamic = false;
+
+    // draw a stress scene of this many instances of a small mesh, from vertex and instance buffers,
+    // rather than the triangle
+    // non-zero implies dynamic_frames
+    uint32_t instances = 0;
+
+    // run for this many measured frames, then log CPU and GPU frame time percentiles and triangle throughput, and quit
+    // non-zero implies dynamic_frames; ignored if another benchmark is requested
+    uint32_t benchmark_frames = 0;
+
+    // filter, convert and mip a generated image of this width on the compute queue, alongside rendering,
+    // verifying each result bit exact against a CPU reference once complete; 0 disables
+    uint32_t image_processing_size = 0;
+
+    // file of a texture sampled by the triangles, in the stream that textureprocessor sends: a TextureHeader followed
+    // by its RGBA8 texels; empty draws them untextured
+    // cannot be used with instances, nor capture_path
+    std::string texture_path;
+
+    // render through a frame graph of a scene pass and post-process blits, rather than a single render pass
+    // implies dynamic_frames, and records the scene on the calling thread
+    bool     render_graph = false;
+
+    // directory of the GLSL shader sources, compiled at startup rather than loading pre-built SPIR-V
+    std::string shader_dir;
+
+    // directory in which compiled SPIR-V is cached between runs, when compiling shaders; must exist
+    std::string shader_cache_dir;
+
+    // number of background threads compiling pipelines, during which draws using them are skipped
+    // 0 compiles on the calling thread
+    uint32_t pipeline_threads = 1;
+
+    // file from which the pipeline cache is loaded at startup, and to which it is saved at exit
+    std::string pipeline_cache_path;
+
+    // values of the shaders' specialisation constants for the pipeline drawn with, as name=value pairs separated
+    // by commas or spaces; empty for the shaders' defaults
+    std::string pipeline_variant;
+
+    // file listing pipeline variants, one line of name=value pairs each, compiled at startup so that switching to
+    // them later does not wait on compilation
+    std::string pipeline_variant_manifest;
+
+    // path of a CSV file to which per-scope CPU and GPU times are written, along with pipeline statistics and
+    // samples passed of each pass, where the device supports them
+    // non-empty implies dynamic_frames, as the queries are recorded each frame
+    std::string gpu_profile_path;
+
+    // route the Vulkan implementation's host allocations through our own allocation callbacks, pooling them and
+    // logging their counts and sizes by allocation scope at exit, rather than leaving them to the implementation
+    bool     host_allocator = false;
+
+    // path of a JSON file to which the capabilities of the instance and every physical device are written,
+    // after startup; the capabilities are not otherwise queried
+    std::string capability_report_path;
+
+    // path of a file to which the objects and commands of the first capture_frames frames are written, for
+    // VulkanReplay to re-execute headlessly; the application finishes once they are written
+    // cannot be used with render_graph, nor the benchmarks
+    std::string capture_path;
+    uint32_t capture_frames = 100;
+
+    // number of windows drawn to, from the one device, each with its own swapchain, all presented together
+    // windows beyond the first draw the scene inline; implies dynamic_frames
+    // cannot be used with render_graph, capture_path, nor the recording benchmarks
+    uint32_t windows = 1;
+
+    // number of reports of each validation message logged per second, from a background thread; repeats beyond it
+    // are counted and summarised
+    // 0 logs every message on the reporting thread, as it is reported, e.g. to see the last messages before a crash
+    uint32_t debug_report_rate = 10;
+};
+
+#endif // VULKAN_RENDERER_SETTINGS_H
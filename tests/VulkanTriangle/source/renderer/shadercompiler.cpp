@@ -0,0 +1,314 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "shadercompiler.h"
+#include "exception.h"
+#include "hash.h"
+#include "log.h"
+
+#include "glslang/Public/ShaderLang.h"
+#include "SPIRV/GlslangToSpv.h"
+#include "StandAlone/ResourceLimits.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+
+// changes whenever the compiler, or its options, change, invalidating the disk cache
+const char *const COMPILER_TAG = "glslang-7.10.2984;vulkan1.0;spv1.0";
+
+const uint32_t SPIRV_MAGIC = 0x07230203;
+
+// precedes the SPIR-V in each disk cache file, so that a truncated or foreign file is rejected
+const uint32_t CACHE_MAGIC = 0x53504348; // 'SPCH'
+struct CacheHeader
+{
+    uint32_t magic;
+    uint32_t word_count; // of the SPIR-V that follows
+    uint64_t key;        // that the file is named after
+    uint64_t checksum;   // FNV-1a of the SPIR-V
+};
+
+uint64_t
+checksum(
+    const std::vector<uint32_t> &inCode)
+{
+    auto result = FNV_OFFSET_BASIS;
+    fnv1a(result, inCode.data(), inCode.size() * sizeof(uint32_t));
+    return result;
+}
+
+EShLanguage
+to_language(
+    const ::VkShaderStageFlagBits inStage)
+{
+    switch (inStage)
+    {
+        case VK_SHADER_STAGE_VERTEX_BIT:
+            return EShLangVertex;
+        case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT:
+            return EShLangTessControl;
+        case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT:
+            return EShLangTessEvaluation;
+        case VK_SHADER_STAGE_GEOMETRY_BIT:
+            return EShLangGeometry;
+        case VK_SHADER_STAGE_FRAGMENT_BIT:
+            return EShLangFragment;
+        case VK_SHADER_STAGE_COMPUTE_BIT:
+            return EShLangCompute;
+        default:
+            throw Exception("Unsupported shader stage for compilation");
+    }
+}
+
+} // anonymous namespace
+
+ShaderCompiler::ShaderCompiler(
+    const std::string &inCacheDir)
+    :
+    _cache_dir(inCacheDir)
+{
+    glslang::InitializeProcess();
+}
+
+ShaderCompiler::~ShaderCompiler()
+{
+    Log().get() << "Shader compiler: " << this->_compilations << " compilations, " << this->_hits << " cache hits" << std::endl;
+    glslang::FinalizeProcess();
+}
+
+uint64_t
+ShaderCompiler::hash(
+    const std::string &inSource,
+    const ::VkShaderStageFlagBits inStage,
+    const Defines &inDefines)
+{
+    auto result = FNV_OFFSET_BASIS;
+    fnv1a(result, COMPILER_TAG);
+    const auto stage = static_cast<uint32_t>(inStage);
+    fnv1a(result, &stage, sizeof(stage));
+    for (const auto &define : inDefines)
+    {
+        fnv1a(result, define.first);
+        fnv1a(result, define.second);
+    }
+    fnv1a(result, inSource);
+    return result;
+}
+
+std::string
+ShaderCompiler::cache_path(
+    const uint64_t inHash) const
+{
+    std::ostringstream path;
+    path << this->_cache_dir << "/" << std::hex << std::setw(16) << std::setfill('0') << inHash << ".spv";
+    return path.str();
+}
+
+bool
+ShaderCompiler::load_cached(
+    const uint64_t inHash,
+    std::vector<uint32_t> &outCode) const
+{
+    if (this->_cache_dir.empty())
+    {
+        return false;
+    }
+    std::ifstream file(this->cache_path(inHash), std::ios::ate | std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    // a truncated or foreign file is treated as a miss, and replaced
+    const auto file_size = static_cast<size_t>(file.tellg());
+    CacheHeader header;
+    if (file_size < sizeof(header))
+    {
+        return false;
+    }
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)))
+    {
+        return false;
+    }
+    if (CACHE_MAGIC != header.magic || inHash != header.key || 0 == header.word_count ||
+        file_size != sizeof(header) + static_cast<size_t>(header.word_count) * sizeof(uint32_t))
+    {
+        return false;
+    }
+    outCode.resize(header.word_count);
+    if (!file.read(reinterpret_cast<char *>(outCode.data()), header.word_count * sizeof(uint32_t)))
+    {
+        return false;
+    }
+    return SPIRV_MAGIC == outCode[0] && header.checksum == checksum(outCode);
+}
+
+void
+ShaderCompiler::store_cached(
+    const uint64_t inHash,
+    const std::vector<uint32_t> &inCode) const
+{
+    if (this->_cache_dir.empty())
+    {
+        return;
+    }
+    // written to a file of its own, then renamed into place, so that an interrupted or concurrent write is never
+    // seen partially written
+    static std::atomic<uint32_t> next_temp(0);
+    const auto path = this->cache_path(inHash);
+    std::ostringstream temp_path;
+    temp_path << path << "." << std::hash<std::thread::id>()(std::this_thread::get_id()) << "." << std::chrono::steady_clock::now().time_since_epoch().count() << "." << next_temp++ << ".tmp";
+    {
+        std::ofstream file(temp_path.str(), std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            Log().get() << "Unable to write shader cache file " << temp_path.str() << std::endl;
+            return;
+        }
+        CacheHeader header;
+        header.magic = CACHE_MAGIC;
+        header.word_count = static_cast<uint32_t>(inCode.size());
+        header.key = inHash;
+        header.checksum = checksum(inCode);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(inCode.data()), inCode.size() * sizeof(uint32_t));
+        file.close();
+        if (!file.good())
+        {
+            Log().get() << "Unable to write shader cache file " << temp_path.str() << std::endl;
+            std::remove(temp_path.str().c_str());
+            return;
+        }
+    }
+    if (0 != std::rename(temp_path.str().c_str(), path.c_str()))
+    {
+        // Windows does not rename over an existing file, which was rejected by load_cached, or was written concurrently
+        std::remove(path.c_str());
+        if (0 != std::rename(temp_path.str().c_str(), path.c_str()))
+        {
+            std::remove(temp_path.str().c_str());
+        }
+    }
+}
+
+std::vector<uint32_t>
+ShaderCompiler::compile_file(
+    const std::string &inPath,
+    const ::VkShaderStageFlagBits inStage,
+    const Defines &inDefines)
+{
+    std::ifstream file(inPath);
+    if (!file.is_open())
+    {
+        throw Exception("Unable to open shader source " + inPath);
+    }
+    std::ostringstream source;
+    source << file.rdbuf();
+    return this->compile(inPath, source.str(), inStage, inDefines);
+}
+
+std::vector<uint32_t>
+ShaderCompiler::compile(
+    const std::string &inName,
+    const std::string &inSource,
+    const ::VkShaderStageFlagBits inStage,
+    const Defines &inDefines)
+{
+    const auto key = hash(inSource, inStage, inDefines);
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        auto it = this->_memory_cache.find(key);
+        if (it != this->_memory_cache.end())
+        {
+            ++this->_hits;
+            return it->second;
+        }
+    }
+
+    std::vector<uint32_t> code;
+    if (this->load_cached(key, code))
+    {
+        Log().get() << "Loaded " << inName << " from the shader cache" << std::endl;
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        ++this->_hits;
+        this->_memory_cache[key] = code;
+        return code;
+    }
+
+    const auto language = to_language(inStage);
+    std::string preamble;
+    for (const auto &define : inDefines)
+    {
+        preamble += "#define " + define.first + " " + define.second + "\n";
+    }
+
+    glslang::TShader shader(language);
+    const char *source = inSource.c_str();
+    const char *name = inName.c_str();
+    const int length = static_cast<int>(inSource.size());
+    shader.setStringsWithLengthsAndNames(&source, &length, &name, 1);
+    shader.setPreamble(preamble.c_str());
+    shader.setEntryPoint("main");
+    shader.setEnvInput(glslang::EShSourceGlsl, language, glslang::EShClientVulkan, 100);
+    shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_0);
+    shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_0);
+
+    const auto messages = static_cast<EShMessages>(EShMsgSpvRules | EShMsgVulkanRules);
+    if (!shader.parse(&glslang::DefaultTBuiltInResource, 100, false, messages))
+    {
+        throw Exception("Failed to compile " + inName + ":\n" + shader.getInfoLog());
+    }
+
+    glslang::TProgram program;
+    program.addShader(&shader);
+    if (!program.link(messages))
+    {
+        throw Exception("Failed to link " + inName + ":\n" + program.getInfoLog());
+    }
+
+    std::vector<unsigned int> spirv;
+    glslang::GlslangToSpv(*program.getIntermediate(language), spirv);
+    code.assign(spirv.begin(), spirv.end());
+    Log().get() << "Compiled " << inName << " to " << code.size() * sizeof(uint32_t) << " bytes of SPIR-V" << std::endl;
+
+    this->store_cached(key, code);
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    ++this->_compilations;
+    this->_memory_cache[key] = code;
+    return code;
+}
@@ -0,0 +1,101 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_SHADERCOMPILER_H
+#define VULKAN_RENDERER_SHADERCOMPILER_H
+
+#include "vulkan/vulkan.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// in-process GLSL to SPIR-V compilation with glslang
+// modules are cached in memory, and optionally on disk, keyed by a hash of the stage, source and defines,
+// so that unchanged shaders are never recompiled
+// compile may be called from multiple threads
+class ShaderCompiler
+{
+public:
+    typedef std::vector<std::pair<std::string, std::string>> Defines;
+
+    // inCacheDir is the directory of the disk cache, which must exist; empty to cache in memory only
+    explicit ShaderCompiler(
+        const std::string &inCacheDir);
+    ~ShaderCompiler();
+
+    ShaderCompiler(const ShaderCompiler &) = delete;
+    ShaderCompiler &operator=(const ShaderCompiler &) = delete;
+
+    // throws Exception with the glslang log on failure
+    std::vector<uint32_t>
+    compile_file(
+        const std::string &inPath,
+        const ::VkShaderStageFlagBits inStage,
+        const Defines &inDefines = Defines());
+
+    std::vector<uint32_t>
+    compile(
+        const std::string &inName,
+        const std::string &inSource,
+        const ::VkShaderStageFlagBits inStage,
+        const Defines &inDefines = Defines());
+
+private:
+    static uint64_t
+    hash(
+        const std::string &inSource,
+        const ::VkShaderStageFlagBits inStage,
+        const Defines &inDefines);
+
+    std::string
+    cache_path(
+        const uint64_t inHash) const;
+
+    bool
+    load_cached(
+        const uint64_t inHash,
+        std::vector<uint32_t> &outCode) const;
+
+    void
+    store_cached(
+        const uint64_t inHash,
+        const std::vector<uint32_t> &inCode) const;
+
+    std::string                                          _cache_dir;
+    std::mutex                                           _mutex;
+    std::unordered_map<uint64_t, std::vector<uint32_t>>  _memory_cache;
+    uint32_t                                             _hits = 0;
+    uint32_t                                             _compilations = 0;
+};
+
+#endif // VULKAN_RENDERER_SHADERCOMPILER_H
@@ -0,0 +1,443 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "shaderreflection.h"
+#include "exception.h"
+
+#include "spirv_cross.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace
+{
+
+uint32_t
+descriptor_count(
+    const spirv_cross::SPIRType &inType,
+    const std::string &inName)
+{
+    uint32_t count = 1;
+    for (auto i = 0u; i < inType.array.size(); ++i)
+    {
+        if (!inType.array_size_literal[i])
+        {
+            throw Exception("Descriptor array '" + inName + "' is sized by a specialisation constant, which reflection cannot resolve");
+        }
+        // runtime sized arrays are given a single descriptor
+        count *= std::max(inType.array[i], 1u);
+    }
+    return count;
+}
+
+void
+insert_binding(
+    std::map<uint32_t, std::vector<::VkDescriptorSetLayoutBinding>> &ioSets,
+    const uint32_t inSet,
+    const ::VkDescriptorSetLayoutBinding &inBinding)
+{
+    auto &bindings = ioSets[inSet];
+    auto existing = std::find_if(bindings.begin(), bindings.end(), [&inBinding](const ::VkDescriptorSetLayoutBinding &inCandidate)
+    {
+        return inCandidate.binding == inBinding.binding;
+    });
+    if (existing == bindings.end())
+    {
+        auto position = std::upper_bound(bindings.begin(), bindings.end(), inBinding, [](const ::VkDescriptorSetLayoutBinding &inLhs, const ::VkDescriptorSetLayoutBinding &inRhs)
+        {
+            return inLhs.binding < inRhs.binding;
+        });
+        bindings.insert(position, inBinding);
+        return;
+    }
+    if (existing->descriptorType != inBinding.descriptorType || existing->descriptorCount != inBinding.descriptorCount)
+    {
+        throw Exception("Shader stages disagree on the descriptor at set " + std::to_string(inSet) + ", binding " + std::to_string(inBinding.binding));
+    }
+    existing->stageFlags |= inBinding.stageFlags;
+}
+
+void
+add_bindings(
+    const spirv_cross::Compiler &inCompiler,
+    const std::vector<spirv_cross::Resource> &inResources,
+    const ::VkDescriptorType inType,
+    const ::VkDescriptorType inBufferDimType, // for images of dimension Buffer, i.e. texel buffers
+    const ::VkShaderStageFlagBits inStage,
+    std::map<uint32_t, std::vector<::VkDescriptorSetLayoutBinding>> &ioSets)
+{
+    for (const auto &resource : inResources)
+    {
+        const auto &type = inCompiler.get_type(resource.type_id);
+
+        ::VkDescriptorSetLayoutBinding binding;
+        memset(&binding, 0, sizeof(binding));
+        binding.binding = inCompiler.get_decoration(resource.id, spv::DecorationBinding);
+        const auto is_image = (spirv_cross::SPIRType::Image == type.basetype || spirv_cross::SPIRType::SampledImage == type.basetype);
+        binding.descriptorType = (is_image && spv::DimBuffer == type.image.dim) ? inBufferDimType : inType;
+        binding.descriptorCount = descriptor_count(type, resource.name);
+        binding.stageFlags = inStage;
+        binding.pImmutableSamplers = nullptr;
+        insert_binding(ioSets, inCompiler.get_decoration(resource.id, spv::DecorationDescriptorSet), binding);
+    }
+}
+
+::VkFormat
+vertex_format(
+    const spirv_cross::SPIRType &inType)
+{
+    if (32 != inType.width || inType.vecsize < 1 || inType.vecsize > 4)
+    {
+        return VK_FORMAT_UNDEFINED;
+    }
+    static const ::VkFormat float_formats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+    static const ::VkFormat int_formats[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+    static const ::VkFormat uint_formats[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+    switch (inType.basetype)
+    {
+        case spirv_cross::SPIRType::Float:
+            return float_formats[inType.vecsize - 1];
+        case spirv_cross::SPIRType::Int:
+            return int_formats[inType.vecsize - 1];
+        case spirv_cross::SPIRType::UInt:
+            return uint_formats[inType.vecsize - 1];
+        default:
+            return VK_FORMAT_UNDEFINED;
+    }
+}
+
+uint32_t
+format_size(
+    const ::VkFormat inFormat)
+{
+    switch (inFormat)
+    {
+        case VK_FORMAT_R32_SFLOAT:
+        case VK_FORMAT_R32_SINT:
+        case VK_FORMAT_R32_UINT:
+            return 4;
+        case VK_FORMAT_R32G32_SFLOAT:
+        case VK_FORMAT_R32G32_SINT:
+        case VK_FORMAT_R32G32_UINT:
+            return 8;
+        case VK_FORMAT_R32G32B32_SFLOAT:
+        case VK_FORMAT_R32G32B32_SINT:
+        case VK_FORMAT_R32G32B32_UINT:
+            return 12;
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+        case VK_FORMAT_R32G32B32A32_SINT:
+        case VK_FORMAT_R32G32B32A32_UINT:
+            return 16;
+        default:
+            throw Exception("Unexpected vertex format " + std::to_string(inFormat));
+    }
+}
+
+void
+merge_push_constants(
+    std::vector<::VkPushConstantRange> &ioRanges,
+    const ::VkPushConstantRange &inRange)
+{
+    if (ioRanges.empty())
+    {
+        ioRanges.push_back(inRange);
+        return;
+    }
+    // a single range visible to all stages, so that any update is valid with the union of stage flags
+    auto &range = ioRanges.front();
+    const auto end = std::max(range.offset + range.size, inRange.offset + inRange.size);
+    range.offset = std::min(range.offset, inRange.offset);
+    range.size = end - range.offset;
+    range.stageFlags |= inRange.stageFlags;
+}
+
+void
+merge_specialization_constant(
+    std::vector<ShaderReflection::SpecializationConstant> &ioConstants,
+    const ShaderReflection::SpecializationConstant &inConstant)
+{
+    auto existing = std::lower_bound(ioConstants.begin(), ioConstants.end(), inConstant.constant_id, [](const ShaderReflection::SpecializationConstant &inCandidate, const uint32_t inId)
+    {
+        return inCandidate.constant_id < inId;
+    });
+    if (existing == ioConstants.end() || existing->constant_id != inConstant.constant_id)
+    {
+        ioConstants.insert(existing, inConstant);
+        return;
+    }
+    // one value is given per id, to every stage, so the stages must agree on its type
+    if (existing->type != inConstant.type)
+    {
+        throw Exception("Shader stages disagree on the type of specialisation constant " + std::to_string(inConstant.constant_id));
+    }
+}
+
+} // anonymous namespace
+
+ShaderReflection::ShaderReflection(
+    const std::vector<uint32_t> &inCode,
+    const ::VkShaderStageFlagBits inStage)
+    :
+    _stages(inStage)
+{
+    try
+    {
+        spirv_cross::Compiler compiler(inCode);
+        const auto resources = compiler.get_shader_resources();
+
+        add_bindings(compiler, resources.uniform_buffers, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, inStage, this->_descriptor_sets);
+        add_bindings(compiler, resources.storage_buffers, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, inStage, this->_descriptor_sets);
+        add_bindings(compiler, resources.sampled_images, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, inStage, this->_descriptor_sets);
+        add_bindings(compiler, resources.separate_images, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, inStage, this->_descriptor_sets);
+        add_bindings(compiler, resources.separate_samplers, VK_DESCRIPTOR_TYPE_SAMPLER, VK_DESCRIPTOR_TYPE_SAMPLER, inStage, this->_descriptor_sets);
+        add_bindings(compiler, resources.storage_images, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, inStage, this->_descriptor_sets);
+        add_bindings(compiler, resources.subpass_inputs, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, inStage, this->_descriptor_sets);
+
+        for (const auto &block : resources.push_constant_buffers)
+        {
+            // only the members that the stage accesses
+            const auto ranges = compiler.get_active_buffer_ranges(block.id);
+            for (const auto &active : ranges)
+            {
+                ::VkPushConstantRange range;
+                memset(&range, 0, sizeof(range));
+                range.stageFlags = inStage;
+                range.offset = static_cast<uint32_t>(active.offset);
+                range.size = static_cast<uint32_t>(active.range);
+                merge_push_constants(this->_push_constant_ranges, range);
+            }
+        }
+
+        for (const auto &constant : compiler.get_specialization_constants())
+        {
+            const auto &value = compiler.get_constant(constant.id);
+            const auto &type = compiler.get_type(value.constant_type);
+            SpecializationConstant reflected;
+            reflected.name = compiler.get_name(constant.id);
+            reflected.constant_id = constant.constant_id;
+            reflected.default_value = value.scalar();
+            switch (type.basetype)
+            {
+            case spirv_cross::SPIRType::Boolean:
+                reflected.type = SpecializationConstant::Type::Boolean;
+                break;
+            case spirv_cross::SPIRType::Int:
+                reflected.type = SpecializationConstant::Type::Int;
+                break;
+            case spirv_cross::SPIRType::UInt:
+                reflected.type = SpecializationConstant::Type::UInt;
+                break;
+            case spirv_cross::SPIRType::Float:
+                reflected.type = SpecializationConstant::Type::Float;
+                break;
+            default:
+                throw Exception("Specialisation constant '" + reflected.name + "' is not a 32 bit scalar");
+            }
+            if (reflected.name.empty())
+            {
+                reflected.name = "constant_" + std::to_string(reflected.constant_id);
+            }
+            merge_specialization_constant(this->_specialization_constants, reflected);
+        }
+
+        if (VK_SHADER_STAGE_VERTEX_BIT == inStage)
+        {
+            for (const auto &input : resources.stage_inputs)
+            {
+                if (compiler.has_decoration(input.id, spv::DecorationBuiltIn))
+                {
+                    continue;
+                }
+                const auto &type = compiler.get_type(input.type_id);
+                const auto format = vertex_format(type);
+                if (VK_FORMAT_UNDEFINED == format || !type.array.empty())
+                {
+                    throw Exception("Vertex input '" + input.name + "' has a type that cannot be reflected into a vertex format");
+                }
+                const auto location = compiler.get_decoration(input.id, spv::DecorationLocation);
+                // matrices occupy one location per column
+                for (auto column = 0u; column < type.columns; ++column)
+                {
+                    ::VkVertexInputAttributeDescription attribute;
+                    memset(&attribute, 0, sizeof(attribute));
+                    attribute.location = location + column;
+                    attribute.binding = 0;
+                    attribute.format = format;
+                    this->_vertex_attributes.push_back(attribute);
+                }
+            }
+            std::sort(this->_vertex_attributes.begin(), this->_vertex_attributes.end(), [](const ::VkVertexInputAttributeDescription &inLhs, const ::VkVertexInputAttributeDescription &inRhs)
+            {
+                return inLhs.location < inRhs.location;
+            });
+            this->pack_vertex_attributes();
+        }
+    }
+    catch (const spirv_cross::CompilerError &inError)
+    {
+        throw Exception(std::string("Unable to reflect SPIR-V: ") + inError.what());
+    }
+}
+
+void
+ShaderReflection::merge(
+    const ShaderReflection &inOther)
+{
+    for (const auto &set : inOther._descriptor_sets)
+    {
+        for (const auto &binding : set.second)
+        {
+            insert_binding(this->_descriptor_sets, set.first, binding);
+        }
+    }
+    for (const auto &range : inOther._push_constant_ranges)
+    {
+        merge_push_constants(this->_push_constant_ranges, range);
+    }
+    if (!inOther._vertex_attributes.empty())
+    {
+        this->_vertex_attributes = inOther._vertex_attributes;
+        this->_vertex_bindings = inOther._vertex_bindings;
+    }
+    for (const auto &constant : inOther._specialization_constants)
+    {
+        merge_specialization_constant(this->_specialization_constants, constant);
+    }
+    this->_stages |= inOther._stages;
+}
+
+const std::map<uint32_t, std::vector<::VkDescriptorSetLayoutBinding>> &
+ShaderReflection::descriptor_sets() const
+{
+    return this->_descriptor_sets;
+}
+
+const std::vector<::VkPushConstantRange> &
+ShaderReflection::push_constant_ranges() const
+{
+    return this->_push_constant_ranges;
+}
+
+const std::vector<::VkVertexInputAttributeDescription> &
+ShaderReflection::vertex_attributes() const
+{
+    return this->_vertex_attributes;
+}
+
+void
+ShaderReflection::set_instance_rate(
+    const uint32_t inFirstLocation)
+{
+    for (auto &attribute : this->_vertex_attributes)
+    {
+        attribute.binding = (attribute.location >= inFirstLocation) ? 1 : 0;
+    }
+    this->pack_vertex_attributes();
+}
+
+void
+ShaderReflection::use_dynamic_uniform_buffers()
+{
+    for (auto &set : this->_descriptor_sets)
+    {
+        for (auto &binding : set.second)
+        {
+            if (VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER == binding.descriptorType)
+            {
+                binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            }
+        }
+    }
+}
+
+void
+ShaderReflection::use_immutable_sampler(
+    const ::VkSampler *inSampler)
+{
+    for (auto &set : this->_descriptor_sets)
+    {
+        for (auto &binding : set.second)
+        {
+            if (VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER != binding.descriptorType)
+            {
+                continue;
+            }
+            if (1 != binding.descriptorCount)
+            {
+                throw Exception("Sampler array at set " + std::to_string(set.first) + " binding " + std::to_string(binding.binding) + " cannot share one immutable sampler");
+            }
+            binding.pImmutableSamplers = inSampler;
+        }
+    }
+}
+
+const std::vector<::VkVertexInputBindingDescription> &
+ShaderReflection::vertex_bindings() const
+{
+    return this->_vertex_bindings;
+}
+
+const std::vector<ShaderReflection::SpecializationConstant> &
+ShaderReflection::specialization_constants() const
+{
+    return this->_specialization_constants;
+}
+
+void
+ShaderReflection::pack_vertex_attributes()
+{
+    // attributes are in location order, so each binding is packed in location order too
+    this->_vertex_bindings.clear();
+    for (auto &attribute : this->_vertex_attributes)
+    {
+        auto binding = std::find_if(this->_vertex_bindings.begin(), this->_vertex_bindings.end(), [&attribute](const ::VkVertexInputBindingDescription &inBinding)
+        {
+            return inBinding.binding == attribute.binding;
+        });
+        if (binding == this->_vertex_bindings.end())
+        {
+            ::VkVertexInputBindingDescription description;
+            memset(&description, 0, sizeof(description));
+            description.binding = attribute.binding;
+            description.stride = 0;
+            description.inputRate = (0 == attribute.binding) ? VK_VERTEX_INPUT_RATE_VERTEX : VK_VERTEX_INPUT_RATE_INSTANCE;
+            this->_vertex_bindings.push_back(description);
+            binding = this->_vertex_bindings.end() - 1;
+        }
+        attribute.offset = binding->stride;
+        binding->stride += format_size(attribute.format);
+    }
+}
+
+::VkShaderStageFlags
+ShaderReflection::stages() const
+{
+    return this->_stages;
+}
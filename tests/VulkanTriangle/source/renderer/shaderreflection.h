@@ -0,0 +1,125 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_SHADERREFLECTION_H
+#define VULKAN_RENDERER_SHADERREFLECTION_H
+
+#include "vulkan/vulkan.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// the resource interface of one or more shader stages, reflected from SPIR-V with SPIRVCross
+// from which descriptor set layouts, push constant ranges and the vertex input layout are derived,
+// rather than being written by hand alongside each shader
+class ShaderReflection
+{
+public:
+    // a scalar constant whose value is chosen when a pipeline is created, rather than when the shader is compiled
+    struct SpecializationConstant
+    {
+        enum class Type
+        {
+            Boolean, // not Bool, which Xlib defines as a macro
+            Int,
+            UInt,
+            Float
+        };
+
+        std::string name;
+        uint32_t    constant_id = 0;
+        Type        type = Type::UInt;
+        uint32_t    default_value = 0; // bit pattern, as given to VkSpecializationInfo
+    };
+
+    // throws Exception if the module cannot be parsed, or uses an unsupported vertex input type
+    ShaderReflection(
+        const std::vector<uint32_t> &inCode,
+        const ::VkShaderStageFlagBits inStage);
+
+    // combine with another stage of the same pipeline; bindings used by both stages are visible to both
+    // throws Exception if the stages disagree about the type of a binding
+    void
+    merge(
+        const ShaderReflection &inOther);
+
+    // keyed by set number, each sorted by binding number; there may be gaps in set numbers
+    const std::map<uint32_t, std::vector<::VkDescriptorSetLayoutBinding>> &
+    descriptor_sets() const;
+
+    // at most one range, covering every stage's push constant block
+    const std::vector<::VkPushConstantRange> &
+    push_constant_ranges() const;
+
+    // move vertex inputs at or beyond inFirstLocation into a binding 1 advanced per instance
+    void
+    set_instance_rate(
+        const uint32_t inFirstLocation);
+
+    // make every uniform buffer binding a dynamic uniform buffer, so that the buffer range bound is chosen by an
+    // offset when the descriptor set is bound, rather than by a descriptor write
+    void
+    use_dynamic_uniform_buffers();
+
+    // make every combined image sampler binding sample through *inSampler, baked into its descriptor set layout,
+    // so that descriptor writes give only the image; inSampler must outlive any use of the bindings
+    // throws Exception if such a binding is an array
+    void
+    use_immutable_sampler(
+        const ::VkSampler *inSampler);
+
+    // vertex shader inputs, tightly packed in location order, in binding 0 unless moved by set_instance_rate
+    const std::vector<::VkVertexInputAttributeDescription> &
+    vertex_attributes() const;
+
+    const std::vector<::VkVertexInputBindingDescription> &
+    vertex_bindings() const;
+
+    ::VkShaderStageFlags
+    stages() const;
+
+    // sorted by constant id; a constant used by several stages appears once
+    const std::vector<SpecializationConstant> &
+    specialization_constants() const;
+
+private:
+    std::map<uint32_t, std::vector<::VkDescriptorSetLayoutBinding>> _descriptor_sets;
+    std::vector<::VkPushConstantRange>                              _push_constant_ranges;
+    void
+    pack_vertex_attributes();
+
+    std::vector<::VkVertexInputAttributeDescription>                _vertex_attributes;
+    std::vector<::VkVertexInputBindingDescription>                  _vertex_bindings;
+    std::vector<SpecializationConstant>                             _specialization_constants;
+    ::VkShaderStageFlags                                            _stages = 0;
+};
+
+#endif // VULKAN_RENDERER_SHADERREFLECTION_H
@@ -0,0 +1,78 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "startupprofile.h"
+#include "log.h"
+
+#include <algorithm>
+#include <iomanip>
+
+void
+StartupProfile::begin(
+    const std::string &inPhase)
+{
+    this->end();
+    this->_current = inPhase;
+    this->_start = Clock::now();
+}
+
+void
+StartupProfile::end()
+{
+    if (this->_current.empty())
+    {
+        return;
+    }
+    const std::chrono::duration<double, std::milli> elapsed = Clock::now() - this->_start;
+    this->_phases.push_back({ this->_current, elapsed.count() });
+    this->_current.clear();
+}
+
+void
+StartupProfile::report() const
+{
+    auto total = 0.0;
+    size_t width = 0;
+    for (const auto &phase : this->_phases)
+    {
+        total += phase.milliseconds;
+        width = std::max(width, phase.name.size());
+    }
+
+    Log log;
+    auto &stream = log.get();
+    stream << "Startup took " << std::fixed << std::setprecision(3) << total << " ms:" << std::endl;
+    for (const auto &phase : this->_phases)
+    {
+        const auto percent = (total > 0) ? (100.0 * phase.milliseconds / total) : 0.0;
+        stream << "\t" << std::left << std::setw(static_cast<int>(width)) << phase.name << std::right
+            << std::setw(12) << phase.milliseconds << " ms"
+            << std::setw(8) << std::setprecision(1) << percent << " %" << std::setprecision(3) << std::endl;
+    }
+}
@@ -0,0 +1,67 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_STARTUPPROFILE_H
+#define VULKAN_RENDERER_STARTUPPROFILE_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// wall clock time of each phase of startup, reported together once startup has completed
+// each phase runs from its begin until the next begin, or the end
+class StartupProfile
+{
+public:
+    void
+    begin(
+        const std::string &inPhase);
+
+    void
+    end();
+
+    // as a single log message, so that the log file is written once for the whole report
+    void
+    report() const;
+
+private:
+    typedef std::chrono::high_resolution_clock Clock;
+
+    struct Phase
+    {
+        std::string name;
+        double      milliseconds;
+    };
+
+    std::vector<Phase>  _phases;
+    std::string         _current;
+    Clock::time_point   _start;
+};
+
+#endif // VULKAN_RENDERER_STARTUPPROFILE_H
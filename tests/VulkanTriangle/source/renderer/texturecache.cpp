@@ -0,0 +1,754 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "texturecache.h"
+#include "impl.h"
+#include "exception.h"
+#include "log.h"
+
+#include "texture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace
+{
+
+const ::VkFormat FORMAT = VK_FORMAT_R8G8B8A8_UNORM; // the layout of textureprocessor's payloads
+const ::VkDeviceSize TEXEL_SIZE = 4;
+
+// of each allocation of device memory that images are placed in; larger images have a block to themselves
+const ::VkDeviceSize IMAGE_BLOCK_SIZE = 64 * 1024 * 1024;
+
+::VkDeviceSize
+align_up(
+    const ::VkDeviceSize inSize,
+    const ::VkDeviceSize inAlignment)
+{
+    return (inSize + inAlignment - 1) / inAlignment * inAlignment;
+}
+
+::VkImageMemoryBarrier
+level_barrier(
+    ::VkImage inImage,
+    const uint32_t inBaseLevel,
+    const uint32_t inLevelCount,
+    const ::VkImageLayout inOldLayout,
+    const ::VkImageLayout inNewLayout,
+    const ::VkAccessFlags inSrcAccess,
+    const ::VkAccessFlags inDstAccess)
+{
+    ::VkImageMemoryBarrier barrier;
+    memset(&barrier, 0, sizeof(barrier));
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = inSrcAccess;
+    barrier.dstAccessMask = inDstAccess;
+    barrier.oldLayout = inOldLayout;
+    barrier.newLayout = inNewLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = inImage;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = inBaseLevel;
+    barrier.subresourceRange.levelCount = inLevelCount;
+    barrier.subresourceRange.layerCount = 1;
+    return barrier;
+}
+
+} // anonymous namespace
+
+TextureCache::TextureCache(
+    const DeviceDispatch &inDispatch,
+    const ::VkPhysicalDeviceMemoryProperties &inMemoryProperties,
+    const ::VkPhysicalDeviceLimits &inLimits,
+    const ::VkFormatProperties &inFormatProperties,
+    const uint32_t inQueueFamily,
+    ::VkQueue inQueue,
+    const ::VkDeviceSize inStagingSize,
+    const uint32_t inMaxTextures)
+    :
+    _dispatch(inDispatch),
+    _device(inDispatch.device),
+    _memory_properties(inMemoryProperties),
+    _max_dimension(inLimits.maxImageDimension2D),
+    // all powers of two, so the largest satisfies copies of whole texels, the optimal copy offset, and flushes of
+    // non-coherent memory alike
+    _staging_alignment(std::max(TEXEL_SIZE, std::max(inLimits.optimalBufferCopyOffsetAlignment, inLimits.nonCoherentAtomSize))),
+    _staging_atom(inLimits.nonCoherentAtomSize),
+    _max_textures(inMaxTextures),
+    _timeline(inDispatch, inQueue)
+{
+    auto device = this->_device;
+    this->_staging_size = align_up(std::max<::VkDeviceSize>(inStagingSize, 1), this->_staging_alignment);
+
+    // blitting between levels with a linear filter needs both blit features, and linear filtering
+    const ::VkFormatFeatureFlags blit_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    const auto features = inFormatProperties.optimalTilingFeatures;
+    if (0 == (features & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+    {
+        throw Exception("Textures require a format that can be sampled with optimal tiling");
+    }
+    this->_generate_mips = (blit_features == (features & blit_features));
+    const auto linear = (0 != (features & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT));
+
+    ::VkBufferCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+    createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    createInfo.size = this->_staging_size;
+    createInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    auto createBufferFn = GETDFN(device, vkCreateBuffer);
+    ::VkBuffer buffer;
+    VK_ERR_CHECK(createBufferFn(
+        device,
+        &createInfo,
+        this->_dispatch.allocator,
+        &buffer
+    ));
+
+    auto getBufferMemoryRequirementsFn = GETDFN(device, vkGetBufferMemoryRequirements);
+    ::VkMemoryRequirements requirements;
+    getBufferMemoryRequirementsFn(
+        device,
+        buffer,
+        &requirements
+    );
+
+    // coherent memory needs no flushes, so is preferred, though not required
+    auto memory_type = this->find_memory_type(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    if (std::numeric_limits<uint32_t>::max() == memory_type)
+    {
+        memory_type = this->find_memory_type(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    }
+    if (std::numeric_limits<uint32_t>::max() == memory_type)
+    {
+        // the buffer is destroyed on throwing, only once owned
+        this->_staging_buffer = { this->_dispatch, buffer };
+        throw Exception("No host visible memory type suitable for the texture staging ring");
+    }
+    this->_staging_coherent = (0 != (inMemoryProperties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+
+    ::VkMemoryAllocateInfo allocateInfo;
+    memset(&allocateInfo, 0, sizeof(allocateInfo));
+    allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize = requirements.size;
+    allocateInfo.memoryTypeIndex = memory_type;
+
+    auto allocateMemoryFn = GETDFN(device, vkAllocateMemory);
+    ::VkDeviceMemory memory;
+    VK_ERR_CHECK(allocateMemoryFn(
+        device,
+        &allocateInfo,
+        this->_dispatch.allocator,
+        &memory
+    ));
+    this->_staging_memory = { this->_dispatch, memory };
+    this->_staging_buffer = { this->_dispatch, buffer };
+
+    auto bindBufferMemoryFn = GETDFN(device, vkBindBufferMemory);
+    VK_ERR_CHECK(bindBufferMemoryFn(
+        device,
+        buffer,
+        memory,
+        0
+    ));
+
+    auto mapMemoryFn = GETDFN(device, vkMapMemory);
+    void *mapped = nullptr;
+    VK_ERR_CHECK(mapMemoryFn(
+        device,
+        memory,
+        0,
+        VK_WHOLE_SIZE,
+        0,
+        &mapped
+    ));
+    this->_staging_mapped = static_cast<char *>(mapped);
+
+    // filtering within and between levels, where the format allows it
+    ::VkSamplerCreateInfo samplerInfo;
+    memset(&samplerInfo, 0, sizeof(samplerInfo));
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = linear ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+    samplerInfo.minFilter = samplerInfo.magFilter;
+    samplerInfo.mipmapMode = linear ? VK_SAMPLER_MIPMAP_MODE_LINEAR : VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+    samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+
+    auto createSamplerFn = GETDFN(device, vkCreateSampler);
+    ::VkSampler sampler;
+    VK_ERR_CHECK(createSamplerFn(
+        device,
+        &samplerInfo,
+        this->_dispatch.allocator,
+        &sampler
+    ));
+    this->_sampler = { this->_dispatch, sampler };
+    this->_sampler_handle = sampler;
+
+    ::VkDescriptorPoolSize poolSize;
+    poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSize.descriptorCount = std::max(1u, inMaxTextures);
+    ::VkDescriptorPoolCreateInfo poolInfo;
+    memset(&poolInfo, 0, sizeof(poolInfo));
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = poolSize.descriptorCount;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    auto createDescriptorPoolFn = GETDFN(device, vkCreateDescriptorPool);
+    ::VkDescriptorPool descriptorPool;
+    VK_ERR_CHECK(createDescriptorPoolFn(
+        device,
+        &poolInfo,
+        this->_dispatch.allocator,
+        &descriptorPool
+    ));
+    this->_descriptor_pool = { this->_dispatch, descriptorPool };
+
+    // command buffers are allocated per submission, and freed once it completes
+    ::VkCommandPoolCreateInfo commandPoolInfo;
+    memset(&commandPoolInfo, 0, sizeof(commandPoolInfo));
+    commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    commandPoolInfo.queueFamilyIndex = inQueueFamily;
+    auto createCommandPoolFn = GETDFN(device, vkCreateCommandPool);
+    ::VkCommandPool commandPool;
+    VK_ERR_CHECK(createCommandPoolFn(
+        device,
+        &commandPoolInfo,
+        this->_dispatch.allocator,
+        &commandPool
+    ));
+    this->_command_pool = { this->_dispatch, commandPool };
+
+    Log().get() << "Texture cache: staging ring of " << this->_staging_size << " bytes in " << (this->_staging_coherent ? "coherent" : "non-coherent") << " memory type " << memory_type << ", " << (this->_generate_mips ? "mip chains blitted on queue family " + std::to_string(inQueueFamily) : std::string("a single level, as the format cannot be blitted linearly")) << std::endl;
+}
+
+TextureCache::~TextureCache()
+{
+    ::VkDeviceSize block_bytes = 0;
+    ::VkDeviceSize used_bytes = 0;
+    for (const auto &block : this->_blocks)
+    {
+        block_bytes += block.size;
+        used_bytes += block.used;
+    }
+    Log().get() << "Texture cache: " << this->_textures.size() << " textures, " << this->_uploaded_bytes << " bytes uploaded, placed in " << used_bytes << " bytes of " << this->_blocks.size() << " blocks totalling " << block_bytes << " bytes" << std::endl;
+}
+
+uint32_t
+TextureCache::upload(
+    const TextureHeader &inHeader)
+{
+    const auto width = inHeader.mu32Width;
+    const auto height = inHeader.mu32Height;
+    const auto size = static_cast<::VkDeviceSize>(width) * height * TEXEL_SIZE;
+    if ((0 == width) || (0 == height) || (width > this->_max_dimension) || (height > this->_max_dimension))
+    {
+        throw Exception("Texture of " + std::to_string(width) + "x" + std::to_string(height) + " texels is outside of the device's limit of " + std::to_string(this->_max_dimension));
+    }
+    if ((nullptr == inHeader.mpData) || (size != inHeader.mu32TotalTextureDataSize))
+    {
+        throw Exception("Texture of " + std::to_string(width) + "x" + std::to_string(height) + " RGBA8 texels requires " + std::to_string(size) + " bytes, not " + std::to_string(inHeader.mu32TotalTextureDataSize));
+    }
+    if (size > this->_staging_size)
+    {
+        throw Exception("Texture of " + std::to_string(size) + " bytes exceeds the staging ring of " + std::to_string(this->_staging_size) + " bytes");
+    }
+
+    // staged before the command buffer is chosen, as waiting for space may flush the one being recorded
+    const auto staging_offset = this->allocate_staging(size);
+    memcpy(this->_staging_mapped + staging_offset, inHeader.mpData, static_cast<size_t>(size));
+
+    auto levels = 1u;
+    if (this->_generate_mips)
+    {
+        for (auto extent = std::max(width, height); extent > 1; extent /= 2)
+        {
+            ++levels;
+        }
+    }
+
+    auto device = this->_device;
+
+    ::VkImageCreateInfo imageInfo;
+    memset(&imageInfo, 0, sizeof(imageInfo));
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = FORMAT;
+    imageInfo.extent.width = width;
+    imageInfo.extent.height = height;
+    imageInfo.extent.depth = 1;
+    imageInfo.mipLevels = levels;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (levels > 1)
+    {
+        imageInfo.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    auto createImageFn = GETDFN(device, vkCreateImage);
+    ::VkImage image;
+    VK_ERR_CHECK_QUIET(createImageFn(
+        device,
+        &imageInfo,
+        this->_dispatch.allocator,
+        &image
+    ));
+    Entry entry;
+    entry.image = { this->_dispatch, image };
+    this->bind_image_memory(image);
+
+    ::VkImageViewCreateInfo viewInfo;
+    memset(&viewInfo, 0, sizeof(viewInfo));
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = FORMAT;
+    viewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount = levels;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    auto createImageViewFn = GETDFN(device, vkCreateImageView);
+    ::VkImageView view;
+    VK_ERR_CHECK_QUIET(createImageViewFn(
+        device,
+        &viewInfo,
+        this->_dispatch.allocator,
+        &view
+    ));
+    entry.view = { this->_dispatch, view };
+
+    auto commandBuffer = this->recording_command_buffer();
+    auto cmdPipelineBarrierFn = GETDFN(device, vkCmdPipelineBarrier);
+    auto cmdCopyBufferToImageFn = GETDFN(device, vkCmdCopyBufferToImage);
+    auto cmdBlitImageFn = GETDFN(device, vkCmdBlitImage);
+
+    // every level is written by a transfer, the first from the staging ring
+    auto barrier = level_barrier(image, 0, levels, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+    cmdPipelineBarrierFn(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0, nullptr,
+        0, nullptr,
+        1, &barrier
+    );
+
+    ::VkBufferImageCopy copy;
+    memset(&copy, 0, sizeof(copy));
+    copy.bufferOffset = staging_offset;
+    copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    copy.imageSubresource.layerCount = 1;
+    copy.imageExtent = imageInfo.extent;
+    cmdCopyBufferToImageFn(
+        commandBuffer,
+        this->_staging_buffer.get(),
+        image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        1,
+        &copy
+    );
+
+    // each level is blitted from the one above, once that is written and made a transfer source
+    for (auto level = 1u; level < levels; ++level)
+    {
+        barrier = level_barrier(image, level - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+        cmdPipelineBarrierFn(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &barrier
+        );
+
+        ::VkImageBlit region;
+        memset(&region, 0, sizeof(region));
+        region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.srcSubresource.mipLevel = level - 1;
+        region.srcSubresource.layerCount = 1;
+        region.srcOffsets[1].x = static_cast<int32_t>(std::max(1u, width >> (level - 1)));
+        region.srcOffsets[1].y = static_cast<int32_t>(std::max(1u, height >> (level - 1)));
+        region.srcOffsets[1].z = 1;
+        region.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.dstSubresource.mipLevel = level;
+        region.dstSubresource.layerCount = 1;
+        region.dstOffsets[1].x = static_cast<int32_t>(std::max(1u, width >> level));
+        region.dstOffsets[1].y = static_cast<int32_t>(std::max(1u, height >> level));
+        region.dstOffsets[1].z = 1;
+        cmdBlitImageFn(
+            commandBuffer,
+            image,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1,
+            &region,
+            VK_FILTER_LINEAR
+        );
+    }
+
+    // the levels blitted from are transfer sources, the last is still a destination; all are then sampled,
+    // by anything later submitted to the queue
+    ::VkImageMemoryBarrier readBarriers[2];
+    uint32_t numReadBarriers = 0;
+    if (levels > 1)
+    {
+        readBarriers[numReadBarriers++] = level_barrier(image, 0, levels - 1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT);
+    }
+    readBarriers[numReadBarriers++] = level_barrier(image, levels - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+    cmdPipelineBarrierFn(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        0,
+        0, nullptr,
+        0, nullptr,
+        numReadBarriers, readBarriers
+    );
+
+    entry.texture.image = image;
+    entry.texture.view = view;
+    entry.texture.width = width;
+    entry.texture.height = height;
+    entry.texture.levels = levels;
+    this->_textures.push_back(std::move(entry));
+    this->_uploaded_bytes += size;
+
+    const auto index = static_cast<uint32_t>(this->_textures.size() - 1);
+    Log().get() << "Texture " << index << ": " << width << "x" << height << ", " << levels << " levels" << std::endl;
+    return index;
+}
+
+void
+TextureCache::flush()
+{
+    if (VK_NULL_HANDLE == this->_recording)
+    {
+        return;
+    }
+    auto device = this->_device;
+
+    // host writes are made visible to the device by the submission, once flushed from non-coherent memory
+    std::vector<::VkMappedMemoryRange> ranges;
+    for (const auto &staged : this->_staging_ranges)
+    {
+        if ((0 != staged.value) || this->_staging_coherent)
+        {
+            continue;
+        }
+        ::VkMappedMemoryRange range;
+        memset(&range, 0, sizeof(range));
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.memory = this->_staging_memory.get();
+        range.offset = staged.start;
+        range.size = staged.end - staged.start;
+        ranges.push_back(range);
+    }
+    if (!ranges.empty())
+    {
+        auto flushMappedMemoryRangesFn = GETDFN(device, vkFlushMappedMemoryRanges);
+        VK_ERR_CHECK_QUIET(flushMappedMemoryRangesFn(
+            device,
+            static_cast<uint32_t>(ranges.size()),
+            ranges.data()
+        ));
+    }
+
+    auto endCommandBufferFn = GETDFN(device, vkEndCommandBuffer);
+    VK_ERR_CHECK_QUIET(endCommandBufferFn(
+        this->_recording
+    ));
+    const auto value = this->_timeline.submit({ this->_recording }, {});
+    for (auto &staged : this->_staging_ranges)
+    {
+        if (0 == staged.value)
+        {
+            staged.value = value;
+        }
+    }
+    this->_submissions.push_back({ value, this->_recording });
+    this->_recording = VK_NULL_HANDLE;
+}
+
+const TextureCache::Texture &
+TextureCache::texture(
+    const uint32_t inIndex) const
+{
+    return this->_textures.at(inIndex).texture;
+}
+
+const ::VkSampler &
+TextureCache::sampler() const
+{
+    return this->_sampler_handle;
+}
+
+::VkDescriptorSet
+TextureCache::descriptor_set(
+    const uint32_t inIndex,
+    ::VkDescriptorSetLayout inSetLayout)
+{
+    if (this->_descriptor_sets >= this->_max_textures)
+    {
+        throw Exception("Texture cache has allocated all " + std::to_string(this->_max_textures) + " of its descriptor sets");
+    }
+    auto device = this->_device;
+    const auto &texture = this->texture(inIndex);
+
+    ::VkDescriptorSetAllocateInfo setInfo;
+    memset(&setInfo, 0, sizeof(setInfo));
+    setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setInfo.descriptorPool = this->_descriptor_pool.get();
+    setInfo.descriptorSetCount = 1;
+    setInfo.pSetLayouts = &inSetLayout;
+    auto allocateDescriptorSetsFn = GETDFN(device, vkAllocateDescriptorSets);
+    ::VkDescriptorSet descriptorSet;
+    VK_ERR_CHECK_QUIET(allocateDescriptorSetsFn(
+        device,
+        &setInfo,
+        &descriptorSet
+    ));
+    ++this->_descriptor_sets;
+
+    // the sampler is immutable in the layout, so only the image is written
+    ::VkDescriptorImageInfo imageInfo;
+    memset(&imageInfo, 0, sizeof(imageInfo));
+    imageInfo.imageView = texture.view;
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    ::VkWriteDescriptorSet write;
+    memset(&write, 0, sizeof(write));
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptorSet;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &imageInfo;
+    auto updateDescriptorSetsFn = GETDFN(device, vkUpdateDescriptorSets);
+    updateDescriptorSetsFn(device, 1, &write, 0, nullptr);
+    return descriptorSet;
+}
+
+void
+TextureCache::bind_image_memory(
+    ::VkImage inImage)
+{
+    auto device = this->_device;
+    auto getImageMemoryRequirementsFn = GETDFN(device, vkGetImageMemoryRequirements);
+    ::VkMemoryRequirements requirements;
+    getImageMemoryRequirementsFn(
+        device,
+        inImage,
+        &requirements
+    );
+
+    // blocks hold only optimally tiled images, so bufferImageGranularity does not separate them
+    Block *chosen = nullptr;
+    ::VkDeviceSize offset = 0;
+    for (auto &block : this->_blocks)
+    {
+        const auto start = align_up(block.used, requirements.alignment);
+        if ((requirements.memoryTypeBits & (1u << block.memory_type)) && (start + requirements.size <= block.size))
+        {
+            chosen = &block;
+            offset = start;
+            break;
+        }
+    }
+    if (nullptr == chosen)
+    {
+        auto memory_type = this->find_memory_type(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (std::numeric_limits<uint32_t>::max() == memory_type)
+        {
+            memory_type = this->find_memory_type(requirements.memoryTypeBits, 0);
+        }
+        if (std::numeric_limits<uint32_t>::max() == memory_type)
+        {
+            throw Exception("No memory type suitable for textures");
+        }
+
+        ::VkMemoryAllocateInfo allocateInfo;
+        memset(&allocateInfo, 0, sizeof(allocateInfo));
+        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocateInfo.allocationSize = std::max(IMAGE_BLOCK_SIZE, requirements.size);
+        allocateInfo.memoryTypeIndex = memory_type;
+
+        auto allocateMemoryFn = GETDFN(device, vkAllocateMemory);
+        ::VkDeviceMemory memory;
+        VK_ERR_CHECK(allocateMemoryFn(
+            device,
+            &allocateInfo,
+            this->_dispatch.allocator,
+            &memory
+        ));
+
+        Block block;
+        block.memory = { this->_dispatch, memory };
+        block.memory_type = memory_type;
+        block.size = allocateInfo.allocationSize;
+        this->_blocks.push_back(std::move(block));
+        chosen = &this->_blocks.back();
+        offset = 0;
+        Log().get() << "Texture cache: block " << (this->_blocks.size() - 1) << " of " << chosen->size << " bytes in memory type " << memory_type << std::endl;
+    }
+
+    auto bindImageMemoryFn = GETDFN(device, vkBindImageMemory);
+    VK_ERR_CHECK_QUIET(bindImageMemoryFn(
+        device,
+        inImage,
+        chosen->memory.get(),
+        offset
+    ));
+    chosen->used = offset + requirements.size;
+}
+
+uint32_t
+TextureCache::find_memory_type(
+    const uint32_t inTypeBits,
+    const ::VkMemoryPropertyFlags inProperties) const
+{
+    for (auto i = 0u; i < this->_memory_properties.memoryTypeCount; ++i)
+    {
+        if ((inTypeBits & (1u << i)) && (inProperties == (this->_memory_properties.memoryTypes[i].propertyFlags & inProperties)))
+        {
+            return i;
+        }
+    }
+    return std::numeric_limits<uint32_t>::max();
+}
+
+::VkDeviceSize
+TextureCache::allocate_staging(
+    const ::VkDeviceSize inSize)
+{
+    const auto size = align_up(inSize, this->_staging_alignment);
+    auto start = this->_staging_head;
+    if (start + size > this->_staging_size)
+    {
+        start = 0;
+    }
+    const auto end = start + size;
+
+    // ranges are allocated in ring order, so the oldest is released first until none overlap
+    for (;;)
+    {
+        const auto overlaps = std::any_of(this->_staging_ranges.begin(), this->_staging_ranges.end(), [start, end](const StagingRange &inRange)
+        {
+            return (inRange.start < end) && (start < inRange.end);
+        });
+        if (!overlaps)
+        {
+            break;
+        }
+        if (0 == this->_staging_ranges.front().value)
+        {
+            this->flush();
+        }
+        this->_timeline.wait(this->_staging_ranges.front().value);
+        this->_staging_ranges.pop_front();
+    }
+    this->collect();
+
+    this->_staging_ranges.push_back({ start, end, 0 });
+    this->_staging_head = end;
+    return start;
+}
+
+void
+TextureCache::collect()
+{
+    const auto completed = this->_timeline.completed();
+    while (!this->_staging_ranges.empty() && (0 != this->_staging_ranges.front().value) && (this->_staging_ranges.front().value <= completed))
+    {
+        this->_staging_ranges.pop_front();
+    }
+    auto freeCommandBuffersFn = GETDFN(this->_device, vkFreeCommandBuffers);
+    while (!this->_submissions.empty() && (this->_submissions.front().value <= completed))
+    {
+        freeCommandBuffersFn(
+            this->_device,
+            this->_command_pool.get(),
+            1,
+            &this->_submissions.front().command_buffer
+        );
+        this->_submissions.pop_front();
+    }
+}
+
+::VkCommandBuffer
+TextureCache::recording_command_buffer()
+{
+    if (VK_NULL_HANDLE != this->_recording)
+    {
+        return this->_recording;
+    }
+    auto device = this->_device;
+
+    ::VkCommandBufferAllocateInfo allocInfo;
+    memset(&allocInfo, 0, sizeof(allocInfo));
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = this->_command_pool.get();
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+    auto allocateCommandBuffersFn = GETDFN(device, vkAllocateCommandBuffers);
+    VK_ERR_CHECK_QUIET(allocateCommandBuffersFn(
+        device,
+        &allocInfo,
+        &this->_recording
+    ));
+
+    ::VkCommandBufferBeginInfo beginInfo;
+    memset(&beginInfo, 0, sizeof(beginInfo));
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    auto beginCommandBufferFn = GETDFN(device, vkBeginCommandBuffer);
+    VK_ERR_CHECK_QUIET(beginCommandBufferFn(
+        this->_recording,
+        &beginInfo
+    ));
+    return this->_recording;
+}
@@ -0,0 +1,198 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_TEXTURECACHE_H
+#define VULKAN_RENDERER_TEXTURECACHE_H
+
+#include "timeline.h"
+#include "uniquehandle.h"
+#include "vulkan/vulkan.h"
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+struct TextureHeader;
+
+// sampled textures, in the RGBA8 payloads that textureprocessor sends to rendertexture, so that either renderer
+// ingests the same data
+// images are placed in large device local blocks of memory, rather than an allocation each, and are uploaded
+// from a host visible staging ring that is mapped for its lifetime, whose space is reused once the submission
+// reading it completes
+// mip chains are generated on the GPU by blitting each level from the one above, where the format supports
+// linear blits; otherwise textures have a single level
+// every texture is sampled through one sampler, intended to be immutable in the descriptor set layouts
+// uploads are recorded into a command buffer of the queue that samples them, ordered before later submissions
+// to it by barriers, so no semaphore is needed
+// all functions are to be called from a single thread, which submits to the queue
+class TextureCache
+{
+public:
+    struct Texture
+    {
+        ::VkImage     image = VK_NULL_HANDLE;
+        ::VkImageView view = VK_NULL_HANDLE;
+        uint32_t      width = 0;
+        uint32_t      height = 0;
+        uint32_t      levels = 0;
+    };
+
+    // inFormatProperties are those of VK_FORMAT_R8G8B8A8_UNORM; inQueue must support graphics, for blits
+    // inStagingSize is the most bytes of payload uploaded by a single submission
+    // inMaxTextures is the most descriptor sets that will be allocated
+    TextureCache(
+        const DeviceDispatch &inDispatch,
+        const ::VkPhysicalDeviceMemoryProperties &inMemoryProperties,
+        const ::VkPhysicalDeviceLimits &inLimits,
+        const ::VkFormatProperties &inFormatProperties,
+        const uint32_t inQueueFamily,
+        ::VkQueue inQueue,
+        const ::VkDeviceSize inStagingSize,
+        const uint32_t inMaxTextures);
+
+    // waits for outstanding uploads
+    ~TextureCache();
+
+    TextureCache(const TextureCache &) = delete;
+    TextureCache &operator=(const TextureCache &) = delete;
+
+    // copies the mu32TotalTextureDataSize bytes at inHeader.mpData into the staging ring, and records their upload
+    // and mip generation, returning the index of the texture; it may be sampled by anything submitted after flush
+    // blocks if the staging ring is full until earlier uploads complete
+    // throws Exception if the payload is not mu32Width * mu32Height RGBA8 texels, or cannot fit in the staging ring
+    uint32_t
+    upload(
+        const TextureHeader &inHeader);
+
+    // submits the uploads recorded since the last flush
+    void
+    flush();
+
+    const Texture &
+    texture(
+        const uint32_t inIndex) const;
+
+    // shared by every texture; its address is stable, for VkDescriptorSetLayoutBinding::pImmutableSamplers
+    const ::VkSampler &
+    sampler() const;
+
+    // a descriptor set of inSetLayout, whose binding 0 is a combined image sampler with an immutable sampler,
+    // bound to texture inIndex; freed with the cache
+    ::VkDescriptorSet
+    descriptor_set(
+        const uint32_t inIndex,
+        ::VkDescriptorSetLayout inSetLayout);
+
+private:
+    // a device memory allocation from which images are sub-allocated in turn
+    struct Block
+    {
+        UniqueHandle<::VkDeviceMemory> memory;
+        uint32_t                       memory_type = 0;
+        ::VkDeviceSize                 size = 0;
+        ::VkDeviceSize                 used = 0;
+    };
+
+    // declared such that the view is destroyed before the image
+    struct Entry
+    {
+        UniqueHandle<::VkImage>     image;
+        UniqueHandle<::VkImageView> view;
+        Texture                     texture;
+    };
+
+    // bytes of the staging ring read by a submission; its timeline value is 0 until flushed
+    struct StagingRange
+    {
+        ::VkDeviceSize start;
+        ::VkDeviceSize end;
+        uint64_t       value;
+    };
+
+    struct Submission
+    {
+        uint64_t          value;
+        ::VkCommandBuffer command_buffer;
+    };
+
+    // binds inImage to memory of a block, allocating a block if none has room
+    void
+    bind_image_memory(
+        ::VkImage inImage);
+
+    uint32_t
+    find_memory_type(
+        const uint32_t inTypeBits,
+        const ::VkMemoryPropertyFlags inProperties) const;
+
+    // inSize aligned bytes of the staging ring, waiting for the uploads using them to complete
+    ::VkDeviceSize
+    allocate_staging(
+        const ::VkDeviceSize inSize);
+
+    // frees the command buffers of completed submissions
+    void
+    collect();
+
+    // the command buffer into which uploads are recorded until the next flush
+    ::VkCommandBuffer
+    recording_command_buffer();
+
+    const DeviceDispatch              &_dispatch;
+    ::VkDevice                         _device;
+    ::VkPhysicalDeviceMemoryProperties _memory_properties;
+    uint32_t                           _max_dimension;
+    bool                               _generate_mips = false;
+    // the staging buffer is destroyed before its memory is freed; freeing it implicitly unmaps it
+    UniqueHandle<::VkDeviceMemory>     _staging_memory;
+    UniqueHandle<::VkBuffer>           _staging_buffer;
+    char                              *_staging_mapped = nullptr;
+    ::VkDeviceSize                     _staging_size;
+    ::VkDeviceSize                     _staging_alignment;
+    ::VkDeviceSize                     _staging_atom;
+    bool                               _staging_coherent = false;
+    ::VkDeviceSize                     _staging_head = 0;
+    std::deque<StagingRange>           _staging_ranges; // in the order allocated
+    UniqueHandle<::VkSampler>          _sampler;
+    ::VkSampler                        _sampler_handle = VK_NULL_HANDLE; // of _sampler, at an address that is kept
+    UniqueHandle<::VkDescriptorPool>   _descriptor_pool;
+    uint32_t                           _max_textures;
+    uint32_t                           _descriptor_sets = 0;
+    // declared such that images are destroyed before the blocks they are bound to are freed
+    std::vector<Block>                 _blocks;
+    std::vector<Entry>                 _textures;
+    UniqueHandle<::VkCommandPool>      _command_pool;
+    ::VkCommandBuffer                  _recording = VK_NULL_HANDLE;
+    std::deque<Submission>             _submissions;
+    uint64_t                           _uploaded_bytes = 0;
+    // declared last, so that outstanding uploads complete before anything they use is destroyed
+    Timeline                           _timeline;
+};
+
+#endif // VULKAN_RENDERER_TEXTURECACHE_H
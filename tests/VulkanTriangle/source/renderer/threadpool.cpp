@@ -0,0 +1,164 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "threadpool.h"
+
+#include <algorithm>
+#include <atomic>
+
+ThreadPool::ThreadPool(
+    const uint32_t inNumThreads)
+{
+    for (auto i = 0u; i < inNumThreads; ++i)
+    {
+        this->_threads.emplace_back(&ThreadPool::worker_main, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_quit = true;
+    }
+    this->_task_available.notify_all();
+    for (auto &thread : this->_threads)
+    {
+        thread.join();
+    }
+}
+
+uint32_t
+ThreadPool::num_threads() const
+{
+    return static_cast<uint32_t>(this->_threads.size());
+}
+
+void
+ThreadPool::submit(
+    Task inTask)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_tasks.push_back(std::move(inTask));
+    }
+    this->_task_available.notify_one();
+}
+
+void
+ThreadPool::parallel_for(
+    const uint32_t inCount,
+    const std::function<void(uint32_t)> &inTask)
+{
+    if (0 == inCount)
+    {
+        return;
+    }
+
+    // shared with the helper tasks, and outlives them, as this function does not
+    // return until every helper has finished with it
+    struct Batch
+    {
+        std::atomic<uint32_t>   next_index;
+        uint32_t                active_helpers;
+        std::mutex              mutex;
+        std::condition_variable done;
+        std::exception_ptr      error;
+    } batch;
+    batch.next_index = 0;
+
+    // indices are claimed rather than pre-assigned, so that a busy or late worker
+    // does not hold up the batch
+    auto drain = [&batch, &inTask, inCount]()
+    {
+        for (;;)
+        {
+            const auto index = batch.next_index.fetch_add(1);
+            if (index >= inCount)
+            {
+                return;
+            }
+            try
+            {
+                inTask(index);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(batch.mutex);
+                if (!batch.error)
+                {
+                    batch.error = std::current_exception();
+                }
+            }
+        }
+    };
+
+    const auto num_helpers = std::min(this->num_threads(), inCount - 1);
+    batch.active_helpers = num_helpers;
+    for (auto i = 0u; i < num_helpers; ++i)
+    {
+        this->submit([&batch, &drain]()
+        {
+            drain();
+            std::lock_guard<std::mutex> lock(batch.mutex);
+            if (0 == --batch.active_helpers)
+            {
+                batch.done.notify_one();
+            }
+        });
+    }
+    drain();
+
+    std::unique_lock<std::mutex> lock(batch.mutex);
+    batch.done.wait(lock, [&batch]() { return 0 == batch.active_helpers; });
+    if (batch.error)
+    {
+        std::rethrow_exception(batch.error);
+    }
+}
+
+void
+ThreadPool::worker_main()
+{
+    for (;;)
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(this->_mutex);
+            this->_task_available.wait(lock, [this]() { return this->_quit || !this->_tasks.empty(); });
+            if (this->_tasks.empty())
+            {
+                return; // quitting, and nothing left to do
+            }
+            task = std::move(this->_tasks.front());
+            this->_tasks.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,242 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "timeline.h"
+#include "impl.h"
+#include "log.h"
+
+#include <cstring>
+#include <limits>
+
+Timeline::Timeline(
+    const DeviceDispatch &inDispatch,
+    ::VkQueue inQueue)
+    :
+    _dispatch(inDispatch),
+    _device(inDispatch.device),
+    _queue(inQueue)
+{}
+
+Timeline::~Timeline()
+{
+    std::vector<::VkFence> fences;
+    for (const auto &point : this->_pending)
+    {
+        fences.push_back(point.fence.get());
+    }
+    if (!fences.empty())
+    {
+        auto waitForFencesFn = GETDFN(this->_device, vkWaitForFences);
+        VK_ERR_CHECK(waitForFencesFn(
+            this->_device,
+            static_cast<uint32_t>(fences.size()),
+            fences.data(),
+            VK_TRUE,
+            std::numeric_limits<uint64_t>::max()
+        ));
+    }
+    Log().get() << "Timeline: " << this->_submitted << " submissions" << std::endl;
+}
+
+uint64_t
+Timeline::submit(
+    const std::vector<::VkCommandBuffer> &inCommandBuffers,
+    const std::vector<Wait> &inWaits)
+{
+    Point point;
+    std::vector<::VkSemaphore> waitSemaphores;
+    std::vector<::VkPipelineStageFlags> waitStages;
+    for (const auto &wait : inWaits)
+    {
+        auto semaphore = wait.timeline->consume(wait.value);
+        if (!semaphore)
+        {
+            continue;
+        }
+        waitSemaphores.push_back(semaphore.get());
+        waitStages.push_back(wait.stage);
+        point.waited.push_back(std::move(semaphore));
+    }
+    point.value = this->_submitted + 1;
+    point.semaphore = this->acquire_semaphore();
+    point.fence = this->acquire_fence();
+    ::VkSemaphore signalSemaphore = point.semaphore.get();
+
+    ::VkSubmitInfo submitInfo;
+    memset(&submitInfo, 0, sizeof(submitInfo));
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+    submitInfo.pWaitSemaphores = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
+    submitInfo.commandBufferCount = static_cast<uint32_t>(inCommandBuffers.size());
+    submitInfo.pCommandBuffers = inCommandBuffers.data();
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &signalSemaphore;
+
+    auto queueSubmitFn = GETDFN(this->_device, vkQueueSubmit);
+    VK_ERR_CHECK_QUIET(queueSubmitFn(
+        this->_queue,
+        1,
+        &submitInfo,
+        point.fence.get()
+    ));
+    this->_submitted = point.value;
+    this->_pending.push_back(std::move(point));
+    return this->_submitted;
+}
+
+uint64_t
+Timeline::completed()
+{
+    auto getFenceStatusFn = GETDFN(this->_device, vkGetFenceStatus);
+    auto resetFencesFn = GETDFN(this->_device, vkResetFences);
+    while (!this->_pending.empty())
+    {
+        auto &point = this->_pending.front();
+        if (VK_SUCCESS != getFenceStatusFn(this->_device, point.fence.get()))
+        {
+            break;
+        }
+        // the submission's waits are complete, so its consumed semaphores are unsignalled and reusable
+        // whereas a semaphore that nothing waited on remains signalled, and can only be destroyed
+        for (auto &semaphore : point.waited)
+        {
+            this->_free_semaphores.push_back(std::move(semaphore));
+        }
+        auto fence = point.fence.get();
+        VK_ERR_CHECK_QUIET(resetFencesFn(
+            this->_device,
+            1,
+            &fence
+        ));
+        this->_free_fences.push_back(std::move(point.fence));
+        this->_completed = point.value;
+        this->_pending.pop_front();
+    }
+    return this->_completed;
+}
+
+void
+Timeline::wait(
+    const uint64_t inValue)
+{
+    if (inValue <= this->completed())
+    {
+        return;
+    }
+    for (const auto &point : this->_pending)
+    {
+        if (point.value < inValue)
+        {
+            continue;
+        }
+        auto fence = point.fence.get();
+        auto waitForFencesFn = GETDFN(this->_device, vkWaitForFences);
+        VK_ERR_CHECK_QUIET(waitForFencesFn(
+            this->_device,
+            1,
+            &fence,
+            VK_TRUE,
+            std::numeric_limits<uint64_t>::max()
+        ));
+        break;
+    }
+    this->completed();
+}
+
+Timeline::UniqueSemaphore
+Timeline::consume(
+    const uint64_t inValue)
+{
+    if (inValue <= this->completed())
+    {
+        return UniqueSemaphore();
+    }
+    // any later point implies this one, as its signal covers every earlier submission
+    for (auto &point : this->_pending)
+    {
+        if ((point.value >= inValue) && point.semaphore)
+        {
+            return std::move(point.semaphore);
+        }
+    }
+    // every semaphore from inValue onwards has been consumed, so signal a new one after them
+    this->submit(std::vector<::VkCommandBuffer>(), std::vector<Wait>());
+    return std::move(this->_pending.back().semaphore);
+}
+
+Timeline::UniqueSemaphore
+Timeline::acquire_semaphore()
+{
+    if (!this->_free_semaphores.empty())
+    {
+        auto semaphore = std::move(this->_free_semaphores.back());
+        this->_free_semaphores.pop_back();
+        return semaphore;
+    }
+    auto device = this->_device;
+    ::VkSemaphoreCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+    createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    auto createSemaphoreFn = GETDFN(device, vkCreateSemaphore);
+    ::VkSemaphore semaphore;
+    VK_ERR_CHECK(createSemaphoreFn(
+        device,
+        &createInfo,
+        this->_dispatch.allocator,
+        &semaphore
+    ));
+    return UniqueSemaphore(this->_dispatch, semaphore);
+}
+
+Timeline::UniqueFence
+Timeline::acquire_fence()
+{
+    if (!this->_free_fences.empty())
+    {
+        auto fence = std::move(this->_free_fences.back());
+        this->_free_fences.pop_back();
+        return fence;
+    }
+    auto device = this->_device;
+    ::VkFenceCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+    createInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    auto createFenceFn = GETDFN(device, vkCreateFence);
+    ::VkFence fence;
+    VK_ERR_CHECK(createFenceFn(
+        device,
+        &createInfo,
+        this->_dispatch.allocator,
+        &fence
+    ));
+    return UniqueFence(this->_dispatch, fence);
+}
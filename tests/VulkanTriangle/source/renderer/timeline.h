@@ -0,0 +1,115 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_TIMELINE_H
+#define VULKAN_RENDERER_TIMELINE_H
+
+#include "uniquehandle.h"
+#include "vulkan/vulkan.h"
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// a timeline semaphore, emulated on Vulkan 1.0 for a single queue
+// each submission through the timeline signals the next value, with a binary semaphore for device waits and
+// a fence for host waits; values are reached in order, since the signal operations of a submission cover
+// every earlier submission to the queue
+// a device wait on a value consumes a semaphore signalled at or after it, which is reclaimed once the waiting
+// submission has completed
+// all functions are to be called from a single thread
+class Timeline
+{
+public:
+    struct Wait
+    {
+        Timeline               *timeline;
+        uint64_t                value;
+        ::VkPipelineStageFlags  stage;
+    };
+
+    Timeline(
+        const DeviceDispatch &inDispatch,
+        ::VkQueue inQueue);
+
+    // waits for every submission, so that no semaphore or fence is destroyed in use
+    ~Timeline();
+
+    Timeline(const Timeline &) = delete;
+    Timeline &operator=(const Timeline &) = delete;
+
+    // submits inCommandBuffers to execute once every wait is reached, returning the value reached on completion
+    uint64_t
+    submit(
+        const std::vector<::VkCommandBuffer> &inCommandBuffers,
+        const std::vector<Wait> &inWaits);
+
+    // the highest value reached, without blocking
+    uint64_t
+    completed();
+
+    // blocks until inValue is reached
+    void
+    wait(
+        const uint64_t inValue);
+
+private:
+    typedef UniqueHandle<::VkSemaphore> UniqueSemaphore;
+    typedef UniqueHandle<::VkFence>     UniqueFence;
+
+    struct Point
+    {
+        uint64_t                     value;
+        UniqueSemaphore              semaphore; // null once consumed by a device wait
+        UniqueFence                  fence;
+        std::vector<UniqueSemaphore> waited;    // consumed by this submission, unsignalled once it completes
+    };
+
+    // a semaphore signalled at or after inValue, for a single device wait; null if inValue is already reached
+    UniqueSemaphore
+    consume(
+        const uint64_t inValue);
+
+    UniqueSemaphore
+    acquire_semaphore();
+
+    UniqueFence
+    acquire_fence();
+
+    const DeviceDispatch        &_dispatch;
+    ::VkDevice                   _device;
+    ::VkQueue                    _queue;
+    uint64_t                     _submitted = 0;
+    uint64_t                     _completed = 0;
+    std::vector<UniqueSemaphore> _free_semaphores;
+    std::vector<UniqueFence>     _free_fences;
+    std::deque<Point>            _pending;
+};
+
+#endif // VULKAN_RENDERER_TIMELINE_H
@@ -0,0 +1,364 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "uniformring.h"
+#include "impl.h"
+#include "layoutcache.h"
+#include "framecapture.h"
+#include "exception.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace
+{
+
+::VkDeviceSize
+align_up(
+    const ::VkDeviceSize inSize,
+    const ::VkDeviceSize inAlignment)
+{
+    return (inSize + inAlignment - 1) / inAlignment * inAlignment;
+}
+
+} // anonymous namespace
+
+UniformRing::UniformRing(
+    const DeviceDispatch &inDispatch,
+    const ::VkPhysicalDeviceMemoryProperties &inMemoryProperties,
+    const ::VkPhysicalDeviceLimits &inLimits,
+    const uint32_t inNumFrames,
+    const ::VkDeviceSize inBytesPerFrame,
+    LayoutCache &inLayoutCache,
+    const std::vector<::VkDescriptorSetLayoutBinding> &inBindings,
+    const std::vector<::VkDeviceSize> &inBindingRanges,
+    FrameCapture *inCapture)
+    :
+    _dispatch(inDispatch),
+    _device(inDispatch.device),
+    _capture(inCapture),
+    _num_frames(inNumFrames),
+    // both limits are powers of two, so the larger satisfies dynamic offsets and flushes of non-coherent memory alike
+    _alignment(std::max(inLimits.minUniformBufferOffsetAlignment, inLimits.nonCoherentAtomSize)),
+    _region_size(align_up(std::max<::VkDeviceSize>(inBytesPerFrame, 1), _alignment)),
+    _head(0)
+{
+    auto device = this->_device;
+    const auto buffer_size = this->_region_size * (inNumFrames + 1);
+    if (buffer_size > std::numeric_limits<uint32_t>::max())
+    {
+        throw Exception("Uniform ring of " + std::to_string(buffer_size) + " bytes cannot be addressed by dynamic offsets");
+    }
+    if (inBindings.size() != inBindingRanges.size())
+    {
+        throw Exception("Uniform ring requires a range for each of its " + std::to_string(inBindings.size()) + " bindings");
+    }
+    for (const auto range : inBindingRanges)
+    {
+        if (range > inLimits.maxUniformBufferRange)
+        {
+            throw Exception("Uniform block of " + std::to_string(range) + " bytes exceeds the device's maximum uniform buffer range");
+        }
+    }
+
+    ::VkBufferCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+    createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    createInfo.size = buffer_size;
+    createInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    auto createBufferFn = GETDFN(device, vkCreateBuffer);
+    ::VkBuffer buffer;
+    VK_ERR_CHECK(createBufferFn(
+        device,
+        &createInfo,
+        this->_dispatch.allocator,
+        &buffer
+    ));
+    this->_buffer.buffer = { this->_dispatch, buffer };
+
+    auto getBufferMemoryRequirementsFn = GETDFN(device, vkGetBufferMemoryRequirements);
+    ::VkMemoryRequirements requirements;
+    getBufferMemoryRequirementsFn(
+        device,
+        buffer,
+        &requirements
+    );
+
+    // host visible device local memory (e.g. resizable BAR, or unified memory) is read by the GPU without crossing
+    // the bus, and coherent memory needs no flushes; either is preferred, though neither is required
+    const ::VkMemoryPropertyFlags preferences[] =
+    {
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+    };
+    auto memory_type = std::numeric_limits<uint32_t>::max();
+    for (const auto properties : preferences)
+    {
+        for (auto i = 0u; i < inMemoryProperties.memoryTypeCount; ++i)
+        {
+            if ((requirements.memoryTypeBits & (1u << i)) && (properties == (inMemoryProperties.memoryTypes[i].propertyFlags & properties)))
+            {
+                memory_type = i;
+                break;
+            }
+        }
+        if (std::numeric_limits<uint32_t>::max() != memory_type)
+        {
+            break;
+        }
+    }
+    if (std::numeric_limits<uint32_t>::max() == memory_type)
+    {
+        throw Exception("No host visible memory type suitable for the uniform ring");
+    }
+    const auto memory_flags = inMemoryProperties.memoryTypes[memory_type].propertyFlags;
+    this->_coherent = (0 != (memory_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+
+    ::VkMemoryAllocateInfo allocateInfo;
+    memset(&allocateInfo, 0, sizeof(allocateInfo));
+    allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize = requirements.size;
+    allocateInfo.memoryTypeIndex = memory_type;
+
+    auto allocateMemoryFn = GETDFN(device, vkAllocateMemory);
+    ::VkDeviceMemory memory;
+    VK_ERR_CHECK(allocateMemoryFn(
+        device,
+        &allocateInfo,
+        this->_dispatch.allocator,
+        &memory
+    ));
+    this->_buffer.memory = { this->_dispatch, memory };
+
+    auto bindBufferMemoryFn = GETDFN(device, vkBindBufferMemory);
+    VK_ERR_CHECK(bindBufferMemoryFn(
+        device,
+        buffer,
+        memory,
+        0
+    ));
+
+    // mapped once, and left mapped; freeing the memory implicitly unmaps it
+    auto mapMemoryFn = GETDFN(device, vkMapMemory);
+    void *mapped = nullptr;
+    VK_ERR_CHECK(mapMemoryFn(
+        device,
+        memory,
+        0,
+        VK_WHOLE_SIZE,
+        0,
+        &mapped
+    ));
+    this->_mapped = static_cast<char *>(mapped);
+
+    ::VkDescriptorPoolSize poolSize;
+    poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    poolSize.descriptorCount = static_cast<uint32_t>(inBindingRanges.size());
+    ::VkDescriptorPoolCreateInfo poolInfo;
+    memset(&poolInfo, 0, sizeof(poolInfo));
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    auto createDescriptorPoolFn = GETDFN(device, vkCreateDescriptorPool);
+    ::VkDescriptorPool descriptorPool;
+    VK_ERR_CHECK(createDescriptorPoolFn(
+        device,
+        &poolInfo,
+        this->_dispatch.allocator,
+        &descriptorPool
+    ));
+    this->_descriptor_pool = { this->_dispatch, descriptorPool };
+
+    ::VkDescriptorSetAllocateInfo setInfo;
+    memset(&setInfo, 0, sizeof(setInfo));
+    setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setInfo.descriptorPool = descriptorPool;
+    setInfo.descriptorSetCount = 1;
+    auto setLayout = inLayoutCache.descriptor_set_layout(inBindings);
+    setInfo.pSetLayouts = &setLayout;
+    auto allocateDescriptorSetsFn = GETDFN(device, vkAllocateDescriptorSets);
+    VK_ERR_CHECK(allocateDescriptorSetsFn(
+        device,
+        &setInfo,
+        &this->_descriptor_set
+    ));
+
+    // the only descriptor writes the ring ever needs; each binding's window is moved by its dynamic offset
+    std::vector<::VkDescriptorBufferInfo> bufferInfos(inBindingRanges.size());
+    std::vector<::VkWriteDescriptorSet> writes(inBindingRanges.size());
+    for (auto i = 0u; i < inBindingRanges.size(); ++i)
+    {
+        memset(&bufferInfos[i], 0, sizeof(bufferInfos[i]));
+        bufferInfos[i].buffer = buffer;
+        bufferInfos[i].offset = 0;
+        bufferInfos[i].range = inBindingRanges[i];
+
+        memset(&writes[i], 0, sizeof(writes[i]));
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = this->_descriptor_set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        writes[i].pBufferInfo = &bufferInfos[i];
+    }
+    auto updateDescriptorSetsFn = GETDFN(device, vkUpdateDescriptorSets);
+    updateDescriptorSetsFn(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+    if (nullptr != this->_capture)
+    {
+        this->_capture->buffer(buffer, buffer_size, createInfo.usage, nullptr);
+        this->_capture->descriptor_set(this->_descriptor_set, inBindings, writes);
+    }
+
+    Log().get() << "Uniform ring: " << (inNumFrames + 1) << " regions of " << this->_region_size << " bytes, aligned to " << this->_alignment << " bytes, in " << (this->_coherent ? "coherent" : "non-coherent") << " memory type " << memory_type << std::endl;
+}
+
+UniformRing::~UniformRing()
+{
+    Log().get() << "Uniform ring: peak of " << this->_peak << " of " << this->_region_size << " bytes used by a frame" << std::endl;
+}
+
+void
+UniformRing::begin_frame(
+    const uint32_t inFrame)
+{
+    assert(inFrame <= this->_num_frames);
+    this->_frame = inFrame;
+    this->_head.store(this->_retained, std::memory_order_relaxed);
+}
+
+void
+UniformRing::set_retained_size(
+    const ::VkDeviceSize inBytes)
+{
+    const auto retained = this->aligned_size(inBytes);
+    if (retained >= this->_region_size)
+    {
+        throw Exception("Cannot retain " + std::to_string(inBytes) + " bytes of a uniform ring region of " + std::to_string(this->_region_size) + " bytes");
+    }
+    this->_retained = retained;
+}
+
+UniformRing::Allocation
+UniformRing::retained(
+    const ::VkDeviceSize inOffset) const
+{
+    assert(inOffset < this->_retained);
+    assert(0 == inOffset % this->_alignment);
+    const auto offset = this->_frame * this->_region_size + inOffset;
+
+    Allocation allocation;
+    allocation.data = this->_mapped + offset;
+    allocation.offset = static_cast<uint32_t>(offset);
+    return allocation;
+}
+
+::VkDeviceSize
+UniformRing::aligned_size(
+    const ::VkDeviceSize inSize) const
+{
+    return align_up(inSize, this->_alignment);
+}
+
+uint32_t
+UniformRing::persistent_frame() const
+{
+    return this->_num_frames;
+}
+
+UniformRing::Allocation
+UniformRing::allocate(
+    const ::VkDeviceSize inSize)
+{
+    const auto size = align_up(inSize, this->_alignment);
+    // only commit allocations that fit, so the head never passes the region that flush() reads back
+    auto start = this->_head.load(std::memory_order_relaxed);
+    do
+    {
+        if (start + size > this->_region_size)
+        {
+            throw Exception("Uniform ring region of " + std::to_string(this->_region_size) + " bytes is exhausted");
+        }
+    }
+    while (!this->_head.compare_exchange_weak(start, start + size, std::memory_order_relaxed));
+    const auto offset = this->_frame * this->_region_size + start;
+
+    Allocation allocation;
+    allocation.data = this->_mapped + offset;
+    allocation.offset = static_cast<uint32_t>(offset);
+    return allocation;
+}
+
+void
+UniformRing::flush()
+{
+    const auto used = this->_head.load(std::memory_order_relaxed);
+    this->_peak = std::max(this->_peak, used);
+    if (0 == used)
+    {
+        return;
+    }
+    if (nullptr != this->_capture)
+    {
+        const auto start = this->_frame * this->_region_size;
+        this->_capture->buffer_data(this->_buffer.buffer.get(), start, used, this->_mapped + start);
+    }
+    if (this->_coherent)
+    {
+        return;
+    }
+
+    // from the start of the region, as the retained bytes may have been written too
+    // allocations are aligned to the atom size, so the range is too
+    ::VkMappedMemoryRange range;
+    memset(&range, 0, sizeof(range));
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.memory = this->_buffer.memory.get();
+    range.offset = this->_frame * this->_region_size;
+    range.size = used;
+    auto flushMappedMemoryRangesFn = GETDFN(this->_device, vkFlushMappedMemoryRanges);
+    VK_ERR_CHECK_QUIET(flushMappedMemoryRangesFn(
+        this->_device,
+        1,
+        &range
+    ));
+}
+
+::VkDescriptorSet
+UniformRing::descriptor_set() const
+{
+    return this->_descriptor_set;
+}
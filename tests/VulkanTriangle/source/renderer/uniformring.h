@@ -0,0 +1,144 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_UNIFORMRING_H
+#define VULKAN_RENDERER_UNIFORMRING_H
+
+#include "uniquehandle.h"
+#include "vulkan/vulkan.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// uniform data written by the host each frame, sub-allocated from one host visible buffer that is mapped for
+// its lifetime, with a region per frame in flight reused once that frame's fence has signalled
+// every binding of the descriptor set is a dynamic uniform buffer over the whole buffer, written once, so that
+// an allocation is bound by passing its offset to vkCmdBindDescriptorSets, rather than by a descriptor write
+// a further, persistent, region holds the data of command buffers recorded once and submitted many times
+// the start of each region may be retained from frame to frame, for data referenced by command buffers that are
+// re-recorded only when it changes
+class LayoutCache;
+class FrameCapture;
+
+class UniformRing
+{
+public:
+    struct Allocation
+    {
+        void     *data = nullptr;
+        uint32_t  offset = 0; // dynamic offset, from the start of the buffer
+    };
+
+    // inBindings are those of the descriptor set, numbered from 0, every one of which must be
+    // VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC; inBindingRanges is the size of the uniform block at each
+    // inCapture, if not nullptr, records the buffer, its descriptor set, and the host's writes to it
+    UniformRing(
+        const DeviceDispatch &inDispatch,
+        const ::VkPhysicalDeviceMemoryProperties &inMemoryProperties,
+        const ::VkPhysicalDeviceLimits &inLimits,
+        const uint32_t inNumFrames,
+        const ::VkDeviceSize inBytesPerFrame,
+        LayoutCache &inLayoutCache,
+        const std::vector<::VkDescriptorSetLayoutBinding> &inBindings,
+        const std::vector<::VkDeviceSize> &inBindingRanges,
+        FrameCapture *inCapture);
+    ~UniformRing();
+
+    UniformRing(const UniformRing &) = delete;
+    UniformRing &operator=(const UniformRing &) = delete;
+
+    // allocations are subsequently made from region inFrame, discarding everything previously allocated from it,
+    // but not its retained bytes
+    // the GPU must have finished with the region
+    void
+    begin_frame(
+        const uint32_t inFrame);
+
+    // the index of the region kept for command buffers that are recorded once
+    uint32_t
+    persistent_frame() const;
+
+    // aligned for use as a dynamic offset; the contents are undefined
+    // may be called from multiple threads
+    // throws Exception if the region is exhausted
+    Allocation
+    allocate(
+        const ::VkDeviceSize inSize);
+
+    // the first inBytes of every region are kept, rather than allocated from; takes effect from the next begin_frame
+    // throws Exception if that leaves nothing to allocate from
+    void
+    set_retained_size(
+        const ::VkDeviceSize inBytes);
+
+    // the retained bytes from inOffset of the current region, which must be aligned
+    Allocation
+    retained(
+        const ::VkDeviceSize inOffset) const;
+
+    // inSize rounded up to the alignment of every allocation
+    ::VkDeviceSize
+    aligned_size(
+        const ::VkDeviceSize inSize) const;
+
+    // makes the host writes to the current region visible to the device, if the memory is not coherent, and captures them
+    // to be called after the region's last allocation is written, and before submitting work reading it
+    void
+    flush();
+
+    ::VkDescriptorSet
+    descriptor_set() const;
+
+private:
+    // declared such that the buffer is destroyed before its memory is freed
+    struct Buffer
+    {
+        UniqueHandle<::VkDeviceMemory> memory;
+        UniqueHandle<::VkBuffer>       buffer;
+    };
+
+    const DeviceDispatch                &_dispatch;
+    ::VkDevice                           _device;
+    FrameCapture                        *_capture;
+    uint32_t                             _num_frames;
+    ::VkDeviceSize                       _alignment;
+    ::VkDeviceSize                       _region_size;
+    bool                                 _coherent = false;
+    Buffer                               _buffer;
+    char                                *_mapped = nullptr;
+    UniqueHandle<::VkDescriptorPool>     _descriptor_pool;
+    ::VkDescriptorSet                    _descriptor_set = VK_NULL_HANDLE; // freed with the pool
+    uint32_t                             _frame = 0;
+    ::VkDeviceSize                       _retained = 0;
+    std::atomic<::VkDeviceSize>          _head;  // bytes allocated from the current region
+    ::VkDeviceSize                       _peak = 0;
+};
+
+#endif // VULKAN_RENDERER_UNIFORMRING_H
@@ -0,0 +1,154 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_RENDERER_UNIQUEHANDLE_H
+#define VULKAN_RENDERER_UNIQUEHANDLE_H
+
+#include "devicedispatch.h"
+#include "vulkan/vulkan.h"
+
+// how each type of device object is destroyed, chosen at compile time
+template <typename Handle>
+struct DeviceHandleTraits;
+
+#define DEVICE_HANDLE_TRAITS(_handle, _destroy) \
+template <> \
+struct DeviceHandleTraits<_handle> \
+{ \
+    static void destroy(const DeviceDispatch &inDispatch, _handle inHandle) { inDispatch._destroy(inDispatch.device, inHandle, inDispatch.allocator); } \
+}
+
+DEVICE_HANDLE_TRAITS(::VkSemaphore, destroy_semaphore);
+DEVICE_HANDLE_TRAITS(::VkFence, destroy_fence);
+DEVICE_HANDLE_TRAITS(::VkImage, destroy_image);
+DEVICE_HANDLE_TRAITS(::VkImageView, destroy_image_view);
+DEVICE_HANDLE_TRAITS(::VkSampler, destroy_sampler);
+DEVICE_HANDLE_TRAITS(::VkBuffer, destroy_buffer);
+DEVICE_HANDLE_TRAITS(::VkDeviceMemory, free_memory);
+DEVICE_HANDLE_TRAITS(::VkFramebuffer, destroy_framebuffer);
+DEVICE_HANDLE_TRAITS(::VkRenderPass, destroy_render_pass);
+DEVICE_HANDLE_TRAITS(::VkCommandPool, destroy_command_pool);
+DEVICE_HANDLE_TRAITS(::VkShaderModule, destroy_shader_module);
+DEVICE_HANDLE_TRAITS(::VkPipeline, destroy_pipeline);
+DEVICE_HANDLE_TRAITS(::VkPipelineLayout, destroy_pipeline_layout);
+DEVICE_HANDLE_TRAITS(::VkPipelineCache, destroy_pipeline_cache);
+DEVICE_HANDLE_TRAITS(::VkDescriptorSetLayout, destroy_descriptor_set_layout);
+DEVICE_HANDLE_TRAITS(::VkDescriptorPool, destroy_descriptor_pool);
+DEVICE_HANDLE_TRAITS(::VkQueryPool, destroy_query_pool);
+DEVICE_HANDLE_TRAITS(::VkSwapchainKHR, destroy_swapchain);
+
+#undef DEVICE_HANDLE_TRAITS
+
+// sole owner of a device object, destroying it through the device's dispatch table
+// the size of two pointers, with no allocation, type erasure or function lookup, so that transient objects
+// are cheap to create and destroy in numbers; nothing is logged on destruction for the same reason
+template <typename Handle, typename Traits = DeviceHandleTraits<Handle>>
+class UniqueHandle
+{
+public:
+    UniqueHandle() = default;
+
+    UniqueHandle(
+        const DeviceDispatch &inDispatch,
+        Handle inHandle)
+        :
+        _dispatch(&inDispatch),
+        _handle(inHandle)
+    {}
+
+    ~UniqueHandle()
+    {
+        this->reset();
+    }
+
+    UniqueHandle(
+        UniqueHandle &&inOther) noexcept
+        :
+        _dispatch(inOther._dispatch),
+        _handle(inOther.release())
+    {}
+
+    UniqueHandle &
+    operator=(
+        UniqueHandle &&inOther) noexcept
+    {
+        if (this != &inOther)
+        {
+            this->reset();
+            this->_dispatch = inOther._dispatch;
+            this->_handle = inOther.release();
+        }
+        return *this;
+    }
+
+    UniqueHandle(const UniqueHandle &) = delete;
+    UniqueHandle &operator=(const UniqueHandle &) = delete;
+
+    Handle
+    get() const
+    {
+        return this->_handle;
+    }
+
+    const DeviceDispatch *
+    dispatch() const
+    {
+        return this->_dispatch;
+    }
+
+    explicit operator bool() const
+    {
+        return VK_NULL_HANDLE != this->_handle;
+    }
+
+    // gives up ownership, without destroying the object
+    Handle
+    release()
+    {
+        const auto handle = this->_handle;
+        this->_handle = VK_NULL_HANDLE;
+        return handle;
+    }
+
+    void
+    reset()
+    {
+        if (VK_NULL_HANDLE != this->_handle)
+        {
+            Traits::destroy(*this->_dispatch, this->_handle);
+            this->_handle = VK_NULL_HANDLE;
+        }
+    }
+
+private:
+    const DeviceDispatch *_dispatch = nullptr;
+    Handle                _handle = VK_NULL_HANDLE;
+};
+
+#endif // VULKAN_RENDERER_UNIQUEHANDLE_H
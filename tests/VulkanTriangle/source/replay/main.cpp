@@ -0,0 +1,94 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "replayer.h"
+#include "log.h"
+
+#include <cstdlib>
+#include <exception>
+#include <stdexcept>
+#include <string>
+
+// VulkanReplay <capture> [--iterations=N]
+// re-executes a capture made with VulkanTriangle's --capture option, N times (default 1), logging its timing
+int
+main(
+    int argc,
+    char *argv[])
+{
+    Log::set_path(std::string(argv[0]) + "/../replay_log.txt");
+    Log().get() << "Vulkan replay starting up..." << std::endl;
+    try
+    {
+        std::string path;
+        uint32_t iterations = 1;
+        for (auto i = 1; i < argc; ++i)
+        {
+            const std::string arg(argv[i]);
+            const std::string iterations_option("--iterations=");
+            if (0 == arg.compare(0, iterations_option.size(), iterations_option))
+            {
+                char *end = nullptr;
+                const auto value = arg.substr(iterations_option.size());
+                iterations = static_cast<uint32_t>(std::strtoul(value.c_str(), &end, 10));
+                if (value.empty() || '\0' != *end)
+                {
+                    throw std::runtime_error("Option --iterations requires an unsigned integer value, not '" + value + "'");
+                }
+            }
+            else if (path.empty() && (0 != arg.compare(0, 2, "--")))
+            {
+                path = arg;
+            }
+            else
+            {
+                throw std::runtime_error("Unknown option '" + arg + "'");
+            }
+        }
+        if (path.empty())
+        {
+            throw std::runtime_error("Usage: VulkanReplay <capture> [--iterations=N]");
+        }
+
+        Replayer replayer(path);
+        replayer.run(iterations);
+        Log().get() << "Vulkan replay finished successfully" << std::endl;
+        return 0;
+    }
+    catch (const std::exception &inEx)
+    {
+        Log().get() << "ERROR: " << inEx.what() << std::endl;
+        return -1;
+    }
+    catch (...)
+    {
+        Log().get() << "ERROR: Unhandled exception" << std::endl;
+        return -2;
+    }
+}
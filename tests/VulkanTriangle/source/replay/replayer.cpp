@@ -0,0 +1,1204 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "replayer.h"
+#include "renderer/impl.h"
+#include "renderer/layoutcache.h"
+#include "renderer/pipelinecompiler.h"
+#include "renderer/exception.h"
+#include "log.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <sstream>
+
+namespace
+{
+
+std::vector<::VkDescriptorSetLayoutBinding>
+read_bindings(
+    CaptureReader &ioPayload)
+{
+    std::vector<::VkDescriptorSetLayoutBinding> bindings(ioPayload.u32());
+    for (auto &binding : bindings)
+    {
+        memset(&binding, 0, sizeof(binding));
+        binding.binding = ioPayload.u32();
+        binding.descriptorType = static_cast<::VkDescriptorType>(ioPayload.u32());
+        binding.descriptorCount = ioPayload.u32();
+        binding.stageFlags = ioPayload.u32();
+    }
+    return bindings;
+}
+
+template <typename T>
+std::vector<T>
+read_raw_array(
+    CaptureReader &ioPayload)
+{
+    std::vector<T> values(ioPayload.u32());
+    for (auto &value : values)
+    {
+        value = ioPayload.raw<T>();
+    }
+    return values;
+}
+
+} // anonymous namespace
+
+Replayer::Replayer(
+    const std::string &inPath)
+{
+    this->create_instance();
+    this->create_logical_device();
+    this->load(inPath);
+    this->create_command_buffers();
+}
+
+Replayer::~Replayer()
+{
+    if (this->_logical_device)
+    {
+        auto logical_device = this->_logical_device.get();
+        auto waitIdleFn = GETDFN(logical_device, vkDeviceWaitIdle);
+        VK_ERR_CHECK(waitIdleFn(
+            logical_device
+        ));
+    }
+}
+
+void
+Replayer::run(
+    const uint32_t inIterations)
+{
+    typedef std::chrono::high_resolution_clock Clock;
+    typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+    auto logical_device = this->_logical_device.get();
+    auto waitForFencesFn = GETDFN(logical_device, vkWaitForFences);
+    auto resetFencesFn = GETDFN(logical_device, vkResetFences);
+    auto resetCommandBufferFn = GETDFN(logical_device, vkResetCommandBuffer);
+    auto beginCommandBufferFn = GETDFN(logical_device, vkBeginCommandBuffer);
+    auto endCommandBufferFn = GETDFN(logical_device, vkEndCommandBuffer);
+    auto queueSubmitFn = GETDFN(logical_device, vkQueueSubmit);
+    auto waitIdleFn = GETDFN(logical_device, vkDeviceWaitIdle);
+
+    ::VkCommandBufferBeginInfo beginInfo;
+    memset(&beginInfo, 0, sizeof(beginInfo));
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    const auto num_frames = static_cast<uint32_t>(this->_frames.size());
+    Milliseconds record_time(0);
+    const auto start = Clock::now();
+    for (auto iteration = 0u; iteration < inIterations; ++iteration)
+    {
+        for (auto frame_index = 0u; frame_index < num_frames; ++frame_index)
+        {
+            // the capturing renderer's host writes for a frame only overlap those of frames this many before it
+            const auto slot = frame_index % this->_frames_in_flight;
+            auto fence = this->_fences[slot].get();
+            VK_ERR_CHECK_QUIET(waitForFencesFn(
+                logical_device,
+                1,
+                &fence,
+                VK_TRUE,
+                std::numeric_limits<uint64_t>::max()
+            ));
+            VK_ERR_CHECK_QUIET(resetFencesFn(
+                logical_device,
+                1,
+                &fence
+            ));
+
+            const auto &frame = this->_frames[frame_index];
+            const auto record_start = Clock::now();
+            for (const auto &write : frame.writes)
+            {
+                memcpy(write.destination, write.data.data(), write.data.size());
+            }
+            auto commandBuffer = this->_command_buffers[slot];
+            VK_ERR_CHECK_QUIET(resetCommandBufferFn(
+                commandBuffer,
+                0
+            ));
+            VK_ERR_CHECK_QUIET(beginCommandBufferFn(
+                commandBuffer,
+                &beginInfo
+            ));
+            this->record_frame(commandBuffer, frame);
+            VK_ERR_CHECK_QUIET(endCommandBufferFn(
+                commandBuffer
+            ));
+            record_time += Clock::now() - record_start;
+
+            ::VkSubmitInfo submitInfo;
+            memset(&submitInfo, 0, sizeof(submitInfo));
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &commandBuffer;
+            VK_ERR_CHECK_QUIET(queueSubmitFn(
+                this->_queue,
+                1,
+                &submitInfo,
+                fence
+            ));
+        }
+    }
+    VK_ERR_CHECK(waitIdleFn(
+        logical_device
+    ));
+    const Milliseconds total_time = Clock::now() - start;
+
+    const auto submitted = static_cast<uint64_t>(inIterations) * num_frames;
+    Log().get() << "Replayed " << num_frames << " frames x " << inIterations << " iterations: " << total_time.count() << "ms";
+    if (submitted > 0)
+    {
+        Log().get() << ", " << (submitted * 1000.0 / total_time.count()) << " frames/s, " << (record_time.count() / submitted) << "ms recording per frame";
+    }
+    Log().get() << std::endl;
+}
+
+void
+Replayer::create_instance()
+{
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    ::VkApplicationInfo appInfo;
+    memset(&appInfo, 0, sizeof(appInfo));
+    appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    appInfo.pApplicationName = "Replay";
+    appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+    appInfo.pEngineName = "No engine";
+    appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+    appInfo.apiVersion = VK_API_VERSION_1_0;
+
+    // no surface, so no extensions
+    ::VkInstanceCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+    createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    createInfo.pApplicationInfo = &appInfo;
+    ::VkInstance instance;
+    auto createInstanceFn = GETFN(vkCreateInstance);
+    VK_ERR_CHECK(createInstanceFn(&createInfo, nullptr, &instance));
+
+    auto instance_deleter = [](::VkInstance inInstance)
+    {
+        auto deleter = GETIFN(inInstance, vkDestroyInstance);
+        Log().get() << "Destroying VkInstance 0x" << std::hex << inInstance << std::endl;
+        deleter(inInstance, nullptr);
+    };
+    this->_instance = { instance, instance_deleter };
+}
+
+void
+Replayer::create_logical_device()
+{
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    auto instance = this->_instance.get();
+    auto enumerateDevicesFn = GETIFN(instance, vkEnumeratePhysicalDevices);
+    uint32_t numPhysicalDevices = 0;
+    VK_ERR_CHECK(enumerateDevicesFn(instance, &numPhysicalDevices, nullptr));
+    std::vector<::VkPhysicalDevice> physical_devices(numPhysicalDevices);
+    VK_ERR_CHECK(enumerateDevicesFn(instance, &numPhysicalDevices, physical_devices.data()));
+
+    // the first device with a graphics queue
+    auto getQueueFamilyPropsFn = GETIFN(instance, vkGetPhysicalDeviceQueueFamilyProperties);
+    for (auto pDevice : physical_devices)
+    {
+        uint32_t numFamilies = 0;
+        getQueueFamilyPropsFn(pDevice, &numFamilies, nullptr);
+        std::vector<::VkQueueFamilyProperties> families(numFamilies);
+        getQueueFamilyPropsFn(pDevice, &numFamilies, families.data());
+        for (auto i = 0u; i < numFamilies; ++i)
+        {
+            if ((families[i].queueCount > 0) && (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT))
+            {
+                this->_physical_device = pDevice;
+                this->_queue_family_index = i;
+                break;
+            }
+        }
+        if (VK_NULL_HANDLE != this->_physical_device)
+        {
+            break;
+        }
+    }
+    if (VK_NULL_HANDLE == this->_physical_device)
+    {
+        throw Exception("No physical device has a graphics queue");
+    }
+
+    auto getPropertiesFn = GETIFN(instance, vkGetPhysicalDeviceProperties);
+    ::VkPhysicalDeviceProperties properties;
+    getPropertiesFn(this->_physical_device, &properties);
+    Log().get() << "Replaying on '" << properties.deviceName << "', queue family " << this->_queue_family_index << std::endl;
+
+    auto getMemoryPropsFn = GETIFN(instance, vkGetPhysicalDeviceMemoryProperties);
+    getMemoryPropsFn(this->_physical_device, &this->_memory_properties);
+
+    const float priority = 1.0f;
+    ::VkDeviceQueueCreateInfo queueInfo;
+    memset(&queueInfo, 0, sizeof(queueInfo));
+    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueFamilyIndex = this->_queue_family_index;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &priority;
+
+    ::VkDeviceCreateInfo deviceCreateInfo;
+    memset(&deviceCreateInfo, 0, sizeof(deviceCreateInfo));
+    deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceCreateInfo.queueCreateInfoCount = 1;
+    deviceCreateInfo.pQueueCreateInfos = &queueInfo;
+    auto createDeviceFn = GETIFN(instance, vkCreateDevice);
+    ::VkDevice device;
+    VK_ERR_CHECK(createDeviceFn(this->_physical_device, &deviceCreateInfo, nullptr, &device));
+
+    auto destroy_device = [device](::VkDevice inDevice)
+    {
+        auto destroy = GETDFN(device, vkDestroyDevice);
+        Log().get() << "Destroying VkDevice 0x" << std::hex << inDevice << std::endl;
+        destroy(inDevice, nullptr);
+    };
+    this->_logical_device = { device, destroy_device };
+    this->_dispatch.reset(new DeviceDispatch(device, nullptr));
+
+    auto getQueueFn = GETDFN(device, vkGetDeviceQueue);
+    getQueueFn(
+        device,
+        this->_queue_family_index,
+        0,
+        &this->_queue
+    );
+
+    // resolved once, as replaying calls them for every captured command
+    this->_cmd_begin_render_pass = GETDFN(device, vkCmdBeginRenderPass);
+    this->_cmd_end_render_pass = GETDFN(device, vkCmdEndRenderPass);
+    this->_cmd_bind_pipeline = GETDFN(device, vkCmdBindPipeline);
+    this->_cmd_set_viewport = GETDFN(device, vkCmdSetViewport);
+    this->_cmd_set_scissor = GETDFN(device, vkCmdSetScissor);
+    this->_cmd_bind_descriptor_sets = GETDFN(device, vkCmdBindDescriptorSets);
+    this->_cmd_push_constants = GETDFN(device, vkCmdPushConstants);
+    this->_cmd_bind_vertex_buffers = GETDFN(device, vkCmdBindVertexBuffers);
+    this->_cmd_bind_index_buffer = GETDFN(device, vkCmdBindIndexBuffer);
+    this->_cmd_draw = GETDFN(device, vkCmdDraw);
+    this->_cmd_draw_indexed = GETDFN(device, vkCmdDrawIndexed);
+
+    this->_layout_cache.reset(new LayoutCache(*this->_dispatch));
+    this->_pipeline_compiler.reset(new PipelineCompiler(*this->_dispatch, 0, ""));
+}
+
+void
+Replayer::create_command_buffers()
+{
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    auto logical_device = this->_logical_device.get();
+
+    ::VkCommandPoolCreateInfo poolCreateInfo;
+    memset(&poolCreateInfo, 0, sizeof(poolCreateInfo));
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolCreateInfo.queueFamilyIndex = this->_queue_family_index;
+    poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    auto createCommandPoolFn = GETDFN(logical_device, vkCreateCommandPool);
+    ::VkCommandPool commandPool;
+    VK_ERR_CHECK(createCommandPoolFn(
+        logical_device,
+        &poolCreateInfo,
+        this->_dispatch->allocator,
+        &commandPool
+    ));
+    this->_command_pool = { *this->_dispatch, commandPool };
+
+    ::VkCommandBufferAllocateInfo allocInfo;
+    memset(&allocInfo, 0, sizeof(allocInfo));
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = this->_frames_in_flight;
+    this->_command_buffers.resize(this->_frames_in_flight);
+    auto allocateCommandBuffersFn = GETDFN(logical_device, vkAllocateCommandBuffers);
+    VK_ERR_CHECK(allocateCommandBuffersFn(
+        logical_device,
+        &allocInfo,
+        this->_command_buffers.data()
+    ));
+
+    ::VkFenceCreateInfo fenceCreateInfo;
+    memset(&fenceCreateInfo, 0, sizeof(fenceCreateInfo));
+    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    auto createFenceFn = GETDFN(logical_device, vkCreateFence);
+    for (auto i = 0u; i < this->_frames_in_flight; ++i)
+    {
+        ::VkFence fence;
+        VK_ERR_CHECK(createFenceFn(
+            logical_device,
+            &fenceCreateInfo,
+            this->_dispatch->allocator,
+            &fence
+        ));
+        this->_fences.emplace_back(*this->_dispatch, fence);
+    }
+}
+
+void
+Replayer::load(
+    const std::string &inPath)
+{
+    Log().get() << "==================================================" << std::endl;
+    Log().get() << "## " << __FUNCTION__ << std::endl;
+    Log().get() << "==================================================" << std::endl;
+    std::ifstream file(inPath, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw Exception("Unable to open capture '" + inPath + "'");
+    }
+    const std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    CaptureReader reader(contents.data(), contents.size());
+    const auto header = reader.raw<CaptureHeader>();
+    if (CAPTURE_MAGIC != header.magic)
+    {
+        throw Exception("'" + inPath + "' is not a capture");
+    }
+    if (CAPTURE_VERSION != header.version)
+    {
+        std::ostringstream message;
+        message << "Capture '" << inPath << "' is version " << header.version << ", rather than " << CAPTURE_VERSION;
+        throw Exception(message.str());
+    }
+    if (0 == header.frames_in_flight)
+    {
+        throw Exception("Capture '" + inPath + "' has no frames in flight");
+    }
+    this->_frames_in_flight = header.frames_in_flight;
+
+    while (!reader.at_end())
+    {
+        const auto type = static_cast<CaptureRecord>(reader.u32());
+        const auto size = reader.u32();
+        CaptureReader payload(reader.bytes(size), size);
+        switch (type)
+        {
+            case CaptureRecord::ShaderModule:
+                this->create_shader_module(payload);
+                break;
+            case CaptureRecord::RenderPass:
+                this->create_render_pass(payload);
+                break;
+            case CaptureRecord::Framebuffer:
+                this->create_framebuffer(payload);
+                break;
+            case CaptureRecord::PipelineLayout:
+                this->create_pipeline_layout(payload);
+                break;
+            case CaptureRecord::Pipeline:
+                this->create_pipeline(payload);
+                break;
+            case CaptureRecord::Buffer:
+                this->create_buffer(payload);
+                break;
+            case CaptureRecord::BufferData:
+                this->write_buffer(payload);
+                break;
+            case CaptureRecord::DescriptorSet:
+                this->create_descriptor_set(payload);
+                break;
+            case CaptureRecord::Frame:
+                this->translate_frame(payload);
+                break;
+            default:
+                {
+                    std::ostringstream message;
+                    message << "Capture '" << inPath << "' has an unknown record type " << static_cast<uint32_t>(type);
+                    throw Exception(message.str());
+                }
+        }
+    }
+    if (this->_frames.size() != header.frame_count)
+    {
+        std::ostringstream message;
+        message << "Capture '" << inPath << "' has " << this->_frames.size() << " frames, rather than " << header.frame_count;
+        throw Exception(message.str());
+    }
+    // the first frame reads the host's writes made after the last frame, when replayed again
+    if (!this->_pending_writes.empty() && !this->_frames.empty())
+    {
+        auto &first_writes = this->_frames.front().writes;
+        first_writes.insert(first_writes.end(), this->_pending_writes.begin(), this->_pending_writes.end());
+        this->_pending_writes.clear();
+    }
+    this->_pipeline_compiler->wait_idle();
+    Log().get() << "Loaded " << this->_frames.size() << " frames, " << this->_num_commands << " commands, from '" << inPath << "'" << std::endl;
+}
+
+void
+Replayer::create_shader_module(
+    CaptureReader &ioPayload)
+{
+    const auto id = ioPayload.u64();
+    ioPayload.u32(); // stage, which the pipeline states
+    const auto code = read_raw_array<uint32_t>(ioPayload);
+
+    ::VkShaderModuleCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = code.size() * sizeof(uint32_t);
+    createInfo.pCode = code.data();
+
+    auto logical_device = this->_logical_device.get();
+    auto createShaderModuleFn = GETDFN(logical_device, vkCreateShaderModule);
+    ::VkShaderModule shaderModule;
+    VK_ERR_CHECK(createShaderModuleFn(
+        logical_device,
+        &createInfo,
+        this->_dispatch->allocator,
+        &shaderModule
+    ));
+    this->_shader_modules.emplace_back(*this->_dispatch, shaderModule);
+    this->_handles[std::make_pair(CaptureRecord::ShaderModule, id)] = capture_id(shaderModule);
+}
+
+void
+Replayer::create_render_pass(
+    CaptureReader &ioPayload)
+{
+    const auto id = ioPayload.u64();
+    auto colorAttachment = ioPayload.raw<::VkAttachmentDescription>();
+    // rendered to an offscreen image, which is never presented
+    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    ::VkAttachmentReference colorAttachmentRef;
+    memset(&colorAttachmentRef, 0, sizeof(colorAttachmentRef));
+    colorAttachmentRef.attachment = 0;
+    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    ::VkSubpassDescription subpass;
+    memset(&subpass, 0, sizeof(subpass));
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorAttachmentRef;
+
+    // successive frames render to the same image
+    ::VkSubpassDependency dependency;
+    memset(&dependency, 0, sizeof(dependency));
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = 0;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    ::VkRenderPassCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+    createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    createInfo.attachmentCount = 1;
+    createInfo.pAttachments = &colorAttachment;
+    createInfo.subpassCount = 1;
+    createInfo.pSubpasses = &subpass;
+    createInfo.dependencyCount = 1;
+    createInfo.pDependencies = &dependency;
+
+    auto logical_device = this->_logical_device.get();
+    auto createRenderPassFn = GETDFN(logical_device, vkCreateRenderPass);
+    ::VkRenderPass renderPass;
+    VK_ERR_CHECK(createRenderPassFn(
+        logical_device,
+        &createInfo,
+        this->_dispatch->allocator,
+        &renderPass
+    ));
+    this->_render_passes.emplace_back(*this->_dispatch, renderPass);
+    this->_handles[std::make_pair(CaptureRecord::RenderPass, id)] = capture_id(renderPass);
+    this->_render_pass_formats[capture_id(renderPass)] = colorAttachment.format;
+}
+
+void
+Replayer::create_framebuffer(
+    CaptureReader &ioPayload)
+{
+    const auto id = ioPayload.u64();
+    const auto renderPass = capture_handle<::VkRenderPass>(this->handle(CaptureRecord::RenderPass, ioPayload.u64()));
+    const auto width = ioPayload.u32();
+    const auto height = ioPayload.u32();
+    const auto format = this->_render_pass_formats.at(capture_id(renderPass));
+
+    auto logical_device = this->_logical_device.get();
+    std::unique_ptr<ReplayFramebuffer> framebuffer(new ReplayFramebuffer);
+
+    ::VkImageCreateInfo imageCreateInfo;
+    memset(&imageCreateInfo, 0, sizeof(imageCreateInfo));
+    imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageCreateInfo.format = format;
+    imageCreateInfo.extent.width = width;
+    imageCreateInfo.extent.height = height;
+    imageCreateInfo.extent.depth = 1;
+    imageCreateInfo.mipLevels = 1;
+    imageCreateInfo.arrayLayers = 1;
+    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageCreateInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    auto createImageFn = GETDFN(logical_device, vkCreateImage);
+    ::VkImage image;
+    VK_ERR_CHECK(createImageFn(
+        logical_device,
+        &imageCreateInfo,
+        this->_dispatch->allocator,
+        &image
+    ));
+    framebuffer->image = { *this->_dispatch, image };
+
+    auto getRequirementsFn = GETDFN(logical_device, vkGetImageMemoryRequirements);
+    ::VkMemoryRequirements requirements;
+    getRequirementsFn(
+        logical_device,
+        image,
+        &requirements
+    );
+    ::VkMemoryAllocateInfo allocInfo;
+    memset(&allocInfo, 0, sizeof(allocInfo));
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = this->find_memory_type(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    auto allocateMemoryFn = GETDFN(logical_device, vkAllocateMemory);
+    ::VkDeviceMemory memory;
+    VK_ERR_CHECK(allocateMemoryFn(
+        logical_device,
+        &allocInfo,
+        this->_dispatch->allocator,
+        &memory
+    ));
+    framebuffer->memory = { *this->_dispatch, memory };
+    auto bindImageMemoryFn = GETDFN(logical_device, vkBindImageMemory);
+    VK_ERR_CHECK(bindImageMemoryFn(
+        logical_device,
+        image,
+        memory,
+        0
+    ));
+
+    ::VkImageViewCreateInfo viewCreateInfo;
+    memset(&viewCreateInfo, 0, sizeof(viewCreateInfo));
+    viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewCreateInfo.image = image;
+    viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewCreateInfo.format = format;
+    viewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewCreateInfo.subresourceRange.levelCount = 1;
+    viewCreateInfo.subresourceRange.layerCount = 1;
+    auto createImageViewFn = GETDFN(logical_device, vkCreateImageView);
+    ::VkImageView view;
+    VK_ERR_CHECK(createImageViewFn(
+        logical_device,
+        &viewCreateInfo,
+        this->_dispatch->allocator,
+        &view
+    ));
+    framebuffer->view = { *this->_dispatch, view };
+
+    ::VkFramebufferCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+    createInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    createInfo.renderPass = renderPass;
+    createInfo.attachmentCount = 1;
+    createInfo.pAttachments = &view;
+    createInfo.width = width;
+    createInfo.height = height;
+    createInfo.layers = 1;
+    auto createFramebufferFn = GETDFN(logical_device, vkCreateFramebuffer);
+    ::VkFramebuffer frameBuffer;
+    VK_ERR_CHECK(createFramebufferFn(
+        logical_device,
+        &createInfo,
+        this->_dispatch->allocator,
+        &frameBuffer
+    ));
+    framebuffer->framebuffer = { *this->_dispatch, frameBuffer };
+
+    this->_framebuffers.emplace_back(std::move(framebuffer));
+    this->_handles[std::make_pair(CaptureRecord::Framebuffer, id)] = capture_id(frameBuffer);
+}
+
+void
+Replayer::create_pipeline_layout(
+    CaptureReader &ioPayload)
+{
+    const auto id = ioPayload.u64();
+    std::vector<::VkDescriptorSetLayout> set_layouts(ioPayload.u32());
+    for (auto &set_layout : set_layouts)
+    {
+        set_layout = this->_layout_cache->descriptor_set_layout(read_bindings(ioPayload));
+    }
+    const auto push_constant_ranges = read_raw_array<::VkPushConstantRange>(ioPayload);
+    const auto layout = this->_layout_cache->pipeline_layout(set_layouts, push_constant_ranges);
+    this->_handles[std::make_pair(CaptureRecord::PipelineLayout, id)] = capture_id(layout);
+}
+
+void
+Replayer::create_pipeline(
+    CaptureReader &ioPayload)
+{
+    const auto id = ioPayload.u64();
+    PipelineDesc desc;
+    desc.vertex_shader = capture_handle<::VkShaderModule>(this->handle(CaptureRecord::ShaderModule, ioPayload.u64()));
+    desc.fragment_shader = capture_handle<::VkShaderModule>(this->handle(CaptureRecord::ShaderModule, ioPayload.u64()));
+    desc.vertex_bindings = read_raw_array<::VkVertexInputBindingDescription>(ioPayload);
+    desc.vertex_attributes = read_raw_array<::VkVertexInputAttributeDescription>(ioPayload);
+    desc.topology = static_cast<::VkPrimitiveTopology>(ioPayload.u32());
+    desc.cull_mode = ioPayload.u32();
+    desc.front_face = static_cast<::VkFrontFace>(ioPayload.u32());
+    desc.layout = capture_handle<::VkPipelineLayout>(this->handle(CaptureRecord::PipelineLayout, ioPayload.u64()));
+    desc.render_pass = capture_handle<::VkRenderPass>(this->handle(CaptureRecord::RenderPass, ioPayload.u64()));
+    desc.subpass = ioPayload.u32();
+    desc.specialization_entries.resize(ioPayload.u32());
+    for (auto &entry : desc.specialization_entries)
+    {
+        entry.constantID = ioPayload.u32();
+        entry.offset = ioPayload.u32();
+        entry.size = ioPayload.u32();
+    }
+    desc.specialization_data = read_raw_array<uint32_t>(ioPayload);
+
+    // compiled on this thread, as every frame is translated before any is replayed
+    const auto pipeline = this->_pipeline_compiler->wait(this->_pipeline_compiler->compile(desc));
+    this->_handles[std::make_pair(CaptureRecord::Pipeline, id)] = capture_id(pipeline);
+}
+
+void
+Replayer::create_buffer(
+    CaptureReader &ioPayload)
+{
+    const auto id = ioPayload.u64();
+    const auto size = ioPayload.u64();
+    const auto usage = ioPayload.u32();
+    const auto has_contents = (0 != ioPayload.u32());
+
+    auto logical_device = this->_logical_device.get();
+    std::unique_ptr<ReplayBuffer> buffer(new ReplayBuffer);
+    buffer->size = size;
+
+    ::VkBufferCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+    createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    createInfo.size = size;
+    createInfo.usage = usage;
+    createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    auto createBufferFn = GETDFN(logical_device, vkCreateBuffer);
+    ::VkBuffer vkBuffer;
+    VK_ERR_CHECK(createBufferFn(
+        logical_device,
+        &createInfo,
+        this->_dispatch->allocator,
+        &vkBuffer
+    ));
+    buffer->buffer = { *this->_dispatch, vkBuffer };
+
+    // coherent, so that replaying the host's writes is only a copy, as it was for the renderer's uniform ring
+    auto getRequirementsFn = GETDFN(logical_device, vkGetBufferMemoryRequirements);
+    ::VkMemoryRequirements requirements;
+    getRequirementsFn(
+        logical_device,
+        vkBuffer,
+        &requirements
+    );
+    ::VkMemoryAllocateInfo allocInfo;
+    memset(&allocInfo, 0, sizeof(allocInfo));
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = this->find_memory_type(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    auto allocateMemoryFn = GETDFN(logical_device, vkAllocateMemory);
+    ::VkDeviceMemory memory;
+    VK_ERR_CHECK(allocateMemoryFn(
+        logical_device,
+        &allocInfo,
+        this->_dispatch->allocator,
+        &memory
+    ));
+    buffer->memory = { *this->_dispatch, memory };
+    auto bindBufferMemoryFn = GETDFN(logical_device, vkBindBufferMemory);
+    VK_ERR_CHECK(bindBufferMemoryFn(
+        logical_device,
+        vkBuffer,
+        memory,
+        0
+    ));
+
+    // mapped until the memory is freed
+    auto mapMemoryFn = GETDFN(logical_device, vkMapMemory);
+    void *mapped = nullptr;
+    VK_ERR_CHECK(mapMemoryFn(
+        logical_device,
+        memory,
+        0,
+        VK_WHOLE_SIZE,
+        0,
+        &mapped
+    ));
+    buffer->mapped = static_cast<char *>(mapped);
+    if (has_contents)
+    {
+        memcpy(buffer->mapped, ioPayload.bytes(static_cast<size_t>(size)), static_cast<size_t>(size));
+    }
+
+    this->_buffer_ids[id] = buffer.get();
+    this->_handles[std::make_pair(CaptureRecord::Buffer, id)] = capture_id(vkBuffer);
+    this->_buffers.emplace_back(std::move(buffer));
+}
+
+void
+Replayer::write_buffer(
+    CaptureReader &ioPayload)
+{
+    const auto id = ioPayload.u64();
+    const auto offset = ioPayload.u64();
+    const auto size = ioPayload.u64();
+    const auto data = ioPayload.bytes(static_cast<size_t>(size));
+
+    const auto found = this->_buffer_ids.find(id);
+    if (this->_buffer_ids.end() == found)
+    {
+        throw Exception("Capture writes to an unknown buffer");
+    }
+    auto buffer = found->second;
+    if ((offset > buffer->size) || (size > buffer->size - offset))
+    {
+        throw Exception("Capture writes beyond the end of a buffer");
+    }
+
+    // writes before the first frame are setup, made once; later writes are repeated with the frame after them
+    if (this->_frames.empty())
+    {
+        memcpy(buffer->mapped + offset, data, static_cast<size_t>(size));
+        return;
+    }
+    ReplayWrite write;
+    write.destination = buffer->mapped + offset;
+    write.data.assign(data, data + size);
+    this->_pending_writes.emplace_back(std::move(write));
+}
+
+void
+Replayer::create_descriptor_set(
+    CaptureReader &ioPayload)
+{
+    const auto id = ioPayload.u64();
+    const auto set_layout = this->_layout_cache->descriptor_set_layout(read_bindings(ioPayload));
+
+    struct Write
+    {
+        uint32_t           binding;
+        ::VkDescriptorType type;
+        ::VkDescriptorBufferInfo info;
+    };
+    std::vector<Write> writes(ioPayload.u32());
+    std::map<::VkDescriptorType, uint32_t> type_counts;
+    for (auto &write : writes)
+    {
+        write.binding = ioPayload.u32();
+        write.type = static_cast<::VkDescriptorType>(ioPayload.u32());
+        write.info.buffer = capture_handle<::VkBuffer>(this->handle(CaptureRecord::Buffer, ioPayload.u64()));
+        write.info.offset = ioPayload.u64();
+        write.info.range = ioPayload.u64();
+        ++type_counts[write.type];
+    }
+
+    auto logical_device = this->_logical_device.get();
+
+    // a pool per set, as there are few
+    std::vector<::VkDescriptorPoolSize> pool_sizes;
+    for (const auto &type_count : type_counts)
+    {
+        ::VkDescriptorPoolSize pool_size;
+        pool_size.type = type_count.first;
+        pool_size.descriptorCount = type_count.second;
+        pool_sizes.push_back(pool_size);
+    }
+    ::VkDescriptorPoolCreateInfo poolCreateInfo;
+    memset(&poolCreateInfo, 0, sizeof(poolCreateInfo));
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolCreateInfo.maxSets = 1;
+    poolCreateInfo.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    poolCreateInfo.pPoolSizes = pool_sizes.data();
+    auto createDescriptorPoolFn = GETDFN(logical_device, vkCreateDescriptorPool);
+    ::VkDescriptorPool pool;
+    VK_ERR_CHECK(createDescriptorPoolFn(
+        logical_device,
+        &poolCreateInfo,
+        this->_dispatch->allocator,
+        &pool
+    ));
+    this->_descriptor_pools.emplace_back(*this->_dispatch, pool);
+
+    ::VkDescriptorSetAllocateInfo allocInfo;
+    memset(&allocInfo, 0, sizeof(allocInfo));
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &set_layout;
+    auto allocateDescriptorSetsFn = GETDFN(logical_device, vkAllocateDescriptorSets);
+    ::VkDescriptorSet set;
+    VK_ERR_CHECK(allocateDescriptorSetsFn(
+        logical_device,
+        &allocInfo,
+        &set
+    ));
+
+    std::vector<::VkWriteDescriptorSet> descriptor_writes(writes.size());
+    for (auto i = 0u; i < writes.size(); ++i)
+    {
+        auto &descriptor_write = descriptor_writes[i];
+        memset(&descriptor_write, 0, sizeof(descriptor_write));
+        descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptor_write.dstSet = set;
+        descriptor_write.dstBinding = writes[i].binding;
+        descriptor_write.descriptorCount = 1;
+        descriptor_write.descriptorType = writes[i].type;
+        descriptor_write.pBufferInfo = &writes[i].info;
+    }
+    auto updateDescriptorSetsFn = GETDFN(logical_device, vkUpdateDescriptorSets);
+    updateDescriptorSetsFn(
+        logical_device,
+        static_cast<uint32_t>(descriptor_writes.size()),
+        descriptor_writes.data(),
+        0,
+        nullptr
+    );
+    this->_handles[std::make_pair(CaptureRecord::DescriptorSet, id)] = capture_id(set);
+}
+
+void
+Replayer::translate_frame(
+    CaptureReader &ioPayload)
+{
+    const auto size = ioPayload.u32();
+    CaptureReader commands(ioPayload.bytes(size), size);
+
+    ReplayFrame frame;
+    frame.writes.swap(this->_pending_writes);
+    auto &stream = frame.commands;
+    while (!commands.at_end())
+    {
+        const auto command = commands.u32();
+        stream.u32(command);
+        switch (static_cast<CaptureCommand>(command))
+        {
+            case CaptureCommand::BeginRenderPass:
+                {
+                    stream.u64(this->handle(CaptureRecord::RenderPass, commands.u64()));
+                    stream.u64(this->handle(CaptureRecord::Framebuffer, commands.u64()));
+                    stream.raw(commands.raw<::VkRect2D>());
+                    const auto num_clear_values = commands.u32();
+                    stream.u32(num_clear_values);
+                    stream.bytes(commands.bytes(num_clear_values * sizeof(::VkClearValue)), num_clear_values * sizeof(::VkClearValue));
+                }
+                break;
+            case CaptureCommand::EndRenderPass:
+                break;
+            case CaptureCommand::BindPipeline:
+                stream.u64(this->handle(CaptureRecord::Pipeline, commands.u64()));
+                break;
+            case CaptureCommand::SetViewport:
+                stream.raw(commands.raw<::VkViewport>());
+                break;
+            case CaptureCommand::SetScissor:
+                stream.raw(commands.raw<::VkRect2D>());
+                break;
+            case CaptureCommand::BindDescriptorSets:
+                {
+                    stream.u64(this->handle(CaptureRecord::PipelineLayout, commands.u64()));
+                    stream.u32(commands.u32());
+                    const auto num_sets = commands.u32();
+                    stream.u32(num_sets);
+                    for (auto i = 0u; i < num_sets; ++i)
+                    {
+                        stream.u64(this->handle(CaptureRecord::DescriptorSet, commands.u64()));
+                    }
+                    const auto num_offsets = commands.u32();
+                    stream.u32(num_offsets);
+                    stream.bytes(commands.bytes(num_offsets * sizeof(uint32_t)), num_offsets * sizeof(uint32_t));
+                }
+                break;
+            case CaptureCommand::PushConstants:
+                {
+                    stream.u64(this->handle(CaptureRecord::PipelineLayout, commands.u64()));
+                    stream.u32(commands.u32());
+                    stream.u32(commands.u32());
+                    const auto num_bytes = commands.u32();
+                    stream.u32(num_bytes);
+                    stream.bytes(commands.bytes(num_bytes), num_bytes);
+                }
+                break;
+            case CaptureCommand::BindVertexBuffers:
+                {
+                    stream.u32(commands.u32());
+                    const auto num_buffers = commands.u32();
+                    stream.u32(num_buffers);
+                    for (auto i = 0u; i < num_buffers; ++i)
+                    {
+                        stream.u64(this->handle(CaptureRecord::Buffer, commands.u64()));
+                        stream.u64(commands.u64());
+                    }
+                }
+                break;
+            case CaptureCommand::BindIndexBuffer:
+                stream.u64(this->handle(CaptureRecord::Buffer, commands.u64()));
+                stream.u64(commands.u64());
+                stream.u32(commands.u32());
+                break;
+            case CaptureCommand::Draw:
+                stream.bytes(commands.bytes(4 * sizeof(uint32_t)), 4 * sizeof(uint32_t));
+                break;
+            case CaptureCommand::DrawIndexed:
+                stream.bytes(commands.bytes(5 * sizeof(uint32_t)), 5 * sizeof(uint32_t));
+                break;
+            default:
+                {
+                    std::ostringstream message;
+                    message << "Capture has an unknown command " << command << " in frame " << this->_frames.size();
+                    throw Exception(message.str());
+                }
+        }
+        ++this->_num_commands;
+    }
+    this->_frames.emplace_back(std::move(frame));
+}
+
+void
+Replayer::record_frame(
+    ::VkCommandBuffer inCommandBuffer,
+    const ReplayFrame &inFrame) const
+{
+    // already validated when translated, so is decoded without checks beyond the reader's own
+    const auto &data = inFrame.commands.data();
+    CaptureReader commands(data.data(), data.size());
+    while (!commands.at_end())
+    {
+        switch (static_cast<CaptureCommand>(commands.u32()))
+        {
+            case CaptureCommand::BeginRenderPass:
+                {
+                    ::VkRenderPassBeginInfo beginInfo;
+                    memset(&beginInfo, 0, sizeof(beginInfo));
+                    beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+                    beginInfo.renderPass = capture_handle<::VkRenderPass>(commands.u64());
+                    beginInfo.framebuffer = capture_handle<::VkFramebuffer>(commands.u64());
+                    beginInfo.renderArea = commands.raw<::VkRect2D>();
+                    beginInfo.clearValueCount = commands.u32();
+                    // unaligned in the stream, so copied out
+                    std::vector<::VkClearValue> clear_values(beginInfo.clearValueCount);
+                    memcpy(clear_values.data(), commands.bytes(clear_values.size() * sizeof(::VkClearValue)), clear_values.size() * sizeof(::VkClearValue));
+                    beginInfo.pClearValues = clear_values.data();
+                    this->_cmd_begin_render_pass(
+                        inCommandBuffer,
+                        &beginInfo,
+                        VK_SUBPASS_CONTENTS_INLINE
+                    );
+                }
+                break;
+            case CaptureCommand::EndRenderPass:
+                this->_cmd_end_render_pass(
+                    inCommandBuffer
+                );
+                break;
+            case CaptureCommand::BindPipeline:
+                this->_cmd_bind_pipeline(
+                    inCommandBuffer,
+                    VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    capture_handle<::VkPipeline>(commands.u64())
+                );
+                break;
+            case CaptureCommand::SetViewport:
+                {
+                    const auto viewport = commands.raw<::VkViewport>();
+                    this->_cmd_set_viewport(
+                        inCommandBuffer,
+                        0,
+                        1,
+                        &viewport
+                    );
+                }
+                break;
+            case CaptureCommand::SetScissor:
+                {
+                    const auto scissor = commands.raw<::VkRect2D>();
+                    this->_cmd_set_scissor(
+                        inCommandBuffer,
+                        0,
+                        1,
+                        &scissor
+                    );
+                }
+                break;
+            case CaptureCommand::BindDescriptorSets:
+                {
+                    const auto layout = capture_handle<::VkPipelineLayout>(commands.u64());
+                    const auto first_set = commands.u32();
+                    std::vector<::VkDescriptorSet> sets(commands.u32());
+                    for (auto &set : sets)
+                    {
+                        set = capture_handle<::VkDescriptorSet>(commands.u64());
+                    }
+                    std::vector<uint32_t> offsets(commands.u32());
+                    memcpy(offsets.data(), commands.bytes(offsets.size() * sizeof(uint32_t)), offsets.size() * sizeof(uint32_t));
+                    this->_cmd_bind_descriptor_sets(
+                        inCommandBuffer,
+                        VK_PIPELINE_BIND_POINT_GRAPHICS,
+                        layout,
+                        first_set,
+                        static_cast<uint32_t>(sets.size()),
+                        sets.data(),
+                        static_cast<uint32_t>(offsets.size()),
+                        offsets.data()
+                    );
+                }
+                break;
+            case CaptureCommand::PushConstants:
+                {
+                    const auto layout = capture_handle<::VkPipelineLayout>(commands.u64());
+                    const auto stages = commands.u32();
+                    const auto offset = commands.u32();
+                    const auto size = commands.u32();
+                    this->_cmd_push_constants(
+                        inCommandBuffer,
+                        layout,
+                        stages,
+                        offset,
+                        size,
+                        commands.bytes(size)
+                    );
+                }
+                break;
+            case CaptureCommand::BindVertexBuffers:
+                {
+                    const auto first_binding = commands.u32();
+                    const auto num_buffers = commands.u32();
+                    std::vector<::VkBuffer> buffers(num_buffers);
+                    std::vector<::VkDeviceSize> offsets(num_buffers);
+                    for (auto i = 0u; i < num_buffers; ++i)
+                    {
+                        buffers[i] = capture_handle<::VkBuffer>(commands.u64());
+                        offsets[i] = commands.u64();
+                    }
+                    this->_cmd_bind_vertex_buffers(
+                        inCommandBuffer,
+                        first_binding,
+                        num_buffers,
+                        buffers.data(),
+                        offsets.data()
+                    );
+                }
+                break;
+            case CaptureCommand::BindIndexBuffer:
+                {
+                    const auto buffer = capture_handle<::VkBuffer>(commands.u64());
+                    const auto offset = commands.u64();
+                    this->_cmd_bind_index_buffer(
+                        inCommandBuffer,
+                        buffer,
+                        offset,
+                        static_cast<::VkIndexType>(commands.u32())
+                    );
+                }
+                break;
+            case CaptureCommand::Draw:
+                {
+                    const auto vertex_count = commands.u32();
+                    const auto instance_count = commands.u32();
+                    const auto first_vertex = commands.u32();
+                    const auto first_instance = commands.u32();
+                    this->_cmd_draw(
+                        inCommandBuffer,
+                        vertex_count,
+                        instance_count,
+                        first_vertex,
+                        first_instance
+                    );
+                }
+                break;
+            case CaptureCommand::DrawIndexed:
+                {
+                    const auto index_count = commands.u32();
+                    const auto instance_count = commands.u32();
+                    const auto first_index = commands.u32();
+                    const auto vertex_offset = commands.raw<int32_t>();
+                    const auto first_instance = commands.u32();
+                    this->_cmd_draw_indexed(
+                        inCommandBuffer,
+                        index_count,
+                        instance_count,
+                        first_index,
+                        vertex_offset,
+                        first_instance
+                    );
+                }
+                break;
+        }
+    }
+}
+
+uint32_t
+Replayer::find_memory_type(
+    const uint32_t inTypeBits,
+    const ::VkMemoryPropertyFlags inProperties) const
+{
+    for (auto i = 0u; i < this->_memory_properties.memoryTypeCount; ++i)
+    {
+        if ((inTypeBits & (1u << i)) && (inProperties == (this->_memory_properties.memoryTypes[i].propertyFlags & inProperties)))
+        {
+            return i;
+        }
+    }
+    throw Exception("No memory type suitable for a replayed object");
+}
+
+uint64_t
+Replayer::handle(
+    const CaptureRecord inType,
+    const uint64_t inId) const
+{
+    const auto found = this->_handles.find(std::make_pair(inType, inId));
+    if (this->_handles.end() == found)
+    {
+        std::ostringstream message;
+        message << "Capture refers to object 0x" << std::hex << inId << " of record type " << std::dec << static_cast<uint32_t>(inType) << " before recording it";
+        throw Exception(message.str());
+    }
+    return found->second;
+}
@@ -0,0 +1,205 @@
+/*
+Copyright (c) 2010-2019, Mark Final
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of BuildAMation nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VULKAN_REPLAY_REPLAYER_H
+#define VULKAN_REPLAY_REPLAYER_H
+
+#include "renderer/captureformat.h"
+#include "renderer/uniquehandle.h"
+#include "vulkan/vulkan.h"
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class LayoutCache;
+class PipelineCompiler;
+
+// re-executes a capture written by FrameCapture, on a device without a surface, so that the renderer's workload
+// can be timed, and compared between drivers and devices, without a window or the application that made it
+// every object that the capture records is created up front, rendering to offscreen images in place of the
+// swapchain's; buffers are host visible, and the host's writes to them during the captured frames are repeated
+// before the frame that followed them, as the renderer made them
+// frames are submitted back to back, with as many in flight as the capturing renderer had
+class Replayer
+{
+public:
+    explicit Replayer(
+        const std::string &inPath);
+    ~Replayer();
+
+    Replayer(const Replayer &) = delete;
+    Replayer &operator=(const Replayer &) = delete;
+
+    // submits every captured frame inIterations times, then waits for the device to idle
+    void
+    run(
+        const uint32_t inIterations);
+
+private:
+    struct ReplayBuffer
+    {
+        UniqueHandle<::VkDeviceMemory> memory;
+        UniqueHandle<::VkBuffer>       buffer;
+        char                          *mapped = nullptr;
+        ::VkDeviceSize                 size = 0;
+    };
+
+    struct ReplayFramebuffer
+    {
+        UniqueHandle<::VkDeviceMemory> memory;
+        UniqueHandle<::VkImage>        image;
+        UniqueHandle<::VkImageView>    view;
+        UniqueHandle<::VkFramebuffer>  framebuffer;
+    };
+
+    struct ReplayWrite
+    {
+        char             *destination;
+        std::vector<char> data;
+    };
+
+    struct ReplayFrame
+    {
+        std::vector<ReplayWrite> writes; // of the host, since the previous frame
+        CaptureWriter            commands; // with the capture's identifiers replaced by this device's handles
+    };
+
+    void
+    create_instance();
+
+    void
+    create_logical_device();
+
+    void
+    create_command_buffers();
+
+    void
+    load(
+        const std::string &inPath);
+
+    void
+    create_shader_module(
+        CaptureReader &ioPayload);
+
+    void
+    create_render_pass(
+        CaptureReader &ioPayload);
+
+    void
+    create_framebuffer(
+        CaptureReader &ioPayload);
+
+    void
+    create_pipeline_layout(
+        CaptureReader &ioPayload);
+
+    void
+    create_pipeline(
+        CaptureReader &ioPayload);
+
+    void
+    create_buffer(
+        CaptureReader &ioPayload);
+
+    void
+    write_buffer(
+        CaptureReader &ioPayload);
+
+    void
+    create_descriptor_set(
+        CaptureReader &ioPayload);
+
+    void
+    translate_frame(
+        CaptureReader &ioPayload);
+
+    void
+    record_frame(
+        ::VkCommandBuffer inCommandBuffer,
+        const ReplayFrame &inFrame) const;
+
+    uint32_t
+    find_memory_type(
+        const uint32_t inTypeBits,
+        const ::VkMemoryPropertyFlags inProperties) const;
+
+    // the handle created for the latest record of a capture identifier, throwing Exception if there was none
+    // keyed by record type too, as handles of different types may share values
+    uint64_t
+    handle(
+        const CaptureRecord inType,
+        const uint64_t inId) const;
+
+    std::unique_ptr< ::VkInstance_T, std::function<void(::VkInstance)>>        _instance;
+    ::VkPhysicalDevice                                                         _physical_device = VK_NULL_HANDLE;
+    ::VkPhysicalDeviceMemoryProperties                                         _memory_properties;
+    uint32_t                                                                   _queue_family_index = 0;
+    std::unique_ptr< ::VkDevice_T, std::function<void(::VkDevice)>>            _logical_device;
+    std::unique_ptr<DeviceDispatch>                                            _dispatch;
+    ::VkQueue                                                                  _queue = VK_NULL_HANDLE;
+    PFN_vkCmdBeginRenderPass                                                   _cmd_begin_render_pass = nullptr;
+    PFN_vkCmdEndRenderPass                                                     _cmd_end_render_pass = nullptr;
+    PFN_vkCmdBindPipeline                                                      _cmd_bind_pipeline = nullptr;
+    PFN_vkCmdSetViewport                                                       _cmd_set_viewport = nullptr;
+    PFN_vkCmdSetScissor                                                        _cmd_set_scissor = nullptr;
+    PFN_vkCmdBindDescriptorSets                                                _cmd_bind_descriptor_sets = nullptr;
+    PFN_vkCmdPushConstants                                                     _cmd_push_constants = nullptr;
+    PFN_vkCmdBindVertexBuffers                                                 _cmd_bind_vertex_buffers = nullptr;
+    PFN_vkCmdBindIndexBuffer                                                   _cmd_bind_index_buffer = nullptr;
+    PFN_vkCmdDraw                                                              _cmd_draw = nullptr;
+    PFN_vkCmdDrawIndexed                                                       _cmd_draw_indexed = nullptr;
+
+    // objects are kept until exit, even once an identifier is reused, as earlier frames may still refer to them
+    std::unique_ptr<LayoutCache>                                               _layout_cache;
+    std::unique_ptr<PipelineCompiler>                                          _pipeline_compiler;
+    std::vector<UniqueHandle<::VkShaderModule>>                                _shader_modules;
+    std::vector<UniqueHandle<::VkRenderPass>>                                  _render_passes;
+    std::vector<std::unique_ptr<ReplayFramebuffer>>                            _framebuffers;
+    std::vector<std::unique_ptr<ReplayBuffer>>                                 _buffers;
+    std::vector<UniqueHandle<::VkDescriptorPool>>                              _descriptor_pools;
+    std::map<std::pair<CaptureRecord, uint64_t>, uint64_t>                     _handles; // capture identifier to this device's handle
+    std::unordered_map<uint64_t, ReplayBuffer *>                               _buffer_ids;
+    std::unordered_map<uint64_t, ::VkFormat>                                   _render_pass_formats;
+    std::vector<ReplayWrite>                                                   _pending_writes;
+    std::vector<ReplayFrame>                                                   _frames;
+    uint32_t                                                                   _frames_in_flight = 0;
+    uint64_t                                                                   _num_commands = 0;
+
+    UniqueHandle<::VkCommandPool>                                              _command_pool;
+    std::vector<::VkCommandBuffer>                                             _command_buffers;
+    std::vector<UniqueHandle<::VkFence>>                                       _fences;
+};
+
+#endif // VULKAN_REPLAY_REPLAYER_H
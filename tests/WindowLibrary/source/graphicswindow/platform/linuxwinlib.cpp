@@ -43,6 +43,12 @@ GraphicsWindow::init(
     impl->createWindow(inWidth, inHeight, inTitle);
 }
 
+void
+GraphicsWindow::finalise()
+{
+    // onCreate has already been called, once the window was created by init
+}
+
 void
 GraphicsWindow::show()
 {
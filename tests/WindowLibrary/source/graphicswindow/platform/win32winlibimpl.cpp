@@ -31,6 +31,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "windowlibrary/exception.h"
 #include "win32winlibimpl.h"
 
+#include <atomic>
 #include <cassert>
 
 namespace
@@ -57,6 +58,9 @@ WindowProcBootstrap(
     return window->win32MessageProc(hWnd, Msg, wParam, lParam);
 }
 
+// each window registers, and unregisters, a class of its own, so that several windows may exist at once
+std::atomic<unsigned> nextClassIndex(0);
+
 } // anonymous namespace
 
 namespace WindowLibrary
@@ -67,7 +71,7 @@ GraphicsWindow::Impl::Impl(
     :
     _parent(inParent),
     _instance(nullptr),
-    _className("GraphicsWindowClass")
+    _className("GraphicsWindowClass" + std::to_string(nextClassIndex++))
 {}
 
 GraphicsWindow::Impl::~Impl()
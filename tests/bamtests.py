@@ -8,6 +8,7 @@ def configure_repository():
                                           osx={"Native": [clang64, clang32], "MakeFile": [clang64, clang32], "Xcode": [clang64, clang32]})
     configs["RenderTextureAndProcessor"] = TestSetup(win={"Native": [visualc64, visualc32, mingw32], "VSSolution": [visualc64, visualc32], "MakeFile": [visualc64, visualc32, mingw32]})
     configs["VulkanTriangle"] = TestSetup(win={"Native": [visualc64], "VSSolution": [visualc64], "MakeFile": [visualc64]},
+                                          linux={"Native": [gcc64], "MakeFile": [gcc64]},
                                           osx={"Native": [clang64], "MakeFile": [clang64], "Xcode": [clang64]})
     configs["MetalTriangle"] = TestSetup(osx={"Native": [clang64], "MakeFile": [clang64], "Xcode": [clang64]})
     #configs["WindowLibrary"] = TestSetup(win={"Native": [visualc64, visualc32, mingw32], "VSSolution": [visualc64, visualc32], "MakeFile": [visualc64, visualc32, mingw32]},